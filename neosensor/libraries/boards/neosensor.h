@@ -138,6 +138,17 @@
   #endif
 #endif
 
+/* Luminosity sensors INT line (open drain, active low)
+ * [oct.26] not wired on current PCBs ==> sensors get polled.
+ * Building with -DLUMINOSITY_INT=<gpio> enables sensors' event mode.
+ */
+//#define LUMINOSITY_INT      19
+
+/* MCP9808 temperature sensor ALERT line (open drain, active low)
+ * [oct.26] not wired on current PCBs ==> Ta flags get polled.
+ */
+//#define TEMPERATURE_ALERT   25
+
 /* PIR sensor
  * [aug.20] TODO: configure PIR sensor through sensOCampus JSON config
  */
@@ -0,0 +1,149 @@
+/*
+ * neOCampus operation
+ *
+ * Heap telemetry and low-memory back-pressure
+ *
+ * ---
+ * Notes:
+ * - ESP32 tracks min-ever-free at allocation time, ESP8266 only gets
+ *   our 1s sampling
+ * ---
+ * oct.26  initial release
+ *
+ */
+
+
+/*
+ * Includes
+ */
+#include <Arduino.h>
+#include <Esp.h>
+
+#include "neocampus.h"
+#include "neocampus_debug.h"
+
+#include "neocampus_heap.h"
+
+
+
+/*
+ * Global variables
+ */
+static heapStats_t _heapStats = { 0, 0, UINT32_MAX, UINT32_MAX, 0 };
+static heapPressure_t _heapPressure = heapPressure_t::normal;
+
+
+
+/*
+ * low-level heap sampling
+ */
+static void _heapSample( heapStats_t *hs ) {
+  hs->freeHeap = ESP.getFreeHeap();
+#if defined(ESP8266)
+  hs->maxBlock = ESP.getMaxFreeBlockSize();
+#elif defined(ESP32)
+  hs->maxBlock = ESP.getMaxAllocHeap();
+#else
+  hs->maxBlock = hs->freeHeap;
+#endif
+  // fragmentation: how far the largest block is from the whole free heap
+  hs->fragmentation = ( hs->freeHeap ? 100 - (uint8_t)(((uint64_t)hs->maxBlock*100) / hs->freeHeap) : 0 );
+
+  if( hs->freeHeap < hs->minFree ) hs->minFree = hs->freeHeap;
+#if defined(ESP32)
+  if( ESP.getMinFreeHeap() < hs->minFree ) hs->minFree = ESP.getMinFreeHeap();
+#endif
+  if( hs->maxBlock < hs->minMaxBlock ) hs->minMaxBlock = hs->maxBlock;
+}
+
+
+/*
+ * sample heap and compute back-pressure level
+ * a level increases as soon as a threshold is crossed but it will only
+ * decrease once we're above threshold + hysteresis
+ */
+bool heapUpdate( void ) {
+
+  _heapSample( &_heapStats );
+
+  uint32_t _free  = _heapStats.freeHeap;
+  uint32_t _block = _heapStats.maxBlock;
+  heapPressure_t _level;
+
+  if( _free < HEAP_CRITICAL_THRESHOLD or _block < HEAP_MIN_BLOCK/2 ) {
+    _level = heapPressure_t::critical;
+  }
+  else if( _free < HEAP_LOW_THRESHOLD or _block < HEAP_MIN_BLOCK ) {
+    _level = heapPressure_t::low;
+    // hysteresis from critical
+    if( _heapPressure==heapPressure_t::critical and
+        (_free < HEAP_CRITICAL_THRESHOLD+HEAP_HYSTERESIS or _block < HEAP_MIN_BLOCK/2+HEAP_HYSTERESIS) ) {
+      _level = heapPressure_t::critical;
+    }
+  }
+  else {
+    _level = heapPressure_t::normal;
+    // hysteresis from low or critical
+    if( _heapPressure!=heapPressure_t::normal and
+        (_free < HEAP_LOW_THRESHOLD+HEAP_HYSTERESIS or _block < HEAP_MIN_BLOCK+HEAP_HYSTERESIS) ) {
+      _level = heapPressure_t::low;
+    }
+  }
+
+  if( _level==_heapPressure ) return false;
+  _heapPressure = _level;
+  return true;
+}
+
+
+/*
+ * last heap sample
+ */
+const heapStats_t *heapStats( void ) {
+  return &_heapStats;
+}
+
+
+/*
+ * current back-pressure level
+ */
+heapPressure_t heapPressure( void ) {
+  return _heapPressure;
+}
+
+
+/*
+ * check that an optional allocation would leave enough heap behind
+ * (i.e we won't be the ones to trigger the low-memory pressure)
+ */
+bool heapAvailable( size_t size ) {
+  if( _heapPressure!=heapPressure_t::normal ) return false;
+  heapStats_t hs = _heapStats;
+  _heapSample( &hs );
+  return ( size < hs.maxBlock and hs.freeHeap - size >= HEAP_LOW_THRESHOLD );
+}
+
+
+/*
+ * add heap telemetry to a status report
+ */
+void heapStatus( JsonObject root ) {
+  // fresh sample
+  _heapSample( &_heapStats );
+
+  root[F("heap")] = _heapStats.freeHeap;
+  root[F("heap_min")] = _heapStats.minFree;
+  root[F("heap_maxblock")] = _heapStats.maxBlock;
+  root[F("heap_frag")] = _heapStats.fragmentation;
+  switch( _heapPressure ) {
+    case heapPressure_t::normal :
+      root[F("heap_pressure")] = "normal";
+      break;
+    case heapPressure_t::low :
+      root[F("heap_pressure")] = "low";
+      break;
+    case heapPressure_t::critical :
+      root[F("heap_pressure")] = "critical";
+      break;
+  }
+}
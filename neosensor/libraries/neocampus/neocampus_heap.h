@@ -0,0 +1,84 @@
+/*
+ * neOCampus operation
+ *
+ * Heap telemetry and low-memory back-pressure
+ *
+ * ---
+ * Notes:
+ * - heap gets sampled from endLoop() every second: free heap, largest free
+ *   block, fragmentation and min-ever-free are tracked and published in the
+ *   device module status
+ * - whenever the heap becomes short or fragmented, all modules get notified
+ *   (base::heapPressure) so that they disable their optional features (e.g
+ *   history buffers, batching, debug JSON dumps) BEFORE an allocation fails
+ * ---
+ * oct.26  initial release
+ *
+ */
+
+
+#ifndef _NEOCAMPUS_HEAP_H_
+#define _NEOCAMPUS_HEAP_H_
+
+/*
+ * Includes
+ */
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+
+
+/*
+ * Definitions
+ */
+#ifndef HEAP_LOW_THRESHOLD
+#define HEAP_LOW_THRESHOLD        12288   // bytes: below this free heap, optional features get disabled
+#endif
+#ifndef HEAP_CRITICAL_THRESHOLD
+#define HEAP_CRITICAL_THRESHOLD   4096    // bytes: below this free heap, we're close to an allocation failure
+#endif
+#ifndef HEAP_MIN_BLOCK
+#define HEAP_MIN_BLOCK            4096    // bytes: largest free block ought to stay above (e.g TLS records, JSON buffers)
+#endif
+#define HEAP_HYSTERESIS           2048    // bytes above thresholds to get back to a lower pressure level
+
+// back-pressure levels
+enum class heapPressure_t : uint8_t {
+  normal      = 0,  // everything enabled
+  low,              // optional features disabled
+  critical          // optional features disabled + error messages
+};
+
+// heap telemetry
+typedef struct {
+  uint32_t freeHeap;      // current free heap
+  uint32_t maxBlock;      // current largest free block
+  uint32_t minFree;       // min-ever-free heap
+  uint32_t minMaxBlock;   // min-ever largest free block
+  uint8_t  fragmentation; // percent (0 means a single free block)
+} heapStats_t;
+
+
+
+/*
+ * Functions
+ */
+// sample heap and compute back-pressure level: returns true upon level change
+bool heapUpdate( void );
+
+// last heap sample
+const heapStats_t *heapStats( void );
+
+// current back-pressure level
+heapPressure_t heapPressure( void );
+
+// true when optional features ought to get disabled
+inline bool heapIsLow( void ) { return heapPressure()!=heapPressure_t::normal; }
+
+// check that an optional allocation would leave enough heap behind
+bool heapAvailable( size_t );
+
+// add heap telemetry to a status report
+void heapStatus( JsonObject );
+
+#endif /* _NEOCAMPUS_HEAP_H_ */
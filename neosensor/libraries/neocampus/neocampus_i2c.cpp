@@ -9,6 +9,15 @@
  * ---
  * TODO:
  * ---
+ * oct.26  transactions serialized with a transport sharing the
+ *         bus lines (TM1637 timer1 waveform on SCL)
+ * oct.26  inventory records the modules enabled when it got built
+ * oct.26  transaction layer: status codes, retries, bus recovery,
+ *         per-device clock and errors accounting. Legacy helpers
+ *         (read8, readList ...) now rely on it
+ * oct.26  enumeration of drivers' known addresses first (no
+ *         delay unless a probe fails), optional full sweep,
+ *         devices inventory saved to flash
  * F.Thiebolt aug.21  i2c scan now reads two times to augment detection
  *                    capabilities
  * F.Thiebolt 2015    initial release
@@ -20,6 +29,11 @@
  * Includes
  */
 #include <Wire.h>
+#include <FS.h>
+#if defined(ESP32)
+  #include "SPIFFS.h"
+#endif
+#include <ArduinoJson.h>
 
 // neOCampus specific includes
 #include "neocampus.h"
@@ -29,6 +43,20 @@
 
 
 
+/*
+ * Global variables
+ */
+static uint8_t _i2c_sda         = INVALID_GPIO;
+static uint8_t _i2c_scl         = INVALID_GPIO;
+static uint32_t _i2c_clock      = I2C_DEFL_CLOCK;   // bus default clock
+static uint16_t _i2c_recoveries = 0;
+static i2cDeviceStats_t _i2c_devices[I2C_DEVICES_MAX];
+static uint8_t _i2c_nbDevices   = 0;
+static i2cSharedIdle_t _i2c_sharedIdle = nullptr;  // transport sharing bus lines
+volatile bool _i2c_busy         = false;
+
+
+
 /* I2C scanner: it starts to scan I2C bus according to specified start parameter
  *  Scan stops whenever a device respond and we send back it address. You can continue scanning 
  *  giving previous answered addr+1
@@ -64,15 +92,124 @@ uint8_t i2c_scan( uint8_t start ) {
   return -1;
 }
 
+/*
+ * I2C addresses bitmap: add a driver's list of addresses
+ */
+void i2c_bitmap_add( uint8_t *bitmap, const uint8_t *addrs, uint8_t nb ) {
+  for( uint8_t i=0; i < nb; i++ ) {
+    if( addrs[i] > I2C_ADDR_STOP ) continue;
+    bitmap[addrs[i] >> 3] |= (1 << (addrs[i] & 0x07));
+  }
+}
+
+
+/*
+ * I2C probe: quick write, retried only on failure
+ */
+bool i2c_probe( uint8_t adr, uint8_t tries ) {
+  while( tries-- ) {
+    if( i2c_quick_write( adr )==0 ) return true;
+    if( tries ) delay( I2C_PROBE_RETRY_MS );
+  }
+  return false;
+}
+
+
+/*
+ * I2C enumeration: probe known addresses (bitmap) first then, optionally,
+ *  every other address (single probe). Found addresses get sorted.
+ * return number of found devices
+ */
+uint8_t i2c_enumerate( const uint8_t *known, uint8_t *found, uint8_t maxFound, bool fullSweep ) {
+
+  uint8_t _nb = 0;
+  unsigned long _startMs = millis();
+
+  for( uint8_t _addr=I2C_ADDR_START; _addr <= I2C_ADDR_STOP and _nb < maxFound; _addr++ ) {
+    bool _known = ( known and (known[_addr >> 3] & (1 << (_addr & 0x07))) );
+    if( not _known and not fullSweep ) continue;
+    if( i2c_probe( _addr, (_known ? I2C_PROBE_TRIES : 1) ) ) found[_nb++] = _addr;
+  }
+
+  log_debug(F("\n[I2C] enumeration found ")); log_debug(_nb,DEC);
+  log_debug(F(" device(s) in ")); log_debug(millis()-_startMs,DEC); log_debug(F("ms")); log_flush();
+  return _nb;
+}
+
+
+/*
+ * I2C devices inventory: load from flash
+ */
+bool i2c_inventory_load( i2cDevice_t *devices, uint8_t *nb, uint8_t *enabled ) {
+
+  *nb = 0;
+  *enabled = 0;
+  if( ! SPIFFS.exists(I2C_INVENTORY_FILE) ) return false;
+
+  File _file = SPIFFS.open(I2C_INVENTORY_FILE, "r");
+  if( ! _file ) return false;
+
+  StaticJsonDocument<I2C_INVENTORY_JSON_SIZE> _doc;
+  auto err = deserializeJson( _doc, _file );
+  _file.close();
+  if( err or not _doc[F("devices")].is<JsonArray>() ) {
+    log_error(F("\n[I2C] inventory format error ... removing")); log_flush();
+    SPIFFS.remove(I2C_INVENTORY_FILE);
+    return false;
+  }
+
+  *enabled = _doc[F("enabled")].as<uint8_t>();
+  for( JsonVariant item : _doc[F("devices")].as<JsonArray>() ) {
+    if( *nb >= I2C_INVENTORY_MAX ) break;
+    devices[*nb].addr = item[F("addr")].as<uint8_t>();
+    devices[*nb].modules = item[F("modules")].as<uint8_t>();
+    (*nb)++;
+  }
+  return true;
+}
+
+
+/*
+ * I2C devices inventory: save to flash
+ */
+bool i2c_inventory_save( const i2cDevice_t *devices, uint8_t nb, uint8_t enabled ) {
+
+  StaticJsonDocument<I2C_INVENTORY_JSON_SIZE> _doc;
+  _doc[F("enabled")] = enabled;
+  JsonArray root = _doc.createNestedArray(F("devices"));
+  for( uint8_t i=0; i < nb and i < I2C_INVENTORY_MAX; i++ ) {
+    JsonObject _obj = root.createNestedObject();
+    _obj[F("addr")] = devices[i].addr;
+    _obj[F("modules")] = devices[i].modules;
+  }
+
+  File _file = SPIFFS.open( I2C_INVENTORY_FILE, "w");
+  if( !_file ) {
+    log_error(F("\n[I2C] error creating file: ")); log_error(I2C_INVENTORY_FILE); log_flush();
+    return false;
+  }
+  bool _res = ( serializeJson( _doc, _file ) != 0 );
+  _file.close();
+
+  log_info(F("\n[I2C] devices inventory saved (")); log_info(nb,DEC); log_info(F(" devices)")); log_flush();
+  return _res;
+}
+
+
 /**************************************************************************/
 /*! 
     @brief  Low level I2C read and write functions!
 */
 /**************************************************************************/
+static void _i2c_lock( void );
+static void _i2c_unlock( void );
+
 int i2c_quick_write( uint8_t adr ) {
   int res;
+  _i2c_lock();
   Wire.beginTransmission( adr );
   res = Wire.endTransmission();
+  _i2c_unlock();
 
 #ifdef DEBUG_I2C
   if( res==0 ) {
@@ -84,79 +221,266 @@ int i2c_quick_write( uint8_t adr ) {
   return res;
 }
 
-void write8(uint8_t adr, uint8_t value) {
-#ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-write8] adr=0x%02x (no reg) val=0x%02x", adr, value);
-  log_debug(_msg);log_flush();
-#endif
-  Wire.beginTransmission(adr);
-  Wire.write(value);
-  Wire.endTransmission();
+/* ------------------------------------------------------------------------------
+ * Transaction layer
+ */
+
+static bool _i2c_busStuck( void );
+
+/*
+ * Bus lines shared with another transport: raise busy flag then wait for
+ * the other transport to reach a frame boundary (its ISR keeps running)
+ */
+void i2c_share( i2cSharedIdle_t idle ) {
+  _i2c_sharedIdle = idle;
 }
 
-void write8(uint8_t adr, uint8_t reg, uint8_t value) {
-#ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-write8] adr=0x%02x reg=%d val=0x%02x", adr, reg, value);
-  log_debug(_msg);log_flush();
-#endif
-  Wire.beginTransmission(adr);
-  Wire.write((uint8_t)reg);
-  Wire.write(value);
-  Wire.endTransmission();
+static void _i2c_lock( void ) {
+  _i2c_busy = true;
+  if( _i2c_sharedIdle==nullptr ) return;
+  while( not _i2c_sharedIdle() ) delayMicroseconds( 10 );
 }
 
-uint8_t read8(uint8_t adr, uint8_t reg) {
-  uint8_t val;
-  Wire.beginTransmission(adr);
-  Wire.write((uint8_t)reg);
-  Wire.endTransmission();
+static void _i2c_unlock( void ) {
+  _i2c_busy = false;
+}
 
-  Wire.requestFrom(adr, (uint8_t)1);
-  val= Wire.read();
+/*
+ * I2C bus setup: pins are kept for bus recovery
+ */
+bool i2c_begin( uint8_t sda, uint8_t scl, uint32_t clock ) {
+  if( sda==INVALID_GPIO or scl==INVALID_GPIO ) return false;
+  _i2c_sda = sda;
+  _i2c_scl = scl;
+  _i2c_clock = ( clock ? clock : I2C_DEFL_CLOCK );
+
+  // a device may still hold SDA low (e.g reset in the middle of a read)
+  _i2c_lock();
+  pinMode( sda, INPUT_PULLUP );
+  pinMode( scl, INPUT_PULLUP );
+  bool _res = true;
+  if( _i2c_busStuck() ) _res = i2c_recover();
+  else {
+    Wire.begin( sda, scl );
+    Wire.setClock( _i2c_clock );
+  }
+  _i2c_unlock();
+  return _res;
+}
 
-#ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-read8] adr=0x%02x reg=%d val=0x%02x", adr, reg, val);
-  log_debug(_msg);log_flush();
-#endif
 
-  return val;
+/*
+ * per-device stats (created on first use)
+ */
+static i2cDeviceStats_t *_i2c_device( uint8_t adr ) {
+  for( uint8_t i=0; i < _i2c_nbDevices; i++ ) {
+    if( _i2c_devices[i].addr == adr ) return &_i2c_devices[i];
+  }
+  if( _i2c_nbDevices >= I2C_DEVICES_MAX ) return nullptr;
+  i2cDeviceStats_t *_dev = &_i2c_devices[_i2c_nbDevices++];
+  memset( _dev, 0, sizeof(i2cDeviceStats_t) );
+  _dev->addr = adr;
+  return _dev;
 }
 
-void write16(uint8_t adr, uint8_t reg, uint16_t value) {
-#ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-write16] adr=0x%02x reg=%d val=0x%04x", adr, reg, value);
-  log_debug(_msg);log_flush();
+
+/*
+ * per-device clock: fast mode devices do not run at the slowest one's rate
+ * (0 means bus default clock)
+ */
+void i2c_setClock( uint8_t adr, uint32_t clock ) {
+  i2cDeviceStats_t *_dev = _i2c_device( adr );
+  if( _dev ) _dev->clock = clock;
+}
+
+
+/*
+ * SDA or SCL held low while bus is idle ?
+ */
+static bool _i2c_busStuck( void ) {
+  if( _i2c_sda==INVALID_GPIO or _i2c_scl==INVALID_GPIO ) return false;
+  return ( digitalRead(_i2c_sda)==LOW or digitalRead(_i2c_scl)==LOW );
+}
+
+
+/*
+ * bus recovery: up to 9 clock pulses till slave releases SDA, then STOP
+ * condition and I2C controller restart
+ */
+bool i2c_recover( void ) {
+  if( _i2c_sda==INVALID_GPIO or _i2c_scl==INVALID_GPIO ) return false;
+
+  _i2c_recoveries++;
+  log_warning(F("\n[I2C] bus stuck ... recovery")); log_flush();
+
+#if defined(ESP32) && defined(ESP_ARDUINO_VERSION_MAJOR)
+  #if ESP_ARDUINO_VERSION_MAJOR >= 2
+  Wire.end();
+  #endif
 #endif
-  Wire.beginTransmission(adr);
-  Wire.write((uint8_t)reg);
-  Wire.write(value >> 8);
-  Wire.write(value & 0xFF);
-  Wire.endTransmission();
+  pinMode( _i2c_sda, INPUT_PULLUP );
+  pinMode( _i2c_scl, OUTPUT_OPEN_DRAIN );
+  digitalWrite( _i2c_scl, HIGH );
+  delayMicroseconds( I2C_RECOVERY_HALF_US );
+
+  for( uint8_t i=0; i < 9 and digitalRead(_i2c_sda)==LOW; i++ ) {
+    digitalWrite( _i2c_scl, LOW );
+    delayMicroseconds( I2C_RECOVERY_HALF_US );
+    digitalWrite( _i2c_scl, HIGH );
+    delayMicroseconds( I2C_RECOVERY_HALF_US );
+  }
+
+  // STOP: SDA rising while SCL is high
+  digitalWrite( _i2c_scl, LOW );
+  delayMicroseconds( I2C_RECOVERY_HALF_US );
+  pinMode( _i2c_sda, OUTPUT_OPEN_DRAIN );
+  digitalWrite( _i2c_sda, LOW );
+  delayMicroseconds( I2C_RECOVERY_HALF_US );
+  digitalWrite( _i2c_scl, HIGH );
+  delayMicroseconds( I2C_RECOVERY_HALF_US );
+  digitalWrite( _i2c_sda, HIGH );
+  delayMicroseconds( I2C_RECOVERY_HALF_US );
+  pinMode( _i2c_sda, INPUT_PULLUP );
+  pinMode( _i2c_scl, INPUT_PULLUP );
+
+  bool _res = not _i2c_busStuck();
+
+  Wire.begin( _i2c_sda, _i2c_scl );
+  Wire.setClock( _i2c_clock );
+
+  if( !_res ) {
+    log_error(F("\n[I2C] bus recovery failed :(")); log_flush();
+  }
+  return _res;
 }
 
-uint16_t read16(uint8_t adr, uint8_t reg) {
-  uint16_t val;
 
-  Wire.beginTransmission(adr);
-  Wire.write((uint8_t)reg);
-  Wire.endTransmission();
-  
-  Wire.requestFrom(adr, (uint8_t)2);
-  val = Wire.read();
-  val <<= 8;
-  val |= Wire.read();  
+/*
+ * I2C transaction: optional write phase, optional pause then optional
+ *  read phase. Failed transfers are retried, bus gets recovered if stuck.
+ */
+i2cStatus_t i2c_transfer( uint8_t adr, const uint8_t *wbuf, uint8_t wlen,
+                          uint8_t *rbuf, uint8_t rlen, uint8_t *rcount,
+                          uint16_t pauseMs, bool repeatStart, uint8_t retries ) {
+
+  i2cDeviceStats_t *_dev = _i2c_device( adr );
+  i2cStatus_t _res = i2cStatus_t::ok;
+  uint8_t _nb = 0;
+
+  if( rcount ) *rcount = 0;
+  if( _dev ) _dev->transfers++;
+
+  _i2c_lock();
+  do {
+    // device clock
+    Wire.setClock( (_dev and _dev->clock) ? _dev->clock : _i2c_clock );
+
+    _res = i2cStatus_t::ok;
+    _nb = 0;
+
+    // write phase
+    if( wlen or rlen==0 ) {
+      Wire.beginTransmission( adr );
+      for( uint8_t i=0; i < wlen; i++ ) Wire.write( wbuf[i] );
+      uint8_t _err = Wire.endTransmission( rlen ? !repeatStart : true );  // 'false' enables the 'repeated start bit'
+      if( _err > (uint8_t)i2cStatus_t::timeout ) _err = (uint8_t)i2cStatus_t::other;
+      _res = (i2cStatus_t)_err;
+    }
+
+    // read phase
+    if( _res==i2cStatus_t::ok and rlen ) {
+      if( pauseMs ) delay( pauseMs );
+      Wire.requestFrom( adr, rlen );
+      while( Wire.available() and _nb < rlen ) rbuf[_nb++] = Wire.read();
+      if( _nb==0 ) _res = i2cStatus_t::nack_addr;
+      else if( _nb < rlen ) _res = i2cStatus_t::short_read;
+    }
+
+    if( _res==i2cStatus_t::ok ) break;
+
+    // errors accounting
+    if( _dev ) {
+      if( _res==i2cStatus_t::nack_addr or _res==i2cStatus_t::nack_data ) _dev->nacks++;
+      else if( _res==i2cStatus_t::timeout ) _dev->timeouts++;
+    }
+
+    // bus stuck ?
+    if( _i2c_busStuck() and not i2c_recover() ) {
+      _res = i2cStatus_t::bus_stuck;
+      break;
+    }
+
+    if( retries ) {
+      if( _dev ) _dev->retries++;
+      delayMicroseconds( I2C_RETRY_US );
+    }
+  } while( retries-- );
+  _i2c_unlock();
+
+  if( _res!=i2cStatus_t::ok and _dev ) _dev->errors++;
+  if( rcount ) *rcount = _nb;
 
 #ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-read16] adr=0x%02x reg=%d val=0x%04x", adr, reg, val);
+  char _msg[128];
+  snprintf(_msg, sizeof(_msg), "\n[I2C-xfer] adr=0x%02x wlen=%d rlen=%d read=%d status=%d", adr, wlen, rlen, _nb, (int)_res);
   log_debug(_msg);log_flush();
 #endif
 
-  return val;  
+  return _res;
+}
+
+
+/*
+ * per-device stats to status report
+ */
+uint8_t i2c_nbDevices( void ) {
+  return _i2c_nbDevices;
+}
+
+void i2c_status( uint8_t idx, JsonObject root ) {
+  if( idx >= _i2c_nbDevices ) return;
+  const i2cDeviceStats_t *_dev = &_i2c_devices[idx];
+  root[F("i2c_addr")] = _dev->addr;
+  root[F("clock")] = ( _dev->clock ? _dev->clock : _i2c_clock );
+  root[F("transfers")] = _dev->transfers;
+  root[F("errors")] = _dev->errors;
+  root[F("nacks")] = _dev->nacks;
+  root[F("timeouts")] = _dev->timeouts;
+  root[F("retries")] = _dev->retries;
+  root[F("recoveries")] = _i2c_recoveries;    // bus wide
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  Low level I2C read and write functions!
+    @note   [oct.26] values read on failure are 0xFF (i.e no device)
+*/
+/**************************************************************************/
+void write8(uint8_t adr, uint8_t value) {
+  i2c_transfer( adr, &value, 1 );
+}
+
+void write8(uint8_t adr, uint8_t reg, uint8_t value) {
+  uint8_t _buf[2] = { reg, value };
+  i2c_transfer( adr, _buf, sizeof(_buf) );
+}
+
+uint8_t read8(uint8_t adr, uint8_t reg) {
+  uint8_t val = 0xFF;
+  i2c_transfer( adr, &reg, 1, &val, 1 );
+  return val;
+}
+
+void write16(uint8_t adr, uint8_t reg, uint16_t value) {
+  uint8_t _buf[3] = { reg, (uint8_t)(value >> 8), (uint8_t)(value & 0xFF) };
+  i2c_transfer( adr, _buf, sizeof(_buf) );
+}
+
+uint16_t read16(uint8_t adr, uint8_t reg) {
+  uint8_t _buf[2] = { 0xFF, 0xFF };
+  i2c_transfer( adr, &reg, 1, _buf, sizeof(_buf) );
+  return ((uint16_t)_buf[0] << 8) | _buf[1];
 }
 
 
@@ -165,41 +489,17 @@ uint16_t read16(uint8_t adr, uint8_t reg) {
  * I2C write16 little-endian
  */
 void write16le(uint8_t adr, uint8_t reg, uint16_t value) {
-#ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-write16le] adr=0x%02x reg=%d val=0x%04x", adr, reg, value);
-  log_debug(_msg);log_flush();
-#endif
-  Wire.beginTransmission(adr);
-  Wire.write((uint8_t)reg);
-  Wire.write(value & 0xFF);
-  Wire.write(value >> 8);
-  Wire.endTransmission();
+  uint8_t _buf[3] = { reg, (uint8_t)(value & 0xFF), (uint8_t)(value >> 8) };
+  i2c_transfer( adr, _buf, sizeof(_buf) );
 }
 
 /*
  * I2C read16 little-endian
  */
 uint16_t read16le(uint8_t adr, uint8_t reg) {
-  uint16_t val;
-
-  Wire.beginTransmission(adr);
-  Wire.write((uint8_t)reg);
-  Wire.endTransmission();
-  
-  Wire.requestFrom(adr, (uint8_t)2);
-  uint8_t lsb = Wire.read();
-  uint8_t msb = Wire.read();
-  val = msb << 8;
-  val |= lsb;  
-
-#ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-read16le] adr=0x%02x reg=%d val=0x%04x", adr, reg, val);
-  log_debug(_msg);log_flush();
-#endif
-
-  return val;  
+  uint8_t _buf[2] = { 0xFF, 0xFF };
+  i2c_transfer( adr, &reg, 1, _buf, sizeof(_buf) );
+  return ((uint16_t)_buf[1] << 8) | _buf[0];
 }
 
 
@@ -211,33 +511,9 @@ uint16_t read16le(uint8_t adr, uint8_t reg) {
  * return number of bytes read
  */
 uint8_t readList( uint8_t adr, uint8_t reg, uint8_t tab[], uint8_t tabsize, uint8_t pauseMs, bool repeatStart ) {
-  
-  uint8_t _res;
-  Wire.beginTransmission(adr);
-  Wire.write((uint8_t)reg);
-  _res = Wire.endTransmission( !repeatStart );  // 'false' enables the 'repeated start bit'
-  if( _res ) {
-    log_debug(F("\n[I2C-readList] endTransmission non-zero ret code!"));log_flush();
-    return 0;
-  }
-
-  if( pauseMs ) delay( pauseMs );
-  else yield();
-
-  Wire.requestFrom(adr, tabsize);
-  uint8_t i=0;
-  while( Wire.available() and ( i < tabsize) ) {
-    tab[i++] = Wire.read();
-  }
-  Wire.endTransmission();
-
-#ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-readList] adr=0x%02x reg=0x%02x i=%d val=[0x%02x 0x%02x 0x%02x 0x%02x ... ]", adr, reg, i, tab[0], tab[1], tab[2], tab[3]);
-  log_debug(_msg);log_flush();
-#endif
-  
-  return i;
+  uint8_t _nb;
+  i2c_transfer( adr, &reg, 1, tab, tabsize, &_nb, pauseMs, repeatStart );
+  return _nb;
 }
 
 uint8_t writeList( uint8_t adr, uint8_t reg, uint8_t *tab, uint8_t tabsize ){
@@ -254,28 +530,8 @@ uint8_t writeList( uint8_t adr, uint8_t reg, uint8_t *tab, uint8_t tabsize ){
  * return number of bytes read
  */
 uint8_t readList_ll( uint8_t adr, uint8_t tab[], uint8_t tabsize, uint8_t pauseMs ) {
-  
   /* NOTE: we don't write anything, just start with read */
-  Wire.requestFrom(adr, tabsize);
-
-  if( pauseMs ) delay( pauseMs );
-  else yield();
-
-  uint8_t i=0;
-  while( Wire.available() and (i < tabsize) ) {
-    tab[i++] = Wire.read();
-  }
-  Wire.endTransmission();
-
-#ifdef DEBUG_I2C
-  char _msg[255];
-  snprintf(_msg, sizeof(_msg), "\n[I2C-readList-ll] adr=0x%02x val=[0x%02x 0x%02x 0x%02x 0x%02x ... ]", adr, tab[0], tab[1], tab[2], tab[3]);
-  log_debug(_msg);log_flush();
-#endif
-  
-  return i;
+  uint8_t _nb;
+  i2c_transfer( adr, nullptr, 0, tab, tabsize, &_nb, pauseMs );
+  return _nb;
 }
-
-
-
-
@@ -3,6 +3,10 @@
  * 
  * I2C functions
  * 
+ * oct.26  bus shared with another transport (i2c_share)
+ * oct.26  transaction layer with status codes, retries, bus recovery,
+ *         per-device clock and errors accounting
+ * oct.26  known addresses probing and devices inventory
  * Thiebolt F. June 17
  * 
  */
@@ -15,6 +19,7 @@
  * Includes
  */
 #include <Arduino.h>
+#include <ArduinoJson.h>
 
 
 
@@ -27,6 +32,66 @@
 #define I2C_ADDR_START  0x01
 #define I2C_ADDR_STOP   0x7F
 
+/* [oct.26] enumeration: known addresses (i.e drivers' i2c_addrs[])
+ * are probed first, full sweep of the bus is optional
+ */
+//#define I2C_FULL_SWEEP                  // also probe addresses no driver will ever claim
+#define I2C_PROBE_TRIES         2       // probes of a known address before giving up
+#define I2C_PROBE_RETRY_MS      2       // delay before another probe
+#define I2C_BITMAP_SIZE         ((I2C_ADDR_STOP+1)/8)   // one bit per i2c address
+
+/* [oct.26] transaction layer */
+#ifndef I2C_DEFL_CLOCK
+  #ifdef I2C_FREQ
+    #define I2C_DEFL_CLOCK      I2C_FREQ
+  #else
+    #define I2C_DEFL_CLOCK      100000  // Hz, standard mode
+  #endif
+#endif /* I2C_DEFL_CLOCK */
+#ifndef I2C_FAST_CLOCK
+#define I2C_FAST_CLOCK          400000  // Hz, fast mode devices (e.g SHT3x, MCP9808)
+#endif /* I2C_FAST_CLOCK */
+#define I2C_RETRIES             2       // retries of a failed transfer
+#define I2C_RETRY_US            500     // delay before retry
+#define I2C_RECOVERY_HALF_US    5       // bus recovery: half SCL period (100kHz)
+#define I2C_DEVICES_MAX         16      // devices with their own clock and stats
+
+// transfer status (Wire's endTransmission codes then ours)
+enum class i2cStatus_t : uint8_t {
+  ok            = 0,
+  too_long      = 1,    // data too long for Wire's buffer
+  nack_addr     = 2,    // address not acknowledged (no device, busy device)
+  nack_data     = 3,    // data not acknowledged
+  other         = 4,    // other error (e.g arbitration lost, bus busy)
+  timeout       = 5,    // bus timeout (e.g clock stretching)
+  short_read    = 6,    // less bytes than expected
+  bus_stuck     = 7     // SDA or SCL held low, recovery failed
+};
+
+// per-device clock and stats
+typedef struct {
+  uint8_t addr;
+  uint32_t clock;       // Hz, 0 means bus default clock
+  uint32_t transfers;
+  uint32_t errors;      // failed transfers (i.e once retries exhausted)
+  uint16_t nacks;
+  uint16_t timeouts;
+  uint16_t retries;
+} i2cDeviceStats_t;
+
+/* devices inventory: i2c addr along with bitmask of modules that
+ * adopted the device; saved to flash, later boots just verify it.
+ * [oct.26] bitmask of modules enabled at that time gets saved too: any
+ * module enabled since then never got offered the devices
+ */
+#define I2C_INVENTORY_FILE      "/i2c_inventory.json"
+#define I2C_INVENTORY_MAX       16
+#define I2C_INVENTORY_JSON_SIZE (JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(I2C_INVENTORY_MAX) + I2C_INVENTORY_MAX*JSON_OBJECT_SIZE(2))
+typedef struct {
+  uint8_t addr;
+  uint8_t modules;    // bitmask of modules (see neosensor.ino)
+} i2cDevice_t;
+
 
 
 /*
@@ -35,6 +100,33 @@
 // I2C bus scanner
 uint8_t i2c_scan(uint8_t start);
 
+// I2C known addresses enumeration
+void i2c_bitmap_add( uint8_t *bitmap, const uint8_t *addrs, uint8_t nb );
+bool i2c_probe( uint8_t adr, uint8_t tries=I2C_PROBE_TRIES );
+uint8_t i2c_enumerate( const uint8_t *known, uint8_t *found, uint8_t maxFound, bool fullSweep=false );
+
+// I2C devices inventory (flash)
+bool i2c_inventory_load( i2cDevice_t *devices, uint8_t *nb, uint8_t *enabled );
+bool i2c_inventory_save( const i2cDevice_t *devices, uint8_t nb, uint8_t enabled );
+
+// I2C transaction layer
+bool i2c_begin( uint8_t sda, uint8_t scl, uint32_t clock=I2C_DEFL_CLOCK );
+void i2c_setClock( uint8_t adr, uint32_t clock );
+bool i2c_recover( void );
+i2cStatus_t i2c_transfer( uint8_t adr, const uint8_t *wbuf, uint8_t wlen,
+                          uint8_t *rbuf=nullptr, uint8_t rlen=0, uint8_t *rcount=nullptr,
+                          uint16_t pauseMs=0, bool repeatStart=false, uint8_t retries=I2C_RETRIES );
+uint8_t i2c_nbDevices( void );
+void i2c_status( uint8_t idx, JsonObject root );
+
+/* [oct.26] bus lines shared with another transport (e.g neOClock's TM1637
+ * CLK on SCL): transactions raise _i2c_busy then wait for the other transport
+ * to reach a frame boundary (idle callback), the latter defers its frames
+ * while _i2c_busy is set (read it from ISRs) */
+typedef bool (*i2cSharedIdle_t)( void );
+void i2c_share( i2cSharedIdle_t idle );   // nullptr ==> bus not shared
+extern volatile bool _i2c_busy;
+
 // I2C synchronous functions
 int i2c_quick_write( uint8_t adr );
 
@@ -9,6 +9,7 @@
  * - ...
  * 
  * ---
+ * oct.26  main loop delay that ISRs and modules may cut short
  * F.Thiebolt   aug.21  extended checkCLEAR to 5000ms (some ESP32 have huge
  *                      internal capacitor enabled@starup ?!?!)
  * F.Thiebolt   apr.21  removed DNS related includes
@@ -58,6 +59,11 @@
  */
 bool _WMsaveAddonConfigFlag = false;
 
+// main loop early wakeup
+static volatile bool _loopWakeup = false;
+static bool _loopDeadlineSet = false;
+static unsigned long _loopDeadline = 0;
+
 
 
 /* ----------------------------------------------------------------------------
@@ -622,3 +628,37 @@ void neOSensor_reboot( void ) {
   delay(5000);
 }
 
+
+// --- main loop pacing -------------------------------------------------------
+
+/*
+ * request main loop to run as soon as possible
+ * Note: may get called from an ISR
+ */
+void ICACHE_RAM_ATTR wakeupLoop( void ) {
+  _loopWakeup = true;
+}
+
+/*
+ * request main loop to run no later than ms from now
+ */
+void wakeupLoopIn( unsigned long ms ) {
+  unsigned long _deadline = millis() + ms;
+  if( _loopDeadlineSet and (long)(_deadline - _loopDeadline) >= 0 ) return;
+  _loopDeadline = _deadline;
+  _loopDeadlineSet = true;
+}
+
+/*
+ * main loop delay, cut short upon wakeup request
+ */
+void loopDelay( unsigned long ms ) {
+  unsigned long _start = millis();
+  while( (millis() - _start) < ms ) {
+    if( _loopWakeup ) break;
+    if( _loopDeadlineSet and (long)(millis() - _loopDeadline) >= 0 ) break;
+    delay( LOOP_WAKEUP_GRANULARITY );
+  }
+  _loopWakeup = false;
+  _loopDeadlineSet = false;
+}
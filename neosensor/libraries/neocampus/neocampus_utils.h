@@ -9,6 +9,7 @@
  * - ...
  * 
  * ---
+ * oct.26  main loop pacing (wakeupLoop, loopDelay)
  * F.Thiebolt   aug.20  probably already a lot of mods from initial release ...
  * Thiebolt F. July 17  initial release
  * 
@@ -47,6 +48,9 @@ extern bool _need2reboot;
 #define WM_CONFIG_PORTAL_TIMEOUT        300   // seconds config portail will stay active
 #define WM_CONNECTION_ATTEMPT_TIMEOUT   90    // will wait up to xxs for connecting to the specified SSID
 
+// --- main loop pacing -------------------------------------------------------
+#define LOOP_WAKEUP_GRANULARITY         5     // ms: main loop delay checks for wakeup requests at this pace
+
 
 
 /* ----------------------------------------------------------------------------
@@ -92,4 +96,15 @@ void neOSensor_reboot( void );
 // hex dump of a buffer
 void hex_dump( const char *buf, size_t bufsize, bool ascii=false );
 
+// --- main loop pacing -------------------------------------------------------
+
+// request main loop to run as soon as possible (ISR safe)
+void ICACHE_RAM_ATTR wakeupLoop( void );
+
+// request main loop to run no later than ms from now
+void wakeupLoopIn( unsigned long ms );
+
+// main loop delay, cut short upon wakeup request
+void loopDelay( unsigned long ms );
+
 #endif /* _NEOCAMPUS_UTILS_H */
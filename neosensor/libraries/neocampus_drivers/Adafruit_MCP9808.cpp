@@ -15,6 +15,9 @@
 
 	@section  HISTORY
 
+    oct.26  fast I2C clock only once identity is checked
+    oct.26  alert mode: read upon ALERT line (or Ta flags) only
+    oct.26  400kHz I2C clock
     dec.18  F.Thiebolt  added I2C addr range for 0x48->4F
                         adapted for neOCampus
     v1.0 - First release
@@ -76,6 +79,7 @@ boolean Adafruit_MCP9808::is_device( uint8_t a ) {
 Adafruit_MCP9808::Adafruit_MCP9808( void ) : generic_driver() {
   _i2caddr = INVALID_I2CADDR;
   _resolution = MCP9808_DEFL_RESOLUTION;
+  _band = MCP9808_ALERT_BAND;
 }
 
 /**************************************************************************/
@@ -93,6 +97,10 @@ boolean Adafruit_MCP9808::begin( uint8_t addr=INVALID_I2CADDR) {
   // check device identity
   if( !_check_identity(_i2caddr) ) return false;
 
+  // fast mode capable device
+  // [oct.26] only once identified: another device may sit at this address
+  i2c_setClock( _i2caddr, I2C_FAST_CLOCK );
+
   /* set config:
    * - disable all alerts, hysteresis, critical threshold and so on
    * - set continuous conversions
@@ -111,6 +119,8 @@ boolean Adafruit_MCP9808::begin( uint8_t addr=INVALID_I2CADDR) {
  */
 void Adafruit_MCP9808::powerOFF( void )
 {
+  // alert mode: continuous conversions
+  if( _eventMode() ) return;
   _shutdown_wake(1);
 }
 
@@ -157,6 +167,38 @@ bool Adafruit_MCP9808::setResolution( mcp9808Resolution_t res ) {
   return true;
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Alert mode: continuous conversions, sensor only gets read once
+            Ta went outside [last-band, last+band]; either upon ALERT line
+            falling edge or through Ta register flags (no ALERT line).
+    @note   no significant change means no I2C traffic with an ALERT line
+*/
+/**************************************************************************/
+boolean Adafruit_MCP9808::setAlertMode( uint8_t gpio, float band ) {
+  _band = ( band < 0.0625f ? 0.0625f : band );
+
+  bool _alertLine = _attachINT( gpio );
+  if( !_alertLine ) {
+    // Ta flags poll
+    _event = true;
+    _intFired = true;
+  }
+
+  // critical limit out of reach, continuous conversions
+  write16(_i2caddr, MCP9808_REG_CRIT_TEMP, MCP9808_TCRIT_MAX);
+  write16(_i2caddr, MCP9808_REG_CONFIG, ( _alertLine ? MCP9808_ALERT_CONFIG : 0x0 ));
+  // ... limits get armed upon first read
+
+  if( _alertLine ) {
+    log_info(F("\n[MCP9808] alert mode with ALERT on gpio ")); log_info(gpio,DEC); log_flush();
+  }
+  else {
+    log_info(F("\n[MCP9808] alert mode with Ta flags poll")); log_flush();
+  }
+  return _alertLine;
+}
+
 /**************************************************************************/
 /*! 
     @brief  Reads the 16-bit temperature register and returns the Centigrade
@@ -168,13 +210,20 @@ boolean Adafruit_MCP9808::acquire( float *pval )
 {
   if( !pval ) return false;
 
-  // read configuration register ...
-  uint16_t conf_register = read16(_i2caddr, MCP9808_REG_CONFIG);
+  uint16_t conf_register = 0;
+  if( _eventMode() ) {
+    // alert mode: continuous conversions
+    _intFired = false;
+  }
+  else {
+    // read configuration register ...
+    conf_register = read16(_i2caddr, MCP9808_REG_CONFIG);
   
-  // ... and check if active (i.e continuous conversions active)
-  if( conf_register & MCP9808_REG_CONFIG_SHUTDOWN ) {
-    powerON();
-    delay(_integrationTime);
+    // ... and check if active (i.e continuous conversions active)
+    if( conf_register & MCP9808_REG_CONFIG_SHUTDOWN ) {
+      powerON();
+      delay(_integrationTime);
+    }
   }
   
   // Ta conversion
@@ -187,6 +236,9 @@ boolean Adafruit_MCP9808::acquire( float *pval )
   // ... and finally restore previous power state if needed
   if( conf_register & MCP9808_REG_CONFIG_SHUTDOWN ) powerOFF();
 
+  // alert mode: limits around new value (sensor's own temperature)
+  if( _eventMode() ) _setLimits( Ta );
+
   /* [Mar.18] temperature correction for last i2c sensor ... the one
    * supposed to get tied to the main board. */
 #ifdef TEMPERATURE_CORRECTION_LASTI2C
@@ -233,6 +285,32 @@ bool Adafruit_MCP9808::_check_identity( uint8_t a ) {
   return true;
 }
 
+/*
+ * Alert mode without ALERT line: Ta register flags tell whether
+ * temperature went outside limits
+ */
+bool Adafruit_MCP9808::_eventPoll( void ) {
+  uint16_t _raw = read16(_i2caddr, MCP9808_REG_AMBIENT_TEMP);
+  return ( _raw & (MCP9808_REG_AMBIENT_UPPER | MCP9808_REG_AMBIENT_LOWER) ) != 0;
+}
+
+/*
+ * Alert mode: T_UPPER / T_LOWER limits around temperature
+ */
+void Adafruit_MCP9808::_setLimits( float t ) {
+  write16(_i2caddr, MCP9808_REG_UPPER_TEMP, _toLimit( t + _band, true ));
+  write16(_i2caddr, MCP9808_REG_LOWER_TEMP, _toLimit( t - _band, false ));
+}
+
+/*
+ * Limit register: 13 bits two's complement, 0.25°C steps (i.e 2 LSBs unused)
+ * upper limit gets rounded up, lower limit rounded down
+ */
+uint16_t Adafruit_MCP9808::_toLimit( float t, bool upper ) {
+  int16_t _v = (int16_t)( upper ? ceil( t * 4.0f ) : floor( t * 4.0f ) );
+  return (uint16_t)( _v * 4 ) & 0x1FFC;
+}
+
 //*************************************************************************
 // Set Sensor to Shutdown-State or wake up (Conf_Register BIT8)
 // 1= shutdown / 0= wake up
@@ -13,6 +13,7 @@
 
 	@section  HISTORY
 
+    2026  - alert mode: limits around last value, read upon ALERT line or Ta flags
     2017  - adapter for neOCampus
 	  v1.2  - Add support for low power operations
     v1.1  - Added list of possible I2C address
@@ -59,6 +60,11 @@
 #define MCP9808_REG_CONFIG_ALERTPOL     0x0002
 #define MCP9808_REG_CONFIG_ALERTMODE    0x0001
 
+// Ta register flags
+#define MCP9808_REG_AMBIENT_CRIT        0x8000  // Ta >= T_CRIT
+#define MCP9808_REG_AMBIENT_UPPER       0x4000  // Ta > T_UPPER
+#define MCP9808_REG_AMBIENT_LOWER       0x2000  // Ta < T_LOWER
+
 #define MCP9808_MANUFACTURER_ID         0x0054  // 16 bits value
 #define MCP9808_DEVICE_ID               0x04    // 8 bits value (next 8bits are revision number)
 
@@ -78,6 +84,14 @@ typedef enum {
 // set MCP9808 default resolution
 #define MCP9808_DEFL_RESOLUTION         MCP9808_RESOLUTION_0125DEG
 
+/*
+ * Alert mode: T_UPPER / T_LOWER limits around last value (0.25°C steps),
+ * ALERT output in comparator mode (active low), T_CRIT out of reach
+ */
+#define MCP9808_ALERT_BAND              DATA_SENDING_VARIATION_THRESHOLD  // °C, limits get rounded outwards
+#define MCP9808_ALERT_CONFIG            MCP9808_REG_CONFIG_ALERTCTRL      // continuous, comparator, active low
+#define MCP9808_TCRIT_MAX               0x07FC  // +127.75°C
+
 
 
 /*
@@ -89,6 +103,7 @@ class Adafruit_MCP9808 : public generic_driver {
     
     boolean begin( uint8_t );       // start with an i2c address
     bool setResolution( mcp9808Resolution_t );
+    boolean setAlertMode( uint8_t gpio, float band=MCP9808_ALERT_BAND ); // false means Ta flags poll (no ALERT line)
     void powerON( void );       // switch ON
     void powerOFF( void );      // switch OFF
 
@@ -100,7 +115,7 @@ class Adafruit_MCP9808 : public generic_driver {
     // --- static methods / constants -----------------------
     
     // list of possibles I2C addrs
-    static const uint8_t i2c_addrs[];
+    static const uint8_t i2c_addrs[16];
 
     // device detection
     static boolean is_device( uint8_t );
@@ -110,11 +125,15 @@ class Adafruit_MCP9808 : public generic_driver {
     uint8_t _i2caddr;
     mcp9808Resolution_t _resolution;
     uint8_t _integrationTime; // time to integrate a measure (for non continuous mode)
+    float _band;              // alert mode: limits = last value +/- band
     static const char *units;
 
     // methods ...
     static bool _check_identity( uint8_t );   // check device is what we expect!
     void _shutdown_wake( uint8_t );
+    bool _eventPoll( void );                  // alert mode without ALERT line: Ta flags
+    void _setLimits( float );
+    static uint16_t _toLimit( float, bool );
 };
 
 #endif /* _ADAFRUIT_MCP9808_H */
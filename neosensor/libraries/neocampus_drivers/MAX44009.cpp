@@ -13,6 +13,9 @@
 
 	@section  HISTORY
 
+    2026-Oct  - lux formula: 8 bits mantissa (4 MSBs were lost) and
+                0.045 lux LSB (was 0.72), conversion in toLux()
+    2026-Oct  - event mode with threshold window interrupt
     2020-Nov  - F.Thiebolt    integration
     2020-Oct  - L.Jeanmougin  Initial release
 */
@@ -136,6 +139,30 @@ boolean MAX44009::setIntegration( max44009IntegrationT_t ms=max44009IntegrationT
 }
 
 
+/**************************************************************************/
+/*! 
+    @brief  Event mode: sensor only gets read when its INT line fires
+    @note   no INT gpio (or no interrupt on it) means polling
+*/
+/**************************************************************************/
+boolean MAX44009::setEventMode( uint8_t gpio, uint8_t percent ) {
+
+  _windowPercent = ( (percent==0 or percent>=100) ? DEFL_EVENT_WINDOW_PERCENT : percent );
+
+  if( !_attachINT( gpio ) ) {
+    write8( _i2caddr, static_cast<uint8_t>(max44009Regs_t::interrupt_enable), MAX44009_INTR_DISABLE );
+    log_info(F("\n[MAX44009] no INT line, polling mode")); log_flush();
+    return false;
+  }
+
+  // lux needs to stay outside window for a while (i.e replaces stability counter)
+  write8( _i2caddr, static_cast<uint8_t>(max44009Regs_t::threshold_timer), MAX44009_EVENT_TIMER );
+  // ... window gets armed upon first read
+  log_info(F("\n[MAX44009] event mode with INT on gpio ")); log_info(gpio,DEC); log_flush();
+  return true;
+}
+
+
 /**************************************************************************/
 /*! 
     @brief  Read registers and convert returned lux value to float
@@ -143,8 +170,17 @@ boolean MAX44009::setIntegration( max44009IntegrationT_t ms=max44009IntegrationT
 /**************************************************************************/
 boolean MAX44009::acquire( float *pval )
 {
-  // retrieve LUMINOSITY
-  return _getLux( pval );
+  if( !_eventMode() ) return _getLux( pval );
+
+  // event mode: clear interrupt (status clears on read) then re-arm window
+  _intFired = false;
+  read8( _i2caddr, static_cast<uint8_t>(max44009Regs_t::interrupt_status) );
+  if( !_getLux( pval ) ) {
+    _intFired = true;
+    return false;
+  }
+  _setWindow( *pval );
+  return true;
 }
 
 
@@ -184,6 +220,39 @@ bool MAX44009::_check_identity( uint8_t a ) {
 }
 
 
+/*
+ * Event mode: INT gets raised once lux is outside [lux-x%, lux+x%]
+ * for more than MAX44009_EVENT_TIMER
+ */
+void MAX44009::_setWindow( float lux ) {
+  float _delta = ( lux * _windowPercent ) / 100.0f;
+
+  write8( _i2caddr, static_cast<uint8_t>(max44009Regs_t::threshold_upper), _luxToThreshold( lux + _delta, true ) );
+  write8( _i2caddr, static_cast<uint8_t>(max44009Regs_t::threshold_lower), _luxToThreshold( lux - _delta, false ) );
+  write8( _i2caddr, static_cast<uint8_t>(max44009Regs_t::interrupt_enable), MAX44009_INTR_ENABLE );
+}
+
+
+/*
+ * Threshold register: exponent + 4 MSBs of mantissa
+ * - upper threshold: 4 LSBs of mantissa are 1111 ==> rounding up
+ * - lower threshold: 4 LSBs of mantissa are 0000 ==> rounding down
+ */
+uint8_t MAX44009::_luxToThreshold( float lux, bool upper ) {
+  if( lux <= 0.0f ) return 0x00;
+
+  uint32_t _m = (uint32_t)( lux / MAX44009_LUX_LSB ) + ( upper ? 1 : 0 );
+  uint8_t _e = 0;
+  while( _m > 0xFF and _e < 14 ) {
+    _m = ( upper ? (_m + 1) >> 1 : _m >> 1 );
+    _e++;
+  }
+  if( _m > 0xFF ) return 0xEF;    // max lux
+
+  return ( _e << 4 ) | ( _m >> 4 );
+}
+
+
 /**************************************************************************/
 /*! 
     @brief  Read registers and convert returned lux value to float
@@ -219,23 +288,31 @@ boolean MAX44009::_getLux( float *pval )
   // switvh OFF device
   powerOFF();
 
-  /*
-   * LUX = 2^exp*mantissa*0.72
-   */
-  uint8_t exposant, mantisse;
-  
+  return toLux( buf[0], buf[1], pval );
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  Convert lux registers to lux
+    @note   LUX = 2^exp * mantissa * 0.045 with an 8 bits mantissa: 4 MSBs
+            from lux_upper, 4 LSBs from lux_lower (datasheet p.9)
+*/
+/**************************************************************************/
+boolean MAX44009::toLux( uint8_t upper, uint8_t lower, float *pval )
+{
   // exposant
-  exposant = buf[0] >> 4;
+  uint8_t exposant = upper >> 4;
   if( exposant >= (uint8_t)0x0F ) {
     log_debug(F("\n[MAX44009] overrange exposant !")); log_flush();
     return false;
   }
 
-  // mantisse
-  mantisse = (buf[0] & 0xF0)<<4 | (buf[1]&0x0F);
+  // mantisse: 4 MSBs from lux_upper, 4 LSBs from lux_lower
+  uint8_t mantisse = (upper & 0x0F)<<4 | (lower & 0x0F);
 
   // LUX computation
-  *pval = (float)(pow(2,exposant) * 0.72 * mantisse);
+  *pval = (float)(1UL << exposant) * MAX44009_LUX_LSB * mantisse;
 
   return true;
 }
@@ -13,6 +13,7 @@
 
 	@section  HISTORY
 
+    2026-Oct  - event mode with threshold window interrupt, fixed lux mantissa
     2020-Nov  - F.Thiebolt    integration
     2020-Oct  - L.Jeanmougin  Initial release
 */
@@ -86,6 +87,14 @@ enum class max44009IntegrationT_t : uint8_t {
 #define MAX44009_REG_THRES_TIMER_DEFL   0xFF    // [POR] threshold timer register default value
 
 
+/*
+ * Event mode: lux window around last value
+ * Note: thresholds feature a 4 bits mantissa, window gets widened to match
+ */
+#define MAX44009_EVENT_TIMER        20      // x100ms lux ought to stay outside window to raise INT
+#define MAX44009_LUX_LSB            (float)(0.045)  // lux = 2^exponent x mantissa x 0.045
+
+
 
 /*
  * Class
@@ -107,19 +116,25 @@ class MAX44009 : public generic_driver {
 
     // MAX44009 specific methods
     boolean setIntegration( max44009IntegrationT_t );
+    boolean setEventMode( uint8_t gpio, uint8_t percent=DEFL_EVENT_WINDOW_PERCENT );
 
     // --- static methods / constants -----------------------
     
     // list of possibles I2C addrs
-    static const uint8_t i2c_addrs[];
+    static const uint8_t i2c_addrs[2];
 
     // device detection
     static boolean is_device( uint8_t );
 
+    // lux registers (upper, lower) to lux, false upon overrange
+    static boolean toLux( uint8_t, uint8_t, float* );
+
   private:
     // --- private methods
     boolean _getLux( float* );
     static bool _check_identity( uint8_t );   // check device is what we expect!
+    void _setWindow( float );                 // event mode: INT raised outside [lux-x%, lux+x%]
+    static uint8_t _luxToThreshold( float, bool );
 
     // --- private attributes
     uint8_t _i2caddr;
@@ -114,7 +114,7 @@ class MCP47FEB : public driver_dac {
     // --- static methods / constants -----------------------
     
     // list of possibles I2C addrs
-    static const uint8_t i2c_addrs[];
+    static const uint8_t i2c_addrs[4];
 
     // device detection
     static boolean is_device( uint8_t );
@@ -14,6 +14,10 @@
 
 	@section  HISTORY
 
+    2026-Oct      - sized i2c_addrs (sizeof from the sketch)
+    2026-Oct      - shared Sensirion transport (CRC, commands deadlines)
+    2026-Oct      - (low power) periodic measurement with data ready
+                    polling, per i2c address device shared by CO2, T and RH
     2022-March    - F.Thiebolt Initial release
     
 */
@@ -34,25 +38,28 @@
  * Definitions
  */
 /* SCD4x sensor send back both CO2, T and RH at the same time, but since
- * we'll have three instances of this class ==> we implement a cache to
- * avoid reading the sensor multiple times */
-#define SCD4X_SENSOR_CACHE_MS       5000  // ms caches values validity
-
-// Enable CRC lookup table (regular computation otherwise)
-#ifndef SCD4X_CRC_LOOKUP_TABLE
-#define SCD4X_CRC_LOOKUP_TABLE    1
-#endif
+ * we'll have three instances of this class ==> [oct.26] they share a
+ * device (per i2c address) that holds last measure.
+ * Sensor measures on its own (periodic mode), get_data_ready_status gets
+ * polled and measure is read only once available: loop never waits for
+ * a conversion. */
+#define SCD4X_DEVICES_MAX           2       // distinct i2c addresses
+#define SCD4X_I2C_CLOCK             100000  // Hz, standard mode only (datasheet)
+#define SCD4X_CMD_MS                1       // ms, most commands execution time
+#define SCD4X_STOP_MS               500     // ms, stop_periodic_measurement execution time
+#define SCD4X_POLL_MS               1000    // ms, min delay between two data ready polls
+#define SCD4X_STALE_PERIODS         3       // periods without measure ==> restart measurements
 
 /* scd4x commands
  * Note:
  * - 1ms min. delay between two commands
- * - most commands need a 1ms execution time
+ * - most commands need a 1ms execution time (sensirion_i2c deadlines)
  * - CO2, temp and humidity are measured and sent in a single 9bytes frame
  *      16bits C02 + CRC + 16bits T + CRC + 16bits RH + CRC
  * - every 16bits frames are CRC protected
  * - CRC8 0x31, initial=0xFF, final xor=0x00 for 16bits data (first is )
  */
-enum class sht3xCmd_t : uint16_t {
+enum class scd4xCmd_t : uint16_t {
 
   // basic commands
   start_periodic_measurement              = 0x21b1, // 5000ms measurement delay
@@ -72,7 +79,7 @@ enum class sht3xCmd_t : uint16_t {
   get_automatic_self_calibration_enabled  = 0x2313, // execution time: 1ms
   
   // low-power operations
-  start_low_power_periodoc_measurement    = 0x21ac, // 30s measurement delay
+  start_low_power_periodic_measurement    = 0x21ac, // 30s measurement delay
   get_data_ready_status                   = 0xe4b8, // execution time: 1ms
   // stop_periodic_measurement to stop low_power periodic measurement
 
@@ -88,6 +95,8 @@ enum class sht3xCmd_t : uint16_t {
   measure_single_shot_rht_only            = 0x2196, // execution time: 50ms
 };
 
+#define SCD4X_DATA_READY_MASK   0x07FF  // get_data_ready_status: 0 means no measure
+
 // type of measure
 enum class scd4xMeasureType_t : uint8_t {
   co2           = 0x00,
@@ -95,6 +104,29 @@ enum class scd4xMeasureType_t : uint8_t {
   temperature   = 0x20
 };
 
+// [oct.26] measurement mode
+enum class scd4xMode_t : uint8_t {
+  periodic,             // a measure every 5s
+  low_power_periodic    // a measure every 30s
+};
+#ifndef SCD4X_DEFL_MODE
+#define SCD4X_DEFL_MODE         scd4xMode_t::low_power_periodic
+#endif /* SCD4X_DEFL_MODE */
+
+// [oct.26] device (i.e i2c address) shared by CO2, T and RH instances
+typedef struct {
+  uint8_t addr;
+  scd4xMode_t mode;
+  bool started;               // periodic measurement running
+  bool valid;                 // a measure has been read
+  unsigned long startMs;      // ms periodic measurement start
+  unsigned long lastMsRead;   // ms last measure read
+  unsigned long lastMsPoll;   // ms last data ready poll
+  uint16_t co2;               // raw values
+  uint16_t t;
+  uint16_t rh;
+} scd4xDevice_t;
+
 
 
 /*
@@ -105,13 +137,14 @@ class SCD4x : public generic_driver {
     SCD4x( scd4xMeasureType_t );
   
     boolean begin( uint8_t );   // start with an i2c address
+    bool setMode( scd4xMode_t );  // periodic or low power periodic measurement
     void powerON( void );       // switch ON
     void powerOFF( void );      // switch OFF
 
     // send back sensor's value, units and I2C addr
     boolean acquire( float* );
     const char *sensorUnits( uint8_t=0 );
-    String subID( uint8_t=0 ) { return String(_i2caddr); };
+    String subID( uint8_t=0 ) { return ( _measureType==scd4xMeasureType_t::co2 ? String(F("CO2")) : String(_i2caddr) ); };
     
     // read sensor's values
     boolean getCO2( float* );   // retroieve co2
@@ -121,7 +154,7 @@ class SCD4x : public generic_driver {
     // --- static methods / constants -----------------------
 
     // list of possibles I2C addrs
-    static const uint8_t i2c_addrs[];
+    static const uint8_t i2c_addrs[1];
 
     // device detection
     static boolean is_device( uint8_t );
@@ -129,10 +162,10 @@ class SCD4x : public generic_driver {
   private:
     // -- private methods
     bool _readSensor( uint16_t* );                // low-level function to read value registers
-    static void sw_reset( uint8_t );              // reset sensor via software reset procedure
-    static bool crc_check( uint8_t[], uint8_t, uint8_t );  // data array, nb_bytes, checksum
+    bool _poll( void );                           // read measure once available
+    void _start( void );                          // start (low power) periodic measurement
     static bool _check_identity( uint8_t );       // check device is what we expect!
-    static void _writeCmd( uint8_t, uint16_t );   // write I2C command
+    static scd4xDevice_t *_device( uint8_t, bool=false ); // device at i2c addr (optionally created)
 
     // --- private attributes
     uint8_t _i2caddr;
@@ -140,19 +173,9 @@ class SCD4x : public generic_driver {
     static const char *units_co2;
     static const char *units_temp;
     static const char *units_rh;
-    uint16_t _integrationTime;  // ms time to integrate a measure
-                                /* CO2, TEMP and RH are read at the same time ==> hence we store them
-                                   as shared attributes across all instances */
-    static unsigned long _lastMsRead;   // last time data have been read (elapsed ms from beginning)
-    static uint16_t _co2_sensor;  // shared across all instances
-    static uint16_t _t_sensor;    // shared across all instances
-    static uint16_t _rh_sensor;   // shared across all instances
-
-    // CRC computation
-    static const uint8_t _crc8_polynom;    // crc P(x)=x^8+x^5+x^4+1 (0x31) 1.00110001, init=0xFF
-#ifdef SCD4X_CRC_LOOKUP_TABLE
-    static const uint8_t _crc8_table[256];
-#endif /* SCD4X_CRC_LOOKUP_TABLE */
+    scd4xDevice_t *_dev;        // shared device: CO2, TEMP and RH are read at the same time
+    static scd4xDevice_t _devices[SCD4X_DEVICES_MAX];
+    static uint8_t _nbDevices;
 };
 
 #endif /* _SCD4X_H_ */
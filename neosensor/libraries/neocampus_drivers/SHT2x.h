@@ -13,6 +13,7 @@
 
 	@section  HISTORY
 
+    2026-Oct    - shared Sensirion transport (CRC, commands deadlines)
     2020-May    - F.Thiebolt Initial release
     
 */
@@ -33,8 +34,8 @@
  * Definitions
  */
 
-// Enable CRC lookup table (regular computation otherwise)
-#define SHT2X_CRC_LOOKUP_TABLE    1
+// CRC8 0x31 initial value (sensirion_i2c)
+#define SHT2X_CRC8_INIT           0x00
 
 /* enable UUID's CRC check
  * WARNING: some fakes devices does not support it!
@@ -87,6 +88,7 @@ enum class sht2xIntegrationT_t : uint8_t {
 };
 
 #define SHT2X_INTEGRATION_TIME_CTE    5 // additionnal ms delay to all timings (total <= 255 ---uint8_t)
+#define SHT2X_RESET_MS                50  // ms, soft reset execution time
 
 
 
@@ -114,7 +116,7 @@ class SHT2x : public generic_driver {
     // --- static methods / constants -----------------------
     
     // list of possibles I2C addrs
-    static const uint8_t i2c_addrs[];
+    static const uint8_t i2c_addrs[1];
 
     // device detection
     static boolean is_device( uint8_t );
@@ -134,12 +136,6 @@ class SHT2x : public generic_driver {
     static const char *_t_units;
     static const char *_rh_units;
     uint8_t _integrationTime; // ms time to integrate a measure (for non continuous mode)
-
-    // CRC computation
-    static const uint8_t _crc8_polynom;     // crc P(x)=x^8+x^5+x^4+1 (0x31) 1.00110001
-#ifdef SHT2X_CRC_LOOKUP_TABLE
-    static const uint8_t _crc8_table[256];
-#endif /* SHT2X_CRC_LOOKUP_TABLE */
 };
 
 #endif /* _SHT2X_H_ */
@@ -15,6 +15,12 @@
 
 	@section  HISTORY
 
+    2026-Oct    - per device (i2c addr) mode and cached values: a second
+                  chip used to inherit the first one's mode and measures
+    2026-Oct    - fast I2C clock only once identity is checked
+    2026-Oct    - shared Sensirion transport (CRC, commands deadlines)
+    2026-Oct    - optional periodic acquisition mode (with ART)
+    2026-Oct    - 400kHz I2C clock
     2020-May    - F.Thiebolt Initial release (UUID's CRC check diasbled)
     
 */
@@ -30,6 +36,7 @@
 // [may.20] debug
 #include "neocampus_utils.h"
 
+#include "sensirion_i2c.h"
 
 #include "SHT3x.h"
 
@@ -78,6 +85,7 @@ SHT3x::SHT3x( sht3xMeasureType_t kindness  ) : generic_driver() {
   _i2caddr = -1;
   _measureType = kindness;
   _resolution = SHT3X_DEFL_RESOLUTION;
+  _dev = nullptr;
 }
 
 
@@ -85,10 +93,19 @@ SHT3x::SHT3x( sht3xMeasureType_t kindness  ) : generic_driver() {
 const char *SHT3x::_t_units = "celsius";
 const char *SHT3x::_rh_units = "%r.H.";
 
-/* declare others static vars */
-unsigned long SHT3x::_lastMsRead  = 0;
-uint16_t SHT3x::_t_sensor   = (uint16_t)(-1);
-uint16_t SHT3x::_rh_sensor  = (uint16_t)(-1);
+/* [oct.26] devices shared by temperature and humidity instances */
+sht3xDevice_t SHT3x::_devices[SHT3X_DEVICES_MAX];
+uint8_t SHT3x::_nbDevices = 0;
+
+/* [oct.26] periodic mode commands: high, medium and low repeatability */
+const uint16_t SHT3x::_periodic_cmds[5][3] = {
+  { 0x2032, 0x2024, 0x202F },   // 0.5 mps
+  { 0x2130, 0x2126, 0x212D },   // 1 mps
+  { 0x2236, 0x2220, 0x222B },   // 2 mps
+  { 0x2334, 0x2322, 0x2329 },   // 4 mps
+  { 0x2737, 0x2721, 0x272A }    // 10 mps
+};
+const uint16_t SHT3x::_periodic_ms[6] = { 2000, 1000, 500, 250, 100, 250 };
 
 
 /**************************************************************************/
@@ -125,6 +142,17 @@ boolean SHT3x::begin( uint8_t addr=-1) {
   // check device identity
   if( !_check_identity(_i2caddr) ) return false;
 
+  // fast mode capable device
+  // [oct.26] only once identified: another device may sit at this address
+  i2c_setClock( _i2caddr, I2C_FAST_CLOCK );
+
+  // [oct.26] device shared by temperature and humidity instances
+  _dev = _device( _i2caddr, true );
+  if( _dev==nullptr ) {
+    log_error(F("\n[SHT3x] too many devices ?!?")); log_flush();
+    return false;
+  }
+
   /* set config:
    * - nothing to configure
    * - reset ?
@@ -135,7 +163,14 @@ boolean SHT3x::begin( uint8_t addr=-1) {
 
   /* start lastmsg time measurement.
    * This way, we get sure to have at least a first acquisition! */
-  _lastMsRead = ULONG_MAX/2;
+  _dev->lastMsRead = ULONG_MAX/2;
+
+  /* [oct.26] acquisition mode (device is shared by temperature and humidity
+   * instances). Device may still be in periodic mode (e.g MCU reset) */
+  if( _dev->mode == sht3xMode_t::single_shot ) {
+    sensirion_command( _i2caddr, static_cast<uint16_t>(sht3xCmd_t::periodic_break) );
+  }
+  setMode( SHT3X_DEFL_MODE );
 
   return true;
 }
@@ -176,11 +211,92 @@ bool SHT3x::setResolution( sht3xResolution_t res ) {
   // add some constant to integration time ...
   _integrationTime+=(uint8_t)SHT3X_INTEGRATION_TIME_CTE;
 
+  // [oct.26] periodic mode: repeatability is part of the command
+  bool _changed = ( res != _resolution );
+  _resolution = res;
+  if( _changed and _dev and _dev->mode != sht3xMode_t::single_shot ) _startPeriodic();
+
   // finish :)
   return true;
 }
 
 
+/**************************************************************************/
+/*! 
+    @brief  [oct.26] Setups the HW: acquisition mode
+    @note   periodic mode: sensor measures on its own, values get fetched
+            without waiting for a conversion.
+*/
+/**************************************************************************/
+bool SHT3x::setMode( sht3xMode_t mode ) {
+
+  if( _dev==nullptr or mode > sht3xMode_t::art ) return false;
+  if( mode == _dev->mode ) return true;
+
+  // stop current periodic mode
+  if( _dev->mode != sht3xMode_t::single_shot ) {
+    sensirion_command( _i2caddr, static_cast<uint16_t>(sht3xCmd_t::periodic_break) );
+  }
+
+  _dev->mode = mode;
+  if( _dev->mode != sht3xMode_t::single_shot ) _startPeriodic();
+
+  log_debug(F("\n[SHT3x] acquisition mode set to ")); log_debug((uint8_t)_dev->mode,DEC); log_flush();
+  return true;
+}
+
+
+/*
+ * [oct.26] Periodic mode: send command according to mode and resolution
+ */
+void SHT3x::_startPeriodic( void ) {
+  uint16_t _cmd;
+  if( _dev->mode == sht3xMode_t::art )
+    _cmd = static_cast<uint16_t>(sht3xCmd_t::periodic_art);
+  else
+    _cmd = _periodic_cmds[(uint8_t)_dev->mode - 1][(uint8_t)_resolution];
+
+  sensirion_command( _i2caddr, _cmd );
+  _dev->periodicMs = millis();
+  _dev->lastMsRead = ULONG_MAX/2;    // no measure yet
+}
+
+
+/*
+ * [oct.26] Periodic mode: read out latest measure (both T and RH).
+ * Device NACKs the read if no measure is available since last fetch;
+ * cached values are then used till they get too old.
+ */
+bool SHT3x::_fetch( void ) {
+
+  // no new measure before a full period
+  if( (millis() - _dev->lastMsRead) < (unsigned long)_periodic_ms[(uint8_t)_dev->mode - 1] ) return true;
+
+  // T + RH, device NACKs if no new measure (hence no retries)
+  uint16_t _words[2];
+  sensirionStatus_t _res = sensirion_read_cmd( _i2caddr, static_cast<uint16_t>(sht3xCmd_t::fetch_data), _words, 2, 0, 0 );
+  if( _res == sensirionStatus_t::ok ) {
+    _dev->t = _words[0];
+    _dev->rh = _words[1];
+    _dev->lastMsRead = millis();
+    return true;
+  }
+  if( _res == sensirionStatus_t::crc_error ) {
+    log_error(F("\n[SHT3x] invalid CRC for fetched data ...")); log_flush();
+  }
+
+  // no fresh measure, cached values are still fine
+  if( (millis() - _dev->lastMsRead) < (unsigned long)(SHT3X_SENSOR_CACHE_MS) ) return true;
+
+  // sensor does not measure anymore (e.g reset) ?
+  if( (millis() - _dev->periodicMs) >= (unsigned long)(SHT3X_SENSOR_CACHE_MS) ) {
+    log_warning(F("\n[SHT3x] no measure in periodic mode ... restarting")); log_flush();
+    _startPeriodic();
+  }
+  return false;
+}
+
+
 /**************************************************************************/
 /*! 
     @brief  Reads the 16-bit temperature register and returns the Centigrade
@@ -235,8 +351,6 @@ boolean SHT3x::getRH( float *pval ) {
   
   while( res==false and retry-- ) {
     res = _readSensor( &val );
-    if( res == true ) break;
-    delay(1);  // 1ms demay between commands
   }
 
   if( res==false ) {
@@ -269,8 +383,6 @@ boolean SHT3x::getTemp( float *pval )
   
   while( res==false and retry-- ) {
     res = _readSensor( &val );
-    if( res == true ) break;
-    delay(1);  // 1ms demay between commands
   }
 
   if( res==false ) {
@@ -299,8 +411,7 @@ boolean SHT3x::getTemp( float *pval )
  */
 void SHT3x::sw_reset( uint8_t adr ) {
   log_debug(F("\n[SHT3x] SOFT RESET action started ..."));log_flush();
-  _writeCmd( adr, static_cast<uint16_t>(sht3xCmd_t::soft_reset) );
-  delay( 50 );
+  sensirion_command( adr, static_cast<uint16_t>(sht3xCmd_t::soft_reset), SHT3X_RESET_MS );
 }
 
 
@@ -312,8 +423,14 @@ void SHT3x::sw_reset( uint8_t adr ) {
  */
 bool SHT3x::_readSensor( uint16_t *pval ) {
 
+  if( _dev==nullptr ) return false;
+
+  // [oct.26] periodic mode: latest measure
+  if( _dev->mode != sht3xMode_t::single_shot ) {
+    if( not _fetch() ) return false;
+  }
   // do we need to acquire fresh sensors values ?
-  if( (millis() - _lastMsRead ) >= (unsigned long)(SHT3X_SENSOR_CACHE_MS) ) {
+  else if( (millis() - _dev->lastMsRead ) >= (unsigned long)(SHT3X_SENSOR_CACHE_MS) ) {
 
     // select proper command
     uint16_t _cmd;
@@ -327,41 +444,25 @@ bool SHT3x::_readSensor( uint16_t *pval ) {
     uint8_t _retry = 3;
     bool status = false;
     while( status == false and _retry-- ) {
-      // start acquisition command
-      _writeCmd( _i2caddr, _cmd );
-
-      // wait for integration
-      delay( _integrationTime );
-
-      // retrieve data:
-      //  MSB[T] + LSB[T] + CRC[T] + MSB[RH] + LSB[RH] + CRC[RH]
-      uint8_t buf[6];
-      if( readList_ll(_i2caddr, buf, sizeof(buf)) < sizeof(buf) ) {
-        log_error(F("\n[SHT2x] insufficient bytes answered"));log_flush();
-        yield();
+      // start acquisition command, data available after integration
+      sensirion_command( _i2caddr, _cmd, _integrationTime );
+
+      // retrieve data: T + RH words
+      uint16_t _words[2];
+      sensirionStatus_t _res = sensirion_read( _i2caddr, _words, 2 );
+      if( _res == sensirionStatus_t::i2c_error ) {
+        log_error(F("\n[SHT3x] insufficient bytes answered"));log_flush();
         sw_reset( _i2caddr );
         continue;
       }
-
-      // check first CRC ( TEMP )
-      if( not crc_check(buf,2,buf[2]) ) {
-        log_error(F("\n[SHT3x] invalid CRC for TEMP ...")); log_flush();
-        yield();
-        continue;
-      }
-
-      // check second CRC ( RH )
-      if( not crc_check(&buf[3],2,buf[5]) ) {
-        log_error(F("\n[SHT3x] invalid CRC for RH ...")); log_flush();
-        yield();
+      if( _res != sensirionStatus_t::ok ) {
+        log_error(F("\n[SHT3x] invalid CRC for T or RH ...")); log_flush();
         continue;
       }
 
       // both CRC are valid, let's grab the data
-      _t_sensor = buf[0] << 8;
-      _t_sensor |= buf[1];
-      _rh_sensor = buf[3] << 8;
-      _rh_sensor |= buf[4];
+      _dev->t = _words[0];
+      _dev->rh = _words[1];
 
       status = true;  // success
     }
@@ -372,7 +473,7 @@ bool SHT3x::_readSensor( uint16_t *pval ) {
     }
 
     // success ==> update last read
-    _lastMsRead = millis();
+    _dev->lastMsRead = millis();
   }
   else {
     log_debug(F("\n[SHT3x] using cached value for "));
@@ -386,77 +487,27 @@ bool SHT3x::_readSensor( uint16_t *pval ) {
   }
 
   // send back pointer to proper value
-  if( _measureType == sht3xMeasureType_t::temperature ) *pval = _t_sensor;
-  else *pval = _rh_sensor;
+  if( _measureType == sht3xMeasureType_t::temperature ) *pval = _dev->t;
+  else *pval = _dev->rh;
 
   return true;
 }
 
 
 /*
- * CRC related attributes
+ * [oct.26] device at i2c addr (optionally created)
  */
-const uint8_t SHT3x::_crc8_polynom = 0x31;
-
-#ifdef SHT3X_CRC_LOOKUP_TABLE
-// CRC8 lookup table
-const uint8_t SHT3x::_crc8_table[256] PROGMEM = {
-0x00,0x31,0x62,0x53,0xC4,0xF5,0xA6,0x97,0xB9,0x88,0xDB,0xEA,0x7D,0x4C,0x1F,0x2E,
-0x43,0x72,0x21,0x10,0x87,0xB6,0xE5,0xD4,0xFA,0xCB,0x98,0xA9,0x3E,0x0F,0x5C,0x6D,
-0x86,0xB7,0xE4,0xD5,0x42,0x73,0x20,0x11,0x3F,0x0E,0x5D,0x6C,0xFB,0xCA,0x99,0xA8,
-0xC5,0xF4,0xA7,0x96,0x01,0x30,0x63,0x52,0x7C,0x4D,0x1E,0x2F,0xB8,0x89,0xDA,0xEB,
-0x3D,0x0C,0x5F,0x6E,0xF9,0xC8,0x9B,0xAA,0x84,0xB5,0xE6,0xD7,0x40,0x71,0x22,0x13,
-0x7E,0x4F,0x1C,0x2D,0xBA,0x8B,0xD8,0xE9,0xC7,0xF6,0xA5,0x94,0x03,0x32,0x61,0x50,
-0xBB,0x8A,0xD9,0xE8,0x7F,0x4E,0x1D,0x2C,0x02,0x33,0x60,0x51,0xC6,0xF7,0xA4,0x95,
-0xF8,0xC9,0x9A,0xAB,0x3C,0x0D,0x5E,0x6F,0x41,0x70,0x23,0x12,0x85,0xB4,0xE7,0xD6,
-0x7A,0x4B,0x18,0x29,0xBE,0x8F,0xDC,0xED,0xC3,0xF2,0xA1,0x90,0x07,0x36,0x65,0x54,
-0x39,0x08,0x5B,0x6A,0xFD,0xCC,0x9F,0xAE,0x80,0xB1,0xE2,0xD3,0x44,0x75,0x26,0x17,
-0xFC,0xCD,0x9E,0xAF,0x38,0x09,0x5A,0x6B,0x45,0x74,0x27,0x16,0x81,0xB0,0xE3,0xD2,
-0xBF,0x8E,0xDD,0xEC,0x7B,0x4A,0x19,0x28,0x06,0x37,0x64,0x55,0xC2,0xF3,0xA0,0x91,
-0x47,0x76,0x25,0x14,0x83,0xB2,0xE1,0xD0,0xFE,0xCF,0x9C,0xAD,0x3A,0x0B,0x58,0x69,
-0x04,0x35,0x66,0x57,0xC0,0xF1,0xA2,0x93,0xBD,0x8C,0xDF,0xEE,0x79,0x48,0x1B,0x2A,
-0xC1,0xF0,0xA3,0x92,0x05,0x34,0x67,0x56,0x78,0x49,0x1A,0x2B,0xBC,0x8D,0xDE,0xEF,
-0x82,0xB3,0xE0,0xD1,0x46,0x77,0x24,0x15,0x3B,0x0A,0x59,0x68,0xFF,0xCE,0x9D,0xAC
-};
-
-// crc checksum verification
-bool SHT3x::crc_check( uint8_t data[], uint8_t nb_bytes, uint8_t checksum ) {
-	uint8_t crc = 0xff;
-  while( nb_bytes ) {
-    crc = pgm_read_byte_near(_crc8_table + (*data ^ crc));
-    data++;
-    nb_bytes--;
+sht3xDevice_t *SHT3x::_device( uint8_t adr, bool create ) {
+  for( uint8_t i=0; i < _nbDevices; i++ ) {
+    if( _devices[i].addr == adr ) return &_devices[i];
   }
-
-  if( (crc & 0xFF) != checksum ) return false;
- 	else return true;
-}
-#else
-// crc checksum verification
-bool SHT3x::crc_check( uint8_t data[], uint8_t nb_bytes, uint8_t checksum ) {
-	uint8_t crc = 0xff;
-  uint8_t byteCtr;
-
- 	//calculates 8-Bit checksum with given polynomial
-  for( byteCtr = nb_bytes; byteCtr; --byteCtr) {
- 	  crc ^= *data++;
- 	  for (uint8_t bit = 8; bit; --bit) {
-      crc = (crc & 0x80) ? (crc << 1) ^ _crc8_polynom : (crc << 1);
- 	  }
- 	}
-
- 	if (crc != checksum) return false;
- 	else return true;
-}
-#endif /* SHT3X_CRC_LOOKUP_TABLE */
-
-
-/*
- * Check that device identity is what we expect!
- */
-void SHT3x::_writeCmd( uint8_t a, uint16_t cmd ) {
-  write8( a, (uint8_t)(cmd>>8) , (uint8_t)(cmd&0xFF) );
-  delay(1); // 1ms min between i2c transactions
+  if( not create or _nbDevices >= SHT3X_DEVICES_MAX ) return nullptr;
+  sht3xDevice_t *_dev = &_devices[_nbDevices++];
+  memset( _dev, 0, sizeof(sht3xDevice_t) );
+  _dev->addr = adr;
+  _dev->mode = sht3xMode_t::single_shot;
+  _dev->lastMsRead = ULONG_MAX/2;
+  return _dev;
 }
 
 
@@ -469,28 +520,20 @@ bool SHT3x::_check_identity( uint8_t a ) {
   bool status = false;
 
   while( not status and _retry-- ) {
-    // cmd for read out status register
-    _writeCmd( a, static_cast<uint16_t>(sht3xCmd_t::get_status) );
-
-    // read answer (MSB + LSB + CRC)
-    uint8_t buf[3];
-    if( readList_ll(a, buf, sizeof(buf)) < sizeof(buf) ) {
+    // read out status register
+    uint16_t status_reg;
+    sensirionStatus_t _res = sensirion_read_cmd( a, static_cast<uint16_t>(sht3xCmd_t::get_status), &status_reg, 1 );
+    if( _res == sensirionStatus_t::i2c_error ) {
       log_error(F("\n[SHT3x] not enough bytes read !"));log_flush();
-      delay(1); // min time between commands
       sw_reset( a );
       continue;
     }
-
-    // check answer's CRC
-    if( not crc_check(buf, 2, buf[2]) ) {
+    if( _res != sensirionStatus_t::ok ) {
       log_error(F("\n[SHT3x] CRC check failed !"));log_flush();
-      delay(1); // min time between commands
       continue;
     }
-  
+
     // finally does status match our expectations
-    uint16_t status_reg = buf[0] << 8;
-    status_reg |= buf[1];
     if( (status_reg & SHT3X_STATUS_REG_MASK) != SHT3X_STATUS_REG_DEFL ) return false;
 
     status = true;
@@ -13,6 +13,9 @@
 
 	@section  HISTORY
 
+    2026-Oct    - per device (i2c addr) mode and cached values
+    2026-Oct    - shared Sensirion transport (CRC, commands deadlines)
+    2026-Oct    - optional periodic acquisition mode (with ART)
     2020-May    - F.Thiebolt Initial release
     
 */
@@ -37,18 +40,14 @@
  * avoid reading the sensors two times one for T then for RH */
 #define SHT3X_SENSOR_CACHE_MS       5000  // ms caches values validity
 
-// Enable CRC lookup table (regular computation otherwise)
-#ifndef SHT3X_CRC_LOOKUP_TABLE
-#define SHT3X_CRC_LOOKUP_TABLE    1
-#endif
-
 /* sht3x commands
  * Note:
- * - we won't make use of the 'Periodic Mode' features (i.e continuous measurement)
+ * - [oct.26] optional 'Periodic Mode' (i.e continuous measurement): sensor
+ *   measures on its own, we just fetch latest measure (no conversion wait)
  * - avoid stretch modes because measuremernt can take up to 16ms
  * - useless heater
  * - Repeatability is resolution
- * - 1ms min. delay between two commands
+ * - 1ms min. delay between two commands (sensirion_i2c deadlines)
  * - both temperature and humidity are measured and sent in a single 6bytes frame
  *      16bits T + CRC + 16bits RH + CRC
  * - every 16bits frames are CRC protected
@@ -66,6 +65,9 @@ enum class sht3xCmd_t : uint16_t {
   meas_highRes              = 0x2400,   // Measurement High Repeatability (resolution) WITHOUT clock stretching
   meas_medRes               = 0x240B,   // Measurement Medium Repeatability (resolution) WITHOUT clock stretching
   meas_lowRes               = 0x2416,   // Measurement Low Repeatability (resolution) WITHOUT clock stretching
+  periodic_art              = 0x2B32,   // Periodic Measurement with ART (accelerated response time, 4 mps)
+  fetch_data                = 0xE000,   // Periodic Mode: read out latest measure (NACK if none)
+  periodic_break            = 0x3093,   // stop Periodic Mode (back to single shot mode)
 };
 
 // status
@@ -94,6 +96,33 @@ enum class sht3xIntegration_t : uint8_t {
 };
 
 #define SHT3X_INTEGRATION_TIME_CTE    5 // additionnal ms delay to all timings (total <= 255 ---uint8_t)
+#define SHT3X_RESET_MS                50  // ms, soft reset execution time
+
+/* [oct.26] acquisition mode: single shot or periodic (mps = measures per second)
+ * Note: periodic mode draws more current (sensor measures continuously) */
+enum class sht3xMode_t : uint8_t {
+  single_shot   = 0,    // measure on demand (conversion wait)
+  mps_0_5,
+  mps_1,
+  mps_2,
+  mps_4,
+  mps_10,
+  art                   // accelerated response time (4 mps)
+};
+#ifndef SHT3X_DEFL_MODE
+#define SHT3X_DEFL_MODE         sht3xMode_t::single_shot
+#endif /* SHT3X_DEFL_MODE */
+
+// [oct.26] device (i.e i2c address) shared by temperature and humidity instances
+#define SHT3X_DEVICES_MAX       2     // 0x44 and 0x45
+typedef struct {
+  uint8_t addr;
+  sht3xMode_t mode;           // acquisition mode
+  unsigned long periodicMs;   // ms periodic mode has been (re)started
+  unsigned long lastMsRead;   // ms last measure read
+  uint16_t t;                 // raw values
+  uint16_t rh;
+} sht3xDevice_t;
 
 
 
@@ -106,6 +135,7 @@ class SHT3x : public generic_driver {
   
     boolean begin( uint8_t );       // start with an i2c address
     bool setResolution( sht3xResolution_t );
+    bool setMode( sht3xMode_t );    // single shot or periodic acquisition
     void powerON( void );       // switch ON
     void powerOFF( void );      // switch OFF
 
@@ -121,7 +151,7 @@ class SHT3x : public generic_driver {
     // --- static methods / constants -----------------------
     
     // list of possibles I2C addrs
-    static const uint8_t i2c_addrs[];
+    static const uint8_t i2c_addrs[2];
 
     // device detection
     static boolean is_device( uint8_t );
@@ -129,10 +159,11 @@ class SHT3x : public generic_driver {
   private:
     // -- private methods
     bool _readSensor( uint16_t* );                // low-level function to read value registers
+    bool _fetch( void );                          // periodic mode: read out latest measure
+    void _startPeriodic( void );                  // send periodic mode command
     static void sw_reset( uint8_t );              // reset sensor via software reset procedure
-    static bool crc_check( uint8_t[], uint8_t, uint8_t );  // data array, nb_bytes, checksum
     static bool _check_identity( uint8_t );       // check device is what we expect!
-    static void _writeCmd( uint8_t, uint16_t );   // write I2C command
+    static sht3xDevice_t *_device( uint8_t, bool=false ); // device at i2c addr (optionally created)
 
     // --- private attributes
     uint8_t _i2caddr;
@@ -141,17 +172,11 @@ class SHT3x : public generic_driver {
     static const char *_t_units;
     static const char *_rh_units;
     uint8_t _integrationTime;   // ms time to integrate a measure (for non continuous mode)
-                                /* both TEMP and RH are read at the same time ==> hence we store them
-                                   as shared attributes across all instances */
-    static unsigned long _lastMsRead;   // last time data have been read (elapsed ms from beginning)
-    static uint16_t _t_sensor;  // shared across all instances (for both humidity and temperature modules)
-    static uint16_t _rh_sensor; // shared across all instances (for both humidity and temperature modules)
-
-    // CRC computation
-    static const uint8_t _crc8_polynom;    // crc P(x)=x^8+x^5+x^4+1 (0x31) 1.00110001, init=0xFF
-#ifdef SHT3X_CRC_LOOKUP_TABLE
-    static const uint8_t _crc8_table[256];
-#endif /* SHT3X_CRC_LOOKUP_TABLE */
+    sht3xDevice_t *_dev;        // shared device: TEMP and RH are read at the same time
+    static sht3xDevice_t _devices[SHT3X_DEVICES_MAX];
+    static uint8_t _nbDevices;
+    static const uint16_t _periodic_cmds[5][3];   // mps x resolution
+    static const uint16_t _periodic_ms[6];        // ms between two measures
 };
 
 #endif /* _SHT3X_H_ */
@@ -15,6 +15,8 @@
 //  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 //
 //  2017  - mostly rewritten for neOCampus
+//  2026  - hardware timed transport (ESP8266 timer1)
+//  2026  - hardware timed transport serialized with I2C (CLK on SCL)
 
 
 /*
@@ -29,6 +31,12 @@ extern "C" {
 #include <Arduino.h>
 #include <Ticker.h>
 
+#ifdef ESP8266
+  #include <core_esp8266_waveform.h>    // setTimer1Callback()
+#endif
+
+#include "neocampus_i2c.h"            // i2c_share(), _i2c_busy
+
 #include "TM1637Display.h"
 
 
@@ -40,6 +48,11 @@ extern "C" {
 #define TM1637_I2C_COMM2    0xC0
 #define TM1637_I2C_COMM3    0x80
 
+// [oct.26] hardware timed transport: steps (bit delays) of a frame
+#define TM1637_STEPS_START  1
+#define TM1637_STEPS_BYTE   28    // 8 bits x 3 steps + acknowledge
+#define TM1637_STEPS_STOP   3
+
 //
 //      A
 //     ---
@@ -78,6 +91,11 @@ const uint8_t TM1637Display::dispOFF[] = { 0x00, 0x00, 0x00, 0x00, 0x00 };
 //
 const uint8_t TM1637Display::animMode1[] = { 0b00111001, 0b00001001, 0b00001001, 0b00001111, 0x00 };
 
+#ifdef TM1637_ASYNC
+// display driven by timer1 callback
+TM1637Display *TM1637Display::_async = nullptr;
+#endif
+
 
 
 /*
@@ -103,6 +121,24 @@ TM1637Display::TM1637Display( uint8_t pinClk, uint8_t pinDIO, uint16_t usBitDela
   pinMode(m_pinDIO,INPUT);
   digitalWrite(m_pinClk, LOW);
   digitalWrite(m_pinDIO, LOW);
+
+#ifdef TM1637_ASYNC
+  /* [oct.26] hardware timed transport
+   * Output latches are LOW: enabling a pin output drives its line LOW,
+   * disabling it releases the line (pull-up) */
+  _nbSteps    = 0;
+  _curStep    = 0;
+  _prepared   = 0;
+  _lines      = 0x03;
+  _bitCycles  = microsecondsToClockCycles( _usBitDelay );
+  _clkMask    = ( m_pinClk < 16 ? 1UL << m_pinClk : 0 );
+  _dioMask    = ( m_pinDIO < 16 ? 1UL << m_pinDIO : 0 );
+  if( _async==nullptr and _clkMask and _dioMask ) {
+    _async = this;
+    setTimer1Callback( _timer1Handler );
+    i2c_share( _i2cIdle );
+  }
+#endif
   
    // powermode OFF as a default
   _powerON = false;
@@ -113,6 +149,23 @@ TM1637Display::TM1637Display( uint8_t pinClk, uint8_t pinDIO, uint16_t usBitDela
   _curMin   = -1;
 }
 
+/*
+ * Destructor
+ */
+TM1637Display::~TM1637Display( void )
+{
+  _blinkTimer.detach();
+#ifdef TM1637_ASYNC
+  if( _async==this ) {
+    // waveform completion
+    while( _curStep < _nbSteps ) delay(1);
+    i2c_share( nullptr );
+    setTimer1Callback( nullptr );
+    _async = nullptr;
+  }
+#endif
+}
+
 // ---
 // Brightness control
 void TM1637Display::setBrightness(uint8_t brightness, bool on)
@@ -122,6 +175,46 @@ void TM1637Display::setBrightness(uint8_t brightness, bool on)
 
 void TM1637Display::setSegments(const uint8_t segments[], uint8_t length, uint8_t pos)
 {
+#ifdef TM1637_ASYNC
+  /* [oct.26] hardware timed transport: prepare waveform then let
+   * timer1 play it. Appended to the current waveform (if any), otherwise
+   * wait for enough room.
+   * Note: called from loop or Ticker callbacks ==> never reentrant on ESP8266 */
+  if( _async==this ) {
+    uint16_t _needed = 3*(TM1637_STEPS_START + TM1637_STEPS_STOP) + (3 + length)*TM1637_STEPS_BYTE;
+    if( _curStep < _nbSteps and _nbSteps + _needed > TM1637_ASYNC_STEPS_MAX ) {
+      while( _curStep < _nbSteps );
+    }
+    if( _curStep >= _nbSteps ) {
+      // timer1 idle: start from scratch
+      _nbSteps = 0;
+      _curStep = 0;
+    }
+    _prepared = _nbSteps;
+
+    // COMM1
+    _stepsStart();
+    _stepsByte(TM1637_I2C_COMM1);
+    _stepsStop();
+
+    // COMM2 + first digit address then data bytes
+    _stepsStart();
+    _stepsByte(TM1637_I2C_COMM2 + (pos & 0x07));
+    for (uint8_t k=0; k < length; k++)
+      _stepsByte(segments[k]);
+    _stepsStop();
+
+    // COMM3 + brightness
+    _stepsStart();
+    _stepsByte(TM1637_I2C_COMM3 + (m_brightness & 0x0f));
+    _stepsStop();
+
+    // let's go !
+    _nbSteps = _prepared;
+    return;
+  }
+#endif /* TM1637_ASYNC */
+
     // Write COMM1
 	start();
 	writeByte(TM1637_I2C_COMM1);
@@ -249,6 +342,93 @@ bool TM1637Display::writeByte(uint8_t b)
   return ack;
 }
 
+#ifdef TM1637_ASYNC
+/*
+ * [oct.26] hardware timed transport: waveform steps
+ * Same waveform as start(), writeByte() and stop() with one step per bit
+ * delay. Acknowledge is not read: DIO gets hold LOW as if TM1637 answered.
+ * step: bit0 = CLK released, bit1 = DIO released
+ */
+void TM1637Display::_stepsStart( void )
+{
+  uint16_t i = _prepared;
+  _addStep( 0x01 );                       // DIO low
+  if( i < _prepared ) _starts[i >> 3] |= 1 << (i & 0x07);
+}
+
+void TM1637Display::_stepsStop( void )
+{
+  _addStep( 0x00 );                       // DIO low
+  _addStep( 0x01 );                       // CLK high
+  _addStep( 0x03 );                       // DIO high
+}
+
+void TM1637Display::_stepsByte( uint8_t b )
+{
+  uint8_t data = b;
+
+  // 8 Data Bits
+  for(uint8_t i = 0; i < 8; i++) {
+    uint8_t _dio = ( data & 0x01 ? 0x02 : 0x00 );
+    _addStep( _lines & 0x02 );            // CLK low
+    _addStep( _dio );                     // set data bit
+    _addStep( 0x01 | _dio );              // CLK high
+    data = data >> 1;
+  }
+
+  // acknowledge
+  _addStep( 0x02 );                       // CLK low, DIO released
+  _addStep( 0x03 );                       // CLK high
+  _addStep( 0x01 );                       // DIO low
+  _addStep( 0x00 );                       // CLK low
+}
+
+void TM1637Display::_addStep( uint8_t step )
+{
+  if( _prepared >= TM1637_ASYNC_STEPS_MAX ) return;
+  uint8_t _shift = (_prepared & 0x03) << 1;
+  if( _shift==0 ) _steps[_prepared >> 2] = 0;
+  _steps[_prepared >> 2] |= (step & 0x03) << _shift;
+  _starts[_prepared >> 3] &= ~(1 << (_prepared & 0x07));
+  _lines = step;
+  _prepared++;
+}
+
+/*
+ * timer1 callback (ISR): play next step
+ * returns CPU cycles to next call
+ * A frame won't start during an I2C transaction (CLK may be SCL)
+ */
+uint32_t ICACHE_RAM_ATTR TM1637Display::_timer1Handler( void )
+{
+  TM1637Display *p = _async;
+  if( p==nullptr or p->_curStep >= p->_nbSteps ) return microsecondsToClockCycles( TM1637_ASYNC_IDLE_US );
+
+  uint16_t i = p->_curStep;
+  if( _i2c_busy and (p->_starts[i >> 3] & (1 << (i & 0x07))) ) return microsecondsToClockCycles( TM1637_ASYNC_DEFER_US );
+  uint8_t step = ( p->_steps[i >> 2] >> ((i & 0x03) << 1) ) & 0x03;
+
+  // CLK first (acknowledge step releases DIO just after CLK low)
+  if( step & 0x01 ) GPEC = p->_clkMask; else GPES = p->_clkMask;
+  if( step & 0x02 ) GPEC = p->_dioMask; else GPES = p->_dioMask;
+
+  p->_curStep = i + 1;
+  return p->_bitCycles;
+}
+
+/*
+ * I2C transactions wait for this one: no frame on the wire
+ */
+bool TM1637Display::_i2cIdle( void )
+{
+  TM1637Display *p = _async;
+  if( p==nullptr ) return true;
+  uint16_t i = p->_curStep;
+  if( i >= p->_nbSteps ) return true;
+  return ( p->_starts[i >> 3] & (1 << (i & 0x07)) );
+}
+#endif /* TM1637_ASYNC */
+
 uint8_t TM1637Display::encodeDigit(uint8_t digit)
 {
 	return digitToSegment[digit & 0x0f];
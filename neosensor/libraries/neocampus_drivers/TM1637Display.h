@@ -15,6 +15,7 @@
 //  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 //
 //  2017  - mostly rewritten for neOCampus
+//  2026  - hardware timed transport (ESP8266 timer1)
 
 #ifndef _TM1637DISPLAY_H_
 #define _TM1637DISPLAY_H_
@@ -48,6 +49,22 @@
 #define TM1637_MIN_BITDELAY_US      10    // doc told us min T=2µs, min bit.delay --> T=20µs
 #define TM1637_MAX_BRIGHTNESS       7     // brightness ranges from 0 to 7
 
+/* [oct.26] Hardware timed transport (ESP8266)
+ * setSegments() prepares the whole CLK/DIO waveform (one step per bit delay)
+ * that gets played by timer1 ISR (shared with the waveform generator, i.e
+ * analogWrite) ==> no more busy-wait, updates are fire-and-forget.
+ * Note: single display instance with both pins in GPIO0..15, bit-banging otherwise
+ * Note: CLK may be wired to I2C SCL (neOClock): frames only start while no
+ * I2C transaction is running, and I2C transactions wait for a frame boundary.
+ * TM1637 ignores SCL pulses while DIO is high (i.e between frames).
+ */
+#if defined(ESP8266) && !defined(TM1637_ASYNC_DISABLED)
+#define TM1637_ASYNC
+#endif
+#define TM1637_ASYNC_STEPS_MAX      384   // waveform steps (4 steps per byte)
+#define TM1637_ASYNC_IDLE_US        10000 // timer1 callback period when idle (µs)
+#define TM1637_ASYNC_DEFER_US       100   // timer1 callback period while I2C is busy (µs)
+
 /*
  * neOClock 7 segments x 4 + 2 central dots
  * 
@@ -74,6 +91,7 @@ class TM1637Display : public driver_display {
     //! @param pinClk - The number of the digital pin connected to the clock pin of the module
     //! @param pinDIO - The number of the digital pin connected to the DIO pin of the module
     TM1637Display( uint8_t pinClk, uint8_t pinDIO, uint16_t usBitDelay=25 );
+    ~TM1637Display( void );
 
     //! Sets the brightness of the display.
     //!
@@ -174,6 +192,16 @@ class TM1637Display : public driver_display {
     void stop();
 
     bool writeByte(uint8_t b);
+
+#ifdef TM1637_ASYNC
+    // hardware timed transport: waveform steps
+    void _stepsStart( void );
+    void _stepsByte( uint8_t );
+    void _stepsStop( void );
+    void _addStep( uint8_t );
+    static uint32_t ICACHE_RAM_ATTR _timer1Handler( void );
+    static bool _i2cIdle( void );         // waveform at a frame boundary
+#endif
     
     // process animations
     uint8_t _processAnim( void );
@@ -192,6 +220,19 @@ class TM1637Display : public driver_display {
     uint8_t m_brightness;
     
     uint16_t _usBitDelay;
+
+#ifdef TM1637_ASYNC
+    // hardware timed transport
+    static TM1637Display *_async;   // display instance driven by timer1 (nullptr ==> bit-banging)
+    uint32_t _clkMask, _dioMask;    // GPIO registers masks
+    uint32_t _bitCycles;            // CPU cycles per bit delay
+    uint8_t _steps[TM1637_ASYNC_STEPS_MAX/4];   // 2 bits per step: CLK released, DIO released
+    uint8_t _starts[TM1637_ASYNC_STEPS_MAX/8];  // 1 bit per step: frame start
+    volatile uint16_t _nbSteps;     // steps to play
+    volatile uint16_t _curStep;     // next step to play (ISR)
+    uint16_t _prepared;             // steps prepared (then published through _nbSteps)
+    uint8_t _lines;                 // lines state of last prepared step
+#endif
     
     // power status
     bool _powerON;
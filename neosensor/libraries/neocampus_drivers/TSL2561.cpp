@@ -33,6 +33,8 @@
     SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
     @history
+    2026  - non blocking acquisition with auto-range (gain + integration time)
+    2026  - event mode: continuous integration with threshold window interrupt
     2017  - mostly rewritten for neOCampus
 
 */
@@ -67,6 +69,41 @@ const uint8_t TSL2561::i2c_addrs[3] = { TSL2561_ADDR_LOW, TSL2561_ADDR_FLOAT, TS
 /* declare kind of units */
 const char *TSL2561::units = "lux";
 
+/* auto-range steps, from least to most sensitive */
+const tsl2561Range_t TSL2561::_ranges[] = {
+  { TSL2561_INTEGRATIONTIME_13MS,  TSL2561_GAIN_1X,    137, TSL2561_AGC_THI_13MS,  TSL2561_LUX_CHSCALE_TINT0 << 4 },
+  { TSL2561_INTEGRATIONTIME_101MS, TSL2561_GAIN_1X,   1010, TSL2561_AGC_THI_101MS, TSL2561_LUX_CHSCALE_TINT1 << 4 },
+  { TSL2561_INTEGRATIONTIME_13MS,  TSL2561_GAIN_16X,  2192, TSL2561_AGC_THI_13MS,  TSL2561_LUX_CHSCALE_TINT0 },
+  { TSL2561_INTEGRATIONTIME_402MS, TSL2561_GAIN_1X,   4020, TSL2561_AGC_THI_402MS, (1UL << TSL2561_LUX_CHSCALE) << 4 },
+  { TSL2561_INTEGRATIONTIME_101MS, TSL2561_GAIN_16X, 16160, TSL2561_AGC_THI_101MS, TSL2561_LUX_CHSCALE_TINT1 },
+  { TSL2561_INTEGRATIONTIME_402MS, TSL2561_GAIN_16X, 64320, TSL2561_AGC_THI_402MS, (1UL << TSL2561_LUX_CHSCALE) }
+};
+const uint8_t TSL2561::_nbRanges = sizeof(TSL2561::_ranges) / sizeof(tsl2561Range_t);
+
+/* lux computation coefficients according to package */
+const tsl2561LuxCoef_t TSL2561::_luxCoefs[] = {
+#ifdef TSL2561_PACKAGE_CS
+  { TSL2561_LUX_K1C, TSL2561_LUX_B1C, TSL2561_LUX_M1C },
+  { TSL2561_LUX_K2C, TSL2561_LUX_B2C, TSL2561_LUX_M2C },
+  { TSL2561_LUX_K3C, TSL2561_LUX_B3C, TSL2561_LUX_M3C },
+  { TSL2561_LUX_K4C, TSL2561_LUX_B4C, TSL2561_LUX_M4C },
+  { TSL2561_LUX_K5C, TSL2561_LUX_B5C, TSL2561_LUX_M5C },
+  { TSL2561_LUX_K6C, TSL2561_LUX_B6C, TSL2561_LUX_M6C },
+  { TSL2561_LUX_K7C, TSL2561_LUX_B7C, TSL2561_LUX_M7C },
+  { TSL2561_LUX_K8C, TSL2561_LUX_B8C, TSL2561_LUX_M8C }
+#else
+  { TSL2561_LUX_K1T, TSL2561_LUX_B1T, TSL2561_LUX_M1T },
+  { TSL2561_LUX_K2T, TSL2561_LUX_B2T, TSL2561_LUX_M2T },
+  { TSL2561_LUX_K3T, TSL2561_LUX_B3T, TSL2561_LUX_M3T },
+  { TSL2561_LUX_K4T, TSL2561_LUX_B4T, TSL2561_LUX_M4T },
+  { TSL2561_LUX_K5T, TSL2561_LUX_B5T, TSL2561_LUX_M5T },
+  { TSL2561_LUX_K6T, TSL2561_LUX_B6T, TSL2561_LUX_M6T },
+  { TSL2561_LUX_K7T, TSL2561_LUX_B7T, TSL2561_LUX_M7T },
+  { TSL2561_LUX_K8T, TSL2561_LUX_B8T, TSL2561_LUX_M8T }
+#endif
+};
+const uint8_t TSL2561::_nbLuxCoefs = sizeof(TSL2561::_luxCoefs) / sizeof(tsl2561LuxCoef_t);
+
 
 /**************************************************************************/
 /*! 
@@ -103,6 +140,8 @@ TSL2561::TSL2561( void ) : generic_driver() {
   _integration = TSL2561_DEFL_INTEGR_TIME;
   _gain = TSL2561_DEFL_GAIN;
   _auto_gain = true;    // auto gain activated
+  _state = tsl2561State_t::idle;
+  _cycleMs = 0;
 }
 
 
@@ -148,14 +187,41 @@ void TSL2561::powerON(void)
 
 void TSL2561::powerOFF(void)
 {
+  // event mode: continuous integration
+  if( _eventMode() ) return;
+
   // Disable the device by setting the control bit to 0x03
   write8(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_CLEAR_BIT | TSL2561_REGISTER_CONTROL, TSL2561_CONTROL_POWEROFF);
 }
 
 
-/* Auto Gain to enable automated full range of sensor :) 
+/* Event mode: sensor only gets read when its INT line fires, device
+ * keeps integrating (i.e powered ON).
+ * Note: no INT gpio (or no interrupt on it) means polling
+ */
+boolean TSL2561::setEventMode( uint8_t gpio, uint8_t percent ) {
+
+  _windowPercent = ( (percent==0 or percent>=100) ? DEFL_EVENT_WINDOW_PERCENT : percent );
+
+  if( !_attachINT( gpio ) ) {
+    write8(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_CLEAR_BIT | TSL2561_REGISTER_INTERRUPT, TSL2561_INTR_DISABLE);
+    log_info(F("\n[TSL2561] no INT line, polling mode")); log_flush();
+    return false;
+  }
+
+  // continuous integration, window gets armed upon first read
+  powerON();
+  _state = tsl2561State_t::integrating;
+  _cycleMs = millis();
+  log_info(F("\n[TSL2561] event mode with INT on gpio ")); log_info(gpio,DEC); log_flush();
+  return true;
+}
+
+
+/* Auto Range (gain and integration time) to enable automated full
+ * range of sensor :)
  * - true --> activation
- * - false --> disable auto gain
+ * - false --> disable auto range
  */
 void TSL2561::enableAutoRange(bool enable) {
   _auto_gain = enable ? true : false;;
@@ -169,10 +235,12 @@ void TSL2561::setGain(tsl2561Gain_t gain) {
   powerON();
   
   _gain = gain;
-  write8(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_CLEAR_BIT | TSL2561_REGISTER_TIMING, _integration | _gain);  
+  write8(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_CLEAR_BIT | TSL2561_REGISTER_TIMING, _integration | _gain);
+  _cycleMs = millis();
 
   // stop device to save energy
   powerOFF();
+  if( not _eventMode() ) _state = tsl2561State_t::idle;
 }
 
 void TSL2561::setTiming(tsl2561IntegrationTime_t integration) {
@@ -183,9 +251,11 @@ void TSL2561::setTiming(tsl2561IntegrationTime_t integration) {
   
   _integration = integration;
   write8(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_CLEAR_BIT | TSL2561_REGISTER_TIMING, _integration | _gain);
+  _cycleMs = millis();
 
   // stop device to save energy
   powerOFF();
+  if( not _eventMode() ) _state = tsl2561State_t::idle;
 }
 
 
@@ -208,255 +278,209 @@ bool TSL2561::_check_identity( uint8_t a ) {
 
 
 /* ----------------------------------------------------------
- * Low-level channel 0 and channel 1 sensor acquisition
+ * Acquisition FSM: start integration, then read channel 0 and channel 1
+ * once integration cycle completed ... never waits!
  *   Channel0 --> Visible + IR
  *   Channel1 --> IR only
+ * If 'auto Range' is enabled and channel 0 is out of range, integration
+ * restarts with better suited gain and integration time.
  * - pointer to uint16_t that will hold ch0 and ch1 values
- * - return None
+ * - return true if ch0 and ch1 are valid
  */
-void TSL2561::_getData (uint16_t *ch0, uint16_t *ch1) {
+boolean TSL2561::_fetch( uint16_t *ch0, uint16_t *ch1 ) {
+
+  // start integration
+  if( _state == tsl2561State_t::idle ) {
+    powerON();
+    _cycleMs = millis();
+    _state = tsl2561State_t::integrating;
+    return false;
+  }
 
-  /* Enable the device by setting the control bit to 0x03 */
-  powerON();
+  // integration with current settings not yet completed ?
+  if( millis() - _cycleMs < _integrationMs() ) return false;
 
-  /* Wait x ms for ADC to complete */
-  switch( _integration )
-  {
-    case TSL2561_INTEGRATIONTIME_13MS:
-      delay(TSL2561_DELAY_INTTIME_13MS);  // KTOWN: Was 14ms
-      break;
-    case TSL2561_INTEGRATIONTIME_101MS:
-      delay(TSL2561_DELAY_INTTIME_101MS); // KTOWN: Was 102ms
-      break;
-    default:
-      delay(TSL2561_DELAY_INTTIME_402MS); // KTOWN: Was 403ms
-      break;
-  }
+  _intFired = false;
 
   /* Reads a two byte value from channel 0 (visible + infrared)
    *  little-endian! */
   *ch0 = read16le(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_CHAN0_LOW); // read16 will both read CHAN0_LOW and CHAN0_HI
-  //log_debug(F("\n\t[TSL2561] ch0 = ")); log_debug((int)(*ch0),DEC);
 
   /* Reads a two byte value from channel 1 (infrared)
    *  little-endian! */
   *ch1 = read16le(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_CHAN1_LOW); // read16 will both read CHAN1_LOW and CHAN1_HI
-  //log_debug(F("\n\t[TSL2561] ch1 = "); log_debug((int)(*ch1), DEC);
 
-  /* Turn the device off to save power */
-  powerOFF();
+  if( _auto_gain ) {
+    uint8_t _cur = _range();
+    uint8_t _next = _nextRange( _cur, *ch0 );
+    if( _next != _cur ) {
+      _setRange( _next );
+      _intFired = true;   // event mode: read again after next integration cycle
+      return false;
+    }
+  }
+
+  if( _eventMode() ) {
+    // re-arm window
+    _setWindow( *ch0 );
+  }
+  else {
+    /* Turn the device off to save power */
+    powerOFF();
+    _state = tsl2561State_t::idle;
+  }
+  return true;
 }
 
 
 
 /*
- * Function that retrieves both broadband and IR channels of sensor
- * If 'auto Gain' is enabled, it may iterate with the various possible
- * gains.
- * - pointers to uint16_t that will hold ch0 and ch1 values
- * - return None
+ * Delay for an integration cycle to complete
  */
-void TSL2561::getLuminosity( uint16_t *broadband, uint16_t *ir ) {
-  if( !_initialized ) begin();
+uint16_t TSL2561::_integrationMs( void ) {
+  switch( _integration )
+  {
+    case TSL2561_INTEGRATIONTIME_13MS:
+      return TSL2561_DELAY_INTTIME_13MS;  // KTOWN: Was 14ms
+    case TSL2561_INTEGRATIONTIME_101MS:
+      return TSL2561_DELAY_INTTIME_101MS; // KTOWN: Was 102ms
+    default:
+      return TSL2561_DELAY_INTTIME_402MS; // KTOWN: Was 403ms
+  }
+}
 
-  // acquire data
-  _getData( broadband, ir );
 
-  // auto gain disabled ?
-  if( _auto_gain==false ) return;
 
 /*
-  // Do we need to change the gain ?
-  // ... auto gain computation
-  if( ( ((*broadband & 0xF000) == 0) and ((*ir & 0xF000) == 0) ) and (_gain==TSL2561_GAIN_1X) ) {
+ * Auto-range step matching current gain and integration time
+ */
+uint8_t TSL2561::_range( void ) {
+  for( uint8_t i=0; i < _nbRanges; i++ ) {
+    if( _ranges[i].integration == _integration and _ranges[i].gain == _gain ) return i;
+  }
+  return _nbRanges - 1;
+}
+
 
-    // set gain to 16 and get values
-    log_debug(F("\n[TSL2561][auto] set gain to 16X ..."));
-    setGain(TSL2561_GAIN_16X);
 
-    // ... and acquire data anew ...
-    _getData( broadband, ir );
-    return;
+/*
+ * Auto-range step for next integration according to channel 0 counts
+ * - above current step high threshold: most sensitive lower step where
+ *   expected counts fit with headroom (saturated counts are a lower bound,
+ *   hence several cycles may be needed to reach proper step)
+ * - otherwise: most sensitive upper step where expected counts fit with
+ *   headroom (i.e hysteresis)
+ */
+uint8_t TSL2561::_nextRange( uint8_t cur, uint16_t ch0 ) {
+  uint8_t _next = cur;
+
+  if( ch0 > _ranges[cur].high ) {
+    while( _next > 0 ) {
+      _next--;
+      uint32_t _expected = ( (uint32_t)ch0 * _ranges[_next].sensitivity ) / _ranges[cur].sensitivity;
+      if( _expected <= _ranges[_next].high / TSL2561_AUTORANGE_HEADROOM ) break;
+    }
+    return _next;
   }
 
-  if( ( ((*broadband & 0xF000) == (uint16_t)0xF000) and ((*ir & 0xF000) == (uint16_t)0xF000) ) and (_gain==TSL2561_GAIN_16X) ) {
+  for( uint8_t i=cur+1; i < _nbRanges; i++ ) {
+    uint32_t _expected = ( (uint32_t)ch0 * _ranges[i].sensitivity ) / _ranges[cur].sensitivity;
+    if( _expected <= _ranges[i].high / TSL2561_AUTORANGE_HEADROOM ) _next = i;
+  }
+  return _next;
+}
 
-    // set gain to 1 and get values
-    log_debug(F("\n[TSL2561][auto] set back gain to 1X ..."));
-    setGain(TSL2561_GAIN_1X);
 
-    // ... and acquire data anew ...
-    _getData( broadband, ir );
-    return;
-  }
-*/
 
+/*
+ * Apply auto-range step, device keeps integrating with new settings
+ */
+void TSL2561::_setRange( uint8_t idx ) {
+  _integration = _ranges[idx].integration;
+  _gain = _ranges[idx].gain;
+  log_debug(F("\n[TSL2561][auto] integration = ")); log_debug(_integrationMs(),DEC);
+  log_debug(F("ms, gain = ")); log_debug( (_gain==TSL2561_GAIN_16X ? 16 : 1), DEC); log_flush();
+  write8(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_CLEAR_BIT | TSL2561_REGISTER_TIMING, _integration | _gain);
+  _cycleMs = millis();
+}
 
-  // Read data until we find a valid range
-  bool valid = false;
-  bool _agcCheck = false;
-  do
-  {
-    uint16_t _b, _ir;
-    uint16_t _hi, _lo;
-    tsl2561IntegrationTime_t _it = _integration;
-
-    // Get the hi/low threshold for the current integration time
-    switch(_it)
-    {
-      case TSL2561_INTEGRATIONTIME_13MS:
-        _hi = TSL2561_AGC_THI_13MS;
-        _lo = TSL2561_AGC_TLO_13MS;
-        break;
-      case TSL2561_INTEGRATIONTIME_101MS:
-        _hi = TSL2561_AGC_THI_101MS;
-        _lo = TSL2561_AGC_TLO_101MS;
-        break;
-      default:
-        _hi = TSL2561_AGC_THI_402MS;
-        _lo = TSL2561_AGC_TLO_402MS;
-    }
 
-    _getData(&_b, &_ir);
-
-    // Run an auto-gain check if we haven't already done so ...
-    if (!_agcCheck)
-    {
-      if ((_b < _lo) && (_gain == TSL2561_GAIN_1X))
-      {
-        // Increase the gain and try again
-        log_debug(F("\n[TSL2561][auto] set gain to 16X ..."));
-        setGain(TSL2561_GAIN_16X);
-        // Drop the previous conversion results
-        _getData(&_b, &_ir);
-        // Set a flag to indicate we've adjusted the gain
-        _agcCheck = true;
-      }
-      else if ((_b > _hi) && (_gain == TSL2561_GAIN_16X))
-      {
-        // Drop gain to 1x and try again
-        log_debug(F("\n[TSL2561][auto] set back gain to 1X ..."));
-        setGain(TSL2561_GAIN_1X);
-        // Drop the previous conversion results
-        _getData(&_b, &_ir);
-        // Set a flag to indicate we've adjusted the gain
-        _agcCheck = true;
-      }
-      else
-      {
-        // Nothing to look at here, keep moving ....
-        // Reading is either valid, or we're already at the chips limits
-        *broadband = _b;
-        *ir = _ir;
-        valid = true;
-      }
-    }
-    else
-    {
-      // If we've already adjusted the gain once, just return the new results.
-      // This avoids endless loops where a value is at one extreme pre-gain,
-      // and the the other extreme post-gain
-      *broadband = _b;
-      *ir = _ir;
-      valid = true;
-    }
-  } while( !valid );
 
-  return;
+/*
+ * Event mode: INT gets raised once channel 0 is outside [ch0-x%, ch0+x%]
+ * for more than TSL2561_EVENT_PERSIST integration cycles
+ */
+void TSL2561::_setWindow( uint16_t ch0 ) {
+  uint32_t _delta = ( (uint32_t)ch0 * _windowPercent ) / 100;
+  if( _delta < TSL2561_WINDOW_MIN_COUNTS ) _delta = TSL2561_WINDOW_MIN_COUNTS;
+  uint16_t _lo = ( ch0 > _delta ? ch0 - _delta : 0 );
+  uint16_t _hi = ( (uint32_t)ch0 + _delta > 0xFFFF ? 0xFFFF : ch0 + _delta );
+
+  // thresholds are little-endian words
+  uint8_t buf[3];
+  buf[0] = TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_THRESHHOLDL_LOW;
+  buf[1] = _lo & 0xFF;
+  buf[2] = _lo >> 8;
+  i2c_transfer( _i2caddr, buf, sizeof(buf) );
+  buf[0] = TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_THRESHHOLDH_LOW;
+  buf[1] = _hi & 0xFF;
+  buf[2] = _hi >> 8;
+  i2c_transfer( _i2caddr, buf, sizeof(buf) );
+
+  // clear pending interrupt and enable level interrupt with persistence
+  write8(_i2caddr, TSL2561_COMMAND_BIT | TSL2561_CLEAR_BIT | TSL2561_REGISTER_INTERRUPT, TSL2561_INTR_LEVEL | TSL2561_EVENT_PERSIST);
+}
+
+
+
+/*
+ * Function that retrieves both broadband and IR channels of sensor,
+ * waiting for integration cycles to complete.
+ * If 'auto Range' is enabled, it may iterate with the various possible
+ * gains and integration times.
+ * - pointers to uint16_t that will hold ch0 and ch1 values
+ * - return None
+ */
+void TSL2561::getLuminosity( uint16_t *broadband, uint16_t *ir ) {
+  if( !_initialized ) begin();
+
+  while( !_fetch( broadband, ir ) ) delay( TSL2561_DELAY_INTTIME_13MS );
 }
 
 
 
 /*
  * Compute LUX value according to ch0 and ch1 sensors values
+ * (integer arithmetic only, channels acquired with current settings)
  * - ch0 --> channel 0 sensor (broadband)
  * - ch1 --> channel 1 sensor (IR)
  * - return computed luminosity (lux)
  */
 uint32_t TSL2561::calculateLux(uint16_t ch0, uint16_t ch1)
 {
-  unsigned long chScale;
-  unsigned long channel1;
-  unsigned long channel0;
-
-  switch( _integration )
-  {
-    case TSL2561_INTEGRATIONTIME_13MS:
-      chScale = TSL2561_LUX_CHSCALE_TINT0;
-      break;
-    case TSL2561_INTEGRATIONTIME_101MS:
-      chScale = TSL2561_LUX_CHSCALE_TINT1;
-      break;
-    default: // No scaling ... integration time = 402ms
-      chScale = (1 << TSL2561_LUX_CHSCALE);
-  }
-
-  // Scaling only if gain is 1X
-  if( _gain==TSL2561_GAIN_1X ) chScale = chScale << 4;
-
-  // scale the channel values
-  channel0 = (ch0 * chScale) >> TSL2561_LUX_CHSCALE;
-  channel1 = (ch1 * chScale) >> TSL2561_LUX_CHSCALE;
+  // scale the channel values to 402ms / 16x
+  uint32_t chScale = _ranges[_range()].chScale;
+  uint32_t channel0 = (ch0 * chScale) >> TSL2561_LUX_CHSCALE;
+  uint32_t channel1 = (ch1 * chScale) >> TSL2561_LUX_CHSCALE;
 
   // find the ratio of the channel values (Channel1/Channel0)
-  unsigned long ratio1 = 0;
+  uint32_t ratio1 = 0;
   if (channel0 != 0) ratio1 = (channel1 << (TSL2561_LUX_RATIOSCALE+1)) / channel0;
 
   // round the ratio value
-  unsigned long ratio = (ratio1 + 1) >> 1;
+  uint32_t ratio = (ratio1 + 1) >> 1;
 
-  unsigned int b, m;
-
-#ifdef TSL2561_PACKAGE_CS
-  if ((ratio >= 0) && (ratio <= TSL2561_LUX_K1C))
-    {b=TSL2561_LUX_B1C; m=TSL2561_LUX_M1C;}
-  else if (ratio <= TSL2561_LUX_K2C)
-    {b=TSL2561_LUX_B2C; m=TSL2561_LUX_M2C;}
-  else if (ratio <= TSL2561_LUX_K3C)
-    {b=TSL2561_LUX_B3C; m=TSL2561_LUX_M3C;}
-  else if (ratio <= TSL2561_LUX_K4C)
-    {b=TSL2561_LUX_B4C; m=TSL2561_LUX_M4C;}
-  else if (ratio <= TSL2561_LUX_K5C)
-    {b=TSL2561_LUX_B5C; m=TSL2561_LUX_M5C;}
-  else if (ratio <= TSL2561_LUX_K6C)
-    {b=TSL2561_LUX_B6C; m=TSL2561_LUX_M6C;}
-  else if (ratio <= TSL2561_LUX_K7C)
-    {b=TSL2561_LUX_B7C; m=TSL2561_LUX_M7C;}
-  else if (ratio > TSL2561_LUX_K8C)
-    {b=TSL2561_LUX_B8C; m=TSL2561_LUX_M8C;}
-#else
-  if ((ratio >= 0) && (ratio <= TSL2561_LUX_K1T))
-    {b=TSL2561_LUX_B1T; m=TSL2561_LUX_M1T;}
-  else if (ratio <= TSL2561_LUX_K2T)
-    {b=TSL2561_LUX_B2T; m=TSL2561_LUX_M2T;}
-  else if (ratio <= TSL2561_LUX_K3T)
-    {b=TSL2561_LUX_B3T; m=TSL2561_LUX_M3T;}
-  else if (ratio <= TSL2561_LUX_K4T)
-    {b=TSL2561_LUX_B4T; m=TSL2561_LUX_M4T;}
-  else if (ratio <= TSL2561_LUX_K5T)
-    {b=TSL2561_LUX_B5T; m=TSL2561_LUX_M5T;}
-  else if (ratio <= TSL2561_LUX_K6T)
-    {b=TSL2561_LUX_B6T; m=TSL2561_LUX_M6T;}
-  else if (ratio <= TSL2561_LUX_K7T)
-    {b=TSL2561_LUX_B7T; m=TSL2561_LUX_M7T;}
-  else if (ratio > TSL2561_LUX_K8T)
-    {b=TSL2561_LUX_B8T; m=TSL2561_LUX_M8T;}
-#endif
-
-  unsigned long temp;
-  temp = ((channel0 * b) - (channel1 * m));
+  // coefficients for this ratio (last ones beyond)
+  const tsl2561LuxCoef_t *_coef = _luxCoefs;
+  while( (_coef < &_luxCoefs[_nbLuxCoefs-1]) and (ratio > _coef->k) ) _coef++;
 
   // do not allow negative lux value
-  if (temp < 0) temp = 0;
-
-  // round lsb (2^(LUX_SCALE-1))
-  temp += (1 << (TSL2561_LUX_LUXSCALE-1));
-
-  // strip off fractional portion
-  uint32_t lux = temp >> TSL2561_LUX_LUXSCALE;
+  uint32_t _b = channel0 * _coef->b;
+  uint32_t _m = channel1 * _coef->m;
+  if( _m >= _b ) return 0;
 
-  // Signal I2C had no errors
-  return lux;
+  // round lsb (2^(LUX_SCALE-1)) and strip off fractional portion
+  return ( _b - _m + (1UL << (TSL2561_LUX_LUXSCALE-1)) ) >> TSL2561_LUX_LUXSCALE;
 }
 
 
@@ -469,8 +493,9 @@ boolean TSL2561::acquire( float *pval ) {
 
   uint16_t ch0, ch1;
 
-  // get channels luminosity
-  getLuminosity( &ch0, & ch1 );
+  // get channels luminosity (integration in progress ?)
+  if( !_initialized ) return false;
+  if( !_fetch( &ch0, &ch1 ) ) return false;
 
   // ... and return computed lux value :)
   *pval = (float)calculateLux( ch0, ch1 );
@@ -33,6 +33,8 @@
     SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
     @history
+    2026  - non blocking acquisition with auto-range (gain + integration time)
+    2026  - event mode: continuous integration with threshold window interrupt
     2017  - mostly rewritten for neOCampus
 */
 /**************************************************************************/
@@ -147,6 +149,10 @@
 #define TSL2561_CLIPPING_101MS    (37000)
 #define TSL2561_CLIPPING_402MS    (65000)
 
+// Auto-range: switch to more sensitive settings only if expected channel 0
+// stays below AGC_THI / TSL2561_AUTORANGE_HEADROOM (hysteresis)
+#define TSL2561_AUTORANGE_HEADROOM  2
+
 enum
 {
   TSL2561_REGISTER_CONTROL          = 0x00,
@@ -166,6 +172,12 @@ enum
 
 #define REGISTER_ID_TSL2561         0x10  // ChipID code for TSL2561 (0x50 usually 0b0101xxxx)
 
+// Register: TSL2561_REGISTER_INTERRUPT
+#define TSL2561_INTR_DISABLE        0x00
+#define TSL2561_INTR_LEVEL          0x10  // level interrupt, bits [3:0] are persistence
+#define TSL2561_EVENT_PERSIST       5     // integration cycles channel 0 ought to stay outside window to raise INT
+#define TSL2561_WINDOW_MIN_COUNTS   4     // event mode minimum window (channel 0 counts)
+
 typedef enum {
   TSL2561_INTEGRATIONTIME_13MS      = 0x00,    // 13.7ms
   TSL2561_INTEGRATIONTIME_101MS     = 0x01,    // 101ms
@@ -179,6 +191,28 @@ typedef enum {
 } tsl2561Gain_t;
 #define TSL2561_DEFL_GAIN           TSL2561_GAIN_16X
 
+// auto-range step: gain and integration time, ordered by sensitivity
+typedef struct {
+  tsl2561IntegrationTime_t integration;
+  tsl2561Gain_t gain;
+  uint16_t sensitivity;     // integration time (x0.1ms) x gain
+  uint16_t high;            // channel 0 upper threshold
+  uint32_t chScale;         // lux computation channels scaling (2^LUX_CHSCALE)
+} tsl2561Range_t;
+
+// lux computation coefficients for channels ratio up to 'k'
+typedef struct {
+  uint16_t k;               // ratio ch1/ch0 (2^LUX_RATIOSCALE)
+  uint16_t b;               // channel 0 coefficient (2^LUX_LUXSCALE)
+  uint16_t m;               // channel 1 coefficient (2^LUX_LUXSCALE)
+} tsl2561LuxCoef_t;
+
+// acquisition FSM
+enum class tsl2561State_t : uint8_t {
+  idle            = 0,      // powered OFF
+  integrating               // integration cycle in progress
+};
+
 /*
  * Class
  */
@@ -190,10 +224,12 @@ class TSL2561 : public generic_driver {
     void powerON( void );       // switch ON
     void powerOFF( void );      // switch OFF
 
+    boolean setEventMode( uint8_t gpio, uint8_t percent=DEFL_EVENT_WINDOW_PERCENT );
+
     void enableAutoRange(bool enable);
     void setTiming(tsl2561IntegrationTime_t integration);
     void setGain(tsl2561Gain_t gain);
-    void getLuminosity (uint16_t *ch0, uint16_t *ch1);
+    void getLuminosity (uint16_t *ch0, uint16_t *ch1);   // blocking
     uint32_t calculateLux(uint16_t ch0, uint16_t ch1);
 
     // send back sensor's value and units
@@ -204,7 +240,7 @@ class TSL2561 : public generic_driver {
     // --- static methods / constants -----------------------
     
     // list of possibles I2C addrs
-    static const uint8_t i2c_addrs[];
+    static const uint8_t i2c_addrs[3];
 
     // device detection
     static boolean is_device( uint8_t );
@@ -220,9 +256,22 @@ class TSL2561 : public generic_driver {
     bool _initialized;
     static const char *units;
 
+    tsl2561State_t _state;
+    unsigned long _cycleMs;     // (ms) start of integration with current settings
+
+    static const tsl2561Range_t _ranges[];
+    static const uint8_t _nbRanges;
+    static const tsl2561LuxCoef_t _luxCoefs[];
+    static const uint8_t _nbLuxCoefs;
+
     // methods
     static bool _check_identity( uint8_t );   // check device is what we expect!
-    void _getData( uint16_t *broadband, uint16_t *ir );
+    boolean _fetch( uint16_t *broadband, uint16_t *ir ); // acquisition FSM, never waits
+    uint16_t _integrationMs( void );
+    uint8_t _range( void );                   // current auto-range step
+    uint8_t _nextRange( uint8_t cur, uint16_t broadband );
+    void _setRange( uint8_t );
+    void _setWindow( uint16_t broadband );  // event mode: INT raised when channel 0 outside [ch0-x%, ch0+x%]
 };
 
 #endif /* _TSL2561_H_ */
@@ -11,6 +11,9 @@
 
 	@section  HISTORY
 
+    oct.26  INT line shared by several drivers (one ISR per gpio)
+    oct.26  event mode without INT line: driver's status poll
+    oct.26  added event mode: sensor read upon INT line only
     F.Thiebolt  nov.21  added support for single data threshold_cpt
     F.Thiebolt  aug.21  added support for analog data integration
     2020-May    - First release, F. Thiebolt
@@ -45,6 +48,12 @@ generic_driver::generic_driver( uint16_t read_msinterval,
   _lastMsSent     = ULONG_MAX/2;
 
   value           = -1.0; // fool guard
+
+  _event          = false;
+  _intGpio        = INVALID_GPIO;
+  _intFired       = true; // first read arms the window
+  _lastMsPoll     = ULONG_MAX/2;
+  _windowPercent  = DEFL_EVENT_WINDOW_PERCENT;
 }
 
 /******************************************
@@ -79,6 +88,14 @@ void generic_driver::process( uint16_t coolDown, uint8_t decimals ) {
   // check wether it's time to process or not
   if( _curTime - _lastMsWrite < ((unsigned long)coolDown)*1000 ) return;
   if( _curTime - _lastMsRead < _readMsInterval ) return;
+  // [oct.26] event mode: no read till INT line fired or driver's status poll
+  // reports an event (and at least every _MAX_COOLDOWN_SENSOR)
+  if( _eventMode() and not _intFired and
+      (_curTime - _lastMsRead < ((unsigned long)_MAX_COOLDOWN_SENSOR)*1000) ) {
+    if( _intGpio != INVALID_GPIO or _curTime - _lastMsPoll < _readMsInterval ) return;
+    _lastMsPoll = _curTime;
+    if( not _eventPoll() ) return;
+  }
 
   // acquire data
   float val;
@@ -95,18 +112,21 @@ void generic_driver::process( uint16_t coolDown, uint8_t decimals ) {
     val = (float)round(val*_pow)/_pow;
   }
 
+  // [oct.26] event mode: sensor's persistence already filtered transients
+  uint8_t _cpt = ( _eventMode() ? 1 : _thresholdCpt );
+
   // data has been acquired :)
   if( _currentCpt==(uint8_t)(-1) or
       abs(_current - val) > abs((_current*(float)_thresholdThousandth)/1000.0) ) {
     // (re)initializing either because it's first time or unstable value
     _current    = val;
     _currentCpt = 0;
-    if( _thresholdCpt > 1 ) return;   // allowing others measures
+    if( _cpt > 1 ) return;   // allowing others measures
   }
 
   // value read from sensor is stable :)
   // or we're facing the thresholdCpt == 1 case
-  if( ++_currentCpt < _thresholdCpt-1 ) return;
+  if( ++_currentCpt < _cpt-1 ) return;
 
   // new stable value :)
   _currentCpt   = -1;
@@ -157,3 +177,64 @@ void generic_driver::setDataSent( void ) {
   valueSent = value;
   _lastMsSent = millis();
 }
+
+
+/******************************************
+ * EVENT mode related methods:
+ *  INT line (open drain, active low) gets attached to our ISR
+ *  - false means either no gpio or no interrupt on this gpio ==> polling
+ *  - several drivers may share the same INT line (i.e wired-OR): the
+ *    gpio's ISR flags all of them
+ */
+generic_driver *generic_driver::_intDrivers[EVENT_MAX_DRIVERS] = { nullptr };
+
+bool generic_driver::_attachINT( uint8_t gpio ) {
+  _detachINT();
+  _event = false;
+  if( gpio == INVALID_GPIO or digitalPinToInterrupt(gpio) == NOT_AN_INTERRUPT ) return false;
+
+  // free slot and other drivers already on this gpio ?
+  int8_t _slot = -1;
+  bool _shared = false;
+  for( uint8_t i=0; i < EVENT_MAX_DRIVERS; i++ ) {
+    if( _intDrivers[i] == nullptr ) { if( _slot < 0 ) _slot = i; }
+    else if( _intDrivers[i]->_intGpio == gpio ) _shared = true;
+  }
+  if( _slot < 0 ) return false;
+
+  _event    = true;
+  _intGpio  = gpio;
+  _intFired = true;   // first read arms the window
+  _intDrivers[_slot] = this;
+
+  if( not _shared ) {
+    pinMode( gpio, INPUT_PULLUP );
+    attachInterruptArg( digitalPinToInterrupt(gpio), _intISR, (void *)(uintptr_t)gpio, FALLING );
+  }
+  return true;
+}
+
+void generic_driver::_detachINT( void ) {
+  if( _intGpio == INVALID_GPIO ) return;
+
+  bool _shared = false;
+  for( uint8_t i=0; i < EVENT_MAX_DRIVERS; i++ ) {
+    if( _intDrivers[i] == this ) _intDrivers[i] = nullptr;
+    else if( _intDrivers[i] and _intDrivers[i]->_intGpio == _intGpio ) _shared = true;
+  }
+  // last driver on this gpio
+  if( not _shared ) detachInterrupt( digitalPinToInterrupt(_intGpio) );
+  _intGpio = INVALID_GPIO;
+}
+
+bool generic_driver::_eventMode( void ) {
+  return _event;
+}
+
+void ICACHE_RAM_ATTR generic_driver::_intISR( void *arg ) {
+  uint8_t _gpio = (uint8_t)(uintptr_t)arg;
+  for( uint8_t i=0; i < EVENT_MAX_DRIVERS; i++ ) {
+    generic_driver *_drv = _intDrivers[i];
+    if( _drv and _drv->_intGpio == _gpio ) _drv->_intFired = true;
+  }
+}
@@ -11,6 +11,11 @@
 
 	@section  HISTORY
 
+    oct.26  INT line shared by several drivers
+    oct.26  event mode without INT line: driver's status poll
+    oct.26  added optional event mode (sensor read upon INT line only)
+    oct.26  added optional runtime calibration
+    oct.26  added optional driver's status
     nov.21  F.Thiebolt  started to add support for multiple values/subIDs/value_units
                         from a single sensor.
     aug.21  F.Thiebolt  added support for data integration
@@ -53,6 +58,23 @@
 #define _MAX_DATA_DECIMALS      3           // we won't support more than X decimals for sensors' data
 #define DATA_SENDING_VARIATION_THRESHOLD  (float)(0.15) // new official value ought to differ more than this threshold to get sent
 
+/*
+ * EVENT MODE
+ *
+ * Sensors featuring a threshold interrupt get a window programmed around
+ * their last value; they're only read once their INT line fired (and at
+ * least every _MAX_COOLDOWN_SENSOR). Sensor's own persistence (i.e out of
+ * window for some time) replaces the stability counter.
+ * Drivers may run event mode without INT line: a cheap status check
+ * (i.e _eventPoll) then tells every _readMsInterval whether to read.
+ * Open drain INT lines of several sensors may be wired to a single gpio:
+ * one ISR per gpio then flags all drivers attached to it.
+ */
+#ifndef DEFL_EVENT_WINDOW_PERCENT
+#define DEFL_EVENT_WINDOW_PERCENT 10        // interrupt window = last value +/- 10%
+#endif
+#define EVENT_MAX_DRIVERS         8         // drivers in event mode with an INT line
+
 
 
 /*
@@ -66,7 +88,7 @@ class generic_driver {
                     uint8_t threshold_thousandth=DEFL_THRESHOLD_THOUSANDTH );
     
     // destructor
-    virtual ~generic_driver( void ) { return; };
+    virtual ~generic_driver( void ) { _detachINT(); };
 
     // Power Modes
     virtual void powerON( void );         // switch ON
@@ -92,6 +114,15 @@ class generic_driver {
                                                     // [nov.21] pointer enables multi sensing devices to send back multiple values
     virtual void setDataSent( void );               // data has been sent, reset the 'new official data' trigger
 
+    // driver's own status (optional)
+    virtual void status( JsonObject ) { return; };
+
+    // driver's runtime calibration (optional)
+    virtual boolean calibrate( JsonVariant ) { return false; };
+
+    // event mode: sensor read upon INT line only (optional), false means polling
+    virtual boolean setEventMode( uint8_t gpio, uint8_t percent=DEFL_EVENT_WINDOW_PERCENT ) { return false; };
+
     // public attributes
 
   // --- protected methods / attributes ---------------------
@@ -112,6 +143,19 @@ class generic_driver {
 
     float         valueSent;      // official value that has been sent
     unsigned long _lastMsSent;    // (ms) time the official value has been sent
+
+    // event mode
+    bool          _attachINT( uint8_t gpio );   // INT line falling edge, false means polling
+    void          _detachINT( void );
+    bool          _eventMode( void );
+    virtual bool  _eventPoll( void ) { return false; };  // event mode without INT line: sensor's status says read
+    static void ICACHE_RAM_ATTR _intISR( void * );    // arg is the gpio
+    static generic_driver *_intDrivers[EVENT_MAX_DRIVERS];  // drivers attached to INT lines
+    bool          _event;         // event mode
+    uint8_t       _intGpio;       // INT line (INVALID_GPIO means polling or status poll)
+    volatile bool _intFired;      // INT line fired since last read
+    unsigned long _lastMsPoll;    // (ms) last status poll (event mode without INT line)
+    uint8_t       _windowPercent; // window around last value
 };
 
 #endif /* _GENERIC_DRIVER_H_ */
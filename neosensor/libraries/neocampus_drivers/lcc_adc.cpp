@@ -0,0 +1,262 @@
+/**************************************************************************/
+/*!
+  @file     lcc_adc.cpp
+  @author   neOCampus
+  @license
+
+  ESP32 continuous ADC sampling backend for LCC sensors:
+  I2S DMA scan of ADC1 channels, block averaging decimation and
+  calibration lookup table.
+
+	@section  HISTORY
+
+    oct.26  initial release
+*/
+/**************************************************************************/
+
+
+/*
+ * Includes
+ */
+#include <Arduino.h>
+
+#include "neocampus.h"
+#include "neocampus_debug.h"
+
+#include "lcc_adc.h"
+
+#ifdef LCC_ADC_DMA
+  #include <esp_adc_cal.h>
+  #include <driver/i2s.h>
+  #include <driver/adc.h>
+  #include <soc/syscon_struct.h>
+#endif /* LCC_ADC_DMA */
+
+
+/*
+ * Definitions
+ */
+#ifndef DEFL_ESP32_ADC_VREF
+#define DEFL_ESP32_ADC_VREF       1100  // mv, only used if efuse vref is not set
+#endif /* DEFL_ESP32_ADC_VREF */
+
+#define LCC_ADC_I2S_PORT          I2S_NUM_0   // the only one featuring ADC mode
+#define LCC_ADC_TASK_STACK        2048
+#define LCC_ADC_TASK_PRIORITY     1
+#define LCC_ADC_TASK_CORE         0           // Arduino's loop runs on core 1
+
+/* SAR ADC1 pattern table entry: channel[7:4] width[3:2] atten[1:0] */
+#define LCC_ADC_PATTERN(ch)       ((((ch) & 0x0F) << 4) | (ADC_WIDTH_BIT_12 << 2) | ADC_ATTEN_DB_11)
+
+
+/*
+ * Static attributes
+ */
+boolean lcc_adc::_running               = false;
+#ifdef LCC_ADC_DMA
+uint8_t lcc_adc::_channels              = 0;
+uint8_t lcc_adc::_nbChannels            = 0;
+TaskHandle_t lcc_adc::_taskHandle       = nullptr;
+uint16_t lcc_adc::_lut[LCC_ADC_LUT_SIZE];
+uint32_t lcc_adc::_sum[LCC_ADC_MAX_CHANNELS];
+uint16_t lcc_adc::_cnt[LCC_ADC_MAX_CHANNELS];
+volatile uint32_t lcc_adc::_value[LCC_ADC_MAX_CHANNELS];
+#endif /* LCC_ADC_DMA */
+
+
+
+/**************************************************************************/
+/*!
+    @brief  add an analog input to the scanned channels
+    @note   sampling gets (re)started with the new channels set
+*/
+/**************************************************************************/
+boolean lcc_adc::addChannel( uint8_t gpio ) {
+#ifdef LCC_ADC_DMA
+  int8_t ch = digitalPinToAnalogChannel( gpio );
+  if( ch < 0 or ch >= LCC_ADC_MAX_CHANNELS ) {
+    log_error(F("\n[lcc_adc] gpio ")); log_error(gpio,DEC); log_error(F(" is not an ADC1 input ?!")); log_flush();
+    return false;
+  }
+  if( _running and (_channels & (1 << ch)) ) return true;
+
+  stop();
+  _channels |= (1 << ch);
+  return _start();
+#else
+  return false;
+#endif /* LCC_ADC_DMA */
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  latest decimated value of an analog input, in mV
+    @note   false until a first block of samples has been averaged
+*/
+/**************************************************************************/
+boolean lcc_adc::read_mv( uint8_t gpio, uint32_t *pval ) {
+#ifdef LCC_ADC_DMA
+  if( !_running or pval==nullptr ) return false;
+  int8_t ch = digitalPinToAnalogChannel( gpio );
+  if( ch < 0 or ch >= LCC_ADC_MAX_CHANNELS or not (_channels & (1 << ch)) ) return false;
+
+  uint32_t _raw = _value[ch];   // 32 bits aligned read is atomic
+  if( _raw==0 ) return false;
+  *pval = _raw2mv( _raw - 1 );
+  return true;
+#else
+  return false;
+#endif /* LCC_ADC_DMA */
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  stop sampling, ADC1 gets released
+*/
+/**************************************************************************/
+void lcc_adc::stop( void ) {
+#ifdef LCC_ADC_DMA
+  if( !_running ) return;
+  if( _taskHandle ) {
+    vTaskDelete( _taskHandle );
+    _taskHandle = nullptr;
+  }
+  i2s_adc_disable( LCC_ADC_I2S_PORT );
+  i2s_driver_uninstall( LCC_ADC_I2S_PORT );
+#endif /* LCC_ADC_DMA */
+  _running = false;
+}
+
+
+/* ------------------------------------------------------------------------------
+ * Private'n Protected methods
+ */
+
+#ifdef LCC_ADC_DMA
+/**************************************************************************/
+/*!
+    @brief  setup calibration LUT, I2S ADC mode and scan pattern, then
+            start the task draining the DMA buffers
+*/
+/**************************************************************************/
+boolean lcc_adc::_start( void ) {
+
+  if( !_channels ) return false;
+
+  /* calibration lookup table: the I2S ADC mode delivers 12 bits samples
+   * thus a dedicated characterization (efuse Vref or two points)
+   */
+  esp_adc_cal_characteristics_t _chars;
+  esp_adc_cal_characterize( ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, DEFL_ESP32_ADC_VREF, &_chars );
+  for( uint8_t i=0; i < LCC_ADC_LUT_SIZE; i++ ) {
+    uint32_t _raw = (uint32_t)i << LCC_ADC_LUT_SHIFT;
+    _lut[i] = (uint16_t)esp_adc_cal_raw_to_voltage( min(_raw,(uint32_t)4095), &_chars );
+  }
+
+  // I2S in built-in ADC mode
+  i2s_config_t _cfg;
+  memset( &_cfg, 0, sizeof(_cfg) );
+  _cfg.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+  _cfg.sample_rate = LCC_ADC_RATE;
+  _cfg.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+  _cfg.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+  _cfg.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+  _cfg.dma_buf_count = LCC_ADC_DMA_BUFFERS;
+  _cfg.dma_buf_len = LCC_ADC_DMA_SAMPLES;
+  _cfg.use_apll = false;
+  if( i2s_driver_install( LCC_ADC_I2S_PORT, &_cfg, 0, nullptr ) != ESP_OK ) {
+    log_error(F("\n[lcc_adc] unable to install I2S driver ?!")); log_flush();
+    return false;
+  }
+
+  // scanned channels, first one gets used to setup the ADC mode
+  uint8_t _list[LCC_ADC_MAX_CHANNELS];
+  _nbChannels = 0;
+  for( uint8_t ch=0; ch < LCC_ADC_MAX_CHANNELS; ch++ ) {
+    if( not (_channels & (1 << ch)) ) continue;
+    adc1_config_channel_atten( (adc1_channel_t)ch, ADC_ATTEN_DB_11 );
+    _list[_nbChannels++] = ch;
+    _sum[ch] = 0;
+    _cnt[ch] = 0;
+    _value[ch] = 0;
+  }
+  i2s_set_adc_mode( ADC_UNIT_1, (adc1_channel_t)_list[0] );
+  if( i2s_adc_enable( LCC_ADC_I2S_PORT ) != ESP_OK ) {
+    log_error(F("\n[lcc_adc] unable to enable I2S ADC mode ?!")); log_flush();
+    i2s_driver_uninstall( LCC_ADC_I2S_PORT );
+    return false;
+  }
+
+  /* multi-channels scan: overwrite the single entry pattern table set by
+   * the driver; four 8 bits entries per 32 bits word, MSB first.
+   */
+  uint32_t _patt[2] = { 0, 0 };
+  for( uint8_t i=0; i < _nbChannels; i++ ) {
+    _patt[i/4] |= (uint32_t)LCC_ADC_PATTERN(_list[i]) << (24 - 8*(i%4));
+  }
+  SYSCON.saradc_ctrl.sar1_patt_len = _nbChannels - 1;
+  SYSCON.saradc_sar1_patt_tab[0] = _patt[0];
+  SYSCON.saradc_sar1_patt_tab[1] = _patt[1];
+
+  // DMA draining task
+  if( xTaskCreatePinnedToCore( _task, "lcc_adc", LCC_ADC_TASK_STACK, nullptr,
+                               LCC_ADC_TASK_PRIORITY, &_taskHandle, LCC_ADC_TASK_CORE ) != pdPASS ) {
+    log_error(F("\n[lcc_adc] unable to start sampling task ?!")); log_flush();
+    _taskHandle = nullptr;
+    i2s_adc_disable( LCC_ADC_I2S_PORT );
+    i2s_driver_uninstall( LCC_ADC_I2S_PORT );
+    return false;
+  }
+
+  _running = true;
+  log_info(F("\n[lcc_adc] DMA sampling of ")); log_info(_nbChannels,DEC);
+  log_info(F(" ADC1 channel(s) at ")); log_info(LCC_ADC_RATE,DEC); log_info(F("Hz")); log_flush();
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  DMA draining task: block averaging of LCC_ADC_OVERSAMPLING
+            samples per channel; published value is a fixed point raw
+            value (LCC_ADC_FRAC_BITS) plus one (0 means none yet)
+*/
+/**************************************************************************/
+void lcc_adc::_task( void * ) {
+  uint16_t _buf[LCC_ADC_DMA_SAMPLES];
+  size_t _len;
+
+  for(;;) {
+    if( i2s_read( LCC_ADC_I2S_PORT, _buf, sizeof(_buf), &_len, portMAX_DELAY ) != ESP_OK ) continue;
+
+    for( size_t i=0; i < _len/sizeof(uint16_t); i++ ) {
+      uint8_t ch = (_buf[i] >> 12) & 0x07;
+      if( not (_channels & (1 << ch)) ) continue;
+      _sum[ch] += _buf[i] & 0x0FFF;
+      if( ++_cnt[ch] < LCC_ADC_OVERSAMPLING ) continue;
+
+      // decimation
+      _value[ch] = ((_sum[ch] << LCC_ADC_FRAC_BITS) / LCC_ADC_OVERSAMPLING) + 1;
+      _sum[ch] = 0;
+      _cnt[ch] = 0;
+    }
+  }
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  fixed point raw value to mV, linear interpolation within the
+            calibration LUT
+*/
+/**************************************************************************/
+uint32_t lcc_adc::_raw2mv( uint32_t raw ) {
+  const uint8_t _shift = LCC_ADC_LUT_SHIFT + LCC_ADC_FRAC_BITS;
+  uint32_t idx = raw >> _shift;
+  if( idx >= LCC_ADC_LUT_SIZE - 1 ) return _lut[LCC_ADC_LUT_SIZE - 1];
+  uint32_t frac = raw & ((1UL << _shift) - 1);
+  return _lut[idx] + ((((uint32_t)_lut[idx+1] - _lut[idx]) * frac) >> _shift);
+}
+#endif /* LCC_ADC_DMA */
@@ -0,0 +1,95 @@
+/**************************************************************************/
+/*!
+    @file     lcc_adc.h
+    @author   neOCampus
+	  @license
+
+    This is part of a the neOCampus drivers library.
+    ESP32 continuous ADC sampling backend for the LCC air quality sensors:
+    ADC1 channels get scanned by the I2S DMA at a fixed rate, samples are
+    oversampled and decimated through block averaging then converted to mV
+    with a precomputed (eFuse based) calibration lookup table.
+    Hence a fresh low-noise mV value is available at any time at no cost.
+
+    (c) Copyright 2026 neOCampus
+
+  @note
+    - I2S ADC mode only works with ADC1 (i.e GPIOs 32 to 39)
+    - ADC1 gets locked by the I2S driver: analogRead() on ADC1 inputs is
+      not available while the backend is running
+    - samples come in 16 bits words: channel[15:12] data[11:0]
+
+	@section  HISTORY
+
+    oct.26  initial release
+
+*/
+/**************************************************************************/
+
+#ifndef _LCC_ADC_H_
+#define _LCC_ADC_H_
+
+
+#include <Arduino.h>
+
+
+/*
+ * Definitions
+ */
+#if defined(ESP32) && !defined(DISABLE_ADC_CAL) && !defined(DISABLE_ADC_DMA)
+  #define LCC_ADC_DMA                   // continuous DMA sampling available
+#endif
+
+#ifndef LCC_ADC_RATE
+#define LCC_ADC_RATE              20000   // Hz, overall sampling rate (shared among channels)
+#endif /* LCC_ADC_RATE */
+
+#ifndef LCC_ADC_OVERSAMPLING
+#define LCC_ADC_OVERSAMPLING      1024    // samples averaged per channel for a single value
+#endif /* LCC_ADC_OVERSAMPLING */
+
+#define LCC_ADC_MAX_CHANNELS      8       // ADC1 channels
+#define LCC_ADC_DMA_BUFFERS       4       // nb of DMA buffers
+#define LCC_ADC_DMA_SAMPLES       256     // samples per DMA buffer
+#define LCC_ADC_LUT_SHIFT         6       // calibration LUT: one point every 64 raw codes
+#define LCC_ADC_LUT_SIZE          ((4096 >> LCC_ADC_LUT_SHIFT) + 1)
+#define LCC_ADC_FRAC_BITS         4       // fixed point raw values (oversampling gains resolution)
+
+
+
+/*
+ * Class
+ */
+class lcc_adc {
+  public:
+    // add an analog input to the scanned channels: (re)starts sampling
+    static boolean addChannel( uint8_t gpio );
+
+    // latest decimated value of an analog input (false if not yet available)
+    static boolean read_mv( uint8_t gpio, uint32_t *pval );
+
+    // sampling is running
+    static boolean running( void ) { return _running; };
+
+    // stop sampling (ADC1 gets released)
+    static void stop( void );
+
+  private:
+#ifdef LCC_ADC_DMA
+    static boolean _start( void );
+    static void _task( void * );            // DMA draining and block averaging
+    static uint32_t _raw2mv( uint32_t );    // fixed point raw to mV through LUT
+
+    static uint8_t _channels;               // bitmask of scanned ADC1 channels
+    static uint8_t _nbChannels;
+    static TaskHandle_t _taskHandle;
+    static uint16_t _lut[LCC_ADC_LUT_SIZE]; // mV every (1 << LCC_ADC_LUT_SHIFT) raw codes
+
+    static uint32_t _sum[LCC_ADC_MAX_CHANNELS];     // [task] current block sums
+    static uint16_t _cnt[LCC_ADC_MAX_CHANNELS];     // [task] current block samples
+    static volatile uint32_t _value[LCC_ADC_MAX_CHANNELS];  // latest decimated fixed point raw value (0 means none)
+#endif /* LCC_ADC_DMA */
+    static boolean _running;
+};
+
+#endif /* _LCC_ADC_H_ */
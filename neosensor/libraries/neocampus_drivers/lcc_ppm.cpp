@@ -0,0 +1,119 @@
+/**************************************************************************/
+/*!
+  @file     lcc_ppm.cpp
+  @author   neOCampus
+  @license
+
+  Piecewise-linear fixed point conversion tables for LCC sensors
+
+	@section  HISTORY
+
+    oct.26  initial release
+*/
+/**************************************************************************/
+
+
+/*
+ * Includes
+ */
+#include <math.h>
+
+#include "lcc_ppm.h"
+
+
+
+/**************************************************************************/
+/*!
+    @brief  set table from calibration points
+    @note   fractional bits get selected so that largest value fits
+*/
+/**************************************************************************/
+bool lcc_ppm_table::set( const uint16_t *mv, const float *val, uint8_t nb ) {
+
+  clear();
+  if( mv==nullptr or val==nullptr or nb==0 or nb > LCC_PPM_MAX_POINTS ) return false;
+
+  float _max = 0;
+  for( uint8_t i=0; i < nb; i++ ) {
+    if( i and mv[i] <= mv[i-1] ) return false;
+    if( val[i] < 0 or isnan(val[i]) ) return false;
+    if( val[i] > _max ) _max = val[i];
+  }
+
+  // fixed point format
+  int8_t _f = LCC_PPM_MAX_FRAC;
+  while( _f > -31 and ldexpf(_max, _f) >= 2147483648.0f ) _f--;   // 31 bits headroom
+
+  for( uint8_t i=0; i < nb; i++ ) {
+    _mv[i] = mv[i];
+    _val[i] = (uint32_t)lroundf( ldexpf(val[i], _f) );
+  }
+  _frac = _f;
+  _nb = nb;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  default table: sensor resistance Rgain*(5000-mv)/mv
+*/
+/**************************************************************************/
+bool lcc_ppm_table::setResistance( uint32_t rgain ) {
+
+  uint16_t _mvs[LCC_PPM_DEFL_POINTS];
+  float _vals[LCC_PPM_DEFL_POINTS];
+
+  /* points evenly spread over log(resistance) rather than log(mv) because
+   * of the (5000-mv) term: lower interpolation error for the same size
+   */
+  const float _rmax = (float)(LCC_PPM_VCC_MV - LCC_PPM_DEFL_MV_MIN) / LCC_PPM_DEFL_MV_MIN;
+  const float _rmin = (float)(LCC_PPM_VCC_MV - LCC_PPM_DEFL_MV_MAX) / LCC_PPM_DEFL_MV_MAX;
+
+  uint8_t _n = 0;
+  for( uint8_t i=0; i < LCC_PPM_DEFL_POINTS; i++ ) {
+    float _r = _rmax * powf(_rmin / _rmax, (float)i / (LCC_PPM_DEFL_POINTS - 1));
+    uint16_t _mv = (uint16_t)lroundf( LCC_PPM_VCC_MV / (1.0f + _r) );
+    if( _n and _mv <= _mvs[_n-1] ) continue;
+    _mvs[_n] = _mv;
+    _vals[_n] = (float)rgain * (LCC_PPM_VCC_MV - _mv) / _mv;
+    _n++;
+  }
+  return set( _mvs, _vals, _n );
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  fixed point conversion: binary search of the segment then
+            integer interpolation
+*/
+/**************************************************************************/
+uint32_t lcc_ppm_table::lookup( uint32_t mv ) const {
+
+  if( _nb==0 ) return 0;
+  if( mv <= _mv[0] ) return _val[0];
+  if( mv >= _mv[_nb-1] ) return _val[_nb-1];
+
+  // largest i such that _mv[i] <= mv
+  uint8_t lo = 0, hi = _nb - 1;
+  while( hi - lo > 1 ) {
+    uint8_t mid = (lo + hi) / 2;
+    if( _mv[mid] <= mv ) lo = mid;
+    else hi = mid;
+  }
+
+  int64_t dv = (int64_t)_val[hi] - (int64_t)_val[lo];
+  return (uint32_t)( (int64_t)_val[lo] + dv * (int64_t)(mv - _mv[lo]) / (int64_t)(_mv[hi] - _mv[lo]) );
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  conversion to (float) value
+*/
+/**************************************************************************/
+float lcc_ppm_table::value( uint32_t mv ) const {
+  if( _nb==0 ) return -1.0;
+  return ldexpf( (float)lookup(mv), -_frac );
+}
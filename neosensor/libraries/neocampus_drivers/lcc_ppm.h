@@ -0,0 +1,83 @@
+/**************************************************************************/
+/*!
+    @file     lcc_ppm.h
+    @author   neOCampus
+	  @license
+
+    This is part of a the neOCampus drivers library.
+    Piecewise-linear conversion tables for the LCC air quality sensors:
+    one table per gain resistor maps the AOP output (mV) to either a
+    calibrated concentration or, as default, the sensor resistance.
+
+    (c) Copyright 2026 neOCampus
+
+  @note
+    Tables are built once (begin or calibration order) and hold fixed
+    point values (value * 2^frac) so that a conversion is a binary search
+    followed by an integer interpolation.
+    This code does not depend on the Arduino framework (host tests).
+
+	@section  HISTORY
+
+    oct.26  initial release (from lcc_sensor float calculatePPM)
+
+*/
+/**************************************************************************/
+
+#ifndef _LCC_PPM_H_
+#define _LCC_PPM_H_
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+
+/*
+ * Definitions
+ */
+#define LCC_PPM_MAX_POINTS        48      // max. number of points per table
+#define LCC_PPM_MAX_FRAC          16      // max. fractional bits of fixed point values
+
+/* default table: sensor resistance Rgain*(5000-mv)/mv
+ * over the [MV_MIN, MV_MAX] range
+ */
+#define LCC_PPM_VCC_MV            5000
+#define LCC_PPM_DEFL_MV_MIN       50      // below this, values saturate
+#define LCC_PPM_DEFL_MV_MAX       3300
+#define LCC_PPM_DEFL_POINTS       LCC_PPM_MAX_POINTS
+
+
+
+/*
+ * Class
+ */
+class lcc_ppm_table {
+  public:
+    lcc_ppm_table( void ) { clear(); };
+
+    void clear( void ) { _nb = 0; _frac = 0; };
+
+    // calibration points: mv strictly increasing, values >= 0
+    bool set( const uint16_t *mv, const float *val, uint8_t nb );
+
+    // default curve: sensor resistance for a given gain resistor
+    bool setResistance( uint32_t rgain );
+
+    // fixed point (i.e value * 2^frac()) conversion, values saturate outside of table
+    uint32_t lookup( uint32_t mv ) const;
+
+    // conversion, -1.0 when table is empty
+    float value( uint32_t mv ) const;
+
+    uint8_t size( void ) const { return _nb; };
+    int8_t frac( void ) const { return _frac; };
+
+  private:
+    uint16_t _mv[LCC_PPM_MAX_POINTS];
+    uint32_t _val[LCC_PPM_MAX_POINTS];
+    uint8_t _nb;
+    int8_t _frac;     // fractional bits (negative for very large values)
+};
+
+#endif /* _LCC_PPM_H_ */
@@ -8,6 +8,14 @@
 
 	@section  HISTORY
 
+    oct.26  campaign left upon reset (group campaign accounting)
+    oct.26  mv conversion through piecewise-linear fixed point tables
+            (one per gain), default tables match former Rsensor formula,
+            calibration curves from params or 'calibration' order
+    oct.26  no more delay() within FSM: heater pulses, gain integration
+            and measures interleave are scheduled transitions, the
+            main loop gets woken up on timer expiry.
+            Campaign durations and longest process() in status
     aug.20  F.Thiebolt  neOCampus integration
                         adapted for neOCampus
                         added new CalculatePPM computation proposal
@@ -27,8 +35,10 @@
 
 #include "neocampus.h"
 #include "neocampus_debug.h"
+#include "neocampus_utils.h"
 
 #include "lcc_sensor.h"
+#include "lcc_adc.h"
 
 
 /* 
@@ -52,9 +62,13 @@
 
 
 /* declare kind of units (value_units) */
-//const char *lcc_sensor::units = "ppm";
-const char *lcc_sensor::units = "ohm";  // better to avoid this, we really need to give a ppm value
-#warning "better to send ppm value instead of ohm!"
+const char *lcc_sensor::units = "ohm";      // uncalibrated sensor: resistance
+const char *lcc_sensor::units_ppm = "ppm";  // calibration curves
+
+/* campaigns accounting shared among all LCC sensors */
+uint8_t lcc_sensor::_activeCampaigns    = 0;
+unsigned long lcc_sensor::_groupStart   = 0;
+uint32_t lcc_sensor::_groupMs           = 0;
 
 
 /**************************************************************************/
@@ -76,6 +90,12 @@ lcc_sensor::lcc_sensor( void ) : generic_driver( LCC_MEASURES_INTERLEAVE_MS,
   }
   _cur_gain = LCC_SENSOR_GAIN_NONE;
   _nb_measures = 0;
+  _calibrated = false;
+
+  _campaignStart = 0;
+  _campaignMs = 0;
+  _inCampaign = false;
+  _stallMaxUs = 0;
 }
 
 
@@ -98,6 +118,9 @@ boolean lcc_sensor::begin( JsonVariant root ) {
   boolean _param_subID = false;
   boolean _param_input = false;
 
+  // default conversion tables (i.e sensor resistance)
+  calibrate( JsonVariant() );
+
   /* parse all parameters of our sensor:
   [
     {
@@ -119,6 +142,12 @@ boolean lcc_sensor::begin( JsonVariant root ) {
     {
       "param": "outputs",
       "value": -1
+    },
+    {
+      "param": "calibration",   (optional, one curve per gain resistor)
+      "value": [
+        { "gain": 1000000, "mv": [100, 500, 1200, 2500], "ppm": [0, 0.5, 2, 10] }
+      ]
     }
   ]
   */
@@ -162,6 +191,16 @@ boolean lcc_sensor::begin( JsonVariant root ) {
       }
     }
 
+    // CALIBRATION
+    {
+      const char *_param = PSTR("calibration");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        if( !calibrate( item[F("value")] ) ) {
+          log_error(F("\n[lcc_sensor] invalid calibration curves ... keeping resistance values")); log_flush();
+        }
+      }
+    }
+
   }
 
 
@@ -197,6 +236,8 @@ void lcc_sensor::process( uint16_t coolDown,
                           uint8_t decimals ) {
   if( !_initialized ) return;
 
+  unsigned long _startUs = micros();
+
   // process according to our FSM
   switch( _FSMstatus ) {
 
@@ -205,6 +246,11 @@ void lcc_sensor::process( uint16_t coolDown,
       log_debug(F("\n\t[lcc_sensor]["));log_debug(_subID);log_debug(F("] about to start a new acquisition cycle ...")); log_flush();
       _FSMtimerDelay = 0;
 
+      // campaign accounting
+      _campaignStart = millis();
+      if( _activeCampaigns++ == 0 ) _groupStart = _campaignStart;
+      _inCampaign = true;
+
       // activate heating ...
       _FSMstatus = lccSensorState_t::heating;
       if( heaterStart() ) {
@@ -249,6 +295,11 @@ void lcc_sensor::process( uint16_t coolDown,
       log_debug(F("\n\t[lcc_sensor]["));log_debug(_subID);log_debug(F("] end of measures :) ... activate trigger")); log_flush();
       _trigger = true;
 
+      // campaign accounting
+      _campaignMs = millis() - _campaignStart;
+      if( _activeCampaigns and --_activeCampaigns == 0 ) _groupMs = millis() - _groupStart;
+      _inCampaign = false;
+
       // ok continue with next step: wait4read
       _FSMstatus = lccSensorState_t::wait4read;
       if( _nb_measures ) {
@@ -271,6 +322,86 @@ void lcc_sensor::process( uint16_t coolDown,
       log_error(F("\n\t[lcc_sensor]["));log_debug(_subID);log_debug(F("] unknown FSM state ?!?! ... resetting !")); log_flush();
       _init();
   }
+
+  // loop stall accounting
+  uint32_t _stallUs = micros() - _startUs;
+  if( _stallUs > _stallMaxUs ) _stallMaxUs = _stallUs;
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  status: campaigns durations and longest process() call
+    @note   longest process() call gets reset on each status
+*/
+/**************************************************************************/
+void lcc_sensor::status( JsonObject root ) {
+  if( !_initialized ) return;
+
+  root[F("subID")] = _subID;
+  root[F("campaign_ms")] = _campaignMs;   // this sensor
+  root[F("group_ms")] = _groupMs;         // all LCC sensors (interleaved)
+  root[F("stall_max_us")] = _stallMaxUs;
+  _stallMaxUs = 0;
+  root[F("adc")] = ( lcc_adc::running() ? F("dma") : F("oneshot") );
+  root[F("calibrated")] = _calibrated;
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  load conversion tables from calibration curves:
+            - null or empty array: sensor resistance tables (uncalibrated)
+            - array of curves: one per gain, missing gains get no values
+            - single curve (e.g from an order): replace this gain table
+    @note   a curve is { "gain": <resistor ohms>, "mv": [..], "ppm": [..] }
+            with strictly increasing mv values.
+*/
+/**************************************************************************/
+boolean lcc_sensor::calibrate( JsonVariant root ) {
+
+  // uncalibrated: sensor resistance
+  if( root.isNull() or (root.is<JsonArray>() and root.size()==0) ) {
+    uint32_t _rgain = LCC_SENSOR_RBASE;
+    for( uint8_t g=LCC_SENSOR_GAIN_MIN; g<=LCC_SENSOR_GAIN_MAX; g++ ) {
+      _ppm[g].setResistance( _rgain );
+      _rgain *= LCC_SENSOR_RFACTOR;
+    }
+    _calibrated = false;
+    return true;
+  }
+
+  // single curve
+  if( root.is<JsonObject>() ) {
+    lcc_ppm_table _t;
+    int8_t g = _parseCurve( root.as<JsonObject>(), &_t );
+    if( g < 0 ) return false;
+    if( !_calibrated ) {
+      // do not mix resistance and ppm values
+      for( lcc_ppm_table &_p : _ppm ) _p.clear();
+      _calibrated = true;
+    }
+    _ppm[g] = _t;
+    return true;
+  }
+
+  if( not root.is<JsonArray>() ) return false;
+
+  // whole set of curves: check them all before any change
+  {
+    lcc_ppm_table _t;
+    for( JsonVariant curve : root.as<JsonArray>() ) {
+      if( not curve.is<JsonObject>() or _parseCurve( curve.as<JsonObject>(), &_t ) < 0 ) return false;
+    }
+  }
+  for( lcc_ppm_table &_p : _ppm ) _p.clear();
+  for( JsonVariant curve : root.as<JsonArray>() ) {
+    lcc_ppm_table _t;
+    int8_t g = _parseCurve( curve.as<JsonObject>(), &_t );
+    _ppm[g] = _t;
+  }
+  _calibrated = true;
+  return true;
 }
 
 
@@ -317,12 +448,41 @@ boolean lcc_sensor::acquire( float *pval )
  */
 
 
+/**************************************************************************/
+/*! 
+    @brief  schedule FSM next transition in ms
+    @note   main loop gets woken up on expiry, hence short delays (i.e
+            < MAIN_LOOP_DELAY) don't need to get waited for anymore
+*/
+/**************************************************************************/
+void lcc_sensor::_FSMsetTimer( uint16_t ms ) {
+  _FSMtimerStart = millis();
+  _FSMtimerDelay = ms;
+  if( ms ) wakeupLoopIn( ms );
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  non blocking API: still waiting for current timer ?
+    @note   look at https://arduino.stackexchange.com/questions/33572/arduino-countdown-without-using-delay/33577#33577
+            for an explanation about millis() that wrap around!
+*/
+/**************************************************************************/
+boolean lcc_sensor::_FSMtimerBusy( void ) {
+  if( _FSMtimerDelay==0 ) return false;
+  if( (millis() - _FSMtimerStart) >= (unsigned long)_FSMtimerDelay ) {
+    _FSMtimerDelay = 0;
+    return false;
+  }
+  return true;
+}
+
+
 /**************************************************************************/
 /*! 
     @brief  start heater for a specified duration up to 65535ms
-            for short pulse duration (< MAIN_DELAY_LOOP ---i.e 250ms), we
-            wait for the specified delay, hence blocking behaviour,
-            otherwise this is a non blocking API.
+            non blocking API, whatever the pulse duration
 */
 /**************************************************************************/
 boolean lcc_sensor::heaterStart( uint16_t pulse_ms ) {
@@ -332,17 +492,8 @@ boolean lcc_sensor::heaterStart( uint16_t pulse_ms ) {
   // ok, we start heating the sensor
   digitalWrite( _heater_gpio, HIGH );
 
-  // short pulse ?
-  if( pulse_ms < MAIN_LOOP_DELAY ) {
-    delay( pulse_ms );
-    digitalWrite( _heater_gpio, LOW );
-    _FSMtimerDelay = 0;
-    return false; // no delay activated
-  }
-
   // set FSM timer ...
-  _FSMtimerStart = millis();
-  _FSMtimerDelay = pulse_ms;
+  _FSMsetTimer( pulse_ms );
 
   return true;
 }
@@ -359,19 +510,12 @@ boolean lcc_sensor::heaterBusy( void ) {
 
   if( _heater_gpio==INVALID_GPIO or _FSMtimerDelay==0 ) return false;
 
-  /* reached the delay ?
-   * look at https://arduino.stackexchange.com/questions/33572/arduino-countdown-without-using-delay/33577#33577
-   * for an explanation about millis() that wrap around!
-   */
-  if( (millis() - _FSMtimerStart) >= (unsigned long)_FSMtimerDelay ) {
-    // end of heating period
-    digitalWrite( _heater_gpio, LOW );
-    _FSMtimerDelay = 0;
-    return false;
-  }
+  // heating still on way ?
+  if( _FSMtimerBusy() ) return true;
 
-  // heating still on way
-  return true;
+  // end of heating period
+  digitalWrite( _heater_gpio, LOW );
+  return false;
 }
 
 
@@ -414,14 +558,7 @@ boolean lcc_sensor::autoGainStart( uint16_t integration_ms ) {
   }
 
   // integration delay
-  _FSMtimerDelay = 0;
-  if( integration_ms >= MAIN_LOOP_DELAY ) {
-    _FSMtimerDelay = integration_ms;
-    _FSMtimerStart = millis();
-  }
-  else if( integration_ms!=0 ) {
-    delay( integration_ms );
-  }
+  _FSMsetTimer( integration_ms );
 
   log_debug(F("\n\t[lcc_sensor]["));log_debug(_subID);log_debug(F("][autoGainStart] _cur_gain = ")); log_debug(_cur_gain); log_flush();
 
@@ -444,10 +581,7 @@ boolean lcc_sensor::autoGainBusy( uint16_t integration_ms ) {
   do {
 
     // do we need to wait (i.e are we busy) ?
-    if( _FSMtimerDelay!=0 and 
-        (millis() - _FSMtimerStart) < (unsigned long)_FSMtimerDelay ) {
-      return true;
-    }
+    if( _FSMtimerBusy() ) return true;
 
     // read adc
     uint32_t _adc_val;
@@ -472,14 +606,9 @@ boolean lcc_sensor::autoGainBusy( uint16_t integration_ms ) {
       break;
     }
 
-    // wait delay (short pulse)
-    if( integration_ms < MAIN_LOOP_DELAY ) {
-      delay( integration_ms );
-      _FSMtimerDelay = 0;
-      continue; // restart ADC acquire
-    }
-    _FSMtimerStart = millis();
-    _FSMtimerDelay = integration_ms;
+    // integration delay of the new gain
+    _FSMsetTimer( integration_ms );
+    if( _FSMtimerDelay==0 ) continue; // restart ADC acquire
     return true; // we're busy so check on next loop() iteration
 
   } while( _found==false );
@@ -508,6 +637,9 @@ boolean lcc_sensor::readSensor_mv( uint32_t *pval ) {
 
 #if defined(ESP32)
   #if !defined(DISABLE_ADC_CAL)
+  // continuous sampling: latest oversampled value (ADC1 is locked by the DMA)
+  if( lcc_adc::running() ) return lcc_adc::read_mv( _inputs[LCC_SENSOR_ANALOG], pval );
+
   // advanced ADC reading
   esp_err_t res;
   uint8_t _retry = 3;
@@ -562,8 +694,7 @@ boolean lcc_sensor::measureBusy( void ) {
   while( _nb_measures < LCC_MAX_MEASURES ) {
     
     // do we need to wait (i.e are we busy) ?
-    if( _FSMtimerDelay!=0 and 
-        (millis() - _FSMtimerStart) < (unsigned long)_FSMtimerDelay ) return true;
+    if( _FSMtimerBusy() ) return true;
 
     // acquire data
     res = readSensor_mv( &_measures[_nb_measures] );
@@ -577,15 +708,7 @@ boolean lcc_sensor::measureBusy( void ) {
     if( _nb_measures == LCC_MAX_MEASURES ) break; // not busy anymore
 
     // delay between two measures
-    if( LCC_MEASURES_INTERLEAVE_MS < MAIN_LOOP_DELAY ) {
-      delay( LCC_MEASURES_INTERLEAVE_MS );
-      _FSMtimerDelay = 0;
-      continue;
-    }
-
-    // long delay between measures
-    _FSMtimerStart = millis();
-    _FSMtimerDelay = LCC_MEASURES_INTERLEAVE_MS;
+    _FSMsetTimer( LCC_MEASURES_INTERLEAVE_MS );
     return true; // we're busy so check on next loop() iteration
   }
 
@@ -609,31 +732,59 @@ float lcc_sensor::calculatePPM( uint32_t mv ) {
   /* sep.20: this computation is based on Aymen algorithm.
    * It does not produce a 'ppm' value but instead it 
    * provides a R-ohm of the sensor itself.
+   * [oct.26] precomputed tables: either calibration curves (ppm) or
+   * the Rsensor computation below (see lcc_ppm.h)
+   *    Original Rsensor computation (Aymen)
+   *      Rgain*3300/mv-Rgain;
+   *    [aug.20] Francois Rsensor computation proposal,
+   *      Rgain*(5000-mv)/mv;
    */
 
   log_debug(F("\n\t[lcc_sensor]["));log_debug(_subID);log_debug(F("][calculatePPM] avg adc input(mv): ")); log_debug(mv); log_flush();
 
-  // Gain resistor
-  uint32_t Rgain = 0;
-  switch(_cur_gain) {
-    case LCC_SENSOR_10K:
-      Rgain = 10000; break;
-    case LCC_SENSOR_100K:
-      Rgain = 100000; break;
-    case LCC_SENSOR_1M:
-      Rgain = 1000000; break;
-    case LCC_SENSOR_10M:
-      Rgain = 10000000; break;
-    default:
-      Rgain = 0;
+  if( _cur_gain > LCC_SENSOR_GAIN_MAX ) return -1.0;
+  if( _ppm[_cur_gain].size()==0 ) {
+    log_warning(F("\n\t[lcc_sensor]["));log_warning(_subID);log_warning(F("] no calibration curve for current gain ?!")); log_flush();
+    return -1.0;
   }
+  return _ppm[_cur_gain].value( mv );
+}
+
+
+/**************************************************************************/
+/*! 
+    @brief  calibration curve to conversion table
+    @return gain index or -1
+*/
+/**************************************************************************/
+int8_t lcc_sensor::_parseCurve( JsonObject curve, lcc_ppm_table *table ) {
 
-  // Original Rsensor computation (Aymen)
-  //return (float)Rgain*3300/mv-Rgain;
+  if( curve.isNull() or table==nullptr ) return -1;
 
-  // [aug.20] Francois Rsensor computation proposal,
-  // ... best will be to evalute a PPM concentration ;)
-  return (float)Rgain*(5000-mv)/mv;
+  // gain resistor
+  uint32_t _gain = curve[F("gain")].as<uint32_t>();
+  int8_t g = -1;
+  uint32_t _rgain = LCC_SENSOR_RBASE;
+  for( uint8_t i=LCC_SENSOR_GAIN_MIN; i<=LCC_SENSOR_GAIN_MAX; i++ ) {
+    if( _rgain == _gain ) { g = i; break; }
+    _rgain *= LCC_SENSOR_RFACTOR;
+  }
+  if( g < 0 ) return -1;
+
+  // points
+  JsonArray _mvs = curve[F("mv")];
+  JsonArray _vals = curve[F("ppm")];
+  if( _mvs.isNull() or _vals.isNull() or _mvs.size()!=_vals.size() or
+      _mvs.size()==0 or _mvs.size() > LCC_PPM_MAX_POINTS ) return -1;
+
+  uint16_t _mv[LCC_PPM_MAX_POINTS];
+  float _val[LCC_PPM_MAX_POINTS];
+  uint8_t _nb = 0;
+  for( JsonVariant v : _mvs ) _mv[_nb++] = v.as<uint16_t>();
+  _nb = 0;
+  for( JsonVariant v : _vals ) _val[_nb++] = v.as<float>();
+
+  return ( table->set( _mv, _val, _nb ) ? g : -1 );
 }
 
 
@@ -693,6 +844,12 @@ boolean lcc_sensor::_init( void ) {
   _nb_measures = 0;
   _trigger = false;
 
+  // [oct.26] reset while in a campaign: release our share of the group campaign
+  if( _inCampaign ) {
+    if( _activeCampaigns ) _activeCampaigns--;
+    _inCampaign = false;
+  }
+
   // set FSM initial state
   _FSMstatus = LCC_SENSOR_STATE_DEFL;
   _FSMtimerDelay = 0;
@@ -721,8 +878,10 @@ void lcc_sensor::_reset_gpio( void ) {
   // configure analog_input
 #if defined(ESP32)
   #if !defined(DISABLE_ADC_CAL)
-  if( _inputs[LCC_SENSOR_ANALOG]!=INVALID_GPIO ) {
-    /* the default 11db attenuation enables analog input full range
+  if( _inputs[LCC_SENSOR_ANALOG]!=INVALID_GPIO and
+      not lcc_adc::addChannel( _inputs[LCC_SENSOR_ANALOG] ) ) {
+    /* no continuous sampling: single reads
+     * the default 11db attenuation enables analog input full range
      * Note: unsure if it's not already done somewhere ...
      */
     adc1_config_channel_atten( (adc1_channel_t)digitalPinToAnalogChannel(_inputs[LCC_SENSOR_ANALOG]), ADC_ATTEN_DB_11 );
@@ -11,6 +11,11 @@
 
 	@section  HISTORY
 
+    oct.26  piecewise-linear fixed point conversion tables (per gain),
+            calibration from sensOCampus params or module order
+    oct.26  ESP32 continuous DMA sampling through lcc_adc
+    oct.26  non-blocking FSM: heater, auto-gain and measures waits
+            are scheduled transitions, campaign / loop stall report
     2020-Aug    - First release, F.Thiebolt
     
 */
@@ -28,6 +33,9 @@
 // generic sensor driver
 #include "generic_driver.h"
 
+// mv to ppm (or resistance) conversion tables
+#include "lcc_ppm.h"
+
 
 /*
  * LCC_SENSOR general principle:
@@ -46,6 +54,11 @@
  * 
  * Regarding the huge delays between each operation, we need to implement a continuous
  *  measurement system driven the loop delay itself.
+ *
+ * [oct.26] process() never waits: every delay (heater pulse, gain integration,
+ *  measures interleave) is a timer checked on next calls, the main loop gets
+ *  woken up when it expires. Hence several LCC sensors interleave: one sensor's
+ *  gain settling overlaps another's ADC reads.
  */
 
 /*
@@ -130,7 +143,7 @@ class lcc_sensor : public generic_driver {
     // send back sensor's value, units and subID
     boolean acquire( float* ) { return false; }   // [nov.21] unused because this sensor features its own process()
                                                   // data driven sending means that data won't get asked before we tell it's ready
-    const char *sensorUnits( uint8_t=0 ) { return units; };
+    const char *sensorUnits( uint8_t=0 ) { return ( _calibrated ? units_ppm : units ); };
     String subID( uint8_t=0 ) { return _subID; };
 
     // data integration, override generic_driver
@@ -138,6 +151,12 @@ class lcc_sensor : public generic_driver {
     float getValue( uint8_t *idx=nullptr );               // get official value that has gone through the whole integration process
     void setDataSent( void );                             // data has been sent, reset the 'new official data' trigger
 
+    // campaign duration and loop stall
+    void status( JsonObject );
+
+    // conversion tables from calibration curves (empty means resistance)
+    boolean calibrate( JsonVariant );
+
   // --- protected methods / attributes ---------------------
   // --- i.e subclass have direct access to
   protected:
@@ -151,12 +170,16 @@ class lcc_sensor : public generic_driver {
     boolean measureStart( void );
     boolean measureBusy( void );
 
+    void _FSMsetTimer( uint16_t );      // schedule next transition
+    boolean _FSMtimerBusy( void );      // still waiting for current timer ?
+
     boolean readSensor_mv( uint32_t* );   // internal ADC read; sends back voltage_mv
-    float calculatePPM( uint32_t );       // convert mv voltage to PPM concentration
+    float calculatePPM( uint32_t );       // convert mv voltage to PPM concentration (or resistance)
   
     boolean _init( void );          // low-level init
     void _reset_gpio( void );       // set GPIOs at initial state
     boolean _decreaseGain( void );  // decrease current gain
+    int8_t _parseCurve( JsonObject, lcc_ppm_table * );  // calibration curve to table, sends back gain
 
     // data integration
     boolean _trigger;             // when triggered, module will call getValue to send back value to our infrastructure
@@ -169,6 +192,10 @@ class lcc_sensor : public generic_driver {
     uint8_t _heater_gpio;         // GPIO PIN to start heating the sensor
     uint8_t _cur_gain;            // currently selected Resistor to AOP input
 
+    // conversion tables, one per gain resistor
+    lcc_ppm_table _ppm[LCC_SENSOR_GAIN_MAX+1];
+    boolean _calibrated;          // tables come from calibration curves (i.e ppm)
+
     uint8_t _nb_measures;                 // current number of measures
     uint32_t _measures[LCC_MAX_MEASURES]; // currently measured mv
 
@@ -176,9 +203,19 @@ class lcc_sensor : public generic_driver {
     unsigned long _FSMtimerStart; // ms system time start of current state;
                                   // Only relevant when timerDelay is not null
     uint16_t _FSMtimerDelay;      // ms delay to cur state timeout
+
+    // campaign and loop stall accounting
+    unsigned long _campaignStart; // ms system time current campaign start
+    uint32_t _campaignMs;         // ms duration of last campaign (idle to end of measures)
+    boolean _inCampaign;          // accounted in _activeCampaigns
+    uint32_t _stallMaxUs;         // us longest single process() call since last status
+    static uint8_t _activeCampaigns;      // LCC sensors currently in a campaign
+    static unsigned long _groupStart;     // ms system time first sensor started its campaign
+    static uint32_t _groupMs;             // ms duration of last overall campaign (all sensors)
     
     boolean _initialized;
     static const char *units;
+    static const char *units_ppm;
 };
 
 #endif /* _LCC_SENSOR_H_ */
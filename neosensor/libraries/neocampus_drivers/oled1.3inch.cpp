@@ -15,6 +15,8 @@
 
 	  @section  HISTORY
 
+    2026-Oct  - optional low RAM page buffer mode
+    2026-Oct  - partial refresh: only changed tiles get sent
     2021-Nov  - F.Thiebolt    clear display in destructor
     2021-Sep  - F.Thiebolt    considering 1.3 inches oleds based on SH1106
     2020-Nov  - F.Thiebolt    Initial Release
@@ -71,6 +73,15 @@ oled13inch::oled13inch( void ) : driver_display() {
   _i2caddr      = INVALID_I2CADDR;
   _u8g2         = nullptr;
 
+#if OLED13INCH_PAGE_BUFFER == 0
+  _shadow       = nullptr;
+  _shadowValid  = false;
+  _refreshBytes = 0;
+#endif
+
+  _nbTexts      = 0;
+  _frameWidth   = 0;
+
   _curHours     = (uint8_t)(-1);
   _curMinutes   = (uint8_t)(-1);
 }
@@ -82,6 +93,12 @@ oled13inch::~oled13inch( void ) {
     free( _u8g2 );
     _u8g2 = nullptr;
   }
+#if OLED13INCH_PAGE_BUFFER == 0
+  if( _shadow != nullptr ) {
+    free( _shadow );
+    _shadow = nullptr;
+  }
+#endif
 }
 
 
@@ -101,10 +118,20 @@ boolean oled13inch::begin( uint8_t addr=INVALID_I2CADDR ) {
   /* instantiate u8 device
    * _F_ full frame buffer
    * _1_ or _2_ single or dual line(s) of the frame
+   * [oct.26] selected through OLED13INCH_PAGE_BUFFER
    */
-  _u8g2 = new U8G2_SH1106_128X64_NONAME_F_HW_I2C(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
+  _u8g2 = new oled13inch_u8g2_t(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
   if( _u8g2==nullptr ) return false;
 
+#if OLED13INCH_PAGE_BUFFER == 0
+  /* [oct.26] shadow of the panel for partial refresh
+   * Note: no shadow ==> full refresh each time */
+  _shadow = (uint8_t *)malloc( (uint16_t)_u8g2->getBufferTileWidth() * _u8g2->getBufferTileHeight() * OLED13INCH_TILE_BYTES );
+  if( _shadow==nullptr ) {
+    log_error(F("\n[oled13inch] unable to allocate shadow buffer, full refresh only")); log_flush();
+  }
+#endif
+
   /* set config:
    * - brightness 100%
    */
@@ -126,6 +153,9 @@ void oled13inch::powerON( void ) {
 
   // init display
   _u8g2->begin();
+#if OLED13INCH_PAGE_BUFFER == 0
+  _shadowValid = false;
+#endif
 }
 
 void oled13inch::powerOFF( void ) {
@@ -133,6 +163,9 @@ void oled13inch::powerOFF( void ) {
 
   // clear buffer & display
   _u8g2->clear();
+#if OLED13INCH_PAGE_BUFFER == 0
+  _shadowValid = false;
+#endif
   // enter power save mode
   _u8g2->setPowerSave( true );
 }
@@ -233,14 +266,12 @@ bool oled13inch::dispLogo( void ) {
   uint8_t screen_height = _u8g2->getDisplayHeight();
   uint8_t y_offset = ( str_height>=screen_height ? screen_height-1 : (screen_height-str_height)/2+str_height );
 
-  _u8g2->setFontMode(0);		// non transparent mode
-
   // display logo
-  _u8g2->clearBuffer();
+  _clearLayout();
 
-  _u8g2->drawUTF8(x_offset, y_offset, _str);
+  _addText(u8g2_font_inr16_mr, x_offset, y_offset, _str);
 
-  _u8g2->sendBuffer();
+  _render();
 
   // finish :)
   return true;
@@ -278,24 +309,22 @@ uint8_t oled13inch::dispTime( uint8_t hours, uint8_t minutes, uint8_t seconds )
   uint8_t screen_height = _u8g2->getDisplayHeight();
   //uint8_t y_offset = ( str_height>=screen_height ? screen_height-1 : (screen_height-str_height)/2+str_height );
 
-  _u8g2->setFontMode(0);		// non transparent mode
-
   // display time
-  _u8g2->clearBuffer();
+  _clearLayout();
 
   // hours
   uint8_t x_offset = screen_width - str_width;
   uint8_t y_offset = str_height+2;
   snprintf( _str, sizeof(_str), "%02d", _hours );
-  _u8g2->drawUTF8(x_offset, y_offset, _str);
+  _addText(u8g2_font_freedoomr25_tn, x_offset, y_offset, _str);
 
   // minutes
   y_offset += str_height;
   snprintf( _str, sizeof(_str), "%02d", _minutes );
-  _u8g2->drawUTF8(x_offset, screen_height-1, _str);
+  _addText(u8g2_font_freedoomr25_tn, x_offset, screen_height-1, _str);
 
   // sensors
-  _u8g2->drawRFrame(0,0, x_offset-1, screen_height, 4);
+  _frameWidth = x_offset-1;
 
   _u8g2->setFont(u8g2_font_helvR12_tf); // sensors font
   str_height = _u8g2->getMaxCharHeight();
@@ -326,7 +355,7 @@ uint8_t oled13inch::dispTime( uint8_t hours, uint8_t minutes, uint8_t seconds )
           if( strstr_P(_kv.key().c_str(), _key2avoid)==nullptr ) {
             //snprintf( _str, sizeof(_str), "%.1f°c", (float)(_kv.value().as<float>()));
             snprintf( _str, sizeof(_str), "%.1f%s", _kv.value().as<float>(), _getUnits( _kv.key().c_str(), (kv.value()).as<JsonObject>() ) );
-            _u8g2->drawUTF8(x_offset, y_offset, _str);
+            _addText(u8g2_font_helvR12_tf, x_offset, y_offset, _str);
             y_offset += (str_height + 0);
             sensor2display = true;
             break;  // exit inner loop
@@ -348,7 +377,7 @@ uint8_t oled13inch::dispTime( uint8_t hours, uint8_t minutes, uint8_t seconds )
           if( strstr_P(_kv.key().c_str(), _key2avoid)==nullptr ) {
             //snprintf( _str, sizeof(_str), "%d%%r.h", _kv.value().as<int>());
             snprintf( _str, sizeof(_str), "%d%s", _kv.value().as<int>(), _getUnits( _kv.key().c_str(), (kv.value()).as<JsonObject>() ) );
-            _u8g2->drawUTF8(x_offset, y_offset, _str);
+            _addText(u8g2_font_helvR12_tf, x_offset, y_offset, _str);
             y_offset += (str_height + 0);
             sensor2display = true;
             break;  // exit inner loop
@@ -370,7 +399,7 @@ uint8_t oled13inch::dispTime( uint8_t hours, uint8_t minutes, uint8_t seconds )
           if( strstr_P(_kv.key().c_str(), _key2avoid)==nullptr ) {
             //snprintf( _str, sizeof(_str), "%dlux", _kv.value().as<int>());
             snprintf( _str, sizeof(_str), "%d%s", _kv.value().as<int>(), _getUnits( _kv.key().c_str(), (kv.value()).as<JsonObject>() ) );
-            _u8g2->drawUTF8(x_offset, y_offset, _str);
+            _addText(u8g2_font_helvR12_tf, x_offset, y_offset, _str);
             y_offset += (str_height + 0);
             sensor2display = true;
             break;  // exit inner loop
@@ -392,7 +421,7 @@ uint8_t oled13inch::dispTime( uint8_t hours, uint8_t minutes, uint8_t seconds )
           if( strstr_P(_kv.key().c_str(), _key2avoid)==nullptr ) {
             //snprintf( _str, sizeof(_str), "%s:%dµg/m3", _kv.key().c_str(), _kv.value().as<int>());
             snprintf( _str, sizeof(_str), "%d%s", _kv.value().as<int>(), _getUnits( _kv.key().c_str(), (kv.value()).as<JsonObject>() ) );
-            _u8g2->drawUTF8(x_offset, y_offset, _str);
+            _addText(u8g2_font_helvR12_tf, x_offset, y_offset, _str);
             y_offset += (str_height + 0);
             sensor2display = true;
             break;  // exit inner loop
@@ -406,17 +435,17 @@ uint8_t oled13inch::dispTime( uint8_t hours, uint8_t minutes, uint8_t seconds )
 
   // if no sensor displayed ==> switch to HOURS:MINUTES
   if( !sensor2display ) {
-    _u8g2->clearBuffer();
+    _clearLayout();
     _u8g2->setFont(u8g2_font_freedoomr25_tn);
     snprintf(_str, sizeof(_str), "%02d:%02d", _hours, _minutes);
     str_width = _u8g2->getUTF8Width(_str);
     str_height = _u8g2->getMaxCharHeight();
     x_offset = ( str_width>=screen_width ? 0 : (screen_width-str_width)/2 );
     y_offset = ( str_height>=screen_height ? screen_height-1 : (screen_height-str_height)/2+str_height );
-    _u8g2->drawUTF8(x_offset, y_offset, _str);
+    _addText(u8g2_font_freedoomr25_tn, x_offset, y_offset, _str);
   }
 
-  _u8g2->sendBuffer();
+  _render();
 
   // finish :)
   return true;
@@ -427,6 +456,111 @@ uint8_t oled13inch::dispTime( uint8_t hours, uint8_t minutes, uint8_t seconds )
  * Private methods 
  */
 
+/*
+ * [oct.26] Layout: texts computed once, drawn at each page pass
+ */
+void oled13inch::_clearLayout( void ) {
+  _nbTexts = 0;
+  _frameWidth = 0;
+}
+
+bool oled13inch::_addText( const uint8_t *font, uint8_t x, uint8_t y, const char *str ) {
+  if( _nbTexts >= OLED13INCH_TEXTS_MAX ) return false;
+  oled13inchText_t *_text = &_texts[_nbTexts++];
+  _text->font = font;
+  _text->x = x;
+  _text->y = y;
+  strncpy( _text->str, str, sizeof(_text->str) - 1 );
+  _text->str[sizeof(_text->str) - 1] = '\0';
+  return true;
+}
+
+void oled13inch::_drawLayout( void ) {
+  if( _frameWidth ) _u8g2->drawRFrame(0,0, _frameWidth, _u8g2->getDisplayHeight(), 4);
+
+  _u8g2->setFontMode(0);		// non transparent mode
+  for( uint8_t i=0; i < _nbTexts; i++ ) {
+    _u8g2->setFont(_texts[i].font);
+    _u8g2->drawUTF8(_texts[i].x, _texts[i].y, _texts[i].str);
+  }
+}
+
+
+/*
+ * [oct.26] draw layout to the frame buffer then send it
+ * - full frame buffer: changed tiles only
+ * - page buffer: whole frame, page after page
+ */
+void oled13inch::_render( void ) {
+#if OLED13INCH_PAGE_BUFFER == 0
+  _u8g2->clearBuffer();
+  _drawLayout();
+  _sendBuffer();
+#else
+  _u8g2->firstPage();
+  do {
+    _drawLayout();
+  } while( _u8g2->nextPage() );
+#endif
+}
+
+
+#if OLED13INCH_PAGE_BUFFER == 0
+/*
+ * [oct.26] send to the panel only the tiles that changed since last refresh
+ * Note: a run of changed tiles in a tile row is sent at once, it may
+ * include up to OLED13INCH_TILES_GAP unchanged tiles
+ */
+void oled13inch::_sendBuffer( void ) {
+
+  uint8_t *_buf = _u8g2->getBufferPtr();
+  uint8_t _tw = _u8g2->getBufferTileWidth();
+  uint8_t _th = _u8g2->getBufferTileHeight();
+
+  // no shadow or unknown panel content ==> full refresh
+  if( _shadow==nullptr or not _shadowValid ) {
+    _u8g2->sendBuffer();
+    _refreshBytes = (uint16_t)_tw * _th * OLED13INCH_TILE_BYTES;
+    if( _shadow ) {
+      memcpy( _shadow, _buf, _refreshBytes );
+      _shadowValid = true;
+    }
+    log_debug(F("\n[oled13inch] full refresh bytes: ")); log_debug(_refreshBytes,DEC); log_flush();
+    return;
+  }
+
+  _refreshBytes = 0;
+  for( uint8_t ty=0; ty < _th; ty++ ) {
+    uint8_t *_row = _buf + (uint16_t)ty * _tw * OLED13INCH_TILE_BYTES;
+    uint8_t *_shadowRow = _shadow + (uint16_t)ty * _tw * OLED13INCH_TILE_BYTES;
+
+    uint8_t tx = 0;
+    while( tx < _tw ) {
+      // skip unchanged tiles
+      if( memcmp( _row + tx*OLED13INCH_TILE_BYTES, _shadowRow + tx*OLED13INCH_TILE_BYTES, OLED13INCH_TILE_BYTES )==0 ) {
+        tx++;
+        continue;
+      }
+
+      // extend run while next changed tile is close enough
+      uint8_t _start = tx++;
+      uint8_t _end = tx;
+      while( tx < _tw and tx <= _end + OLED13INCH_TILES_GAP ) {
+        if( memcmp( _row + tx*OLED13INCH_TILE_BYTES, _shadowRow + tx*OLED13INCH_TILE_BYTES, OLED13INCH_TILE_BYTES )!=0 ) _end = tx + 1;
+        tx++;
+      }
+
+      _u8g2->updateDisplayArea( _start, ty, _end - _start, 1 );
+      memcpy( _shadowRow + _start*OLED13INCH_TILE_BYTES, _row + _start*OLED13INCH_TILE_BYTES, (_end - _start)*OLED13INCH_TILE_BYTES );
+      _refreshBytes += (_end - _start)*OLED13INCH_TILE_BYTES;
+    }
+  }
+
+  log_debug(F("\n[oled13inch] partial refresh bytes: ")); log_debug(_refreshBytes,DEC); log_flush();
+}
+#endif /* OLED13INCH_PAGE_BUFFER */
+
+
 /*
  * retrieve units for a key sensor in a Json dictionnary (JsonObject)
  */
@@ -15,6 +15,8 @@
 
 	  @section  HISTORY
 
+    2026-Oct  - optional low RAM page buffer mode
+    2026-Oct  - partial refresh: only changed tiles get sent
     2021-Sep  - F.Thiebolt    considering 1.3 inches oleds based on SH1106
     2020-Nov  - F.Thiebolt    Initial Release
 */
@@ -52,6 +54,49 @@
 #define OLED13INCH_BRIGHTNESS_HIGH                255   // oled API is uint8_t
 #define OLED13INCH_BRIGHTNESS_LOW                 20
 
+/* [oct.26] Frame buffer
+ * 0     full frame buffer (1KB) + partial refresh (shadow 1KB)
+ * 1, 2  single or dual page(s) buffer (128 or 256 bytes), each display
+ *       gets drawn in firstPage()/nextPage() loops, the whole frame is
+ *       sent each time (no partial refresh)
+ * Note: u8g2 buffers are static variables
+ */
+#ifndef OLED13INCH_PAGE_BUFFER
+#define OLED13INCH_PAGE_BUFFER      0
+#endif
+
+#if OLED13INCH_PAGE_BUFFER == 1
+typedef U8G2_SH1106_128X64_NONAME_1_HW_I2C  oled13inch_u8g2_t;
+#elif OLED13INCH_PAGE_BUFFER == 2
+typedef U8G2_SH1106_128X64_NONAME_2_HW_I2C  oled13inch_u8g2_t;
+#else
+typedef U8G2_SH1106_128X64_NONAME_F_HW_I2C  oled13inch_u8g2_t;
+#endif
+
+/* [oct.26] Layout
+ * texts (and their offsets) to display get computed once, then drawn
+ * at each page pass
+ */
+#define OLED13INCH_TEXTS_MAX        6     // hours, minutes + 4 sensors
+#define OLED13INCH_TEXT_LEN         16
+typedef struct {
+  const uint8_t *font;
+  uint8_t x, y;
+  char str[OLED13INCH_TEXT_LEN];
+} oled13inchText_t;
+
+/* [oct.26] Partial refresh (full frame buffer)
+ * u8g2 buffer is made of 8 pixels high tile rows (i.e SH1106 pages), each
+ * tile being 8 bytes (8 columns). A shadow of what the panel displays lets
+ * us send only the tiles that changed since last refresh.
+ * Unchanged tiles between two changed ones get sent anyway if their number
+ * doesn't exceed GAP (cheaper than a new page/column addressing sequence).
+ */
+#define OLED13INCH_TILE_BYTES       8     // 8 columns of 8 pixels
+#ifndef OLED13INCH_TILES_GAP
+#define OLED13INCH_TILES_GAP        1     // max unchanged tiles merged within a run
+#endif
+
 
 
 /*
@@ -84,7 +129,7 @@ class oled13inch : public driver_display {
     // --- static methods / constants -----------------------
     
     // list of possibles I2C addrs
-    static const uint8_t i2c_addrs[];
+    static const uint8_t i2c_addrs[2];
 
     // device detection
     static boolean is_device( uint8_t );
@@ -93,12 +138,31 @@ class oled13inch : public driver_display {
     // attributes
     uint8_t _i2caddr;
 
-    U8G2_SH1106_128X64_NONAME_F_HW_I2C *_u8g2;  // full buffer mode (_F_) or single page (_1_)
+    oled13inch_u8g2_t *_u8g2;   // full buffer mode (_F_) or single/dual page (_1_, _2_)
+
+#if OLED13INCH_PAGE_BUFFER == 0
+    // partial refresh
+    uint8_t *_shadow;           // what the panel currently displays
+    bool _shadowValid;          // false ==> panel content unknown, next refresh is a full one
+    uint16_t _refreshBytes;     // data bytes sent at last refresh
+#endif
+
+    // layout
+    oled13inchText_t _texts[OLED13INCH_TEXTS_MAX];
+    uint8_t _nbTexts;
+    uint8_t _frameWidth;        // rounded frame (full height) width, 0 means no frame
 
     // time related
     uint8_t _curHours, _curMinutes;
 
     // methods ...
+    void _clearLayout( void );
+    bool _addText( const uint8_t *, uint8_t, uint8_t, const char* );  // font, x, y, text
+    void _drawLayout( void );                 // draw texts (current page)
+    void _render( void );                     // draw layout then send it to the panel
+#if OLED13INCH_PAGE_BUFFER == 0
+    void _sendBuffer( void );                 // send changed tiles only
+#endif
     const char* _getUnits( const char*, JsonObject ); // retrieve units for a key sensor in a Json dictionnary (JsonObject)
     static bool _check_identity( uint8_t );   // check device is what we expect!
 };
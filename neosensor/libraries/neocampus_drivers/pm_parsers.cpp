@@ -0,0 +1,428 @@
+/**************************************************************************/
+/*!
+  @file     pm_parsers.cpp
+  @author   neOCampus
+  @license
+
+	Resumable frame parsers for serial particules meters and CO2 sensors
+
+	@section  HISTORY
+
+    oct.26  Sensirion SPS30 SHDLC encoder / decoder
+    oct.26  initial release (from pm_serial blocking readers)
+*/
+/**************************************************************************/
+
+
+/*
+ * Includes
+ */
+#include <string.h>
+
+#include "pm_parsers.h"
+
+
+/*
+ * Definitions
+ */
+#define _PMSX003_SYNC1      0x42
+#define _PMSX003_SYNC2      0x4D
+#define _SDS011_SYNC1       0xAA
+#define _SDS011_SYNC2       0xC0
+#define _SDS011_TAIL        0xAB
+#define _IKEA_SYNC1         0x16
+#define _IKEA_MINLEN        13      // cmd + PM2_5 ... PM10 bytes
+#define _IKEA_MAXLEN        32
+#define _MHZ1X_SYNC1        0xFF
+#define _MHZ1X_SYNC2        0x86
+#define _SHDLC_FLAG         0x7E
+#define _SHDLC_ESCAPE       0x7D
+#define _SHDLC_XOR          0x20
+
+#define _makeWord(h,l)      ( (uint16_t)(((uint16_t)(h) << 8) | (uint8_t)(l)) )
+
+
+
+// ============================================================================
+// === Base parser ============================================================
+
+pm_parser::pm_parser( void ) {
+  memset( _values, 0, sizeof(_values) );
+  memset( &_stats, 0, sizeof(_stats) );
+  _nbValues = 0;
+  reset();
+}
+
+void pm_parser::reset( void ) {
+  _state = pmParserState_t::sync1;
+  _index = 0;
+  _frameLen = 0;
+  _checksum = 0;
+  _calculatedChecksum = 0;
+}
+
+bool pm_parser::feed( const uint8_t *buf, size_t len, size_t *used ) {
+  size_t i = 0;
+  bool res = false;
+  while( i < len and not res ) {
+    res = feed( buf[i++] );
+  }
+  if( used ) *used = i;
+  return res;
+}
+
+void pm_parser::_error( void ) {
+  _stats.errors++;
+  reset();
+}
+
+void pm_parser::_discard( void ) {
+  _stats.discarded++;
+  reset();
+}
+
+
+
+// ============================================================================
+// === PMSx003 ================================================================
+
+bool pmsx003_parser::feed( uint8_t ch ) {
+
+  switch( _state ) {
+
+    case pmParserState_t::sync1:
+      if( ch != _PMSX003_SYNC1 ) { _discard(); break; }
+      _calculatedChecksum = ch;
+      _state = pmParserState_t::sync2;
+      break;
+
+    case pmParserState_t::sync2:
+      if( ch != _PMSX003_SYNC2 ) {
+        _discard();
+        if( ch == _PMSX003_SYNC1 ) return feed( ch );   // may be a new frame start
+        break;
+      }
+      _calculatedChecksum += ch;
+      _index = 0;
+      _state = pmParserState_t::length;
+      break;
+
+    case pmParserState_t::length:
+      _calculatedChecksum += ch;
+      if( _index++ == 0 ) {
+        _frameLen = (uint16_t)ch << 8;
+        break;
+      }
+      _frameLen |= ch;
+      // Unsupported sensor, different frame length, transmission error e.t.c.
+      if( _frameLen != 2 * 9 + 2 and _frameLen != 2 * 13 + 2 ) { _error(); break; }
+      _index = 0;
+      _state = pmParserState_t::payload;
+      break;
+
+    case pmParserState_t::payload:
+      _calculatedChecksum += ch;
+      // Payload is common to all sensors (first 2x6 bytes).
+      if( _index < sizeof(_payload) ) _payload[_index] = ch;
+      if( ++_index >= _frameLen - 2 ) {
+        _index = 0;
+        _state = pmParserState_t::checksum;
+      }
+      break;
+
+    case pmParserState_t::checksum:
+      if( _index++ == 0 ) {
+        _checksum = (uint16_t)ch << 8;
+        break;
+      }
+      _checksum |= ch;
+      if( _calculatedChecksum != _checksum ) { _error(); break; }
+
+      // Atmospheric Environment.
+      //_values[] = _makeWord(_payload[6], _payload[7]);   // PM1_0
+      _values[0] = _makeWord(_payload[8], _payload[9]);     // PM2_5
+      _values[1] = _makeWord(_payload[10], _payload[11]);   // PM10
+      _stats.frames++;
+      reset();
+      return true;
+
+    default:
+      _error();
+  }
+
+  return false;
+}
+
+
+
+// ============================================================================
+// === SDS011 =================================================================
+
+bool sds011_parser::feed( uint8_t ch ) {
+
+  switch( _state ) {
+
+    case pmParserState_t::sync1:
+      if( ch != _SDS011_SYNC1 ) { _discard(); break; }
+      _state = pmParserState_t::sync2;
+      break;
+
+    case pmParserState_t::sync2:
+      if( ch != _SDS011_SYNC2 ) {
+        _discard();
+        if( ch == _SDS011_SYNC1 ) return feed( ch );
+        break;
+      }
+      _index = 0;
+      _calculatedChecksum = 0;
+      _state = pmParserState_t::payload;
+      break;
+
+    case pmParserState_t::payload:
+      _calculatedChecksum += ch;
+      if( _index < sizeof(_payload) ) _payload[_index] = ch;
+      if( ++_index >= 6 ) _state = pmParserState_t::checksum;
+      break;
+
+    case pmParserState_t::checksum:
+      _checksum = ch;
+      _state = pmParserState_t::tail;
+      break;
+
+    case pmParserState_t::tail:
+      if( ch != _SDS011_TAIL or (uint8_t)_calculatedChecksum != (uint8_t)_checksum ) { _error(); break; }
+
+      _values[0] = _makeWord(_payload[1], _payload[0])/10;   // PM2_5
+      _values[1] = _makeWord(_payload[3], _payload[2])/10;   // PM10
+      _stats.frames++;
+      reset();
+      return true;
+
+    default:
+      _error();
+  }
+
+  return false;
+}
+
+
+
+// ============================================================================
+// === IKEA ===================================================================
+
+bool ikea_parser::feed( uint8_t ch ) {
+
+  switch( _state ) {
+
+    case pmParserState_t::sync1:
+      if( ch != _IKEA_SYNC1 ) { _discard(); break; }
+      _calculatedChecksum = ch;
+      _state = pmParserState_t::length;
+      break;
+
+    case pmParserState_t::length:
+      if( ch < _IKEA_MINLEN or ch > _IKEA_MAXLEN ) {
+        _error();
+        if( ch == _IKEA_SYNC1 ) return feed( ch );
+        break;
+      }
+      _calculatedChecksum += ch;
+      _frameLen = ch;
+      _index = 0;
+      _state = pmParserState_t::payload;
+      break;
+
+    case pmParserState_t::payload:
+      // command byte answer: it could be 0x02 or 0x0b, followed by len-1 data bytes
+      _calculatedChecksum += ch;
+      if( _index > 0 and (size_t)(_index - 1) < sizeof(_payload) ) _payload[_index - 1] = ch;
+      if( ++_index >= _frameLen ) _state = pmParserState_t::checksum;
+      break;
+
+    case pmParserState_t::checksum:
+      if( (uint8_t)(_calculatedChecksum + ch) != (uint8_t)0 ) { _error(); break; }
+
+      _values[0] = _makeWord(_payload[2], _payload[3]);     // PM2_5
+      _values[1] = _makeWord(_payload[10], _payload[11]);   // PM10
+      // [feb.22] no idea DF13-DF16 bytes from 0x0B command are useful for ??
+      _stats.frames++;
+      reset();
+      return true;
+
+    default:
+      _error();
+  }
+
+  return false;
+}
+
+
+
+// ============================================================================
+// === MH-Z1x =================================================================
+
+bool mhz1x_parser::feed( uint8_t ch ) {
+
+  switch( _state ) {
+
+    case pmParserState_t::sync1:
+      if( ch != _MHZ1X_SYNC1 ) { _discard(); break; }
+      _state = pmParserState_t::sync2;
+      break;
+
+    case pmParserState_t::sync2:
+      if( ch != _MHZ1X_SYNC2 ) {
+        _discard();
+        if( ch == _MHZ1X_SYNC1 ) return feed( ch );
+        break;
+      }
+      _calculatedChecksum = ch;   // yes, preamble is not part of checksum
+      _index = 0;
+      _state = pmParserState_t::payload;
+      break;
+
+    case pmParserState_t::payload:
+      _calculatedChecksum += ch;
+      _payload[_index] = ch;
+      if( ++_index >= sizeof(_payload) ) _state = pmParserState_t::checksum;
+      break;
+
+    case pmParserState_t::checksum:
+      if( (uint8_t)(~_calculatedChecksum + 1) != ch ) { _error(); break; }
+
+      _values[0] = _makeWord(_payload[0], _payload[1]);     // CO2
+      _stats.frames++;
+      reset();
+      return true;
+
+    default:
+      _error();
+  }
+
+  return false;
+}
+
+
+
+// ============================================================================
+// === SPS30 (SHDLC) ==========================================================
+
+/* SHDLC bytes that need stuffing */
+static inline bool _shdlc_stuffed( uint8_t ch ) {
+  return ( ch == 0x7E or ch == 0x7D or ch == 0x11 or ch == 0x13 );
+}
+
+/*
+ * MOSI frame encoder
+ */
+size_t sps30_parser::encode( uint8_t *buf, size_t size, uint8_t cmd, const uint8_t *data, uint8_t len ) {
+
+  uint8_t sum = SPS30_ADDR + cmd + len;
+  for( uint8_t i=0; i<len; i++ ) sum += data[i];
+
+  size_t n = 0;
+  // worst case: every byte stuffed
+  if( size < (size_t)(2 * (4 + len) + 2) ) return 0;
+
+  buf[n++] = _SHDLC_FLAG;
+  for( uint8_t i=0; i < 4 + len; i++ ) {
+    uint8_t ch;
+    if( i == 0 ) ch = SPS30_ADDR;
+    else if( i == 1 ) ch = cmd;
+    else if( i == 2 ) ch = len;
+    else if( i < 3 + len ) ch = data[i - 3];
+    else ch = (uint8_t)~sum;
+
+    if( _shdlc_stuffed( ch ) ) {
+      buf[n++] = _SHDLC_ESCAPE;
+      ch ^= _SHDLC_XOR;
+    }
+    buf[n++] = ch;
+  }
+  buf[n++] = _SHDLC_FLAG;
+
+  return n;
+}
+
+
+/*
+ * MISO frame decoder
+ * Note: frames are delimited by 0x7E, a stop flag may also be the start of
+ * the next frame (i.e a single flag between two frames).
+ */
+bool sps30_parser::feed( uint8_t ch ) {
+
+  switch( _state ) {
+
+    case pmParserState_t::sync1:
+      if( ch != _SHDLC_FLAG ) { _discard(); break; }
+      _escape = false;
+      _index = 0;
+      _calculatedChecksum = 0;
+      _state = pmParserState_t::payload;
+      break;
+
+    case pmParserState_t::payload:
+      if( ch == _SHDLC_FLAG ) {
+        // empty frame: consecutive flags, this one is the start
+        if( _index == 0 ) { _escape = false; break; }
+        bool res = _frameCheck();
+        // flag may be next frame's start
+        _state = pmParserState_t::payload;
+        _escape = false;
+        _index = 0;
+        _calculatedChecksum = 0;
+        return res;
+      }
+      if( ch == _SHDLC_ESCAPE ) { _escape = true; break; }
+      if( _escape ) {
+        ch ^= _SHDLC_XOR;
+        _escape = false;
+      }
+
+      // header then data + checksum
+      if( _index < sizeof(_header) ) _header[_index] = ch;
+      else if( (size_t)(_index - sizeof(_header)) < sizeof(_payload) ) _payload[_index - sizeof(_header)] = ch;
+      else { _error(); break; }   // longer than any frame we expect
+
+      _calculatedChecksum += ch;
+      _last = ch;
+      _index++;
+      break;
+
+    default:
+      _error();
+  }
+
+  return false;
+}
+
+
+/*
+ * frame check upon stop flag
+ * @return true if frame holds measured values
+ */
+bool sps30_parser::_frameCheck( void ) {
+
+  // adr + cmd + state + len + checksum at least
+  if( _index < sizeof(_header) + 1 or _index != sizeof(_header) + _header[3] + 1 ) { _error(); return false; }
+  // checksum: inverted LSB of the sum of all bytes except checksum itself
+  if( (uint8_t)~(uint8_t)(_calculatedChecksum - _last) != _last ) { _error(); return false; }
+
+  _command = _header[1];
+  _status = _header[2];
+  _stats.frames++;
+
+  // command failure (bit 7 is a device error flag, the command itself succeeded)
+  if( _status & 0x7F ) { _stats.errors++; return false; }
+
+  // measured values ? (an empty answer means no new values yet)
+  if( _command != SPS30_CMD_READ or _header[3] != _SPS30_MAXDATA ) return false;
+
+  for( uint8_t i=0; i < _nbValues; i++ ) {
+    uint32_t raw = ((uint32_t)_payload[4*i] << 24) | ((uint32_t)_payload[4*i+1] << 16) |
+                   ((uint32_t)_payload[4*i+2] << 8) | (uint32_t)_payload[4*i+3];
+    memcpy( &_values[i], &raw, sizeof(float) );
+  }
+  return true;
+}
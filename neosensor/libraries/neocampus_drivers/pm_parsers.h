@@ -0,0 +1,211 @@
+/**************************************************************************/
+/*!
+    @file     pm_parsers.h
+    @author   neOCampus
+	  @license
+
+    This is part of a the neOCampus drivers library.
+    Resumable frame parsers for the serial particules meters / CO2 sensors
+    handled by pm_serial:
+    - PMSx003
+    - SDS011
+    - IKEA VINDRIKTNING (Cubic PM1006K)
+    - CO2 sensor MH-Z1x
+    - Sensirion SPS30 (SHDLC)
+
+    (c) Copyright 2026 neOCampus
+
+  @note
+    Each parser is fed one byte at a time with whatever the serial link
+    holds and keeps its state (sync, length, payload, checksum) across
+    calls: nothing ever waits for a frame to complete.
+    These parsers do not depend on the Arduino framework (host tests).
+
+	@section  HISTORY
+
+    oct.26  Sensirion SPS30 SHDLC encoder / decoder, float values
+    oct.26  initial release (from pm_serial blocking readers)
+
+*/
+/**************************************************************************/
+
+#ifndef _PM_PARSERS_H_
+#define _PM_PARSERS_H_
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+
+/*
+ * Definitions
+ */
+#define PM_PARSER_MAX_VALUES      10  // maximum number of values decoded from a single frame
+
+// parsers FSM
+enum class pmParserState_t : uint8_t {
+  sync1         = 0,    // waiting for 1st frame byte
+  sync2,                // waiting for 2nd frame byte
+  length,               // frame length byte(s)
+  payload,              // payload bytes (including command byte if any)
+  checksum,             // checksum byte(s)
+  tail                  // frame tail byte (if any)
+};
+
+// parsers statistics
+typedef struct {
+  uint32_t      frames;       // valid frames decoded
+  uint32_t      errors;       // wrong length or checksum
+  uint32_t      discarded;    // bytes skipped while searching for sync
+} pmParserStats_t;
+
+
+
+/*
+ * Base class
+ */
+class pm_parser {
+  public:
+    pm_parser( void );
+    virtual ~pm_parser( void ) { };
+
+    // restart searching for a frame start
+    virtual void reset( void );
+
+    // feed one byte: true when a complete and valid frame has been decoded
+    virtual bool feed( uint8_t ) = 0;
+
+    // feed a buffer: true as soon as a frame is complete (*used holds consumed bytes)
+    bool feed( const uint8_t *, size_t, size_t *used=nullptr );
+
+    // values decoded from the last valid frame (see pm_serial.h xxxDataIdx_t enums)
+    float value( uint8_t idx ) const { return ( idx < PM_PARSER_MAX_VALUES ? _values[idx] : 0 ); };
+    uint8_t nbValues( void ) const { return _nbValues; };
+
+    const pmParserStats_t *stats( void ) const { return &_stats; };
+
+  protected:
+    pmParserState_t _state;
+    uint8_t _index;                 // byte index within current state
+    uint16_t _frameLen;
+    uint16_t _checksum;             // received checksum
+    uint16_t _calculatedChecksum;
+    float _values[PM_PARSER_MAX_VALUES];
+    uint8_t _nbValues;
+    pmParserStats_t _stats;
+
+    // frame failure: account error and search for a new frame start
+    void _error( void );
+    // byte not matching a frame start
+    void _discard( void );
+};
+
+
+/*
+ * PMSx003
+ * 0x42 0x4D lenH lenL payload[len-2] csumH csumL
+ * values: PM2_5, PM10 (atmospheric environment)
+ */
+class pmsx003_parser : public pm_parser {
+  public:
+    pmsx003_parser( void ) : pm_parser() { _nbValues = 2; };
+    bool feed( uint8_t );
+    using pm_parser::feed;
+  private:
+    uint8_t _payload[12];
+};
+
+
+/*
+ * SDS011
+ * 0xAA 0xC0 data[6] csum 0xAB
+ * values: PM2_5, PM10
+ */
+class sds011_parser : public pm_parser {
+  public:
+    sds011_parser( void ) : pm_parser() { _nbValues = 2; };
+    bool feed( uint8_t );
+    using pm_parser::feed;
+  private:
+    uint8_t _payload[4];
+};
+
+
+/*
+ * IKEA VINDRIKTNING (Cubic PM1006K)
+ * 0x16 len cmd payload[len-1] csum (sum of all bytes == 0)
+ * values: PM2_5, PM10
+ */
+class ikea_parser : public pm_parser {
+  public:
+    ikea_parser( void ) : pm_parser() { _nbValues = 2; };
+    bool feed( uint8_t );
+    using pm_parser::feed;
+  private:
+    uint8_t _payload[16];
+};
+
+
+/*
+ * MH-Z1x
+ * 0xFF 0x86 payload[6] csum (two's complement of bytes 1..7 sum)
+ * values: CO2
+ */
+class mhz1x_parser : public pm_parser {
+  public:
+    mhz1x_parser( void ) : pm_parser() { _nbValues = 1; };
+    bool feed( uint8_t );
+    using pm_parser::feed;
+  private:
+    uint8_t _payload[6];
+};
+
+
+/*
+ * Sensirion SPS30 (SHDLC)
+ * MOSI: 0x7E adr cmd len data[len] csum 0x7E
+ * MISO: 0x7E adr cmd state len data[len] csum 0x7E
+ * csum is the inverted LSB of the sum of all bytes between start and stop,
+ * 0x7E, 0x7D, 0x11, 0x13 get stuffed as 0x7D followed by byte ^ 0x20.
+ * feed() only reports 'read measured values' frames (big-endian IEEE754):
+ * values: PM1, PM2_5, PM4, PM10 (µg/m3), NC0_5, NC1, NC2_5, NC4, NC10 (#/cm3),
+ *         typical particle size (µm)
+ * all other valid frames are acknowledges (see command() and status())
+ */
+#define SPS30_ADDR                0x00
+#define SPS30_CMD_START           0x00    // start measurement (0x01, 0x03: float values)
+#define SPS30_CMD_STOP            0x01    // stop measurement
+#define SPS30_CMD_READ            0x03    // read measured values
+#define SPS30_CMD_SLEEP           0x10    // idle mode only (firmware >= 2.0)
+#define SPS30_CMD_WAKEUP          0x11    // after a low pulse on RX (firmware >= 2.0)
+#define SPS30_CMD_CLEANING        0x56    // start fan cleaning (measurement mode only)
+#define SPS30_CMD_RESET           0xD3
+
+#define SPS30_FRAME_MAXLEN        (2 * (5 + 4) + 2)   // largest MOSI frame we send (stuffed)
+#define _SPS30_MAXDATA            40      // 10 floats
+
+class sps30_parser : public pm_parser {
+  public:
+    sps30_parser( void ) : pm_parser() { _nbValues = 10; _command = 0xFF; _status = 0; };
+    bool feed( uint8_t );
+    using pm_parser::feed;
+
+    // last valid frame's command and state byte (0 means success)
+    uint8_t command( void ) const { return _command; };
+    uint8_t status( void ) const { return _status; };
+
+    // SHDLC encoder: build a stuffed MOSI frame, returns frame length (0 upon overflow)
+    static size_t encode( uint8_t *, size_t, uint8_t cmd, const uint8_t *data=nullptr, uint8_t len=0 );
+
+  private:
+    bool _escape;                     // previous byte was 0x7D
+    uint8_t _last;                    // last unstuffed byte (i.e checksum once frame is over)
+    uint8_t _command;
+    uint8_t _status;
+    uint8_t _header[4];               // adr, cmd, state, len
+    uint8_t _payload[_SPS30_MAXDATA + 1];   // data + checksum
+    bool _frameCheck( void );
+};
+
+#endif /* _PM_PARSERS_H_ */
@@ -8,6 +8,19 @@
 
 	@section  HISTORY
 
+    oct.26  adaptive sleep bound with wake up delays above 30mn
+    oct.26  SPS30 start measurement whenever it gets powered
+    oct.26  32bits FSM timer (i.e wake up delays above 65s)
+    oct.26  sensor reset releases measures, parser and serial link
+            before _init() (re-init used to fail right away)
+    oct.26  adaptive sleep between campaigns (PM2.5 variability and
+            level), fan running time accounting
+    oct.26  Sensirion SPS30 through SHDLC frames
+    oct.26  per sensor serial link (Serial1, Serial2 or SoftwareSerial),
+            RX buffering + event callback, per sensor power save
+            settings and staggered wakeup / measure phases
+    oct.26  non-blocking measures: resumable frame parsers fed from
+            process() with whatever the serial link holds
     feb.22  F.thiebolt  IKEA sensor: switched to a new read command borrowed 
                         from on board IKEA PM sensor micro-controller
     oct.21  F.thiebolt  initial release
@@ -22,6 +35,7 @@
 
 #include "neocampus.h"
 #include "neocampus_debug.h"
+#include "neocampus_utils.h"
 
 #include "pm_serial.h"   // neOCampus driver
 
@@ -37,11 +51,24 @@
 /* declare kind of units (value_units) */
 const char *pm_serial::units_pm   = "µg/m3";
 const char *pm_serial::units_co2  = "ppm";
+const char *pm_serial::units_nc   = "#/cm3";
 /* declare subIDs */
 const char *pm_serial::subID_pm2_5  = "pm2_5";
 const char *pm_serial::subID_pm10   = "pm10";
+const char *pm_serial::subID_pm1    = "pm1";
+const char *pm_serial::subID_pm4    = "pm4";
+const char *pm_serial::subID_nc0_5  = "nc0_5";
+const char *pm_serial::subID_nc1    = "nc1";
+const char *pm_serial::subID_nc2_5  = "nc2_5";
+const char *pm_serial::subID_nc4    = "nc4";
+const char *pm_serial::subID_nc10   = "nc10";
 const char *pm_serial::subID_co2    = "co2";
 
+/* shared among all sensors */
+uint8_t pm_serial::_linksUsed         = 0;
+boolean pm_serial::_phaseStarted      = false;
+unsigned long pm_serial::_lastPhaseMs = 0;
+
 
 /**************************************************************************/
 /*! 
@@ -56,12 +83,34 @@ pm_serial::pm_serial( void ) : generic_driver( _MEASURES_INTERLEAVE_MS,
   _stream = nullptr;
   _link = SENSORS_SERIAL_LINK;        // serial link number (e.g 2 --> Serial2)
   _link_speed = PM_DEFL_LINK_SPEED;   // serial link bauds rate
+  _rx_gpio = INVALID_GPIO;
+  _tx_gpio = INVALID_GPIO;
+  _ownStream = false;
+
+  _powerSaveParam = -1;               // sensor's default
+  _wakeupDelay = PM_WAKEUP_DELAY;
+  _cleaningHours = SPS30_CLEANING_HOURS;
+
+  _adaptive = true;
+  _minSleep = PM_ADAPTIVE_MIN_SLEEP;
+  _maxSleep = PM_ADAPTIVE_MAX_SLEEP;
+  _sleep = PM_ADAPTIVE_STEP;
+  _refIdx = 0;
+  _ewmaInit = false;
+  _ewmaMean = 0;
+  _ewmaVar = 0;
+  _awake = false;
+  _awakeSince = 0;
+  _fanSeconds = 0;
 
   _sensor_type = pmSensorType_t::undefined;
 
   _measures = nullptr;
   _nbMeasures = 0;
 
+  _parser = nullptr;
+  _reading = false;
+
   /* [nov.21] we choose to disable PM%_ENABLE gpio because PMS sensors
    * already features both sleep() and wakeUp() commands
   _enable_gpio = PM_ENABLE;           // PM_ENABLE gpio
@@ -76,8 +125,35 @@ pm_serial::pm_serial( void ) : generic_driver( _MEASURES_INTERLEAVE_MS,
  * Note: very scrase use of dynammic allocation in our code
  */
 pm_serial::~pm_serial( void ) {
+  _release();
+}
+
+
+/*
+ * [oct.26] release measures, frames parser and serial link
+ * i.e back to a state _init() accepts (sensor reset)
+ */
+void pm_serial::_release( void ) {
+  _initialized = false;
+  _FSMstatus = PM_FSMSTATE_DEFL;
+  _reading = false;
+
   delete [] _measures;
   _measures = nullptr;
+  delete _parser;
+  _parser = nullptr;
+
+  // release serial link
+#if defined(ESP8266)
+  if( _ownStream ) delete (SoftwareSerial *)_stream;
+#elif defined(ESP32)
+  if( _stream ) {
+    ((HardwareSerial *)_stream)->end();
+    _linksUsed &= ~(1 << _link);
+  }
+#endif
+  _stream = nullptr;
+  _ownStream = false;
 }
 
 
@@ -96,6 +172,10 @@ void pm_serial::powerOFF( void )
   else if( _ll_sleep() ) {
     log_debug(F("\n[pm_serial] going to sleep through sleep() command"));log_flush();
   }
+  else return;    // sensor still running
+
+  _fanUpdate();
+  _awake = false;
 }
 
 void pm_serial::powerON( void )
@@ -105,10 +185,21 @@ void pm_serial::powerON( void )
   if( _enable_gpio != INVALID_GPIO ) {
     log_debug(F("\n[pm_serial] wakeup through GPIO "));log_debug(_enable_gpio);log_flush();
     pinMode( _enable_gpio, INPUT );    // output value has already been set to LOW
+    // [oct.26] SPS30 powers up in idle mode: start measurement (float values)
+    if( _sensor_type == pmSensorType_t::SPS3X ) {
+      delay(50);
+      const uint8_t data[] = { 0x01, 0x03 };
+      _ll_sps30Command( SPS30_CMD_START, data, sizeof(data) ); delay(50);
+    }
   }
   else if( _ll_wakeUp() ) {
     log_debug(F("\n[pm_serial] wakeup through wakeUp() command"));log_flush();
   }
+
+  if( !_awake ) {
+    _awake = true;
+    _awakeSince = millis();
+  }
 }
 
 
@@ -145,6 +236,38 @@ boolean pm_serial::begin( JsonVariant root ) {
     {
       "param": "enable_gpio", // hardware enable gpio pin
       "value": 5
+    },
+    {
+      "param": "rx_gpio",     // [ESP32] mandatory for link 1, [ESP8266] SoftwareSerial RX
+      "value": 13
+    },
+    {
+      "param": "tx_gpio",     // [ESP32] mandatory for link 1, [ESP8266] SoftwareSerial TX
+      "value": 12
+    },
+    {
+      "param": "power_save",  // optional: override sensor's default power save mode
+      "value": false
+    },
+    {
+      "param": "wakeup",      // optional: seconds waking up sensor before reading data
+      "value": 30
+    },
+    {
+      "param": "cleaning",    // [SPS30] optional: hours between two fan cleanings (0 to disable)
+      "value": 168
+    },
+    {
+      "param": "adaptive",    // optional: adaptive sleep between campaigns (power save only)
+      "value": true
+    },
+    {
+      "param": "min_sleep",   // optional: seconds, adaptive sleep lower bound (0 means continuous)
+      "value": 0
+    },
+    {
+      "param": "max_sleep",   // optional: seconds, adaptive sleep upper bound
+      "value": 1200
     }
   ]
   */
@@ -190,8 +313,80 @@ boolean pm_serial::begin( JsonVariant root ) {
       }
     }
 
+    // RX_GPIO
+    {
+      const char *_param = PSTR("rx_gpio");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _rx_gpio = (uint8_t)item[F("value")].as<int>();    // to force -1 to get converted to (uint8_t)255
+      }
+    }
+
+    // TX_GPIO
+    {
+      const char *_param = PSTR("tx_gpio");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _tx_gpio = (uint8_t)item[F("value")].as<int>();    // to force -1 to get converted to (uint8_t)255
+      }
+    }
+
+    // POWER_SAVE
+    {
+      const char *_param = PSTR("power_save");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _powerSaveParam = ( item[F("value")].as<bool>() ? 1 : 0 );
+      }
+    }
+
+    // WAKEUP delay
+    {
+      const char *_param = PSTR("wakeup");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _wakeupDelay = (uint16_t)item[F("value")].as<unsigned int>();
+      }
+    }
+
+    // ADAPTIVE duty cycle
+    {
+      const char *_param = PSTR("adaptive");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _adaptive = item[F("value")].as<bool>();
+      }
+    }
+
+    // MIN_SLEEP
+    {
+      const char *_param = PSTR("min_sleep");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _minSleep = (uint16_t)item[F("value")].as<unsigned int>();
+      }
+    }
+
+    // MAX_SLEEP
+    {
+      const char *_param = PSTR("max_sleep");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _maxSleep = (uint16_t)item[F("value")].as<unsigned int>();
+      }
+    }
+
+    // CLEANING interval
+    {
+      const char *_param = PSTR("cleaning");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _cleaningHours = (uint16_t)item[F("value")].as<unsigned int>();
+        if( _cleaningHours > SPS30_CLEANING_MAX_HOURS ) _cleaningHours = SPS30_CLEANING_MAX_HOURS;
+      }
+    }
+
   }
 
+  // adaptive sleep bounds (starvation avoidance needs a value every _MAX_COOLDOWN_SENSOR)
+  // [oct.26] a wake up longer than _MAX_COOLDOWN_SENSOR leaves no room for any sleep
+  uint16_t _sleepBound = ( _wakeupDelay < _MAX_COOLDOWN_SENSOR ? _MAX_COOLDOWN_SENSOR - _wakeupDelay : 0 );
+  if( _maxSleep > _sleepBound ) _maxSleep = _sleepBound;
+  if( _minSleep > _maxSleep ) _minSleep = _maxSleep;
+  _sleep = constrain( _sleep, _minSleep, _maxSleep );
+
   /*
    * sensor HW initialisation
    */
@@ -216,14 +411,18 @@ void pm_serial::process( uint16_t coolDown, uint8_t decimals ) {
 
     // IDLE
     case pmSensorState_t::idle:
-      // still in cooldown phase ?
-      if( _curTime - _lastMsRead < ((unsigned long)coolDown)*1000 ) break;
+      // still in cooldown phase ? (adaptive sleep replaces module's coolDown)
+      if( _curTime - _lastMsRead < ((unsigned long)( _adaptiveOn() ? _sleep : coolDown ))*1000 ) break;
+      // another sensor just started its own cycle ? (keep current peaks and CPU bursts apart)
+      if( _phaseStarted and _curTime - _lastPhaseMs < PM_STAGGER_MS ) break;
+      _phaseStarted = true;
+      _lastPhaseMs = _curTime;
       log_debug(F("\n\t[pm_serial] going out of cooldown ...")); log_flush();
       _FSMtimerDelay = 0;
 
       // wake-up sensor ...
       _FSMstatus = pmSensorState_t::wakeup;
-      if( FSMwakeUpStart() ) {
+      if( FSMwakeUpStart( _wakeupDelay ) ) {
         log_debug(F("\n\t[pm_serial] start wake-up cycle ...")); log_flush();
       }
       // ... and continue with next step ...
@@ -250,8 +449,8 @@ void pm_serial::process( uint16_t coolDown, uint8_t decimals ) {
       if( FSMmeasureBusy() ) break;
       log_debug(F("\n\t[pm_serial] end of measures :)")); log_flush();
 
-      // shutdown sensor
-      if( _powerSave ) powerOFF();
+      // shutdown sensor ... unless next campaign comes sooner than a wake-up cycle
+      if( _powerSave and (not _adaptiveOn() or _sleep > _wakeupDelay) ) powerOFF();
 
       // ok continue with next step: wait4read
       _FSMstatus = pmSensorState_t::wait4read;
@@ -275,6 +474,8 @@ void pm_serial::process( uint16_t coolDown, uint8_t decimals ) {
     default:
       log_error(F("\n\t[pm_serial] unknown FSM state ?!?! ... resetting !")); log_flush();
       delay(1000);
+      // [oct.26] _init() only accepts a released sensor
+      _release();
       _init();
   }
 }
@@ -330,7 +531,7 @@ String pm_serial::subID( uint8_t idx ) {
 
 /**************************************************************************/
 /*! 
-    @brief  start wake up cycle up to 65535ms
+    @brief  start wake up cycle up to 65535s
             for short pulse duration (< MAIN_DELAY_LOOP ---i.e 250ms), we
             wait for the specified delay, hence blocking behaviour,
             otherwise this is a non blocking API.
@@ -339,7 +540,8 @@ String pm_serial::subID( uint8_t idx ) {
 /**************************************************************************/
 boolean pm_serial::FSMwakeUpStart( uint16_t seconds ) {
 
-  if( ! _powerSave ) {
+  // sensor already running (e.g continuous measurement) ?
+  if( ! _powerSave or _awake ) {
     _FSMtimerDelay = 0;
     return false; // no delay
   }
@@ -347,7 +549,7 @@ boolean pm_serial::FSMwakeUpStart( uint16_t seconds ) {
   // start sensors
   powerON();
 
-  unsigned long delay_ms = seconds * 1000;
+  unsigned long delay_ms = (unsigned long)seconds * 1000UL;
   // short pulse ?
   if( delay_ms < MAIN_LOOP_DELAY ) {
     delay( delay_ms );
@@ -403,21 +605,26 @@ boolean pm_serial::FSMmeasureStart( void ) {
   }
   _readCpt = 0;
   _retryCpt = _MAX_FAILURES;
+  _reading = false;
 
-  // active mode
-  if( !_activeMode ) {
-    if( _ll_activeMode() ) {
-      _activeMode = true;
-      log_debug(F("\n[pm_serial] active mode enabled ..."));log_flush();
-    }
-    else {
-      log_warning(F("\n[pm_serial] unable to switch to activeMode !?!? ... continuing"));log_flush();
-      delay(500);
-    }
+  // active mode (if supported by sensor)
+  if( !_activeMode and _ll_activeMode() ) {
+    _activeMode = true;
+    log_debug(F("\n[pm_serial] active mode enabled ..."));log_flush();
   }
   // start reading immediately
   _FSMtimerDelay = 0;
 
+  // [SPS30] time for fan cleaning ? (values are meaningless meanwhile)
+  if( _cleaningHours and
+      (millis() - _lastCleaning) >= (unsigned long)_cleaningHours*3600UL*1000UL and
+      _ll_fanCleaning() ) {
+    log_info(F("\n[pm_serial] start fan cleaning ..."));log_flush();
+    _lastCleaning = millis();
+    _FSMtimerStart = _lastCleaning;
+    _FSMtimerDelay = SPS30_CLEANING_MS;
+  }
+
   return true;
 }
 
@@ -429,49 +636,27 @@ boolean pm_serial::FSMmeasureStart( void ) {
 /**************************************************************************/
 boolean pm_serial::FSMmeasureBusy( void ) {
 
-  boolean res = true;
-
   while( (_readCpt < _MAX_MEASURES) and _retryCpt ) {
 
     // do we need to wait (i.e are we busy) ?
     if( _FSMtimerDelay!=0 and 
         (millis() - _FSMtimerStart) < (unsigned long)_FSMtimerDelay ) return true;
+    _FSMtimerDelay = 0;
 
-    // acquire data trough blocking API
-    switch( _sensor_type ) {
-
-      // PMSX003
-      case pmSensorType_t::PMSx003 :
-        _ll_requestRead();
-        res = serialRead_pmsx003(); // blocking read with timeout
-        break;
-
-      // SDS011
-      case pmSensorType_t::SDS011 :
-        _ll_requestRead();
-        res = serialRead_sds011();  // blocking read with timeout
-        break;
-
-      // IKEA
-      case pmSensorType_t::IKEA :
-        _ll_requestRead();
-        res = serialRead_ikea();    // blocking read with timeout
-        break;
-
-      // [CO2] MH-Z1x
-      case pmSensorType_t::MHZ1x :
-        _ll_requestRead();
-        res = serialRead_mhz1x();   // blocking read with timeout
-        break;
-
-      // default
-      default:
-        log_error(F("\n\t[pm_serial] unknown sensor type Ox"));log_error((uint8_t)_sensor_type,HEX);log_flush();
-        delay(1000);
-        return false;
+    // request data (if passive mode) ...
+    if( !_reading ) serialReadStart();
+
+    // ... then feed parser with whatever has been received so far
+    int8_t res = serialRead();
+    if( res == 0 ) {
+      // frame not yet complete, come back soon (RX callback will wake us up)
+#ifndef PM_RX_CALLBACK
+      wakeupLoopIn( PM_READ_POLL_MS );
+#endif /* PM_RX_CALLBACK */
+      return true;
     }
 
-    if( !res ) {
+    if( res < 0 ) {
       log_debug(F("\n\t[pm_serial] read failure ?!?! ... next iteration :|")); log_flush();
       _retryCpt--;
     }
@@ -483,13 +668,6 @@ boolean pm_serial::FSMmeasureBusy( void ) {
     if( _readCpt == _MAX_MEASURES ) break; // not busy anymore
 
     // delay between two measures
-    if( _MEASURES_INTERLEAVE_MS < MAIN_LOOP_DELAY ) {
-      delay( _MEASURES_INTERLEAVE_MS );
-      _FSMtimerDelay = 0;
-      continue;
-    }
-
-    // long delay between measures
     _FSMtimerStart = millis();
     _FSMtimerDelay = _MEASURES_INTERLEAVE_MS;
     return true; // we're busy so check on next loop() iteration
@@ -498,7 +676,6 @@ boolean pm_serial::FSMmeasureBusy( void ) {
   // check for many consecutives failures
   if( !_retryCpt ) {
     log_error(F("\n[pm_serial] too many consecutives reading errors ... next cycle :|")); log_flush();
-    delay(500);
     return false; // not busy anymore :|
   }
 
@@ -518,10 +695,88 @@ boolean pm_serial::FSMmeasureBusy( void ) {
     }
   }
 
+  // next campaign
+  if( _adaptiveOn() ) _adaptiveUpdate();
+
   return false; // not busy anymore
 }
 
 
+/**************************************************************************/
+/*! 
+    @brief  adaptive duty cycle: compute sleep till next campaign
+    @note   'activity' is 0 in clean and stable air, it reaches 1 upon a
+            pollution event or fast changing air (then continuous measurement).
+            Sleep drops immediately but it at most doubles between two
+            campaigns (attack fast, release slow).
+*/
+/**************************************************************************/
+void pm_serial::_adaptiveUpdate( void ) {
+
+  float v = _measures[_refIdx].value;
+  float d = 0;
+
+  if( !_ewmaInit ) {
+    _ewmaMean = v;
+    _ewmaVar = 0;
+    _ewmaInit = true;
+  }
+  else {
+    d = v - _ewmaMean;
+    _ewmaMean += PM_ADAPTIVE_EWMA_WEIGHT * d;
+    _ewmaVar = (1.0 - PM_ADAPTIVE_EWMA_WEIGHT) * (_ewmaVar + PM_ADAPTIVE_EWMA_WEIGHT * d * d);
+  }
+
+  float _stddev = sqrtf( _ewmaVar );
+  float activity = max( _stddev, (float)fabs(d) ) / PM_ADAPTIVE_STDDEV_REF;
+  activity = max( activity, max( v, _ewmaMean ) / (float)PM_ADAPTIVE_LEVEL_REF );
+
+  uint32_t target = _minSleep;
+  if( activity < 1.0 ) {
+    target += (uint32_t)( (float)(_maxSleep - _minSleep) * (1.0 - activity) * (1.0 - activity) );
+  }
+
+  // release slow
+  uint32_t _up = max( (uint32_t)_sleep * 2, (uint32_t)_sleep + PM_ADAPTIVE_STEP );
+  if( target > _up ) target = _up;
+  _sleep = (uint16_t)constrain( target, (uint32_t)_minSleep, (uint32_t)_maxSleep );
+
+  log_debug(F("\n[pm_serial] adaptive: mean = "));log_debug(_ewmaMean);
+  log_debug(F(" stddev = "));log_debug(_stddev);
+  log_debug(F(" activity = "));log_debug(activity);
+  log_debug(F(" ==> next campaign in "));log_debug(_sleep);log_debug(F("s"));log_flush();
+}
+
+
+/*
+ * fan running time accounting
+ */
+void pm_serial::_fanUpdate( void ) {
+  if( !_awake ) return;
+  unsigned long _elapsed = (millis() - _awakeSince) / 1000;
+  _fanSeconds += _elapsed;
+  _awakeSince += _elapsed * 1000;
+}
+
+
+/*
+ * status: duty cycle and fan usage
+ * Note: fan hours since startup
+ */
+void pm_serial::status( JsonObject root ) {
+  if( !_initialized ) return;
+
+  _fanUpdate();
+  root[F("type")] = (uint8_t)_sensor_type;
+  root[F("fan_hours")] = serialized(String((float)_fanSeconds / 3600.0, 2));
+  if( _adaptiveOn() ) {
+    root[F("sleep")] = _sleep;
+    root[F("mean")] = serialized(String(_ewmaMean, 1));
+    root[F("stddev")] = serialized(String(sqrtf(_ewmaVar), 1));
+  }
+}
+
+
 /*
  * DATA integration related methods
  *  send back global sensor's trigger
@@ -654,10 +909,42 @@ boolean pm_serial::_init( void ) {
       _measures[(uint8_t)ikeaDataIdx_t::PM10].units = units_pm;
       break;
 
+    // Sensirion SPS30
+    case pmSensorType_t::SPS3X :
+      log_debug(F("\n[pm_serial] start SPS30 PM sensor setup ..."));log_flush();
+      _activeMode = false;  // values are always requested
+      _link_speed = SPS30_LINK_SPEED;
+      _nbMeasures = (uint8_t)sps30DataIdx_t::last;
+      _measures = new serialMeasure_t[_nbMeasures];
+      for( uint8_t i=0; i<_nbMeasures; i++ ) {
+        _measures[i].subID = nullptr;
+        _measures[i].units = nullptr;
+      }
+      _measures[(uint8_t)sps30DataIdx_t::PM1].subID = subID_pm1;
+      _measures[(uint8_t)sps30DataIdx_t::PM1].units = units_pm;
+      _measures[(uint8_t)sps30DataIdx_t::PM2_5].subID = subID_pm2_5;
+      _measures[(uint8_t)sps30DataIdx_t::PM2_5].units = units_pm;
+      _measures[(uint8_t)sps30DataIdx_t::PM4].subID = subID_pm4;
+      _measures[(uint8_t)sps30DataIdx_t::PM4].units = units_pm;
+      _measures[(uint8_t)sps30DataIdx_t::PM10].subID = subID_pm10;
+      _measures[(uint8_t)sps30DataIdx_t::PM10].units = units_pm;
+      _measures[(uint8_t)sps30DataIdx_t::NC0_5].subID = subID_nc0_5;
+      _measures[(uint8_t)sps30DataIdx_t::NC0_5].units = units_nc;
+      _measures[(uint8_t)sps30DataIdx_t::NC1].subID = subID_nc1;
+      _measures[(uint8_t)sps30DataIdx_t::NC1].units = units_nc;
+      _measures[(uint8_t)sps30DataIdx_t::NC2_5].subID = subID_nc2_5;
+      _measures[(uint8_t)sps30DataIdx_t::NC2_5].units = units_nc;
+      _measures[(uint8_t)sps30DataIdx_t::NC4].subID = subID_nc4;
+      _measures[(uint8_t)sps30DataIdx_t::NC4].units = units_nc;
+      _measures[(uint8_t)sps30DataIdx_t::NC10].subID = subID_nc10;
+      _measures[(uint8_t)sps30DataIdx_t::NC10].units = units_nc;
+      break;
+
     // [CO2] MH-Z1x
     case pmSensorType_t::MHZ1x :
       log_debug(F("\n[pm_serial] start MH-Z1x CO2 sensor setup ..."));log_flush();
       _activeMode = false;  // [nov.21] yes, passive as default
+      _powerSave = false;   // [oct.26] no sleep command, heater is always on
       _nbMeasures = (uint8_t)mhz1xDataIdx_t::last;
       _measures = new serialMeasure_t[_nbMeasures];
       for( uint8_t i=0; i<_nbMeasures; i++ ) {
@@ -675,6 +962,36 @@ boolean pm_serial::_init( void ) {
       return false;
   }
 
+  // adaptive duty cycle is driven by PM2.5 (if any)
+  for( uint8_t i=0; i<_nbMeasures; i++ ) {
+    if( _measures[i].subID == subID_pm2_5 ) _refIdx = i;
+  }
+
+  // serial frames parser
+  switch( _sensor_type ) {
+    case pmSensorType_t::PMSx003 :
+      _parser = new pmsx003_parser();
+      break;
+    case pmSensorType_t::SDS011 :
+      _parser = new sds011_parser();
+      break;
+    case pmSensorType_t::IKEA :
+      _parser = new ikea_parser();
+      break;
+    case pmSensorType_t::MHZ1x :
+      _parser = new mhz1x_parser();
+      break;
+    case pmSensorType_t::SPS3X :
+      _parser = new sps30_parser();
+      break;
+    default:
+      break;
+  }
+  if( !_parser ) {
+    log_error(F("\n[pm_serial] unable to allocate frames parser ?!?!"));log_flush();
+    return false;
+  }
+
   _trigger = false;
 
   /* 
@@ -688,17 +1005,13 @@ boolean pm_serial::_init( void ) {
   }
   _currentCpt    = (uint8_t)(-1);
   _lastMsRead    = ULONG_MAX/2;
+  _lastCleaning  = millis();
 
-  /* Initialize serial link.
-   * Note: link number is the serialX stream object
-   */
-  if( _link != SENSORS_SERIAL_LINK ) {
-    log_error(F("\n[pm_serial] inappropriate serial link number "));log_error(_link);log_flush();
-    return false;
-  }
-  Serial2.begin( _link_speed );
-  _stream = &Serial2;  // TODO pointer to stream according to link number specified ... maybe later ;)
-  if( !_stream ) return false;
+  // sensOCampus power save override (if any)
+  if( _powerSaveParam >= 0 ) _powerSave = ( _powerSaveParam ? true : false );
+
+  // initialize our own serial link
+  if( !_linkSetup() ) return false;
   
   // switch to passive mode (if any)
   if( _ll_passiveMode() ) {
@@ -712,7 +1025,10 @@ boolean pm_serial::_init( void ) {
     digitalWrite( _enable_gpio, LOW );  // this way, INPUT ==> normal ops, OUTPUT ==> sensor disabled
   }
 
-  // powerSave mode ==> stop sensor, otherwise start it
+  /* powerSave mode ==> stop sensor, otherwise start it
+   * [oct.26] powerON() / powerOFF() are no-ops till we're initialized (e.g SPS30
+   * without power save never received its start measurement command) */
+  _initialized = true;
   if( _powerSave ) powerOFF();
   else {
     log_debug(F("\n[pm_serial] DISABLED power save mode ... "));log_flush();
@@ -727,7 +1043,6 @@ boolean pm_serial::_init( void ) {
   _FSMtimerDelay = 0;
 
   // the end ...
-  _initialized = true;
   log_debug(F("\n[pm_serial] successfully initialized PM sensor"));log_flush();
 
   return _initialized;
@@ -735,6 +1050,70 @@ boolean pm_serial::_init( void ) {
 
 
 
+/**************************************************************************/
+/*! 
+    @brief  Open sensor's own serial link
+    @note   [ESP32] link number is the SerialX stream object (1 or 2),
+            [ESP8266] SoftwareSerial over rx_gpio / tx_gpio.
+            RX buffer is large enough to hold several frames, hence a
+            sensor won't lose data while another one gets processed.
+*/
+/**************************************************************************/
+boolean pm_serial::_linkSetup( void ) {
+
+#if defined(ESP32)
+  HardwareSerial *_serial = nullptr;
+  if( _link == 1 ) {
+    // default Serial1 pins are flash ones!
+    if( _rx_gpio == INVALID_GPIO or _tx_gpio == INVALID_GPIO ) {
+      log_error(F("\n[pm_serial] serial link 1 needs both rx_gpio and tx_gpio"));log_flush();
+      return false;
+    }
+    _serial = &Serial1;
+  }
+  else if( _link == 2 ) {
+    _serial = &Serial2;
+  }
+  if( !_serial or (_linksUsed & (1 << _link)) ) {
+    log_error(F("\n[pm_serial] inappropriate or already used serial link number "));log_error(_link);log_flush();
+    return false;
+  }
+
+  _serial->setRxBufferSize( PM_RX_BUFFER_SIZE );   // before begin()
+  _serial->begin( _link_speed, SERIAL_8N1,
+                  ( _rx_gpio == INVALID_GPIO ? -1 : (int8_t)_rx_gpio ),
+                  ( _tx_gpio == INVALID_GPIO ? -1 : (int8_t)_tx_gpio ) );
+#ifdef PM_RX_CALLBACK
+  // UART driver event: wake up main loop whenever data arrived
+  _serial->onReceive( []( void ) { wakeupLoop(); } );
+#endif /* PM_RX_CALLBACK */
+  _linksUsed |= (1 << _link);
+  _stream = _serial;
+
+#elif defined(ESP8266)
+  if( _rx_gpio == INVALID_GPIO or _tx_gpio == INVALID_GPIO ) {
+    log_error(F("\n[pm_serial] SoftwareSerial needs both rx_gpio and tx_gpio"));log_flush();
+    return false;
+  }
+  SoftwareSerial *_serial = new SoftwareSerial();
+  _serial->begin( _link_speed, SWSERIAL_8N1, _rx_gpio, _tx_gpio, false, PM_RX_BUFFER_SIZE );
+  if( !(*_serial) ) {
+    log_error(F("\n[pm_serial] unable to start SoftwareSerial ?!?!"));log_flush();
+    delete _serial;
+    return false;
+  }
+  _ownStream = true;
+  _stream = _serial;
+
+#else
+  log_error(F("\n[pm_serial] no serial link available on this platform"));log_flush();
+#endif
+
+  return ( _stream != nullptr );
+}
+
+
+
 // ============================================================================
 // === LOW-LEVEL serial methods ===============================================
 
@@ -760,6 +1139,12 @@ boolean pm_serial::_ll_sleep( void ) {
     _stream->write(command, sizeof(command)); delay(50);
     res = true;
   }
+  else if( _sensor_type ==  pmSensorType_t::SPS3X ) {
+    // sleep is only allowed from idle mode
+    _ll_sps30Command( SPS30_CMD_STOP ); delay(50);
+    _ll_sps30Command( SPS30_CMD_SLEEP ); delay(50);
+    res = true;
+  }
 
   return res;
 }
@@ -786,6 +1171,15 @@ boolean pm_serial::_ll_wakeUp( void ) {
     _stream->write(command, sizeof(command)); delay(50);
     res = true;
   }
+  else if( _sensor_type ==  pmSensorType_t::SPS3X ) {
+    // low pulse on RX line then wake-up command within 100ms ...
+    _stream->write( (uint8_t)0xFF );
+    _ll_sps30Command( SPS30_CMD_WAKEUP ); delay(50);
+    // ... then start measurement (float values)
+    const uint8_t data[] = { 0x01, 0x03 };
+    _ll_sps30Command( SPS30_CMD_START, data, sizeof(data) ); delay(50);
+    res = true;
+  }
 
   return res;
 }
@@ -851,6 +1245,7 @@ boolean pm_serial::_ll_activeMode( void ) {
 /*! 
     @brief  ask for data to get read
     @note   only relevant if PM sensor has support for such feature
+    @note   no delay after command, answer is awaited by serialRead()
 */
 /**************************************************************************/
 boolean pm_serial::_ll_requestRead( void ) {
@@ -861,23 +1256,27 @@ boolean pm_serial::_ll_requestRead( void ) {
 
   if( _sensor_type ==  pmSensorType_t::PMSx003 ) {
     uint8_t command[] = { 0x42, 0x4D, 0xE2, 0x00, 0x00, 0x01, 0x71 };
-    _stream->write(command, sizeof(command)); delay(50);
+    _stream->write(command, sizeof(command));
     res = true;
   }
   else if( _sensor_type ==  pmSensorType_t::SDS011 ) {
     uint8_t command[] = { 0xAA, 0xB4, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x02, 0xAB };
-    _stream->write(command, sizeof(command)); delay(50);
+    _stream->write(command, sizeof(command));
     res = true;
   }
   else if( _sensor_type ==  pmSensorType_t::IKEA ) {
     // uint8_t command[] = { 0x11, 0x01, 0x02, 0xEC }; // regular command
     uint8_t command[] = { 0x11, 0x02, 0x0b, 0x01, 0xE1 }; // [feb.22] hidden command
-    _stream->write(command, sizeof(command)); delay(50);
+    _stream->write(command, sizeof(command));
     res = true;
   }
   else if( _sensor_type ==  pmSensorType_t::MHZ1x ) {
     uint8_t command[] = { 0XFF, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x79 };
-    _stream->write(command, sizeof(command)); delay(50);
+    _stream->write(command, sizeof(command));
+    res = true;
+  }
+  else if( _sensor_type ==  pmSensorType_t::SPS3X ) {
+    _ll_sps30Command( SPS30_CMD_READ );
     res = true;
   }
 
@@ -885,362 +1284,86 @@ boolean pm_serial::_ll_requestRead( void ) {
 }
 
 
+/**************************************************************************/
+/*! 
+    @brief  start fan cleaning
+    @note   only relevant if PM sensor has support for such feature
+*/
+/**************************************************************************/
+boolean pm_serial::_ll_fanCleaning( void ) {
+  if( ! _stream ) return false;
 
-// ============================================================================
-// === SENSORS SPECIFIC READ PROTOCOL methods =================================
-
-/*!
- * PMSX003: serial data grabber and parser
- * @note blocking call till data OK or timeout
- */
-boolean pm_serial::serialRead_pmsx003( uint16_t timeout ) {
-  
-  uint8_t _index = 0;
-  uint16_t _frameLen = 0;
-  uint16_t _checksum = 0;
-  uint16_t _calculatedChecksum = 0;
-  uint8_t _payload[12];
-
-  unsigned long startTime=millis();
-
-  do {
-    // serial data available ?
-    if( !_stream->available() ) {
-      delay(5); continue;
-    }
-    // read serial char
-    uint8_t ch = _stream->read();
-    // switch to byte position in frame
-    switch( _index ) {
-
-      case 0:
-        if( ch != 0x42 ) continue;
-        _calculatedChecksum = ch;
-        break;
-
-      case 1:
-        if( ch != 0x4D ) {
-          _index = 0;
-          continue;
-        }
-        _calculatedChecksum += ch;
-        break;
-
-      case 2:
-        _calculatedChecksum += ch;
-        _frameLen = ch << 8;
-        break;
-
-      case 3:
-        _frameLen |= ch;
-        // Unsupported sensor, different frame length, transmission error e.t.c.
-        if( _frameLen != 2 * 9 + 2 && _frameLen != 2 * 13 + 2 ) {
-          _index = 0;
-          continue;
-        }
-        _calculatedChecksum += ch;
-        break;
-
-      default:
-        if(_index == _frameLen + 2 ) {
-          _checksum = ch << 8;
-        }
-        else if( _index == _frameLen + 2 + 1 ) {
-          _checksum |= ch;
-
-          if( _calculatedChecksum != _checksum ) {
-            // bad checksum ...
-            log_warning(F("\n[pm_serial][PMSx003] bad checksum ...")); log_flush();
-            _index = 0;
-            continue;
-          }
-
-          uint16_t value;
-          /* Standard Particles, CF=1.
-          _data->PM_SP_UG_1_0 = makeWord(_payload[0], _payload[1]);
-          _data->PM_SP_UG_2_5 = makeWord(_payload[2], _payload[3]);
-          _data->PM_SP_UG_10_0 = makeWord(_payload[4], _payload[5]);
-          */
-          // Atmospheric Environment.
-          //value = makeWord(_payload[6], _payload[7]);   // PM1_0
-          value = makeWord(_payload[8], _payload[9]);     // PM2_5
-          log_debug(F("\n[pm_serial][PMSx003] PM2_5 = "));log_debug(value);log_flush();
-          _measures[(uint8_t)pmsx003DataIdx_t::PM2_5]._currentSum += (float)value;
-          log_debug(F("\t_currentSum = "));log_debug(_measures[(uint8_t)pmsx003DataIdx_t::PM2_5]._currentSum);
-          log_flush();
-          value = makeWord(_payload[10], _payload[11]);   // PM10
-          log_debug(F("\n[pm_serial][PMSx003] PM10 = "));log_debug(value);log_flush();
-          _measures[(uint8_t)pmsx003DataIdx_t::PM10]._currentSum += (float)value;
-
-          // data acquired, finisk :)
-          log_debug(F("\n[pm_serial][PMSx003] "));log_debug(millis()-startTime);
-          log_debug(F("ms reading data over serial link"));log_flush();
-          _index = 0; // useless since we return now ...
-          return true;
-        }
-        else {
-          // payload acquire
-          _calculatedChecksum += ch;
-          uint8_t payloadIndex = _index - 4;
-
-          // Payload is common to all sensors (first 2x6 bytes).
-          if( payloadIndex < sizeof(_payload) ) _payload[payloadIndex] = ch;
-        }
-    }
-    _index++;
+  boolean res = false;
 
-  } while( millis() - startTime < timeout );
+  if( _sensor_type ==  pmSensorType_t::SPS3X ) {
+    // measurement mode only
+    _ll_sps30Command( SPS30_CMD_CLEANING );
+    res = true;
+  }
 
-  return false;
+  return res;
 }
 
 
-/*!
- * SDS011: serial data grabber and parser
- * @note blocking call till data OK or timeout
- */
-boolean pm_serial::serialRead_sds011( uint16_t timeout ) {
-  
-  uint8_t _index = 0;
-  uint16_t _checksum = 0;
-  uint16_t _calculatedChecksum = 0;
-  uint8_t _payload[4];
-
-  unsigned long startTime=millis();
-
-  do {
-    // serial data available ?
-    if( !_stream->available() ) {
-      delay(5); continue;
-    }
-    // read serial char
-    uint8_t ch = _stream->read();
-    // switch to byte position in frame
-    switch( _index ) {
-
-      case 0:
-        if( ch != 0xAA ) continue;
-        break;
-
-      case 1:
-        if( ch != 0xC0 ) {
-          _index = 0;
-          continue;
-        }
-        break;
-
-      case 8:
-        _checksum = ch;
-        break;
-
-      case 9:
-        if( ch != 0xAB ) {
-          _index = 0;
-          continue;
-        }
-        if( (uint8_t)_calculatedChecksum != (uint8_t)_checksum ) {
-          log_warning(F("\n[pm_serial][SDS011] bad checksum ...")); log_flush();
-          _index = 0;
-          continue;
-        }
-        uint16_t value;
-        // Atmospheric Environment.
-        value = makeWord(_payload[1], _payload[0])/10;     // PM2_5
-        log_debug(F("\n[pm_serial][SDS011] PM2_5 = "));log_debug(value);log_flush();
-        _measures[(uint8_t)sds011DataIdx_t::PM2_5]._currentSum += (float)value;
-        log_debug(F("\t_currentSum = "));log_debug(_measures[(uint8_t)sds011DataIdx_t::PM2_5]._currentSum);
-        log_flush();
-        value = makeWord(_payload[3], _payload[2])/10;   // PM10
-        log_debug(F("\n[pm_serial][SDS011] PM10 = "));log_debug(value);log_flush();
-        _measures[(uint8_t)sds011DataIdx_t::PM10]._currentSum += (float)value;
-
-        // data acquired, finisk :)
-        log_debug(F("\n[pm_serial][SDS011] "));log_debug(millis()-startTime);
-        log_debug(F("ms reading data over serial link"));log_flush();
-        _index = 0; // useless since we return now ...
-        return true;
-
-      default:
-        if(_index == 2) _calculatedChecksum = ch;
-        else _calculatedChecksum += ch;
-
-        if( _index-2 < sizeof(_payload) ) _payload[_index-2] = ch;
-    }
-    _index++;
+/**************************************************************************/
+/*! 
+    @brief  [SPS30] send a SHDLC command
+    @note   answer (if any) gets dropped on next read request
+*/
+/**************************************************************************/
+void pm_serial::_ll_sps30Command( uint8_t cmd, const uint8_t *data, uint8_t len ) {
+  uint8_t frame[SPS30_FRAME_MAXLEN];
+  size_t frameLen = sps30_parser::encode( frame, sizeof(frame), cmd, data, len );
+  if( frameLen ) _stream->write( frame, frameLen );
+}
 
-  } while( millis() - startTime < timeout );
 
-  return false;
-}
 
+// ============================================================================
+// === SENSORS SPECIFIC READ PROTOCOL methods =================================
 
 /*!
- * IKEA: serial data grabber and parser
- * @note blocking call till data OK or timeout
+ * start waiting for a frame:
+ * drop stale data, reset parser and request data (passive mode)
  */
-boolean pm_serial::serialRead_ikea( uint16_t timeout ) {
-
-  uint8_t _index = 0;
-  uint16_t _frameLen = 0;
-  uint16_t _checksum = 0;
-  uint16_t _calculatedChecksum = 0;
-  uint8_t _payload[16]; // [feb.22] newer command send back up to 16 bytes (no idea DF13-DF16 role)
-
-  unsigned long startTime=millis();
-
-  do {
-    // serial data available ?
-    if( !_stream->available() ) {
-      delay(5); continue;
-    }
-
-    // read serial char
-    uint8_t ch = _stream->read();
-
-    // switch to byte position in frame
-    switch( _index ) {
-
-      case 0:
-        if( ch != 0x16 ) continue;
-        _calculatedChecksum = ch;
-        break;
-
-      case 1:
-        _calculatedChecksum += ch;
-        _frameLen = ch;
-        break;
-
-      case 2:
-        // command byte answer: it could be 0x02 or 0x0b
-        /*
-        if( ch != 0x02 ) {
-          _index = 0;
-          continue;
-        }
-        */
-        _calculatedChecksum += ch;
-        break;
-
-      default:
-        if(_index == _frameLen + 2) {
-          _checksum = ch;
-          
-          if( uint8_t(_calculatedChecksum+_checksum) != (uint8_t)0 ) {
-            // bad checksum ...
-            log_warning(F("\n[pm_serial][IKEA] bad checksum ...")); log_flush();
-            _index = 0;
-            continue;
-          }
-
-          uint16_t value;
-          // Atmospheric Environment.
-          //value = makeWord(_payload[6], _payload[7]);   // PM1_0
-          value = makeWord(_payload[2], _payload[3]);     // PM2_5
-          log_debug(F("\n[pm_serial][IKEA] PM2_5 = "));log_debug(value);log_flush();
-          _measures[(uint8_t)ikeaDataIdx_t::PM2_5]._currentSum += (float)value;
-          log_debug(F("\t_currentSum = "));log_debug(_measures[(uint8_t)ikeaDataIdx_t::PM2_5]._currentSum);
-          log_flush();
-          value = makeWord(_payload[10], _payload[11]);   // PM10
-          log_debug(F("\n[pm_serial][IKEA] PM10 = "));log_debug(value);log_flush();
-          _measures[(uint8_t)ikeaDataIdx_t::PM10]._currentSum += (float)value;
-          // [feb.22] no idea DF13-DF16 bytes from 0x0B command are useful for ??
-
-          // data acquired, finisk :)
-          log_debug(F("\n[pm_serial][IKEA] "));log_debug(millis()-startTime);
-          log_debug(F("ms reading data over serial link"));log_flush();
-          _index = 0; // useless since we return now ...
-          return true;
-
-        }
-        else {
-          // payload acquire
-          _calculatedChecksum += ch;
-          uint8_t payloadIndex = _index - 3;
-
-          if( payloadIndex < sizeof(_payload) ) _payload[payloadIndex] = ch;
-        }
-    }
-    _index++;
-
-  } while( millis() - startTime < timeout );
-
-  return false;
+void pm_serial::serialReadStart( void ) {
+  while( _stream->available() ) _stream->read();
+  _parser->reset();
+  _ll_requestRead();
+  _readStart = millis();
+  _reading = true;
 }
 
+
 /*!
- * MH-Z1x: serial data grabber and parser
- * @note blocking call till data OK or timeout
+ * feed parser with received data (non-blocking)
+ * @return 1 frame read, 0 frame not yet complete, -1 timeout
  */
-boolean pm_serial::serialRead_mhz1x( uint16_t timeout ) {
+int8_t pm_serial::serialRead( void ) {
 
-  uint8_t _index = 0;
-  uint16_t _frameLen = 0;
-  uint16_t _checksum = 0;
-  uint16_t _calculatedChecksum = 0;
-  uint8_t _payload[6];
+  while( _stream->available() ) {
+    if( not _parser->feed( (uint8_t)_stream->read() ) ) continue;
 
-  unsigned long startTime=millis();
-
-  do {
-    // serial data available ?
-    if( !_stream->available() ) {
-      delay(5); continue;
+    // frame decoded: accumulate values
+    _reading = false;
+    for( uint8_t i=0; i<_nbMeasures and i<_parser->nbValues(); i++ ) {
+      _measures[i]._currentSum += (float)_parser->value(i);
+      log_debug(F("\n[pm_serial] "));log_debug(_measures[i].subID);log_debug(F(" = "));log_debug(_parser->value(i));
+      log_debug(F("\t_currentSum = "));log_debug(_measures[i]._currentSum);
     }
+    log_debug(F("\n[pm_serial] "));log_debug(millis()-_readStart);
+    log_debug(F("ms reading data over serial link"));log_flush();
+    return 1;
+  }
 
-    // read serial char
-    uint8_t ch = _stream->read();
-
-    // switch to byte position in frame
-    switch( _index ) {
-
-      case 0:
-        if( ch != 0xff ) continue;
-        break;
-
-      case 1:
-        if( ch != 0x86 ) {
-          _index = 0;
-          continue;
-        }
-        _calculatedChecksum = ch; // yes, preamble is not part of checksum
-        _frameLen = sizeof(_payload);  // fixed frame length
-        break;
-
-      default:
-        if(_index == _frameLen + 2) {
-          _checksum = ch;
-          
-          if( uint8_t(~_calculatedChecksum + 1) != (uint8_t)_checksum ) {
-            // bad checksum ...
-            log_warning(F("\n[pm_serial][MHZ-1x] bad checksum ...")); log_flush();
-            _index = 0;
-            continue;
-          }
-
-          uint16_t value;
-          value = makeWord(_payload[0], _payload[1]);     // CO2
-          log_debug(F("\n[pm_serial][MHZ-1x] CO2 = "));log_debug(value);log_flush();
-          _measures[(uint8_t)mhz1xDataIdx_t::CO2]._currentSum += (float)value;
-          log_debug(F("\t_currentSum = "));log_debug(_measures[(uint8_t)mhz1xDataIdx_t::CO2]._currentSum);
-          log_flush();
-
-          // data acquired, finisk :)
-          log_debug(F("\n[pm_serial][MHZ-1x] "));log_debug(millis()-startTime);
-          log_debug(F("ms reading data over serial link"));log_flush();
-          _index = 0; // useless since we return now ...
-          return true;
-        }
-        else {
-          // payload acquire
-          _calculatedChecksum += ch;
-          uint8_t payloadIndex = _index - 2;
-
-          if( payloadIndex < sizeof(_payload) ) _payload[payloadIndex] = ch;
-        }
-    }
-    _index++;
-
-  } while( millis() - startTime < timeout );
+  // timeout ?
+  if( (millis() - _readStart) >= (unsigned long)(_activeMode ? PM_ACTIVE_MSTIMEOUT : PM_READ_MSTIMEOUT) ) {
+    const pmParserStats_t *_st = _parser->stats();
+    log_warning(F("\n[pm_serial] read timeout, parser errors = "));log_warning(_st->errors);
+    log_warning(F(" discarded bytes = "));log_warning(_st->discarded);log_flush();
+    _reading = false;
+    return -1;
+  }
 
-  return false;
+  return 0;
 }
@@ -8,7 +8,7 @@
     This driver is intended various particules meters featuring a serial link:
     - PMSx003
     - SDS011
-    - [later] Sensirion SPS30
+    - Sensirion SPS30 (SHDLC)
     - CO2 sensor PMH-Z14 (*)
     
     (c) Copyright 2021 Thiebolt F. <thiebolt@irit.fr>
@@ -19,6 +19,13 @@
 
 	@section  HISTORY
 
+    oct.26  adaptive duty cycle according to PM variability and level,
+            estimated fan hours in status
+    oct.26  Sensirion SPS30 support (SHDLC), periodic fan cleaning
+    oct.26  several sensors, each on its own serial link (i.e Serial1,
+            Serial2 or SoftwareSerial on ESP8266) with buffered RX
+            and staggered wakeup / measure phases
+    oct.26  non-blocking reads through resumable frame parsers
     nov.21  F.Thiebolt  integration of functionalities from PMS_library sensor
     oct.21  F.Thiebolt  initial release
     
@@ -37,6 +44,13 @@
 // generic sensor driver
 #include "generic_driver.h"
 
+// serial frames parsers
+#include "pm_parsers.h"
+
+#if defined(ESP8266)
+  #include <SoftwareSerial.h>   // ESP8266 lacks additional RX capable UARTs
+#endif
+
 
 
 /*
@@ -70,8 +84,43 @@
 
 /* reading data timeout ms delay
  * Delay for data to arrive within serial buffer.
+ * Note: reads are non-blocking, process() feeds the parser with whatever
+ * has been received till a frame is complete or timeout
  */
 #define PM_READ_MSTIMEOUT     130   // ms timeout delay for reading data from serial link (use to be < 40ms)
+#define PM_ACTIVE_MSTIMEOUT   2500  // ms timeout delay in active mode (sensor sends frames at its own pace)
+#define PM_READ_POLL_MS       20    // ms between two serial link polling while a frame is awaited
+
+/* several sensors (e.g a PMSx003 and a MH-Z19) may be connected, each of them
+ * on its own serial link:
+ * [ESP32] link 1 (rx_gpio and tx_gpio are mandatory) or link 2 (default pins)
+ * [ESP8266] SoftwareSerial over rx_gpio / tx_gpio
+ * Frames get buffered by the UART driver (or SoftwareSerial ISR) while the
+ * other sensors get processed, hence no link ever waits for another one.
+ */
+#define PM_RX_BUFFER_SIZE     256   // bytes of RX buffering per serial link (several frames)
+#define PM_STAGGER_MS         5000  // ms between two sensors' wakeup / measure phases (peak current)
+
+/* RX event callback: UART driver wakes our main loop up as soon as data
+ * arrived (arduino-esp32 >= 2.0.3), otherwise we poll every PM_READ_POLL_MS */
+#if defined(ESP32) && defined(ESP_ARDUINO_VERSION_VAL)
+  #if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(2,0,3)
+    #define PM_RX_CALLBACK
+  #endif
+#endif
+
+/* adaptive duty cycle (power save sensors only)
+ * sleep between two measuring campaigns adapts to recent PM2.5 variability
+ * and level: long sleeps in clean and stable air, fan kept running (i.e
+ * continuous measurement) during pollution events.
+ * Note: it overrides module's coolDown for this sensor.
+ */
+#define PM_ADAPTIVE_MIN_SLEEP     0       // seconds, default lower bound (0 means continuous measurement)
+#define PM_ADAPTIVE_MAX_SLEEP     1200    // seconds, default upper bound (<= _MAX_COOLDOWN_SENSOR)
+#define PM_ADAPTIVE_STEP          60      // seconds, sleep at most doubles between two campaigns (at least this step)
+#define PM_ADAPTIVE_LEVEL_REF     25.0    // µg/m3 PM2.5 level of a pollution event
+#define PM_ADAPTIVE_STDDEV_REF    5.0     // µg/m3 PM2.5 standard deviation of unstable air
+#define PM_ADAPTIVE_EWMA_WEIGHT   0.25    // weight of the last campaign in mean / variance
 
 // Finite state machine
 enum class pmSensorState_t : uint8_t {
@@ -88,6 +137,14 @@ enum class pmSensorState_t : uint8_t {
  */
 #define PM_DEFL_LINK_SPEED    9600  // serial link default speed
 
+/* [SPS30] periodic fan cleaning
+ * sensor's own auto-cleaning counter restarts whenever it gets powered off,
+ * hence we trigger fan cleaning ourselves */
+#define SPS30_LINK_SPEED          115200  // the only speed SPS30 supports
+#define SPS30_CLEANING_HOURS      168     // default hours between two fan cleanings (0 to disable)
+#define SPS30_CLEANING_MAX_HOURS  1000    // millis() based
+#define SPS30_CLEANING_MS         12000   // ms fan cleaning duration (values are meaningless)
+
 // type of sensor
 enum class pmSensorType_t : uint8_t { 
   PMSx003       = 0x10,       // PMS5003, PMSA003 ...
@@ -115,7 +172,7 @@ typedef struct {
   const char    *units;       // units string
 } serialMeasure_t;
 
-#define PM_MAX_MEASURES         4 // maximum number of single measures
+#define PM_MAX_MEASURES         9 // maximum number of single measures
 
 /* PMSx003 measurements
  * very low precision on 1µm particle so we don't take mention of them
@@ -142,6 +199,22 @@ enum class ikeaDataIdx_t : uint8_t {
   last
 };
 
+/* SPS30 measurements
+ * mass concentrations then number concentrations (same order as frames)
+ */
+enum class sps30DataIdx_t : uint8_t {
+  PM1=0,
+  PM2_5,
+  PM4,
+  PM10,
+  NC0_5,
+  NC1,
+  NC2_5,
+  NC4,
+  NC10,
+  last
+};
+
 /* MH-Z1x measurements
  * [nov.21] CO2 sensor
  */
@@ -182,6 +255,9 @@ class pm_serial : public generic_driver {
     float getValue( uint8_t *idx=nullptr );   // get official value that has gone through the whole integration process
     void setDataSent( void );                 // data has been sent, reset the 'new official data' trigger
 
+    // duty cycle and fan usage
+    void status( JsonObject );
+
   // --- protected methods / attributes ---------------------
   // --- i.e subclass have direct access to
   protected:
@@ -190,23 +266,58 @@ class pm_serial : public generic_driver {
     Stream* _stream;                    // serial link stream (pointer)
     unsigned int _link_speed;           // 9600 to 115200 bauds
     uint8_t _enable_gpio;               // PM_ENABLE gpio
+    uint8_t _rx_gpio;                   // serial link RX gpio (optional on ESP32 Serial2)
+    uint8_t _tx_gpio;                   // serial link TX gpio (optional on ESP32 Serial2)
+    boolean _ownStream;                 // _stream has been allocated by us (i.e SoftwareSerial)
 
     pmSensorType_t _sensor_type;        // kind of PM sensor (e.g PMSx003, SDS011, SCP30 ...)
     boolean _activeMode;                // only relevant to PM sensors having support for active/passive modes
     boolean _powerSave;                 // power save enabled or not
+    int8_t _powerSaveParam;             // sensOCampus power save setting (-1 means sensor's default)
+    uint16_t _wakeupDelay;              // seconds waking up sensor before reading data
+    boolean _adaptive;                  // adaptive duty cycle enabled (only relevant with power save)
+    uint16_t _minSleep;                 // seconds, adaptive sleep lower bound
+    uint16_t _maxSleep;                 // seconds, adaptive sleep upper bound
+    uint16_t _sleep;                    // seconds, current sleep between two campaigns
+    uint8_t _refIdx;                    // measure driving the adaptive duty cycle (i.e PM2.5)
+    boolean _ewmaInit;
+    float _ewmaMean;                    // exponentially weighted mean of campaigns' values
+    float _ewmaVar;                     // exponentially weighted variance of campaigns' values
+    boolean _awake;                     // sensor (fan) is running
+    unsigned long _awakeSince;          // ms system time awake accounting start
+    uint32_t _fanSeconds;               // seconds of fan running since startup
+    uint16_t _cleaningHours;            // [SPS30] hours between two fan cleanings (0 means disabled)
+    unsigned long _lastCleaning;        // [SPS30] ms system time of last fan cleaning
 
     pmSensorState_t _FSMstatus;         // FSM
     unsigned long _FSMtimerStart;       // ms system time start of current state;
                                         // Only relevant when timerDelay is not null
-    uint16_t _FSMtimerDelay;            // ms delay to cur state timeout
+    uint32_t _FSMtimerDelay;            // ms delay to cur state timeout
+
+    pm_parser *_parser;                 // serial frames parser according to sensor type
+    boolean _reading;                   // a frame is awaited
+    unsigned long _readStart;           // ms system time frame request
     
     boolean _initialized;
     static const char *units_pm;
     static const char *units_co2;
+    static const char *units_nc;
     static const char *subID_pm2_5;
     static const char *subID_pm10;
+    static const char *subID_pm1;
+    static const char *subID_pm4;
+    static const char *subID_nc0_5;
+    static const char *subID_nc1;
+    static const char *subID_nc2_5;
+    static const char *subID_nc4;
+    static const char *subID_nc10;
     static const char *subID_co2;
 
+    // shared among all sensors
+    static uint8_t _linksUsed;          // bitmask of hardware serial links already in use
+    static boolean _phaseStarted;       // at least one sensor already left idle state
+    static unsigned long _lastPhaseMs;  // ms system time of last sensor wakeup / measure phase start
+
     // data integration
     boolean _trigger;                   // when triggered, multiple call to getValue(*idx) will send back all stable values
     serialMeasure_t *_measures;         // array of measurement structs
@@ -217,17 +328,21 @@ class pm_serial : public generic_driver {
 
     // -- private/protected methods
     boolean _init( void );          // low-level init
+    void _release( void );          // free measures, parser and serial link (i.e before re-init)
+    boolean _linkSetup( void );     // open our own serial link
 
-    boolean FSMwakeUpStart( uint16_t=PM_WAKEUP_DELAY );
+    boolean FSMwakeUpStart( uint16_t );
     boolean FSMwakeUpBusy( void );
 
     boolean FSMmeasureStart( void );
     boolean FSMmeasureBusy( void );
 
-    boolean serialRead_pmsx003( uint16_t=PM_READ_MSTIMEOUT );   // blocking call reading data from serial till data OK or timeout
-    boolean serialRead_sds011( uint16_t=PM_READ_MSTIMEOUT );    // blocking call reading data from serial till data OK or timeout
-    boolean serialRead_ikea( uint16_t=PM_READ_MSTIMEOUT );      // blocking call reading data from serial till data OK or timeout
-    boolean serialRead_mhz1x( uint16_t=PM_READ_MSTIMEOUT );     // blocking call reading data from serial till data OK or timeout
+    void _adaptiveUpdate( void );       // compute next sleep from last campaign
+    boolean _adaptiveOn( void ) { return ( _adaptive and _powerSave ); };
+    void _fanUpdate( void );            // fan running time accounting
+
+    void serialReadStart( void );       // start waiting for a frame
+    int8_t serialRead( void );          // non-blocking: 1 frame read, 0 still waiting, -1 timeout
 
     // -- [ll] private/protected methods
     boolean _ll_sleep( void );
@@ -235,6 +350,8 @@ class pm_serial : public generic_driver {
     boolean _ll_passiveMode( void );
     boolean _ll_activeMode( void );
     boolean _ll_requestRead( void );
+    boolean _ll_fanCleaning( void );
+    void _ll_sps30Command( uint8_t cmd, const uint8_t *data=nullptr, uint8_t len=0 );
 };
 
 #endif /* _PM_SERIAL_H_ */
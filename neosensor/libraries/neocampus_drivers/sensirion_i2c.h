@@ -0,0 +1,95 @@
+/**************************************************************************/
+/*!
+    @file     sensirion_i2c.h
+    @author   neOCampus
+	  @license
+
+    This is part of a the neOCampus drivers library.
+    Sensirion I2C transport shared by SHT2x, SHT3x and SCD4x drivers:
+    commands, CRC protected 16bits words, commands execution time.
+
+    (c) Copyright 2026 neOCampus
+
+	@section  HISTORY
+
+    2026-Oct    - no 'busy' status: calls wait for the device
+    2026-Oct    - Initial release
+
+*/
+/**************************************************************************/
+
+#ifndef _SENSIRION_I2C_H_
+#define _SENSIRION_I2C_H_
+
+
+#include <Arduino.h>
+
+#include "neocampus_i2c.h"
+
+
+
+/*
+ * Definitions
+ */
+/* Sensirion devices:
+ * - commands are 16bits wide (SHT2x: 8bits), some devices need an
+ *   execution time before next command (1ms min.)
+ * - data are 16bits words, each one followed by its CRC8 0x31
+ *      MSB[0] + LSB[0] + CRC[0] + MSB[1] + LSB[1] + CRC[1] ...
+ * - execution time is a per-device deadline: next transaction waits only
+ *   for what remains (if any), non blocking callers check sensirion_ready()
+ */
+#define SENSIRION_DEVICES_MAX     4       // devices with their own commands deadline
+#define SENSIRION_WORDS_MAX       4       // max words read at once
+#define SENSIRION_CMD_MS          1       // ms, min delay between two commands
+
+// CRC8 P(x)=x^8+x^5+x^4+1 (0x31) 1.00110001
+#define SENSIRION_CRC8_POLYNOM    0x31
+#define SENSIRION_CRC8_INIT       0xFF    // SHT3x, SCD4x (SHT2x: 0x00)
+
+// Enable CRC lookup table (regular computation otherwise)
+#ifndef SENSIRION_CRC_LOOKUP_TABLE
+#define SENSIRION_CRC_LOOKUP_TABLE  1
+#endif
+
+// transport status
+// Note: calls wait for the previous command execution time, never 'busy'
+enum class sensirionStatus_t : uint8_t {
+  ok            = 0,
+  i2c_error,            // no answer, NACK, short read ...
+  crc_error,            // invalid CRC
+  invalid               // invalid parameters (e.g too many words)
+};
+
+// per-device commands deadline
+typedef struct {
+  uint8_t addr;
+  unsigned long readyUs;  // (µs) device accepts next command
+} sensirionDevice_t;
+
+
+
+/*
+ * Functions
+ */
+uint8_t sensirion_crc8( const uint8_t *data, uint8_t len, uint8_t init=SENSIRION_CRC8_INIT );
+
+// commands execution time
+bool sensirion_ready( uint8_t adr );
+void sensirion_wait( uint8_t adr );
+void sensirion_busy( uint8_t adr, uint16_t ms );
+
+// commands without answer
+sensirionStatus_t sensirion_command( uint8_t adr, uint16_t cmd, uint16_t execMs=SENSIRION_CMD_MS );
+sensirionStatus_t sensirion_command8( uint8_t adr, uint8_t cmd, uint16_t execMs=SENSIRION_CMD_MS );
+
+// read CRC protected words (e.g single shot measure started earlier)
+sensirionStatus_t sensirion_read( uint8_t adr, uint16_t *words, uint8_t nb, uint8_t init=SENSIRION_CRC8_INIT );
+
+// command then CRC protected words once command got executed
+sensirionStatus_t sensirion_read_cmd( uint8_t adr, uint16_t cmd, uint16_t *words, uint8_t nb,
+                                      uint16_t execMs=SENSIRION_CMD_MS, uint8_t retries=I2C_RETRIES );
+sensirionStatus_t sensirion_read_cmd8( uint8_t adr, uint8_t cmd, uint16_t *words, uint8_t nb,
+                                       uint16_t execMs, uint8_t init, bool repeatStart=false );
+
+#endif /* _SENSIRION_I2C_H_ */
@@ -4,6 +4,10 @@
  * AirQuality module to manage all kind of air quality sensors that does not
  * fit within the existing sensOCampus classes.
  *
+ * oct.26  SCD4x CO2 sensor auto-detected on i2c bus
+ * oct.26  'calibration' order to push a sensor's calibration curve
+ * oct.26  drivers' own status (e.g PM sensors duty cycle, fan hours)
+ * oct.26  several pm_serial sensors, each on its own serial link
  * F.Thiebolt   oct.21  added support for particle meters (e.g PMS5003)
  *                      switched to data available delivery (instead of timer based)
  * F.Thiebolt   aug.21  in loadSensoConfig, replaced StaticJsonDocument (stack)
@@ -35,6 +39,7 @@
  */
 #define MQTT_MODULE_NAME        "airquality"  // used to build module's base topic
 #define DATA_JSON_SIZE          (JSON_OBJECT_SIZE(20))  // for MQTT data sending
+#define STATUS_JSON_SIZE        (DATA_JSON_SIZE + JSON_ARRAY_SIZE(_MAX_SENSORS) + _MAX_SENSORS*JSON_OBJECT_SIZE(6) + 256)  // module + drivers' status
 #define CONFIG_JSON_SIZE        (JSON_OBJECT_SIZE(3))   // for config FILE that contains: frequency
                                                         // note: others parameters are sent from sensOCampus
                                                         // hence not saved ;)
@@ -102,6 +107,20 @@ boolean airquality::add_sensor( uint8_t adr ) {
     }
   }
    */
+  // check for SCD4x CO2 sensor (temperature and humidity go to their own modules)
+  if( SCD4x::is_device( adr ) == true ) {
+    SCD4x *cur_sensor = new SCD4x( scd4xMeasureType_t::co2 );
+    if( cur_sensor->begin( adr ) != true ) {
+      log_debug(F("\n[airquality] ###ERROR at SCD4x startup ... removing instance ..."));log_flush();
+      free(cur_sensor);
+      cur_sensor = NULL;
+    }
+    else {
+      // low power periodic measurement keeps running (device shared across 3 modules)
+      _sensor[_sensors_count++] = cur_sensor;
+      _sensor_added = true;
+    }
+  }
   // add check for additional device here
 
   // summary
@@ -172,6 +191,18 @@ void airquality::handle_msg( JsonObject root ) {
   const char *_key_order = NULL;    // current 'order'
   int _key_value;                   // current 'value'
   bool _key_value_valid = false;    // is a key_value already get saved in _key_value ?
+
+  /* calibration order features an object as value:
+   * { "order": "calibration", "value": { "subID": "NO2", "gain": 1000000, "mv": [..], "ppm": [..] } }
+   */
+  {
+    const char *_order = PSTR("calibration");
+    if( root[F("order")].is<const char*>() and
+        strncmp_P(root[F("order")], _order, strlen_P(_order))==0 ) {
+      _processCalibration( root[F("value")] );
+      return;
+    }
+  }
   
   // iterate over all [key,values] pairs
   for (JsonObject::iterator it=root.begin(); it!=root.end(); ++it) {
@@ -255,7 +286,17 @@ void airquality::status( JsonObject root ) {
   
   // add base class status
   base::status( root );
-    
+
+  // drivers' own status (if any)
+  JsonArray _drivers = root.createNestedArray(F("drivers"));
+  for( uint8_t i=0; i<_sensors_count; i++ ) {
+    if( _sensor[i]==nullptr ) continue;
+    JsonObject _obj = _drivers.createNestedObject();
+    _sensor[i]->status( _obj );
+    if( _obj.size()==0 ) _drivers.remove( _drivers.size()-1 );
+  }
+  if( _drivers.size()==0 ) root.remove(F("drivers"));
+
   /*
    * TODO: add list of sensors IDs
    */
@@ -566,7 +607,7 @@ bool airquality::_processOrder( const char *order, int *value ) {
     const char *_order = PSTR("status");
     if( strncmp_P(order, _order, strlen_P(_order))==0 ) {
       // required to send status ... so publishing while in callback :)
-      StaticJsonDocument<DATA_JSON_SIZE> _doc;
+      DynamicJsonDocument _doc(STATUS_JSON_SIZE);
       JsonObject root = _doc.to<JsonObject>();
       status( root );
       return sendmsg( root );
@@ -586,7 +627,7 @@ bool airquality::_processOrder( const char *order, int *value ) {
     if( strncmp_P(order, _order, strlen_P(_order))==0 ) {
       if( value ) {
         setFrequency( (uint16_t)(*value), AIRQUALITY_MIN_FREQUENCY, AIRQUALITY_MAX_FREQUENCY );
-        StaticJsonDocument<DATA_JSON_SIZE> _doc;
+        DynamicJsonDocument _doc(STATUS_JSON_SIZE);
         JsonObject root = _doc.to<JsonObject>();
         status( root );
         sendmsg(root);
@@ -601,6 +642,44 @@ bool airquality::_processOrder( const char *order, int *value ) {
 }
 
 
+/*
+ * calibration order: sensor(s) matching subID get the curve
+ */
+bool airquality::_processCalibration( JsonVariant value ) {
+
+  if( not value.is<JsonObject>() or not value[F("subID")].is<const char*>() ) {
+    log_error(F("\n[airquality][calibration] expecting an object with a subID ?!")); log_flush();
+    return false;
+  }
+  const char *_subID = value[F("subID")];
+
+  // a subID alone means back to uncalibrated values
+  JsonVariant _curve = value;
+  if( value.size()==1 ) _curve = JsonVariant();
+
+  bool _found = false;
+  for( uint8_t i=0; i<_sensors_count; i++ ) {
+    if( _sensor[i]==nullptr or _sensor[i]->subID()!=_subID ) continue;
+    _found = true;
+    if( !_sensor[i]->calibrate( _curve ) ) {
+      log_error(F("\n[airquality][calibration] invalid curve for subID: ")); log_error(_subID); log_flush();
+      return false;
+    }
+    log_info(F("\n[airquality][calibration] new curve for subID: ")); log_info(_subID); log_flush();
+  }
+  if( !_found ) {
+    log_error(F("\n[airquality][calibration] unknown subID: ")); log_error(_subID); log_flush();
+    return false;
+  }
+
+  // send back status
+  DynamicJsonDocument _doc(STATUS_JSON_SIZE);
+  JsonObject root = _doc.to<JsonObject>();
+  status( root );
+  return sendmsg( root );
+}
+
+
 /*
  * low-level load JSON config
  */
@@ -628,7 +707,7 @@ boolean airquality::_loadConfig( JsonObject root ) {
   "params":
   [
     {
-      "param": "link",  // optional since serial2 is the only one available serial link for sensors
+      "param": "link",  // optional, serial2 is the default serial link for sensors
       "value": 2
     },
     {
@@ -645,6 +724,30 @@ boolean airquality::_loadConfig( JsonObject root ) {
     }
   ]
 },
+{
+  "module": "airquality",
+  "unit": "mhz19",
+  "driver": "pm_serial",
+  "params":
+  [
+    {
+      "param": "link",  // [ESP32] serial1 needs both rx_gpio and tx_gpio, [ESP8266] SoftwareSerial
+      "value": 1
+    },
+    {
+      "param": "rx_gpio",
+      "value": 13
+    },
+    {
+      "param": "tx_gpio",
+      "value": 12
+    },
+    {
+      "param": "type",  // MH-Z1x CO2 sensor
+      "value": 80
+    }
+  ]
+},
 {
   "module": "airquality",
   "unit": "lcc_sensor",
@@ -4,6 +4,7 @@
  * AirQuality module to manage all kind of air quality sensors that does not
  * fit within the existing sensOCampus classes.
  * 
+ * oct.26  raised max number of sensors (several serial ones)
  * F.Thiebolt   Aug.20  initial release
  * 
  */
@@ -32,7 +33,7 @@
 /*
  * Definitions
  */
-#define _MAX_SENSORS                 4
+#define _MAX_SENSORS                 8       // [oct.26] several serial sensors along with lcc ones
 #define AIRQUALITY_MIN_FREQUENCY    30      // may go up to every 30 seconds ...
 #define AIRQUALITY_MAX_FREQUENCY    _MAX_COOLDOWN_SENSOR
 #define DEFL_AIRQUALITY_FREQUENCY   (AIRQUALITY_MIN_FREQUENCY*2)
@@ -81,6 +82,7 @@ class airquality : public base {
      */
     boolean _loadConfig( JsonObject );
     boolean _processOrder( const char *, int * );   // an order to process with optional value
+    bool _processCalibration( JsonVariant );        // calibration curve for a sensor
     boolean _sendValues( void );                    // send all sensors' values
     void _process_sensors( void );                  // sensors internal processing (optional)
     void _constructor( void );                      // low-level constructor
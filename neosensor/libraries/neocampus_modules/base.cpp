@@ -8,6 +8,9 @@
  * - implement single TCP connexion for all MQTT messages (WARNING: requires topic parsing!)
  * 
  * ---
+ * oct.26  commands JSON sized after LCC_PPM_MAX_POINTS points curves
+ * oct.26  commands may feature a nested value (e.g calibration curve)
+ * oct.26  MQTT clientID without String allocation
  * F.Thiebolt   apr.21  added MQTT client settings through API (buffer_size,
  *                      socker_timeout ...)
  *                      moved to own modules their intrinsic status() description
@@ -32,12 +35,15 @@
 
 #include "neocampus_utils.h"
 
+#include "lcc_ppm.h"            // LCC_PPM_MAX_POINTS
+
 
 
 /*
  * Definitions
  */
-#define COMMAND_JSON_SIZE       (JSON_OBJECT_SIZE(5))
+// [oct.26] nested object value with two arrays (i.e airquality calibration curve)
+#define COMMAND_JSON_SIZE       (JSON_OBJECT_SIZE(5) + JSON_OBJECT_SIZE(4) + 2*JSON_ARRAY_SIZE(LCC_PPM_MAX_POINTS))
 
 
 
@@ -83,6 +89,7 @@ void base::_base( void ) {
   _sensors_count  = 0;
   _sensoClient    = nullptr;
   _trigger        = false;
+  _heapLevel      = heapPressure_t::normal;
 
   pubTopic[0] = '\0';
   subTopic[0] = '\0';
@@ -200,19 +207,16 @@ void base::callback(char* topic, byte* payload, unsigned int length) {
  */
 bool base::reConnect( void ) {
   // compute MQTT clientID
-  String clientID;
-  clientID += getAPname();
-  clientID += "_";
-  clientID += String(micros() & 0xffff, HEX);
-  //clientID += String(random(0xffff), HEX);
+  char clientID[48];
+  snprintf( clientID, sizeof(clientID), "%s_%lx", getAPname(), (unsigned long)(micros() & 0xffff) );
   
-  log_info(F("\n\t[base] (re)connect to MQTT server with CID = ")); log_debug(clientID.c_str()); log_flush();
+  log_info(F("\n\t[base] (re)connect to MQTT server with CID = ")); log_debug(clientID); log_flush();
 
   // Loop until we're reconnected
   uint8_t _retry=MQTT_CONNECT_MAX_RETRIES;
   while( !mqttClient.connected() ) {
   
-    if( mqttClient.connect( (char*)clientID.c_str(), _sensoClient->getUser(), _sensoClient->getPassword() ) ) {
+    if( mqttClient.connect( clientID, _sensoClient->getUser(), _sensoClient->getPassword() ) ) {
       yield();
       
       bool _ret;
@@ -8,6 +8,7 @@
  * -
  * 
  * ---
+ * oct.26  added low-memory back-pressure notification
  * F.Thiebolt   aug.21  added JSON variant and module level _trigger
  * F.Thiebolt   apr.21  removed BASE_MQTT_MSG_MAXLEN for MQTT_MAX_PACKET_SIZE
  * F.Thiebolt   Jul.17  initial release
@@ -33,6 +34,7 @@
 #include "neocampus.h"
 #include "PubSubClient.h"       // MQTT client with some definitions from neocampus.h
 #include "sensocampus.h"
+#include "neocampus_heap.h"
 
 
 /*
@@ -85,6 +87,11 @@ class base {
     // module load its sensOCampus config (if any)
     virtual boolean loadSensoConfig( senso * ) { return false; };
 
+    // [oct.26] low-memory back-pressure: optional features (history buffers,
+    // batching, debug dumps ...) ought to get disabled while heap is low
+    virtual void setHeapPressure( heapPressure_t level ) { _heapLevel = level; };
+    inline bool lowMemory( void ) { return _heapLevel!=heapPressure_t::normal; };
+
     /* 
      * public attributes
      */
@@ -99,6 +106,8 @@ class base {
     // module level flag to specifiy that at least one digital input trigger has been activated ot that one
     // analog value need to get sent
     boolean _trigger;
+    // module level heap back-pressure
+    heapPressure_t _heapLevel;
 
   private:
     /*
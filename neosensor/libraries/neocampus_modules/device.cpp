@@ -3,6 +3,8 @@
  * 
  * Device module for high-level end-device management
  *
+ * oct.26  added 'i2c' order: per-device i2c transfers stats
+ * oct.26  added heap telemetry to status
  * F.Thiebolt   aug.21  implement correct device own status
  *                      added JsonDocument to enable global shared JSON
  * Thiebolt F.  Nov.19  migrate to Arduino Json 6
@@ -25,6 +27,8 @@
 #include "device.h"
 
 #include "neocampus_utils.h"
+#include "neocampus_heap.h"
+#include "neocampus_i2c.h"
 #include "neocampus_OTA.h"
 
 
@@ -39,7 +43,7 @@ extern "C" modulesMgt modulesList;
  * Definitions
  */
 #define MQTT_MODULE_NAME        "device"  // used to build module's base topic
-#define DATA_JSON_SIZE          (JSON_OBJECT_SIZE(20))
+#define DATA_JSON_SIZE          (JSON_OBJECT_SIZE(20) + 128)   // [oct.26] room for keys copied from flash (esp8266)
 #define CONFIG_JSON_SIZE        (JSON_OBJECT_SIZE(3))   // config file contains: frequency
 
 
@@ -211,7 +215,8 @@ void device::status( JsonObject root ) {
   
   root[F("modules")] = modulesList.count(); // remember that device is NOT a sensor (while it adds 1 to the number of modules)
 
-  root[F("heap")] = ESP.getFreeHeap();
+  // [oct.26] free heap, min-ever-free, largest block, fragmentation and back-pressure level
+  heapStatus( root );
 #ifdef ESP8266
   root[F("hardware")] = F("esp8266");
 #elif ESP32
@@ -298,6 +303,22 @@ bool device::_processOrder( const char *order, int *value, const char *svalue )
     }
   }
 
+  {
+    const char *_order = PSTR("i2c");
+    if( strncmp_P(order, _order, strlen_P(_order))==0 ) {
+      /* one message per i2c device: too much for the status
+       * message within a MQTT_MAX_PACKET_SIZE frame */
+      bool _res = true;
+      for( uint8_t i=0; i < i2c_nbDevices(); i++ ) {
+        StaticJsonDocument<DATA_JSON_SIZE> _doc;
+        JsonObject root = _doc.to<JsonObject>();
+        i2c_status( i, root );
+        if( !sendmsg( root ) ) _res = false;
+      }
+      return _res;
+    }
+  }
+
   {
     const char *_order = PSTR("restart");
     if( strncmp_P(order, _order, strlen_P(_order))==0 ) {
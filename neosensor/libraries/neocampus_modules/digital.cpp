@@ -6,6 +6,16 @@
  * of sensors' data on a time interval basis but on configurable fronts
  * detection.
  * 
+ * oct.26  inputs sharing their pin with an output (e.g CLEAR_SW and LED)
+ *         are polled as before (pinMode INPUT then read), no ISR
+ * oct.26  heap back-pressure: no aggregator allocation when heap is
+ *         short, no motion timestamps in summaries while heap is low
+ * oct.26  aggregator only upon a configured holdoff, summaries ratio
+ *         under its own 'occupancy' key
+ * oct.26  occupancy aggregator for presence inputs: summaries every
+ *         'frequency' seconds + immediate occupied/vacant transitions
+ * oct.26  edges captured by ISRs into a timestamps ring, debounce
+ *         and fronts detection now run on these records
  * F.Thiebolt   Aug.21  initial release
  * 
  */
@@ -18,9 +28,11 @@
 #if defined(ESP32)
   #include "SPIFFS.h"
 #endif
+#include <time.h>       // time()
 
 #include "neocampus.h"
 #include "neocampus_debug.h"
+#include "neocampus_utils.h"
 
 #include "digital.h"
 
@@ -33,6 +45,20 @@
 #define CONFIG_JSON_SIZE        (JSON_OBJECT_SIZE(3))   // for config FILE that contains: frequency
                                                         // note: others parameters are sent from sensOCampus
                                                         // hence not saved ;)
+#define DIGITAL_RING_MASK       (DIGITAL_RING_SIZE - 1)
+
+#if (DIGITAL_RING_SIZE & DIGITAL_RING_MASK) != 0
+  #error "DIGITAL_RING_SIZE must be a power of 2"
+#endif
+
+
+/*
+ * Static members
+ */
+digitalEdge_t digital::_ring[DIGITAL_RING_SIZE];
+volatile uint8_t digital::_ringHead = 0;
+volatile uint8_t digital::_ringTail = 0;
+volatile uint16_t digital::_ringDrops = 0;
 
 
 
@@ -52,6 +78,10 @@ void digital::_constructor( void ) {
   // initialize total count of registered GPIOs
   _gpio_count = 0;
 
+  // occupancy summaries
+  _freq = DEFL_DIGITAL_FREQUENCY;
+  _intervalStart = millis();
+
   // [aug.21] reset module trigger
   // ... ought to get done in base constructor
   //_trigger = false;
@@ -66,7 +96,9 @@ digital::~digital( void )
 {
   for( uint8_t i=0; i < _MAX_GPIOS; i++ ) {
     if( _gpio[i] == nullptr ) continue;
-    free(_gpio[i]);
+    if( _gpio[i]->pin != INVALID_GPIO and not _gpio[i]->_polled ) detachInterrupt( digitalPinToInterrupt(_gpio[i]->pin) );
+    if( _gpio[i]->occupancy ) delete _gpio[i]->occupancy;
+    delete _gpio[i];
     _gpio[i] = nullptr;
   }
   _gpio_count = 0;
@@ -78,7 +110,7 @@ digital::~digital( void )
  * add_gpio method
  * Note: specifying front as 'none' will not send their value through MQTT
  */
-boolean digital::add_gpio( const char* subID, uint8_t pin, digitalInputType_t type, digitalFrontDetect_t front, uint16_t coolDown ) {
+boolean digital::add_gpio( const char* subID, uint8_t pin, digitalInputType_t type, digitalFrontDetect_t front, uint16_t coolDown, uint16_t debounce, uint16_t holdOff ) {
   
   if( subID==nullptr or strlen(subID)==0 ) return false;
   if( pin == INVALID_GPIO ) return false;
@@ -103,8 +135,10 @@ boolean digital::add_gpio( const char* subID, uint8_t pin, digitalInputType_t ty
       return false;
     }
     _cur_gpio = _gpio[_gpio_count];
+    _cur_gpio->occupancy = nullptr;
   }
   else {
+    if( not _cur_gpio->_polled ) detachInterrupt( digitalPinToInterrupt(pin) );
     log_warning(F("\n[digital] GPIO"));log_warning(pin);
     log_warning(F(" already exists! >>>> UPDATING <<<< ...")); log_flush();
     delay(500);
@@ -119,11 +153,45 @@ boolean digital::add_gpio( const char* subID, uint8_t pin, digitalInputType_t ty
   _cur_gpio->_trigger    = false;
   _cur_gpio->coolDown    = coolDown;
   _cur_gpio->_lastTX     = millis() - ((unsigned long)coolDown*1000UL);
+  _cur_gpio->debounce    = debounce;
+  _cur_gpio->_pending    = false;
+  _cur_gpio->_overflow   = false;
+  _cur_gpio->_polled     = _sharedOutput( pin );
 
-  // initialize values. _previous field will get used in process()
+  // initialize values
   pinMode( pin, INPUT );
   _cur_gpio->_current    = digitalRead( pin );
   _cur_gpio->value       = _cur_gpio->_current;
+
+  // occupancy aggregator (presence inputs with a hold-off only)
+  // [oct.26] 'none' front inputs are not to get sent, hence no aggregator
+  if( type == digitalInputType_t::presence and holdOff and front != digitalFrontDetect_t::none ) {
+    // [oct.26] aggregator is optional: per-edge messages if heap is short
+    if( _cur_gpio->occupancy == nullptr and heapAvailable( sizeof(digitalOccupancy_t) ) ) {
+      _cur_gpio->occupancy = new digitalOccupancy_t;
+    }
+    if( _cur_gpio->occupancy ) {
+      digitalOccupancy_t *_o = _cur_gpio->occupancy;
+      _o->holdOff     = holdOff;
+      _o->events      = 0;
+      _o->_occupiedMs = 0;
+      _o->lastMotion  = millis() - ULONG_MAX/2;   // i.e no motion yet
+      _o->firstMotion = _o->lastMotion;
+      _o->_since      = millis();
+      _o->occupied    = _cur_gpio->value;
+      if( _o->occupied ) _o->lastMotion = millis();
+    }
+  }
+  else if( _cur_gpio->occupancy ) {
+    delete _cur_gpio->occupancy;
+    _cur_gpio->occupancy = nullptr;
+  }
+
+  // edges capture
+  // [oct.26] not for pins shared with an output: LED toggles would be edges
+  if( not _cur_gpio->_polled ) {
+    attachInterruptArg( digitalPinToInterrupt(pin), _edgeISR, _cur_gpio, CHANGE );
+  }
 /*
   _gpio_added = true;
 
@@ -139,9 +207,12 @@ boolean digital::add_gpio( const char* subID, uint8_t pin, digitalInputType_t ty
   log_debug(F("' GPIO"));log_debug(_cur_gpio->pin);
   log_debug(F(" front="));log_debug((uint8_t)_cur_gpio->front);
   log_debug(F(" coolDown="));log_debug(_cur_gpio->coolDown,DEC);
+  log_debug(F(" debounce="));log_debug(_cur_gpio->debounce,DEC);
+  if( _cur_gpio->occupancy ) { log_debug(F(" holdOff="));log_debug(_cur_gpio->occupancy->holdOff,DEC); }
   log_flush();
 
-  _gpio_count++;
+  // only count newly allocated gpios
+  if( _cur_gpio == _gpio[_gpio_count] ) _gpio_count++;
 
   // everything is ok :)
   return true;
@@ -169,6 +240,8 @@ boolean digital::add_gpio( JsonVariant root ) {
   uint8_t _input              = INVALID_GPIO;
   digitalInputType_t _type    = digitalInputType_t::undefined;
   uint16_t _cooldown          = 0;
+  uint16_t _debounce          = DIGITAL_DEFL_DEBOUNCE;
+  uint16_t _holdoff           = DIGITAL_DEFL_HOLDOFF;
   bool _front_param           = false;
   digitalFrontDetect_t _front = digitalFrontDetect_t::none;
 
@@ -237,6 +310,22 @@ boolean digital::add_gpio( JsonVariant root ) {
       }
     }
 
+    // DEBOUNCE (optional)
+    {
+      const char *_param = PSTR("debounce");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _debounce = (uint16_t)item[F("value")].as<int>();
+      }
+    }
+
+    // HOLDOFF (optional, presence inputs)
+    {
+      const char *_param = PSTR("holdoff");
+      if( strncmp_P(item[F("param")], _param, strlen_P(_param))==0 ) {
+        _holdoff = (uint16_t)item[F("value")].as<int>();
+      }
+    }
+
     // FRONT
     {
       const char *_param = PSTR("front");
@@ -266,7 +355,7 @@ boolean digital::add_gpio( JsonVariant root ) {
   /*
    * sensor HW initialisation
    */
-  return add_gpio( _subID, _input, _type, _front, _cooldown );
+  return add_gpio( _subID, _input, _type, _front, _cooldown, _debounce, _holdoff );
 }
 
 
@@ -364,6 +453,11 @@ bool digital::process( void ) {
   /* sensors internal processing */
   _process_sensors();
 
+  // end of occupancy interval ?
+  if( (millis() - _intervalStart) >= ((unsigned long)_freq)*1000UL ) {
+    _sendOccupancy();
+  }
+
   // [aug.21] TXtime is not based on timer but upon digital inputs events
   // reached time to transmit ?
   //if( !isTXtime() ) return _ret;
@@ -393,6 +487,7 @@ void digital::status( JsonObject root ) {
   
   // add module specific
   root[F("inputs")] = _gpio_count;
+  root[F("edges_dropped")] = _ringDrops;
 
   /*
    * TODO: add list of sensors IDs
@@ -406,14 +501,12 @@ void digital::status( JsonObject root ) {
  * load an eventual module'specific config file
  */
 bool digital::loadConfig( void ) {
-  return false;
-#if 0  
   if( ! SPIFFS.exists( MODULE_CONFIG_FILE(MQTT_MODULE_NAME) ) ) return false;
 
   File configFile = SPIFFS.open( MODULE_CONFIG_FILE(MQTT_MODULE_NAME), "r");
   if( !configFile ) return false;
 
-  log_info(F("\n[airquality] load JSON config file")); log_flush();
+  log_info(F("\n[digital] load JSON config file")); log_flush();
   size_t size = configFile.size();
   // Allocate a buffer to store contents of the file.
   std::unique_ptr<char[]> buf(new char[size]);
@@ -425,8 +518,8 @@ bool digital::loadConfig( void ) {
 
   auto err = deserializeJson( root, buf.get() );
   if( err ) {
-    log_error(F("\n[airquality] ERROR parsing module JSON config file!"));
-    log_error(F("\n[device] ERROR msg: ")); log_error(err.c_str()); log_flush();
+    log_error(F("\n[digital] ERROR parsing module JSON config file!"));
+    log_error(F("\n[digital] ERROR msg: ")); log_error(err.c_str()); log_flush();
     SPIFFS.remove( MODULE_CONFIG_FILE(MQTT_MODULE_NAME) );
     return false;
   }
@@ -436,7 +529,6 @@ bool digital::loadConfig( void ) {
 
   // parse and apply JSON config
   return _loadConfig( root.as<JsonObject>() );
-#endif /* 0 */
 }
 
 
@@ -444,14 +536,12 @@ bool digital::loadConfig( void ) {
  * save module'specific config file
  */
 bool digital::saveConfig( void ) {
-  return false;
-#if 0
   // static JSON buffer
   StaticJsonDocument<CONFIG_JSON_SIZE> _doc;
   JsonObject root = _doc.to<JsonObject>();
 
   // frequency
-  if( _freq != (uint16_t)DEFL_AIRQUALITY_FREQUENCY )
+  if( _freq != (uint16_t)DEFL_DIGITAL_FREQUENCY )
     root[F("frequency")] = _freq;
 
   // add additional parameters to save here
@@ -459,7 +549,6 @@ bool digital::saveConfig( void ) {
   
   // call parent save
   return base::saveConfig( MODULE_CONFIG_FILE(MQTT_MODULE_NAME), root );
-#endif /* 0 */
 }
 
 
@@ -569,72 +658,268 @@ boolean digital::loadSensoConfig( senso *sp ) {
 
 /*
  * digital inputs internal processing
- * this function is called every lopp() call and leverages
- * the needs for (e.g) continuous integration.
+ * this function is called every lopp() call: it drains edges
+ * recorded by ISRs and applies debounce to them.
  */
 void digital::_process_sensors( void ) {
-  // same time for all inputs ...
-  unsigned long curTime = millis();
-
-  // declare pointer to shared JSON
-  JsonObject _obj = variant.as<JsonObject>();
+  /* snapshot of the ring head BEFORE reading time so that all records
+   * we'll process are older than 'now' */
+  uint8_t _head = _ringHead;
+  uint32_t _nowUs = micros();
+  unsigned long _nowMs = millis();
+
+  // drain edges ring
+  while( _ringTail != _head ) {
+    digitalEdge_t _rec = _ring[_ringTail];
+    _ringTail = (_ringTail + 1) & DIGITAL_RING_MASK;   // slot released to ISRs
+    _edge( _rec.gpio, _rec.level, _rec.us, _nowUs, _nowMs );
+  }
 
   // process all digital inputs
   for( uint8_t i=0; i < _gpio_count; i++ ) {
 
-    if( _gpio[i]==nullptr || _gpio[i]->pin==INVALID_GPIO ) continue;
-
-    bool _xor, _value;
-    // first, save previous value
-    _gpio[i]->_previous = _gpio[i]->_current;
-    // then read actual value
-    pinMode( _gpio[i]->pin, INPUT );
-    _gpio[i]->_current = digitalRead( _gpio[i]->pin );
-    // does pin value changed over last acquisition ?
-    _xor = _gpio[i]->_current ^ _gpio[i]->_previous;
-    /* Now let's compute new official digital input value:
-     * pin ought to get stable over two consecutives measure ...
-     * ==> hence if xor=1, we keep the previous official (stable) value, otherwise
-     * the current value WILL become the new official one.
-     */
-    _value = (_gpio[i]->value & _xor) | (_gpio[i]->_current & ~_xor);
-
-    // update shared JSON structure if new official value (trigger independant)
-    if( _value ^ _gpio[i]->value ) {
-      //String _key = "GPIO" + _gpio[i]->pin;
-      //_obj[_key] = _value;
-      _obj[_gpio[i]->subID] = _value;
-    }
-
-    // if the new official digital inputs changed from previous one AND trigger is not already active
-    if( (_value ^ _gpio[i]->value) && not(_gpio[i]->_trigger) ) {
-      bool _fdetect, _isTXtime;
-      // ok, a change has been officially detected ...
-      // but do we need to declare a trigger ?
-      _fdetect =  (_value==true && _gpio[i]->front==digitalFrontDetect_t::rising) ||
-                  (_value==false && _gpio[i]->front==digitalFrontDetect_t::falling) ||
-                  _gpio[i]->front==digitalFrontDetect_t::both;
-
-      log_debug(F("\n[digital] event "));log_debug(_gpio[i]->subID);
-      log_debug(F("\n(GPIO"));log_debug(_gpio[i]->pin);
-      log_debug(F(")="));log_debug(_value);
-      log_debug(F(" _fdetect="));log_debug(_fdetect);
-      log_flush();
-
-      // time to transmit ?
-      _isTXtime = (curTime - _gpio[i]->_lastTX) >= ((unsigned long)_gpio[i]->coolDown)*1000UL;
-
-      if( _fdetect && _isTXtime ) {
-        _gpio[i]->_trigger = true;
-        _trigger = true;  // notify global module's trigger
+    digitalGPIO_t *_g = _gpio[i];
+    if( _g==nullptr || _g->pin==INVALID_GPIO ) continue;
+
+    // pin shared with an output (e.g noise LED): back to input then read
+    if( _g->_polled ) {
+      pinMode( _g->pin, INPUT );
+      bool _level = digitalRead( _g->pin );
+      if( _level != (_g->_pending ? _g->_pendLevel : _g->_current) ) {
+        _edge( _g, _level, _nowUs, _nowUs, _nowMs );
       }
-      // ... and finally save the new official value :)
-      _gpio[i]->value = _value;
     }
+
+    // edges have been dropped: resync with current pin level
+    if( _g->_overflow ) {
+      _g->_overflow = false;
+      _edge( _g, digitalRead( _g->pin ), _nowUs, _nowUs, _nowMs );
+    }
+
+    if( not _g->_pending ) continue;
+
+    // last edge is now stable ?
+    uint32_t _elapsed = _nowUs - _g->_pendUs;
+    if( _elapsed >= (uint32_t)_g->debounce*1000UL ) {
+      _commit( _g, _nowMs - _elapsed/1000UL );
+    }
+    else {
+      // come back as soon as debounce ends (i.e not after a whole main loop delay)
+      wakeupLoopIn( _g->debounce - _elapsed/1000UL );
+    }
+  }
+
+  // occupancy hold-off: vacant after holdOff seconds without motion
+  for( uint8_t i=0; i < _gpio_count; i++ ) {
+    if( _gpio[i]==nullptr || _gpio[i]->occupancy==nullptr ) continue;
+    digitalOccupancy_t *_o = _gpio[i]->occupancy;
+    if( not _o->occupied or _gpio[i]->value ) continue;
+    unsigned long _holdOff = (unsigned long)_o->holdOff*1000UL;
+    if( (_nowMs - _o->lastMotion) >= _holdOff ) {
+      _occupancy( _gpio[i], false, _o->lastMotion + _holdOff );
+    }
+  }
+}
+
+
+/*
+ * pins also driven as outputs (e.g neOSensor's CLEAR_SW is the LED)
+ */
+bool digital::_sharedOutput( uint8_t pin ) {
+#if defined(LED)
+  if( LED != INVALID_GPIO and pin == LED ) return true;
+#endif
+#if defined(NOISE_LED)
+  if( NOISE_LED != INVALID_GPIO and pin == NOISE_LED ) return true;
+#endif
+  return false;
+}
+
+
+/*
+ * gpio edge interrupt: push (gpio, level, micros) to ring
+ */
+void ICACHE_RAM_ATTR digital::_edgeISR( void *arg ) {
+  digitalGPIO_t *_g = (digitalGPIO_t *)arg;
+  uint8_t _next = (_ringHead + 1) & DIGITAL_RING_MASK;
+
+  if( _next == _ringTail ) {
+    // ring full
+    _g->_overflow = true;
+    _ringDrops++;
+  }
+  else {
+    digitalEdge_t *_rec = &_ring[_ringHead];
+    _rec->gpio  = _g;
+    _rec->us    = micros();
+    _rec->level = digitalRead( _g->pin );
+    _ringHead   = _next;    // record published to process()
+  }
+  wakeupLoop();
+}
+
+
+/*
+ * debounce an edge record:
+ * previous pending edge becomes official if it remained stable long enough
+ */
+void digital::_edge( digitalGPIO_t *g, bool level, uint32_t us, uint32_t nowUs, unsigned long nowMs ) {
+  if( g->_pending and (us - g->_pendUs) >= (uint32_t)g->debounce*1000UL ) {
+    _commit( g, nowMs - (nowUs - g->_pendUs)/1000UL );
+  }
+  g->_pending   = true;
+  g->_pendLevel = level;
+  g->_pendUs    = us;
+}
+
+
+/*
+ * new official value (with its millis() timestamp):
+ * update shared JSON and check fronts and coolDown for a trigger
+ */
+void digital::_commit( digitalGPIO_t *g, unsigned long evtMs ) {
+  g->_pending = false;
+  bool _value = g->_pendLevel;
+  g->_previous = g->_current;
+  g->_current = _value;
+
+  // no change of the official value (e.g glitch)
+  if( _value == g->value ) return;
+
+  // update shared JSON structure (trigger independant)
+  JsonObject _obj = variant.as<JsonObject>();
+  _obj[g->subID] = _value;
+
+  // ... and finally save the new official value :)
+  g->value = _value;
+
+  // presence input with occupancy aggregation: no individual edges sent
+  if( g->occupancy ) {
+    digitalOccupancy_t *_o = g->occupancy;
+    _o->lastMotion = evtMs;   // start or end of motion
+    if( _value ) {
+      if( _o->events == 0 ) _o->firstMotion = evtMs;
+      if( _o->events < UINT16_MAX ) _o->events++;
+      if( not _o->occupied ) _occupancy( g, true, evtMs );
+    }
+    return;
+  }
+
+  // trigger already active ?
+  if( g->_trigger ) return;
+
+  // ok, a change has been officially detected ...
+  // but do we need to declare a trigger ?
+  bool _fdetect = (_value==true && g->front==digitalFrontDetect_t::rising) ||
+                  (_value==false && g->front==digitalFrontDetect_t::falling) ||
+                  g->front==digitalFrontDetect_t::both;
+
+  log_debug(F("\n[digital] event "));log_debug(g->subID);
+  log_debug(F("\n(GPIO"));log_debug(g->pin);
+  log_debug(F(")="));log_debug(_value);
+  log_debug(F(" _fdetect="));log_debug(_fdetect);
+  log_flush();
+
+  // time to transmit ?
+  bool _isTXtime = (evtMs - g->_lastTX) >= ((unsigned long)g->coolDown)*1000UL;
+
+  if( _fdetect && _isTXtime ) {
+    g->_txValue = _value;
+    g->_txTime = evtMs;
+    g->_trigger = true;
+    _trigger = true;  // notify global module's trigger
+  }
+}
+
+
+
+/*
+ * occupancy state change (with its millis() timestamp):
+ * account occupied time and raise an immediate transition message
+ */
+void digital::_occupancy( digitalGPIO_t *g, bool occupied, unsigned long evtMs ) {
+  digitalOccupancy_t *_o = g->occupancy;
+
+  if( occupied ) {
+    _o->_since = evtMs;
   }
+  else if( (long)(evtMs - _o->_since) > 0 ) {
+    _o->_occupiedMs += evtMs - _o->_since;
+  }
+  _o->occupied = occupied;
+
+  log_debug(F("\n[digital] "));log_debug(g->subID);
+  log_debug(occupied ? F(" is now OCCUPIED") : F(" is now VACANT"));
+  log_flush();
+
+  // transitions are not subject to coolDown (holdOff already rate-limits them)
+  g->_txValue = occupied;
+  g->_txTime = evtMs;
+  g->_trigger = true;
+  _trigger = true;
 }
 
 
+/*
+ * send occupancy summaries of all presence inputs and start a new interval
+ */
+boolean digital::_sendOccupancy( void ) {
+  bool _ret = true;
+  unsigned long _now = millis();
+  unsigned long _interval = _now - _intervalStart;
+  time_t _epoch = time( nullptr );
+  bool _timeValid = ( _epoch > (time_t)1000000000 );   // i.e NTP synced
+
+  for( uint8_t i=0; i<_gpio_count; i++ ) {
+
+    if( _gpio[i]==nullptr or _gpio[i]->occupancy==nullptr ) continue;
+    digitalOccupancy_t *_o = _gpio[i]->occupancy;
+
+    unsigned long _occupied = _o->_occupiedMs;
+    if( _o->occupied and (long)(_now - _o->_since) > 0 ) _occupied += _now - _o->_since;
+    if( _occupied > _interval ) _occupied = _interval;
+
+    StaticJsonDocument<DATA_JSON_SIZE> _doc;
+    JsonObject root = _doc.to<JsonObject>();
+
+    // occupied ratio (%) with one decimal
+    // [oct.26] own key since 'value' is the occupied/vacant boolean of transitions
+    uint16_t _permil = ( _interval ? (uint16_t)(((uint64_t)_occupied*1000ULL + _interval/2)/_interval) : 0 );
+    root[F("occupancy")] = (float)_permil / 10.0;
+    root[F("occupancy_units")] = F("%");
+    root[F("events")] = _o->events;
+    root[F("interval")] = _interval/1000UL;
+    root[F("state")] = ( _o->occupied ? F("occupied") : F("vacant") );
+    // [oct.26] low heap: motion timestamps are optional
+    if( lowMemory() ) _timeValid = false;
+    if( _timeValid and _o->events ) {
+      root[F("first_motion")] = (unsigned long)(_epoch - (time_t)((_now - _o->firstMotion)/1000UL));
+    }
+    if( _timeValid and (_gpio[i]->value or (long)(_o->lastMotion - _intervalStart) >= 0) ) {
+      unsigned long _last = ( _gpio[i]->value ? _now : _o->lastMotion );
+      root[F("last_motion")] = (unsigned long)(_epoch - (time_t)((_now - _last)/1000UL));
+    }
+    root[F("input")] = _gpio[i]->pin;
+    root[F("type")] = "presence";
+    root[F("subID")] = _gpio[i]->subID;
+
+    // new interval
+    _o->_occupiedMs = 0;
+    _o->events = 0;
+    _o->_since = _now;
+
+    if( !sendmsg(root) ) {
+      log_error(F("\n[digital] ERROR failure MQTT occupancy msg delivery :(")); log_flush();
+      _ret = false;
+    }
+    // delay between two successives values to send
+    delay(20);
+  }
+
+  _intervalStart = _now;
+  return _ret;
+}
+
 
 /*
  * send all sensors' values
@@ -652,10 +937,12 @@ boolean digital::_sendValues( void ) {
     StaticJsonDocument<DATA_JSON_SIZE> _doc;
     JsonObject root = _doc.to<JsonObject>();
 
-    // retrieve data from current sensor
-    bool _value = _gpio[i]->value;
+    // retrieve data from current sensor (i.e event that raised the trigger)
+    bool _value = _gpio[i]->_txValue;
     root[F("value")] = _value;
     root[F("input")] = _gpio[i]->pin;
+    root[F("age_ms")] = millis() - _gpio[i]->_txTime;   // elapsed ms since edge
+    if( _gpio[i]->occupancy ) root[F("state")] = ( _value ? F("occupied") : F("vacant") );
 
     if( _gpio[i]->type == digitalInputType_t::presence ) { root[F("type")] = "presence"; }
     else if( _gpio[i]->type == digitalInputType_t::on_off ) { root[F("type")] = "on_off"; }
@@ -674,7 +961,7 @@ boolean digital::_sendValues( void ) {
       log_debug(F("\n[digital] successfully published msg pin"));
       log_debug(_gpio[i]->pin,DEC); log_debug(F(" = ")); log_debug(_value,DEC); log_flush();
       _gpio[i]->_trigger = false;
-      _gpio[i]->_lastTX = millis();
+      _gpio[i]->_lastTX = _gpio[i]->_txTime;
       _TXoccured = true;
     }
     else {
@@ -726,6 +1013,22 @@ bool digital::_processOrder( const char *order, int *value ) {
     }
   }
 
+  {
+    const char *_order = PSTR("frequency");
+    if( strncmp_P(order, _order, strlen_P(_order))==0 ) {
+      if( value ) {
+        setFrequency( (uint16_t)(*value), DIGITAL_MIN_FREQUENCY, DIGITAL_MAX_FREQUENCY );
+        _intervalStart = millis();
+        StaticJsonDocument<DATA_JSON_SIZE> _doc;
+        JsonObject root = _doc.to<JsonObject>();
+        status( root );
+        sendmsg( root );
+        return saveConfig();
+      }
+      else return false;
+    }
+  }
+
   log_error(F("\n[digital][callback] unknown order: ")); log_debug(order); log_flush();
   return false;
 }
@@ -735,11 +1038,10 @@ bool digital::_processOrder( const char *order, int *value ) {
  * low-level load JSON config
  */
 boolean digital::_loadConfig( JsonObject root ) {
-  return false;
-#if 0  
-  // check for 'frequency' field
+  // check for 'frequency' field (occupancy summaries interval)
   if( root.containsKey(F("frequency")) ) {
-    setFrequency( (uint16_t)(root[F("frequency")].as<unsigned int>()), AIRQUALITY_MIN_FREQUENCY, AIRQUALITY_MAX_FREQUENCY );
+    setFrequency( (uint16_t)(root[F("frequency")].as<unsigned int>()), DIGITAL_MIN_FREQUENCY, DIGITAL_MAX_FREQUENCY );
+    _intervalStart = millis();
   }
 
   /*
@@ -747,7 +1049,6 @@ boolean digital::_loadConfig( JsonObject root ) {
    */
   
   return true;
-#endif /* 0 */
 }
 
 /*
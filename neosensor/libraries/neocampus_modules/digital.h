@@ -10,8 +10,21 @@
  *
  * ----------------------------------------------------------------------------
  * Notes:
+ * - each input gets an edge ISR that pushes (gpio, level, micros) records into
+ *   a lock-free ring (single producer: ISRs, single consumer: process())
+ * - inputs sharing their pin with an output (e.g CLEAR_SW on neOSensor LED)
+ *   get no ISR: they're switched back to INPUT and polled on each process()
+ * - debounce, front detection and coolDown are applied to these records, hence
+ *   events are timestamped at the edge and short pulses don't get missed
+ * - presence inputs with a configured hold-off (and a front other than 'none')
+ *   get an occupancy aggregator: one summary per 'frequency' interval (occupied
+ *   ratio, motion events, first/last motion) plus immediate occupied/vacant
+ *   transitions instead of each edge
  * ----------------------------------------------------------------------------
  *
+ * oct.26  inputs shared with an output (LED) polled, no ISR
+ * oct.26  occupancy aggregation for presence inputs
+ * oct.26  interrupt driven edges capture with timestamps ring
  * F.Thiebolt   Aug.21  initial release
  * 
  */
@@ -40,6 +53,15 @@
  */
 #define _MAX_GPIOS    8   // maximum number of managed GPIOs
 
+#define DIGITAL_RING_SIZE       64    // edges ring, MUST be a power of 2
+#define DIGITAL_DEFL_DEBOUNCE   50    // ms a level ought to stay stable to get official
+
+// occupancy summaries interval (presence inputs)
+#define DIGITAL_MIN_FREQUENCY   60
+#define DIGITAL_MAX_FREQUENCY   3600
+#define DEFL_DIGITAL_FREQUENCY  900     // an occupancy summary every 15mn
+#define DIGITAL_DEFL_HOLDOFF    0       // seconds without motion to declare vacant (0 disables aggregation)
+
 // Types of connected devices
 enum class digitalInputType_t : uint8_t {
   undefined,
@@ -56,6 +78,17 @@ enum class digitalFrontDetect_t : int8_t {
   both                    // both falling and rising edges
 };
 
+// occupancy aggregator (presence inputs)
+typedef struct {
+  bool      occupied;           // current state
+  uint16_t  holdOff;            // seconds without motion before declaring vacant
+  uint16_t  events;             // motion events within interval
+  unsigned long firstMotion;    // millis() of first motion within interval
+  unsigned long lastMotion;     // millis() of last motion (i.e start or end of motion)
+  unsigned long _since;         // millis() of current occupied period start (or interval start)
+  unsigned long _occupiedMs;    // occupied time of closed periods within interval
+} digitalOccupancy_t;
+
 // digital_gpio typedef
 typedef struct {
   uint8_t   pin;                // pin number
@@ -67,9 +100,25 @@ typedef struct {
   bool      value;              // official value
   uint16_t  coolDown;           // seconds to wait between two consecutives events
   unsigned long _lastTX;        // elapsed ms since last message sent
+  uint16_t  debounce;           // ms a level ought to stay stable
+  bool      _pending;           // an edge is waiting for debounce
+  bool      _pendLevel;         // ... its level
+  uint32_t  _pendUs;            // ... and its micros() timestamp
+  bool      _txValue;           // value of the event that raised _trigger
+  unsigned long _txTime;        // ... and its millis() timestamp
+  volatile bool _overflow;      // edges have been dropped (ring full): resync with pin level
+  bool      _polled;            // pin shared with an output (e.g LED): no ISR, polled as input
+  digitalOccupancy_t *occupancy;  // presence aggregator (nullptr if none)
   char subID[SENSO_SUBID_MAXSIZE];  // short description
 } digitalGPIO_t;
 
+// edge record (pushed from ISR)
+typedef struct {
+  digitalGPIO_t *gpio;
+  uint32_t  us;                 // micros() at edge
+  bool      level;              // pin level read in ISR
+} digitalEdge_t;
+
 
 
 /*
@@ -88,7 +137,9 @@ class digital : public base {
                       uint8_t pin,
                       digitalInputType_t type,
                       digitalFrontDetect_t front = digitalFrontDetect_t::both,
-                      uint16_t coolDown = 0 );
+                      uint16_t coolDown = 0,
+                      uint16_t debounce = DIGITAL_DEFL_DEBOUNCE,
+                      uint16_t holdOff = DIGITAL_DEFL_HOLDOFF );
     boolean add_gpio( JsonVariant );
     boolean is_empty();
 
@@ -109,6 +160,13 @@ class digital : public base {
     // array of GPIOs
     digitalGPIO_t *_gpio[_MAX_GPIOS];
     uint8_t _gpio_count;    // current number of registered digital gpios
+    unsigned long _intervalStart;   // millis() of current occupancy interval start
+
+    // edges ring (shared by all instances since ISRs only know about their gpio)
+    static digitalEdge_t _ring[DIGITAL_RING_SIZE];
+    static volatile uint8_t _ringHead;    // written by ISRs
+    static volatile uint8_t _ringTail;    // written by process()
+    static volatile uint16_t _ringDrops;  // edges dropped because of a full ring
 
     /*
      * private member functions
@@ -117,6 +175,12 @@ class digital : public base {
     boolean _processOrder( const char *, int * );   // an order to process with optional value
     boolean _sendValues( void );                    // send all sensors' values
     void _process_sensors( void );                  // sensors internal processing (optional)
+    void _edge( digitalGPIO_t *, bool, uint32_t, uint32_t, unsigned long );  // debounce an edge record
+    void _commit( digitalGPIO_t *, unsigned long ); // new official value
+    void _occupancy( digitalGPIO_t *, bool, unsigned long );  // occupancy state change
+    boolean _sendOccupancy( void );                 // send occupancy summaries
+    static void ICACHE_RAM_ATTR _edgeISR( void * ); // gpio edge interrupt
+    static bool _sharedOutput( uint8_t pin );       // pin also driven as an output
     void _constructor( void );                      // low-level constructor
 };
 
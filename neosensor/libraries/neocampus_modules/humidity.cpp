@@ -10,6 +10,7 @@
  * TODO:
  * - convert all 'frequency' parameters & define into 'cooldown' ones
  * ---
+ * oct.26  added SCD4x (shared with temperature and airquality modules)
  * F.Thiebolt aug.20  switched to intelligent data sending vs timer based data sending
  * Thiebolt.F may.20  initial release
  * 
@@ -108,6 +109,20 @@ boolean humidity::add_sensor( uint8_t adr ) {
       _sensor_added=true;
     }
   }
+  // check for SCD4x
+  else if( SCD4x::is_device( adr ) == true ) {
+    SCD4x *cur_sensor = new SCD4x( scd4xMeasureType_t::humidity );    // device shared with CO2 and temperature
+    if( cur_sensor->begin( adr ) != true ) {
+      log_debug(F("\n[humidity] ###ERROR at SCD4x startup ... removing instance ..."));log_flush();
+      free(cur_sensor);
+      cur_sensor = NULL;
+    }
+    else {
+      // low power periodic measurement keeps running (device shared across 3 modules)
+      _sensor[_sensors_count++] = cur_sensor;
+      _sensor_added=true;
+    }
+  }
 
   // add check for additional device here
 
@@ -9,6 +9,7 @@
  * TODO:
  * - convert all 'frequency' parameters & define into 'cooldown' ones
  * ---
+ * oct.26  sensors in event mode whenever board wires their INT line
  * F.Thiebolt aug.20  switched to intelligent data sending vs timer based data sending
  * Thiebolt.F may.20  force data sent through MQTT as an int
  * Thiebolt.F may.18  send back status upon any change settings received order 
@@ -89,6 +90,9 @@ boolean luminosity::add_sensor( uint8_t adr ) {
     else {
       // TODO: set auto_gain ?
       cur_sensor->powerOFF();
+#ifdef LUMINOSITY_INT
+      cur_sensor->setEventMode( LUMINOSITY_INT );   // read upon INT line only
+#endif
       _sensor[_sensors_count++] = cur_sensor;
       _sensor_added = true;
     }
@@ -103,6 +107,9 @@ boolean luminosity::add_sensor( uint8_t adr ) {
     else {
       // TODO: set manual mode ?
       cur_sensor->powerOFF();
+#ifdef LUMINOSITY_INT
+      cur_sensor->setEventMode( LUMINOSITY_INT );   // read upon INT line only
+#endif
       _sensor[_sensors_count++] = cur_sensor;
       _sensor_added = true;
     }
@@ -4,6 +4,7 @@
  * Modules management class for high-level modules management
  *
  * 
+ * oct.26  added heap back-pressure broadcast
  * F.Thiebolt aug.21  added support for shared JSON
  * Thiebolt F. Nov.19   cancel modules startALL if need2reboot flag is active
  * Thiebolt F. June 18
@@ -119,6 +120,17 @@ bool modulesMgt::stopAll( void ) {
   return _ret;
 }
 
+/*
+ * notify ALL modules about heap back-pressure level
+ */
+void modulesMgt::heapPressureAll( heapPressure_t level ) {
+  for( uint8_t i=0; i < sizeof(modulesList)/sizeof(modulesList[0]); i++ ) {
+    if(  modulesList[i] ) {
+      modulesList[i]->setHeapPressure( level );
+    }
+  }
+}
+
 /*
  * process module (MQTT publish & subscribe)
  */
@@ -3,6 +3,7 @@
  * 
  * Modules management class for high-level modules management
  *
+ * oct.26  added heap back-pressure broadcast
  * F.Thiebolt aug.21  added support for shared JSON
  * Thiebolt F. June 18  initial release
  * 
@@ -51,6 +52,7 @@ class modulesMgt {
     bool processAll( void );        // process all modules
     bool startAll( senso *, JsonDocument& );  // start all modules with added shared JSON
     bool stopAll( void );           // stop all modules
+    void heapPressureAll( heapPressure_t );   // notify all modules about low-memory back-pressure
     
   private:
 
@@ -3,6 +3,7 @@
  * 
  * Clock module to send time to display
  * 
+ * oct.26  display released through delete (i.e destructor runs)
  * Thiebolt.F jun.18  initial release
  * 
  */
@@ -124,7 +125,8 @@ bool neoclock::stop( void ) {
     _display->powerOFF();
     
     // de-allocate memory for _display
-    free(_display);
+    // [oct.26] delete: destructor stops the async transport (timer1 callback)
+    delete _display;
     _display = nullptr;
   }
 
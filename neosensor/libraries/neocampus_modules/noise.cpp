@@ -3,6 +3,13 @@
  * 
  * Noise module to detect noise according to parameters
  * 
+ * oct.26  noise levels report reduced to L50 under heap pressure
+ * oct.26  PCNT free running counter read as deltas (no pulses lost
+ *         between read and clear)
+ * oct.26  configurable sliding window (slot duration, nb slots) and
+ *         periodic noise levels L10/L50/L90 from a pulse rates histogram
+ * oct.26  ESP32 PCNT hardware pulse counting, 16bits slots and
+ *         32bits window sum (no more clipping on loud rooms)
  * Thiebolt.F may.20  force value sent throught MQTT as INT (useless but just
  *                    to get coherent with others classes) 
  * Thiebolt.F may.18  send back status upon any change settings received order 
@@ -30,7 +37,7 @@
  */
 #define MQTT_MODULE_NAME        "noise"  // used to build module's base topic
 #define DATA_JSON_SIZE          (JSON_OBJECT_SIZE(20))
-#define CONFIG_JSON_SIZE        (JSON_OBJECT_SIZE(3))   // config file contains: frequency, threshold, sensitivity
+#define CONFIG_JSON_SIZE        (JSON_OBJECT_SIZE(5))   // config file contains: frequency, threshold, sensitivity, slot, slots
 
 
 
@@ -58,11 +65,22 @@ noise::noise( uint8_t pinSensor, voidFuncPtr isr, uint8_t pinLed ): base()
   _dac = NULL;
   sensitivity = DEFL_SENSITIVITY;
   _pulseCountThreshold = DEFL_PULSES_THRESHOLD;
-  for( uint8_t i=0; i <= DEFL_TIME_WINDOW; i++)
+  _slotMs = DEFL_SLOT_MS;
+  _slots = DEFL_TIME_WINDOW;
+  for( uint8_t i=0; i < NOISE_MAX_SLOTS; i++)
     noiseTab[i]=0;
   curNoiseEntry = 0;
+  memset( (void *)_hist, 0, sizeof(_hist) );
+  _curHist = 0;
   noiseDetected = false;
   _SumNoisePulseCount = 0;
+  _isrPulses = 0;
+  _hwCounter = false;
+#ifdef NOISE_USE_PCNT
+  _pcntOverflows = 0;
+  _pcntOvfSeen = 0;
+  _pcntLast = 0;
+#endif
   _noiseDetectISR = isr;
 
   // load json config file (if any)
@@ -181,6 +199,37 @@ bool noise::setThreshold( uint16_t threshold ) {
 }
 
 
+/*
+ * Sliding window parameters:
+ * slot duration (ms) and number of slots
+ */
+bool noise::setWindow( uint16_t slotMs, uint8_t slots ) {
+  if( slotMs < SLOT_MIN_MS ) slotMs = SLOT_MIN_MS;
+  else if( slotMs > SLOT_MAX_MS ) slotMs = SLOT_MAX_MS;
+  if( slots < 1 ) slots = 1;
+  else if( slots > NOISE_MAX_SLOTS ) slots = NOISE_MAX_SLOTS;
+
+  if( slotMs==_slotMs and slots==_slots ) return true;
+
+  // stop slot timer while we reset the window
+  bool _active = pulseT.active();
+  pulseT.detach();
+
+  _slotMs = slotMs;
+  _slots = slots;
+  for( uint8_t i=0; i < NOISE_MAX_SLOTS; i++)
+    noiseTab[i]=0;
+  curNoiseEntry = 0;
+  _SumNoisePulseCount = 0;
+  _readPulses();   // discard pulses of the current (partial) slot
+
+  if( _active ) _startTimer();
+
+  log_debug(F("\n[noise] sliding window set to ")); log_debug(_slots,DEC); log_debug(F(" slots of ")); log_debug(_slotMs,DEC); log_debug(F("ms")); log_flush();
+  return true;
+}
+
+
 /*
  * Module network startup procedure (MQTT)
  */
@@ -196,7 +245,7 @@ bool noise::start( senso *sensocampus, JsonDocument &sharedRoot ) {
   snprintf( subTopic, sizeof(subTopic), "%s/%s", pubTopic, "command" );
   
   // start timer and pulse count interrupt handler 
-  pulseT.attach( 1, timerHandler, this );
+  _startTimer();
   
   //mqttClient.setCallback( [this] (char* topic, byte* payload, unsigned int length) { this->callback(topic, payload, length); });
   //attachInterrupt(digitalPinToInterrupt(_pinSensor), noiseDetectISR, FALLING);
@@ -209,9 +258,19 @@ bool noise::start( senso *sensocampus, JsonDocument &sharedRoot ) {
   
   //std::function<void()> func = [&]{noiseModule->noiseDetectISR();};
 
-  attachInterrupt(digitalPinToInterrupt(_pinSensor),
-                  _noiseDetectISR,
-                  FALLING);
+#ifdef NOISE_USE_PCNT
+  // count pulses in hardware ...
+  _hwCounter = _pcntSetup();
+  if( !_hwCounter ) {
+    log_warning(F("\n[noise] PCNT setup failure, switching to pulse ISR ..."));log_flush();
+  }
+#endif
+  // ... or one interrupt per pulse
+  if( !_hwCounter ) {
+    attachInterrupt(digitalPinToInterrupt(_pinSensor),
+                    _noiseDetectISR,
+                    FALLING);
+  }
   
   // call to start from base class
   return base::start( sensocampus, sharedRoot );
@@ -303,9 +362,9 @@ bool noise::process( void ) {
   }
   else {
     /* add items to JSON object:
-    * - current status
+    * - noise levels since last report
     */
-    status( root );
+    noiseLevelsMsg( root );
   }
   
   /*
@@ -323,33 +382,29 @@ bool noise::process( void ) {
 
 /*
  * Sliding Window for noise pulse count:
- * timer handler method called EVERY SECOND
+ * timer handler method called EVERY SLOT
  */
 void ICACHE_RAM_ATTR noise::timerHandler( noise *p ) {
 
-  uint8_t _curNoiseEntry, nextNoiseEntry;
-  
-  // increment curNoiseEntry
-  if( p->curNoiseEntry == DEFL_TIME_WINDOW ) {
-    nextNoiseEntry = 0;
-  }
-  else {
-    nextNoiseEntry = p->curNoiseEntry + 1;
-  }
-  
+  // pulses of the last slot (either from PCNT or ISR counter)
+  uint16_t _pulses = p->_readPulses();
+
   /*
    * compute sum of noiseTab (clever way ;)
-   * - remove noiseTab[next_entry] from sum (circular buffer)
-   * - affect curNoiseEntry with next
-   * - add previous to sum
+   * - remove oldest entry from sum (circular buffer)
+   * - overwrite it with last second pulses
+   * - add these to sum
    */
-  p->_SumNoisePulseCount -= p->noiseTab[nextNoiseEntry];
-  p->noiseTab[nextNoiseEntry] = 0;
-  _curNoiseEntry = p->curNoiseEntry;
-  p->curNoiseEntry = nextNoiseEntry;   // ISR will immediately update
-  p->_SumNoisePulseCount += p->noiseTab[_curNoiseEntry];
-  
-  //log_debug(F("\n[noise][timer] noiseTab["));log_debug(_curNoiseEntry,DEC); log_debug(F("] = "));log_debug(p->noiseTab[_curNoiseEntry],DEC);log_flush();
+  p->_SumNoisePulseCount -= p->noiseTab[p->curNoiseEntry];
+  p->noiseTab[p->curNoiseEntry] = _pulses;
+  p->_SumNoisePulseCount += _pulses;
+  if( ++p->curNoiseEntry >= p->_slots ) p->curNoiseEntry = 0;
+
+  // slot's pulse rate to the noise levels histogram
+  uint16_t *_bin = &p->_hist[p->_curHist][ _rateBin( ((uint32_t)_pulses * 1000UL) / p->_slotMs ) ];
+  if( *_bin < UINT16_MAX ) (*_bin)++;
+
+  //log_debug(F("\n[noise][timer] pulses = "));log_debug(_pulses,DEC);log_flush();
   
   // check for noise _pulse_count_threshold
   if( p->_SumNoisePulseCount >= p->_pulseCountThreshold ) {
@@ -364,27 +419,11 @@ void ICACHE_RAM_ATTR noise::timerHandler( noise *p ) {
 
 /*
  * noise detect ISR
- * This method called upon interrup on _pinSensor
- * will increment noiseTab[curNoiseEntry]
+ * This method called upon interrup on _pinSensor (i.e no PCNT)
+ * will increment the pulses counter the timer handler reads every second
  */
 void ICACHE_RAM_ATTR noise::noiseDetectISR( void ) {
-
-  // static uint8_t _curNoiseEntry = -1;
-  
-  /*
-   * this method is called because _pinSensor interrupt was activated
-   */
-  
-  /* check for change in noiseEntry
-  if( _curNoiseEntry != curNoiseEntry ) {
-    _curNoiseEntry = curNoiseEntry;
-    noiseTab[curNoiseEntry] = 1;
-  }
-  else */
-  if( noiseTab[curNoiseEntry] < (uint8_t)-1 ) {
-    // only increment if not already at maximum
-    noiseTab[curNoiseEntry]++;
-  }
+  _isrPulses++;
 }
 
 
@@ -400,6 +439,51 @@ void noise::noiseDetectedMsg( JsonObject root ) {
 }
 
 
+/*
+ * Noise levels report: pulse rates exceeded 10% / 50% / 90% of the time
+ * since last call (i.e L10 / L50 / L90), histogram gets reset afterward
+ */
+void noise::noiseLevelsMsg( JsonObject root ) {
+  // switch timer handler to the other histogram
+  uint8_t _rep = _curHist;
+  _curHist = _rep ^ 1;
+  uint16_t *_h = _hist[_rep];
+
+  uint32_t _total = 0;
+  uint8_t _maxBin = 0;
+  for( uint8_t i=0; i < NOISE_HIST_BINS; i++ ) {
+    _total += _h[i];
+    if( _h[i] ) _maxBin = i;
+  }
+
+  // percentiles lookup (L90 is the 10th percentile of pulse rates)
+  const uint8_t _pct[] = { 90, 50, 10 };
+  uint32_t _levels[3] = { 0, 0, 0 };
+  uint8_t _cur = 0;
+  uint32_t _cumul = 0;
+  for( uint8_t i=0; _total and i < NOISE_HIST_BINS and _cur < 3; i++ ) {
+    _cumul += _h[i];
+    while( _cur < 3 and _cumul*100 >= _total*(100 - _pct[_cur]) and _cumul ) {
+      _levels[_cur++] = _binRate( i );
+    }
+  }
+  memset( _h, 0, sizeof(_hist[0]) );
+
+  root[F("value")] = _levels[1];              // L50
+  root[F("value_units")] = F("pulses/s");
+  // [oct.26] low heap: L50 only (i.e smaller frame to build and publish)
+  if( not lowMemory() ) {
+    root[F("L10")] = _levels[2];
+    root[F("L50")] = _levels[1];
+    root[F("L90")] = _levels[0];
+    root[F("max")] = ( _total ? _binRate( _maxBin ) : 0 );
+    root[F("samples")] = _total;              // number of slots accounted
+  }
+  root[F("input")] = _pinSensor;
+  root[F("subID")] = _dac->subID();
+}
+
+
 /*
  * Status report sending
  */
@@ -410,8 +494,10 @@ void noise::status( JsonObject root ) {
 
   // noise module parameters
   root[F("sensitivity")] = sensitivity;
-  root[F("_scan_window")] = DEFL_TIME_WINDOW;
+  root[F("slot")] = _slotMs;
+  root[F("slots")] = _slots;
   root[F("threshold")] = _pulseCountThreshold;
+  root[F("_counter")] = ( _hwCounter ? F("pcnt") : F("isr") );
 }
 
 
@@ -468,6 +554,122 @@ void inline noise::_ledOFF( void ) {
 }
 
 
+/*
+ * start slot timer
+ */
+void noise::_startTimer( void ) {
+  pulseT.attach_ms( _slotMs, timerHandler, this );
+}
+
+
+/*
+ * pulse rate to histogram bin: exact below 4 pulses/s then
+ * 4 sub-bins per octave (i.e 25% max error)
+ */
+uint8_t ICACHE_RAM_ATTR noise::_rateBin( uint32_t rate ) {
+  if( rate < 4 ) return rate;
+  uint8_t _msb = 31 - __builtin_clz( rate );
+  uint8_t _bin = (_msb - 1)*4 + ((rate >> (_msb - 2)) & 0x03);
+  return ( _bin < NOISE_HIST_BINS ? _bin : NOISE_HIST_BINS - 1 );
+}
+
+/*
+ * histogram bin to pulse rate (middle of the bin)
+ */
+uint32_t noise::_binRate( uint8_t bin ) {
+  if( bin < 4 ) return bin;
+  uint8_t _shift = (bin >> 2) - 1;
+  return ((uint32_t)(4 + (bin & 0x03)) << _shift) + ((1UL << _shift) >> 1);
+}
+
+
+/*
+ * pulses count since last call
+ * Note: called from the timer handler
+ */
+uint16_t ICACHE_RAM_ATTR noise::_readPulses( void ) {
+  uint32_t _pulses;
+
+#ifdef NOISE_USE_PCNT
+  if( _hwCounter ) {
+    /* [oct.26] PCNT counter is never cleared (a clear would lose the pulses
+     * arriving between read and clear): pulses are the delta against the
+     * previous read, h_lim wraps being accounted through _pcntOverflows */
+    int16_t _cnt = 0;
+    uint32_t _ovf;
+    do {
+      _ovf = _pcntOverflows;
+      pcnt_get_counter_value( NOISE_PCNT_UNIT, &_cnt );
+    } while( _ovf != _pcntOverflows );
+
+    int32_t _delta = (int32_t)_cnt - _pcntLast + (int32_t)(_ovf - _pcntOvfSeen) * NOISE_PCNT_HLIM;
+    if( _delta < 0 ) {
+      // counter wrapped but its h_lim ISR has not run yet: account for it now
+      _delta += NOISE_PCNT_HLIM;
+      _ovf++;
+    }
+    _pcntLast = _cnt;
+    _pcntOvfSeen = _ovf;
+    _pulses = (uint32_t)_delta;
+    return ( _pulses > UINT16_MAX ? UINT16_MAX : (uint16_t)_pulses );
+  }
+#endif
+
+  noInterrupts();
+  _pulses = _isrPulses;
+  _isrPulses = 0;
+  interrupts();
+  return ( _pulses > UINT16_MAX ? UINT16_MAX : (uint16_t)_pulses );
+}
+
+
+#ifdef NOISE_USE_PCNT
+/*
+ * ESP32 PCNT setup: count falling edges of _pinSensor
+ */
+bool noise::_pcntSetup( void ) {
+
+  pcnt_config_t _cfg = { };
+  _cfg.pulse_gpio_num = _pinSensor;
+  _cfg.ctrl_gpio_num  = PCNT_PIN_NOT_USED;
+  _cfg.lctrl_mode     = PCNT_MODE_KEEP;
+  _cfg.hctrl_mode     = PCNT_MODE_KEEP;
+  _cfg.pos_mode       = PCNT_COUNT_DIS;   // same as former FALLING interrupt
+  _cfg.neg_mode       = PCNT_COUNT_INC;
+  _cfg.counter_h_lim  = NOISE_PCNT_HLIM;
+  _cfg.counter_l_lim  = -NOISE_PCNT_HLIM;
+  _cfg.unit           = NOISE_PCNT_UNIT;
+  _cfg.channel        = PCNT_CHANNEL_0;
+
+  if( pcnt_unit_config( &_cfg ) != ESP_OK ) return false;
+
+  pcnt_set_filter_value( NOISE_PCNT_UNIT, NOISE_PCNT_FILTER );
+  pcnt_filter_enable( NOISE_PCNT_UNIT );
+
+  // counter resets to zero when reaching h_lim
+  pcnt_event_enable( NOISE_PCNT_UNIT, PCNT_EVT_H_LIM );
+  esp_err_t _err = pcnt_isr_service_install( 0 );
+  if( _err != ESP_OK and _err != ESP_ERR_INVALID_STATE ) return false;  // INVALID_STATE means already installed
+  if( pcnt_isr_handler_add( NOISE_PCNT_UNIT, _pcntOverflowISR, this ) != ESP_OK ) return false;
+
+  pcnt_counter_pause( NOISE_PCNT_UNIT );
+  pcnt_counter_clear( NOISE_PCNT_UNIT );
+  pcnt_counter_resume( NOISE_PCNT_UNIT );
+
+  log_debug(F("\n[noise] PCNT unit started on pin "));log_debug(_pinSensor,DEC);log_flush();
+  return true;
+}
+
+/*
+ * PCNT h_lim event: counter has been reset to zero
+ */
+void IRAM_ATTR noise::_pcntOverflowISR( void *arg ) {
+  noise *p = (noise *)arg;
+  p->_pcntOverflows++;
+}
+#endif /* NOISE_USE_PCNT */
+
+
 /*
  * orders processing ...
  */
@@ -542,6 +744,36 @@ bool noise::_processOrder( const char *order, int *value ) {
     }
   }
 
+  {
+    const char *_order = PSTR("slots");
+    if( strncmp_P(order, _order, strlen_P(_order))==0 ) {
+      if( value ) {
+        setWindow( _slotMs, (uint8_t)(*value) );
+        StaticJsonDocument<DATA_JSON_SIZE> _doc;
+        JsonObject root = _doc.to<JsonObject>();
+        status( root );
+        sendmsg( root );
+        return saveConfig();
+      }
+      else return false;
+    }
+  }
+
+  {
+    const char *_order = PSTR("slot");
+    if( strncmp_P(order, _order, strlen_P(_order))==0 ) {
+      if( value ) {
+        setWindow( (uint16_t)(*value), _slots );
+        StaticJsonDocument<DATA_JSON_SIZE> _doc;
+        JsonObject root = _doc.to<JsonObject>();
+        status( root );
+        sendmsg( root );
+        return saveConfig();
+      }
+      else return false;
+    }
+  }
+
   log_error(F("\n[noise][callback] unknown order: ")); log_debug(order); log_flush();
   return false;
 }
@@ -603,6 +835,12 @@ bool noise::_loadConfig( JsonObject root ) {
     setThreshold( (uint8_t)(root[F("sensitivity")].as<unsigned int>()) );
   }
 
+  // check for 'slot' and 'slots' fields (sliding window)
+  if( root.containsKey(F("slot")) or root.containsKey(F("slots")) ) {
+    setWindow( (root.containsKey(F("slot")) ? (uint16_t)(root[F("slot")].as<unsigned int>()) : _slotMs),
+               (root.containsKey(F("slots")) ? (uint8_t)(root[F("slots")].as<unsigned int>()) : _slots) );
+  }
+
   /*
    * Parse additional fields here
    */
@@ -632,6 +870,12 @@ bool noise::saveConfig( void ) {
     root[F("threshold")] = _pulseCountThreshold;
   
   
+  // sliding window
+  if( _slotMs != (uint16_t)DEFL_SLOT_MS )
+    root[F("slot")] = _slotMs;
+  if( _slots != (uint8_t)DEFL_TIME_WINDOW )
+    root[F("slots")] = _slots;
+
   // add additional parameters to save here
   
   
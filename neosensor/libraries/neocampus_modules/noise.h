@@ -8,6 +8,16 @@
  * 
  * Note: whatever the DAC used behind the scent, sensitivity will range from 0 to 100
  * 
+ * Note: on ESP32, comparator's pulses are counted by the PCNT peripheral (i.e no
+ * interrupt per pulse), ESP8266 lacks such hardware hence an ISR increments a counter.
+ * In both cases, the slot timer reads and clears the counter into the sliding window.
+ * 
+ * Note: sliding window is made of 'slots' slots of 'slot' ms each. Each slot's pulse
+ * rate also feeds an histogram that gets published every reporting interval as
+ * noise levels L10 / L50 / L90 (i.e pulse rates exceeded 10% / 50% / 90% of the time)
+ * 
+ * oct.26  configurable sliding window, noise levels histogram
+ * oct.26  hardware pulse counting (ESP32 PCNT), 16/32 bits counters
  * Thiebolt F. July 17
  * 
  */
@@ -31,6 +41,12 @@
 #include "MCP47X6.h"
 #include "MCP47FEB.h"
 
+// ESP32 hardware pulse counter
+#if defined(ESP32) && !defined(NOISE_DISABLE_PCNT)
+  #define NOISE_USE_PCNT
+  #include "driver/pcnt.h"
+#endif
+
 
 
 
@@ -43,11 +59,24 @@
 
 
 // noise related definitions
-#define DEFL_TIME_WINDOW          5     // (min.nb seconds of the sliding window that will lead to an evaluation of the number of pulses within
-#define THRESHOLD_MIN             100   // minimum number of pulses across the DEFL_TIME_WINDOW seconds to declare that noise has been detected
-#define THRESHOLD_MAX             1000
+#define DEFL_TIME_WINDOW          5     // default number of slots of the sliding window that will lead to an evaluation of the number of pulses within
+#define NOISE_MAX_SLOTS           50    // maximum number of slots of the sliding window
+#define DEFL_SLOT_MS              1000  // default slot duration (ms)
+#define SLOT_MIN_MS               100
+#define SLOT_MAX_MS               10000
+#define THRESHOLD_MIN             100   // minimum number of pulses across the sliding window to declare that noise has been detected
+#define THRESHOLD_MAX             30000 // slots are 16bits and window sum 32bits: no clipping below this
 #define DEFL_PULSES_THRESHOLD     THRESHOLD_MIN // (uint16_t) pulses count threshold for a specified window of time
 
+#ifdef NOISE_USE_PCNT
+  #define NOISE_PCNT_UNIT         PCNT_UNIT_0
+  #define NOISE_PCNT_FILTER       100   // glitches filter in APB clock cycles (80MHz) i.e 1.25us
+  #define NOISE_PCNT_HLIM         32767 // PCNT counter is int16_t: overflows get accounted by an ISR
+#endif
+
+// noise levels histogram: pulse rates (pulses/s) log bins with 4 sub-bins per octave
+#define NOISE_HIST_BINS           80    // up to 2^21 pulses/s
+
 
 // TODO: these parameters OUGHT to get adjusted with real experiments
 #define DEFL_SENSITIVITY          50    // percent of sensitivity (0 disabled, 100% is maximum sensitivity)
@@ -74,6 +103,7 @@ class noise : public base {
     // noise detection parametrisation
     uint8_t setSensitivity( uint8_t );    // set percent sensitivity
     bool setThreshold( uint16_t );        // set pulse count threshold across the whole sliding window
+    bool setWindow( uint16_t, uint8_t );  // set sliding window slot duration (ms) and number of slots
 
     // Every second timer call to this method
     static void ICACHE_RAM_ATTR timerHandler( noise * );
@@ -87,6 +117,7 @@ class noise : public base {
 
     void status( JsonObject );
     void noiseDetectedMsg( JsonObject );
+    void noiseLevelsMsg( JsonObject );  // noise levels since last call
         
     // Module's config
     bool saveConfig( void );
@@ -107,11 +138,22 @@ class noise : public base {
 
     uint16_t _pulseCountThreshold; // threshold above whose we signal that noise has been detected
 
-    Ticker pulseT;                                  // 1 second timer
-    volatile uint8_t noiseTab[DEFL_TIME_WINDOW+1];  // contains noise pulse count for each second
-    volatile uint8_t curNoiseEntry;                 // tells to pulse counter ISR which cell of the noiseTab to increment
-    volatile uint16_t _SumNoisePulseCount;          // sum of noise pulse count across the Time Window (5s default)
+    Ticker pulseT;                                  // slot timer
+    uint16_t _slotMs;                               // slot duration (ms)
+    uint8_t _slots;                                 // number of slots of the sliding window
+    uint16_t noiseTab[NOISE_MAX_SLOTS];             // contains noise pulse count for each of the last slots
+    uint8_t curNoiseEntry;                          // oldest cell of the noiseTab i.e next one to get overwritten
+    volatile uint32_t _SumNoisePulseCount;          // sum of noise pulse count across the sliding window
+    uint16_t _hist[2][NOISE_HIST_BINS];             // slots pulse rates histograms (current one and the one being reported)
+    volatile uint8_t _curHist;                      // histogram the timer handler updates
+    volatile uint32_t _isrPulses;                   // pulses counted by the ISR since last timer call (no PCNT)
     volatile bool noiseDetected;
+    bool _hwCounter;                                // pulses get counted by hardware
+#ifdef NOISE_USE_PCNT
+    volatile uint32_t _pcntOverflows;               // PCNT counter overflows (free running)
+    uint32_t _pcntOvfSeen;                          // overflows already accounted by _readPulses
+    int16_t _pcntLast;                              // PCNT counter value at previous _readPulses
+#endif
     
     voidFuncPtr _noiseDetectISR;                    // pointer to ISR (declared outside)
     
@@ -120,6 +162,14 @@ class noise : public base {
      */
     void inline _ledON( void );
     void inline _ledOFF( void );
+    uint16_t ICACHE_RAM_ATTR _readPulses( void );   // pulses count since last call
+    void _startTimer( void );
+    static uint8_t ICACHE_RAM_ATTR _rateBin( uint32_t );
+    static uint32_t _binRate( uint8_t );
+#ifdef NOISE_USE_PCNT
+    bool _pcntSetup( void );
+    static void IRAM_ATTR _pcntOverflowISR( void * );
+#endif
     bool _loadConfig( JsonObject );
     bool _processOrder( const char *, int * );      // an order to process with optional value
 };
@@ -9,6 +9,8 @@
  * TODO:
  * - convert all 'frequency' parameters & define into 'cooldown' ones
  * ---
+ * oct.26  MCP9808 in alert mode (read upon significant change only)
+ * oct.26  added SCD4x (shared with humidity and airquality modules)
  * F.Thiebolt aug.20  switched to intelligent data sending vs timer based data sending
  * Thiebolt.F nov.20  previous 'force data as float' didn't work! we need to
  *                    use serialized(String(1.0,6)); // 1.000000
@@ -42,6 +44,10 @@
 #define CONFIG_JSON_SIZE        (JSON_OBJECT_SIZE(3))   // config file contains: frequency
 // [nov.20] set FLOAT resolution of data to get sent over MQTT
 #define FLOAT_RESOLUTION        3
+// [oct.26] MCP9808 ALERT line (none means Ta flags poll)
+#ifndef TEMPERATURE_ALERT
+#define TEMPERATURE_ALERT       INVALID_GPIO
+#endif
 
 
 // constructors
@@ -92,6 +98,7 @@ boolean temperature::add_sensor( uint8_t adr ) {
     else {
       cur_sensor->setResolution( MCP9808_RESOLUTION_0125DEG );
       cur_sensor->powerOFF();
+      cur_sensor->setAlertMode( TEMPERATURE_ALERT );  // read upon significant change only
       _sensor[_sensors_count++] = cur_sensor;
       _sensor_added=true;
     }
@@ -128,6 +135,20 @@ boolean temperature::add_sensor( uint8_t adr ) {
       _sensor_added=true;
     }
   }
+  // check for SCD4x
+  else if( SCD4x::is_device( adr ) == true ) {
+    SCD4x *cur_sensor = new SCD4x( scd4xMeasureType_t::temperature );    // device shared with CO2 and humidity
+    if( cur_sensor->begin( adr ) != true ) {
+      log_debug(F("\n[temperature] ###ERROR at SCD4x startup ... removing instance ..."));log_flush();
+      free(cur_sensor);
+      cur_sensor = NULL;
+    }
+    else {
+      // low power periodic measurement keeps running (device shared across 3 modules)
+      _sensor[_sensors_count++] = cur_sensor;
+      _sensor_added=true;
+    }
+  }
   //else if( TCN75A::is_device( adr ) == true ) {
 
   // add check for additional device here
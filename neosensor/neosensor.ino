@@ -24,6 +24,15 @@
  * - as the number of modules is increasing, implement a list of modules in the setup()
  * 
  * ---
+ * oct.26  DAC offered last, only when no other module adopted the device
+ * oct.26  airquality offered devices before noise (SCD4x vs MCP47X6 DAC at 0x62)
+ * oct.26  i2c inventory gets rebuilt whenever enabled modules change
+ * oct.26  SCD4x CO2 sensor offered to airquality module (T and RH to their modules)
+ * oct.26  i2c transactions layer (retries, bus recovery, per device clock)
+ * oct.26  i2c enumeration of drivers' known addresses with devices
+ *         inventory in flash (no more 20ms delays per address)
+ * oct.26  main loop delay may get cut short by modules (e.g digital inputs edges)
+ * oct.26  heap telemetry with low-memory back-pressure to modules
  * F.Thiebolt   nov.21  corrected timezone definition for esp32
  * F.Thiebolt   sep.21  added display module support (e.g oled or 7segment displays)
  * F.Thiebolt   aug.21  added digital inputs support (e;g PIR sensor)
@@ -109,6 +118,7 @@
 #include "neocampus_debug.h"
 #include "neocampus_utils.h"
 #include "neocampus_i2c.h"
+#include "neocampus_heap.h"
 #include "sensocampus.h"
 #include "neocampus_OTA.h"
 //#include "neocampus_comm.h"               // future MQTT(s) comm module: a single MQTTclient shared with multiple subscribers featuring different callbacks
@@ -177,6 +187,18 @@ typedef enum {
 } enum_ledmode_t;
 
 
+/*
+ * i2c devices inventory: modules that adopted a device
+ */
+#define I2C_MODULE_TEMPERATURE    0x01
+#define I2C_MODULE_LUMINOSITY     0x02
+#define I2C_MODULE_NOISE          0x04
+#define I2C_MODULE_HUMIDITY       0x08
+#define I2C_MODULE_DISPLAY        0x10
+#define I2C_MODULE_AIRQUALITY     0x20
+#define I2C_MODULES_ALL           0x3F
+
+
 /*
  * Global variables
  */
@@ -312,17 +334,62 @@ bool setupI2C( void ) {
   }
   
   log_info(F("\n[i2c] start setup ..."));
-  Wire.begin(SDA,SCL);
-  #ifdef I2C_FREQ
-    log_debug(F("\nI2C frequency set to "));log_debug(I2C_FREQ/1000,DEC); log_debug("kHz"); log_flush();
-    Wire.setClock(I2C_FREQ);
-  #else
-    log_debug(F("\nI2C frequency set to default 100kHz")); log_flush();
-  #endif
+  // bus recovery (e.g device holding SDA after a reset) and default clock
+  if( !i2c_begin(SDA, SCL, I2C_DEFL_CLOCK) ) {
+    log_error(F("\n[i2c] bus is stuck, unable to recover ?!")); log_flush();
+  }
+  log_debug(F("\nI2C frequency set to "));log_debug(I2C_DEFL_CLOCK/1000,DEC); log_debug("kHz"); log_flush();
   return true;
 }
 
 
+// ---
+// offer an i2c device to modules (bitmask), sends back modules that adopted it
+// [oct.26] 'adopted' holds modules that already adopted this device
+uint8_t i2cDispatch( uint8_t adr, uint8_t modules, uint8_t adopted ) {
+
+  uint8_t _adopted = 0;
+
+  // is chip a temperature sensor ?
+  if( (modules & I2C_MODULE_TEMPERATURE) and temperatureModule and temperatureModule->add_sensor(adr) == true ) {
+    log_debug(F("\n\t\tadded temperature sensor at i2c addr = 0x"));log_debug(adr,HEX); log_flush();
+    _adopted |= I2C_MODULE_TEMPERATURE;
+  }
+  // is chip a luminosity sensor ?
+  if( (modules & I2C_MODULE_LUMINOSITY) and luminosityModule and luminosityModule->add_sensor(adr) == true ) {
+    log_debug(F("\n\t\tadded luminosity sensor at i2c addr = 0x"));log_debug(adr,HEX); log_flush();
+    _adopted |= I2C_MODULE_LUMINOSITY;
+  }
+  // is chip an air quality sensor (e.g CO2) ?
+  if( (modules & I2C_MODULE_AIRQUALITY) and airqualityModule and airqualityModule->add_sensor(adr) == true ) {
+    log_debug(F("\n\t\tadded airquality sensor at i2c addr = 0x"));log_debug(adr,HEX); log_flush();
+    _adopted |= I2C_MODULE_AIRQUALITY;
+  }
+  // is chip a humidity sensor ?
+  if( (modules & I2C_MODULE_HUMIDITY) and humidityModule and humidityModule->add_sensor(adr) == true ) {
+    log_debug(F("\n\t\tadded humidity sensor at i2c addr = 0x"));log_debug(adr,HEX); log_flush();
+    _adopted |= I2C_MODULE_HUMIDITY;
+  }
+  // is chip a display ?
+  if( (modules & I2C_MODULE_DISPLAY) and displayModule and displayModule->add_display(adr) == true ) {
+    log_debug(F("\n\t\tadded display at i2c addr = 0x"));log_debug(adr,HEX); log_flush();
+    _adopted |= I2C_MODULE_DISPLAY;
+  }
+  /* is chip a DAC (part of a noise detection subsystem) ?
+   * [oct.26] MCP47X6 DACs can't get identified: offered last and only if
+   * no other module adopted this address (e.g SCD4x at 0x62) */
+  if( (modules & I2C_MODULE_NOISE) and noiseModule and not (adopted | _adopted) and
+      noiseModule->add_dac(adr) == true ) {
+    log_debug(F("\n\t\tadded DAC to noise module whose i2c addr = 0x"));log_debug(adr,HEX); log_flush();
+    _adopted |= I2C_MODULE_NOISE;
+  }
+
+  // add test for others modules ...
+
+  return _adopted;
+}
+
+
 // ---
 // Blink system led
 inline void blinkSysLed( void ) {
@@ -352,16 +419,16 @@ inline void blinkSysLed( void ) {
 void endLoop( void ) {
   static unsigned long _lastCheck = 0;    // elapsed ms since last check
 
-#if 0
+#ifdef DEBUG_SHARED_JSON
   // ONY FOR DEBUGGING
   static unsigned long _lastJSONdisplay = 0;    // elapsed ms since last displying shared JSON
-  // 90s second elapsed ?
-  if( ((millis() - _lastJSONdisplay) >= (unsigned long)90*1000UL) == true ) {
+  // 90s second elapsed ? (and not while heap is low)
+  if( ((millis() - _lastJSONdisplay) >= (unsigned long)90*1000UL) == true and not heapIsLow() ) {
     _lastJSONdisplay = millis();
     log_debug(F("\nGlobal sharedJSON:\n")); log_flush();
     serializeJsonPretty( sharedRoot, Serial );
   }
-#endif /* 0 */
+#endif /* DEBUG_SHARED_JSON */
 
   // check if a reboot has been requested ...
   if( _need2reboot ) {
@@ -380,8 +447,18 @@ void endLoop( void ) {
     /* blink SYS_LED */
     blinkSysLed();
 
-    // check Heap available
-    if( ESP.getFreeHeap() < 4096 ) {
+    /* [oct.26] heap telemetry: free heap, largest block, fragmentation ...
+     * modules get notified upon back-pressure level change so they'll
+     * disable their optional features before an allocation fails */
+    if( heapUpdate() ) {
+      const heapStats_t *hs = heapStats();
+      log_warningF("\n[SYS] heap back-pressure level %d (free=%u maxblock=%u frag=%u%%)",
+                    (int)heapPressure(), (unsigned)hs->freeHeap, (unsigned)hs->maxBlock, (unsigned)hs->fragmentation);
+      #ifndef DISABLE_MODULES
+      modulesList.heapPressureAll( heapPressure() );
+      #endif
+    }
+    if( heapPressure()==heapPressure_t::critical ) {
       log_error(F("\n[SYS] CRTICAL free heap very low!!!")); log_flush();
     }
 
@@ -933,82 +1010,100 @@ void setup() {
   /*
    * I2C bus initialization, set pins & frequency
    */
-  setupI2C();
+  bool _i2cEnabled = setupI2C();
 
 
   /* 
    *  neOCampus modules instanciation
-   *  - scan i2c bus
+   *  - enumerate i2c devices
    *  - instantite components :)
-   */
-  uint8_t i2c_addr,res;
-  
-  i2c_addr=I2C_ADDR_START;
-  log_debug(F("\nStart I2C scanning ..."));
-
-  /* i2c scanner loop ...
    * [may.20] since some sensors are of both kinds (e.g SHTXX --> temperature AND hygro)
    * ==> each i2c addr ought to get tested against all kinds of modules 
+   * [oct.26] only drivers' known addresses get probed (full sweep is optional).
+   * Devices along with modules that adopted them are saved in flash: whenever
+   * the very same devices answer on next boot, each device only gets offered
+   * to its own modules (unless the set of enabled modules changed).
    */
-  do {
-    if( _need2reboot ) break;
-    
-    res = i2c_scan(i2c_addr);
-    if( res==uint8_t(-1) ) break;
-    log_debug(F("\n\t... detected device at i2c_addr=0x"));log_debug(res,HEX);log_flush();
-
-
-/* DEBUG single sensor ... 
-if( res!=uint8_t(0x44) ) {
-  log_debug(F("\n\t[DEBUG] discarding device at i2c_addr=0x"));log_debug(res,HEX);log_flush();
-  i2c_addr=res+1;
-  continue;
-}
-*/
-
-    bool _known = false;
+  uint8_t _i2cKnown[I2C_BITMAP_SIZE];
+  memset( _i2cKnown, 0, sizeof(_i2cKnown) );
+  i2c_bitmap_add( _i2cKnown, Adafruit_MCP9808::i2c_addrs, sizeof(Adafruit_MCP9808::i2c_addrs) );
+  i2c_bitmap_add( _i2cKnown, SHT2x::i2c_addrs, sizeof(SHT2x::i2c_addrs) );
+  i2c_bitmap_add( _i2cKnown, SHT3x::i2c_addrs, sizeof(SHT3x::i2c_addrs) );
+  i2c_bitmap_add( _i2cKnown, SCD4x::i2c_addrs, sizeof(SCD4x::i2c_addrs) );
+  i2c_bitmap_add( _i2cKnown, TSL2561::i2c_addrs, sizeof(TSL2561::i2c_addrs) );
+  i2c_bitmap_add( _i2cKnown, MAX44009::i2c_addrs, sizeof(MAX44009::i2c_addrs) );
+  i2c_bitmap_add( _i2cKnown, MCP47FEB::i2c_addrs, sizeof(MCP47FEB::i2c_addrs) );
+  i2c_bitmap_add( _i2cKnown, MCP47X6::i2c_addrs, sizeof(MCP47X6::i2c_addrs) );
+  i2c_bitmap_add( _i2cKnown, oled13inch::i2c_addrs, sizeof(oled13inch::i2c_addrs) );
+  // add others drivers' addresses here ...
+
+  unsigned long _i2cStartMs = millis();
+  uint8_t _i2cFound[I2C_INVENTORY_MAX];
+  uint8_t _i2cNbFound = 0;
+  i2cDevice_t _i2cInventory[I2C_INVENTORY_MAX];
+  uint8_t _i2cNbInventory = 0;
+  bool _i2cInventoryValid = false;
+  uint8_t _i2cInventoryModules = 0;
+
+  // modules devices may get offered to
+  uint8_t _i2cModules = 0;
+  if( temperatureModule ) _i2cModules |= I2C_MODULE_TEMPERATURE;
+  if( luminosityModule ) _i2cModules |= I2C_MODULE_LUMINOSITY;
+  if( noiseModule ) _i2cModules |= I2C_MODULE_NOISE;
+  if( humidityModule ) _i2cModules |= I2C_MODULE_HUMIDITY;
+  if( displayModule ) _i2cModules |= I2C_MODULE_DISPLAY;
+  if( airqualityModule ) _i2cModules |= I2C_MODULE_AIRQUALITY;
+
+  if( _i2cEnabled and not _need2reboot ) {
+    log_debug(F("\nStart I2C enumeration ..."));
+#ifdef I2C_FULL_SWEEP
+    _i2cNbFound = i2c_enumerate( _i2cKnown, _i2cFound, I2C_INVENTORY_MAX, true );
+#else
+    _i2cNbFound = i2c_enumerate( _i2cKnown, _i2cFound, I2C_INVENTORY_MAX );
+#endif
 
-    // is chip a temperature sensor ?
-    if( temperatureModule and temperatureModule->add_sensor(res) == true ) {
-      log_debug(F("\n\t\tadded temperature sensor at i2c addr = 0x"));log_debug(res,HEX); log_flush();
-      _known = true;
-    }
-    // is chip a luminosity sensor ?
-    if( luminosityModule and luminosityModule->add_sensor(res) == true ) {
-      log_debug(F("\n\t\tadded luminosity sensor at i2c addr = 0x"));log_debug(res,HEX); log_flush();
-      _known = true;
-    }
-    // is chip a DAC (part of a noise detection subsystem) ?
-    if( noiseModule and noiseModule->add_dac(res) == true ) {
-      log_debug(F("\n\t\tadded DAC to noise module whose i2c addr = 0x"));log_debug(res,HEX); log_flush();      
-      _known = true;
+    // same devices and same enabled modules as last boot ?
+    if( i2c_inventory_load( _i2cInventory, &_i2cNbInventory, &_i2cInventoryModules ) and
+        _i2cInventoryModules==_i2cModules and _i2cNbInventory==_i2cNbFound ) {
+      _i2cInventoryValid = true;
+      for( uint8_t i=0; i < _i2cNbFound; i++ ) {
+        if( _i2cInventory[i].addr == _i2cFound[i] ) continue;
+        _i2cInventoryValid = false;
+        break;
+      }
     }
-    // is chip a humidity sensor ?
-    if( humidityModule and humidityModule->add_sensor(res) == true ) {
-      log_debug(F("\n\t\tadded humidity sensor at i2c addr = 0x"));log_debug(res,HEX); log_flush();
-      _known = true;
-    }
-    // is chip a display ?
-    if( displayModule and displayModule->add_display(res) == true ) {
-      log_debug(F("\n\t\tadded display at i2c addr = 0x"));log_debug(res,HEX); log_flush();
-      _known = true;
+    if( !_i2cInventoryValid ) {
+      log_info(F("\n[i2c] devices inventory missing or outdated ...")); log_flush();
     }
+  }
 
+  bool _i2cInventoryUpdated = not _i2cInventoryValid;
+  for( uint8_t i=0; i < _i2cNbFound and not _need2reboot; i++ ) {
+    uint8_t res = _i2cFound[i];
+    log_debug(F("\n\t... detected device at i2c_addr=0x"));log_debug(res,HEX);log_flush();
 
-    // add test for others modules ...
+    uint8_t _modules = ( _i2cInventoryValid ? _i2cInventory[i].modules : I2C_MODULES_ALL );
+    uint8_t _adopted = i2cDispatch( res, _modules, 0 );
+    if( _i2cInventoryValid and _adopted != _modules ) {
+      // device changed at this address ... let's offer it to the other modules
+      _adopted |= i2cDispatch( res, I2C_MODULES_ALL & ~_modules, _adopted );
+      _i2cInventoryUpdated = true;
+    }
 
     // did the i2c device has been identified ?
-    if( not _known ) {
+    if( not _adopted ) {
       log_warning(F("\n[WARNING] unknwown i2c device with i2c addr = 0x"));log_debug(res,HEX); log_flush();
     }
-    
-    // next iteration
-    i2c_addr=res+1;
 
-  } while( not _need2reboot and i2c_addr<=I2C_ADDR_STOP );
+    _i2cInventory[i].addr = res;
+    _i2cInventory[i].modules = _adopted;
+  }
+  if( _i2cEnabled and _i2cInventoryUpdated and not _need2reboot ) {
+    i2c_inventory_save( _i2cInventory, _i2cNbFound, _i2cModules );
+  }
 
   // end of scanning
-  log_debug(F("\n... END OF I2C scan ... "));log_flush();
+  log_debug(F("\n... END OF I2C scan in "));log_debug(millis()-_i2cStartMs,DEC);log_debug(F("ms"));log_flush();
 
 
   // add device module
@@ -1162,6 +1257,6 @@ void loop() {
   // call endLoop system management level
   endLoop();
   
-  // waiting a bit
-  delay( MAIN_LOOP_DELAY );
+  // waiting a bit (modules' ISRs may cut it short)
+  loopDelay( MAIN_LOOP_DELAY );
 }
@@ -17,7 +17,15 @@ void func2(byte *p, unsigned int l){
     return;
 }
 
-base_class bc1("airquality",func1);
+void poll1(){
+    // sensor acquisition
+}
+
+void publish1(){
+    log_debug("publish 1 was called");
+}
+
+base_class bc1("airquality",func1,poll1,1000,publish1,60000);
 base_class bc2("temperature",func2);
 
 
@@ -25,11 +33,13 @@ void setup() {
   Serial.begin(115200);
   delay(3000);
 
+  neo.add_sen_type(&bc1);
+  neo.add_sen_type(&bc2);
   neo.setup();
 }
 
 void loop(){
    neo.loop();
 
-   delay(250);
+   delay(TW_TICK_MS);
 }
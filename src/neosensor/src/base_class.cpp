@@ -3,8 +3,9 @@
 /*base_class::base_class(char *t, void (*callback)()): _topic(t),_sensor_qty(0) {
     on_connect() = &callback();
 };*/
-base_class::base_class(): _topic(DEFT_TOPIC_BASE), _sensor_qty(0), on_message{NULL} {};
-base_class::base_class(const char *t, void (*on_message)(byte *p, unsigned int l)): _topic{t}, _sensor_qty(0), on_message{on_message} {};
+base_class::base_class(): _topic(DEFT_TOPIC_BASE), _sensor_qty(0), on_message{NULL}, on_poll{NULL}, poll_ms(0), on_publish{NULL}, publish_ms(0) {};
+base_class::base_class(const char *t, void (*on_message)(byte *p, unsigned int l)): _topic{t}, _sensor_qty(0), on_message{on_message}, on_poll{NULL}, poll_ms(0), on_publish{NULL}, publish_ms(0) {};
+base_class::base_class(const char *t, void (*on_message)(byte *p, unsigned int l), void (*on_poll)(), uint32_t poll_ms, void (*on_publish)(), uint32_t publish_ms): _topic{t}, _sensor_qty(0), on_message{on_message}, on_poll{on_poll}, poll_ms(poll_ms), on_publish{on_publish}, publish_ms(publish_ms) {};
 
 bool base_class::add(){
     _mqttsclient.add(_topic, on_message);
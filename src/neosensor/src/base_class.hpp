@@ -8,11 +8,21 @@
 class base_class{
 public:
     base_class(const char *t, void (*on_message)(byte *, unsigned int));
+    /* sensor type with periodic jobs, run by the neoscheduler timer wheel 
+     * a NULL callback or a 0 period disables the job
+     */
+    base_class(const char *t, void (*on_message)(byte *, unsigned int), void (*on_poll)(), uint32_t poll_ms, void (*on_publish)(), uint32_t publish_ms);
     base_class();
     void on_connect();
     bool add();
     bool publish(char *);
     void (*on_message)(byte *, unsigned int);
+    /* sensor acquisition */
+    void (*on_poll)();
+    uint32_t poll_ms;
+    /* data sending */
+    void (*on_publish)();
+    uint32_t publish_ms;
 
     inline const char * topic(){
         return _topic;
@@ -22,6 +22,14 @@
 
 #define MAX_SENSORS 30
 
+/* neoscheduler consts */
+#define TW_SLOTS 64 // timer wheel buckets (power of 2)
+#define TW_TICK_MS 10 // timer wheel resolution
+#define TW_MAX_TIMERS 32 // sensor types poll/publish jobs + mqtt loop and reconnect
+#define MQTT_RETRY_MIN_MS 1000 // first reconnect backoff
+#define MQTT_RETRY_MAX_MS 60000 // backoff upper bound
+#define MQTT_LOOP_MS 100 // PubSubClient loop() period
+
 /* memory consts */
 #define CRED_FILE "/cred.txt"
 #define MQTT_FILE "/conf.txt"
@@ -30,18 +30,24 @@ bool mqttsclient::connect(){
         log_error("_wcsClient failed to setup");
     }
     log_debug("--- end of mqttsclient::connect ---\n");
-    Serial.flush();
-    delay(1000);
     return success;
 }
 
-void mqttsclient::reconnect(){
-    bool success = connect(); 
+bool mqttsclient::reconnect(){
+    if(_client.connected())
+        return true;
     log_debug("--- beg of mqttsclient::reconnect ---\n");
-    while(!success){
-        success= connect();
-    }
+    bool success = connect() && subscribe();
     log_debug("--- end of mqttsclient::reconnect ---\n");
+    return success;
+}
+
+bool mqttsclient::connected(){
+    return _client.connected();
+}
+
+bool mqttsclient::loop(){
+    return _client.loop();
 }
 
 bool mqttsclient::subscribe(){
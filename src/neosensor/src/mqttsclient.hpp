@@ -24,8 +24,14 @@ public:
     bool add(const char *, void(*)(byte *, unsigned int)); //TODO
     /* connection to the MQTT broker*/
     bool connect();
-    /* reconnect if connection lost */
-    void reconnect();
+    /* single reconnect attempt if connection lost, never waits:
+     * retries and backoff are up to the neoscheduler
+     */
+    bool reconnect();
+    /* state of the link to the broker */
+    bool connected();
+    /* process incoming messages and keepalive */
+    bool loop();
     /* print attributes to serial */
     void serialize();
 
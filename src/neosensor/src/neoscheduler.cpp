@@ -1,7 +1,7 @@
 #include "neoscheduler.hpp"
 
 // constructor
-neoscheduler::neoscheduler( void ) {
+neoscheduler::neoscheduler( void ) : _wheel(&neoscheduler::_clock), _numb_sen_types(0), _mqtt_loop(TW_INVALID), _reconnect(TW_INVALID), _backoff_ms(MQTT_RETRY_MIN_MS) {
     // neOScheduler init
 }
 
@@ -36,9 +36,124 @@ void neoscheduler::setup(){
     }else{
         log_error("this file wasn't found in memory");
     }
+
+    /* sensor types may have been added before setup: restart the wheel
+     * from now with their jobs and a first connection attempt */
+    uint32_t now = millis();
+    _wheel.begin(now);
+    for(int i = 0; i < _numb_sen_types; ++i)
+        _arm(_sen_types[i]);
+    _mqtt_loop = _wheel.every(MQTT_LOOP_MS, &neoscheduler::_mqtt_loop_cb, this);
+    _backoff_ms = MQTT_RETRY_MIN_MS;
+    _reconnect = _wheel.after(0, &neoscheduler::_reconnect_cb, this);
     log_debug("--- end of neoscheduler::setup ---")
 }
 
 void neoscheduler::loop(){
     // main loop processing sensors algorithms
-}
\ No newline at end of file
+    _wheel.advance(millis());
+}
+
+bool neoscheduler::add_sen_type(base_class *sen){
+    if(sen == NULL || _numb_sen_types >= MAX_SENSORS || _find(sen) >= 0){
+        log_error("unable to add sensor type");
+        return false;
+    }
+    sen_type &st = _sen_types[_numb_sen_types];
+    st.sen = sen;
+    if(!_arm(st))
+        return false;
+    if(sen->on_message)
+        _mqtts.add(sen->topic(), sen->on_message);
+    ++_numb_sen_types;
+    return true;
+}
+
+const tw_stats_t *neoscheduler::poll_stats(const base_class *sen) const {
+    int i = _find(sen);
+    return i < 0 ? NULL : _wheel.stats(_sen_types[i].poll);
+}
+
+const tw_stats_t *neoscheduler::publish_stats(const base_class *sen) const {
+    int i = _find(sen);
+    return i < 0 ? NULL : _wheel.stats(_sen_types[i].publish);
+}
+
+void neoscheduler::serialize(){
+    log_info("--- beg of neoscheduler::serialize ---");
+    char line[96];
+    const tw_stats_t &t = _wheel.total();
+    snprintf(line, sizeof(line), "timers: %u runs: %u overruns: %u jitter avg/max: %u/%u ms", _wheel.count(), t.runs, t.overruns, t.avg_jitter_ms(), t.max_jitter_ms);
+    log_info(line);
+    for(int i = 0; i < _numb_sen_types; ++i){
+        const tw_stats_t *s[2] = { _wheel.stats(_sen_types[i].poll), _wheel.stats(_sen_types[i].publish) };
+        for(int j = 0; j < 2; ++j){
+            if(!s[j])
+                continue;
+            snprintf(line, sizeof(line), "%s %s runs: %u overruns: %u jitter avg/max: %u/%u ms duration max: %u ms", _sen_types[i].sen->topic(), j ? "publish" : "poll", s[j]->runs, s[j]->overruns, s[j]->avg_jitter_ms(), s[j]->max_jitter_ms, s[j]->max_duration_ms);
+            log_info(line);
+        }
+    }
+    log_info("--- end of neoscheduler::serialize ---\n");
+}
+
+uint32_t neoscheduler::_clock(){
+    return millis();
+}
+
+void neoscheduler::_poll_cb(void *arg){
+    ((base_class *)arg)->on_poll();
+}
+
+void neoscheduler::_publish_cb(void *arg){
+    ((base_class *)arg)->on_publish();
+}
+
+void neoscheduler::_mqtt_loop_cb(void *arg){
+    neoscheduler *self = (neoscheduler *)arg;
+    if(self->_mqtts.connected()){
+        self->_mqtts.loop();
+    }else if(!self->_wheel.active(self->_reconnect)){
+        // connection lost: next attempt right away, then backoff
+        self->_backoff_ms = MQTT_RETRY_MIN_MS;
+        self->_reconnect = self->_wheel.after(0, &neoscheduler::_reconnect_cb, self);
+    }
+}
+
+void neoscheduler::_reconnect_cb(void *arg){
+    neoscheduler *self = (neoscheduler *)arg;
+    self->_reconnect = TW_INVALID;
+    if(self->_mqtts.reconnect()){
+        self->_backoff_ms = MQTT_RETRY_MIN_MS;
+        return;
+    }
+    // exponential backoff, the wheel keeps running the sensors meanwhile
+    self->_reconnect = self->_wheel.after(self->_backoff_ms, &neoscheduler::_reconnect_cb, self);
+    self->_backoff_ms = (self->_backoff_ms >= MQTT_RETRY_MAX_MS / 2) ? MQTT_RETRY_MAX_MS : self->_backoff_ms * 2;
+}
+
+bool neoscheduler::_arm(sen_type &st){
+    base_class *sen = st.sen;
+    st.poll = TW_INVALID;
+    st.publish = TW_INVALID;
+    if(sen->on_poll && sen->poll_ms)
+        st.poll = _wheel.every(sen->poll_ms, &neoscheduler::_poll_cb, sen);
+    if(sen->on_publish && sen->publish_ms)
+        st.publish = _wheel.every(sen->publish_ms, &neoscheduler::_publish_cb, sen);
+    if((sen->on_poll && sen->poll_ms && st.poll == TW_INVALID) ||
+       (sen->on_publish && sen->publish_ms && st.publish == TW_INVALID)){
+        log_error("timer wheel is full, increase TW_MAX_TIMERS");
+        _wheel.cancel(st.poll);
+        _wheel.cancel(st.publish);
+        return false;
+    }
+    return true;
+}
+
+int neoscheduler::_find(const base_class *sen) const {
+    for(int i = 0; i < _numb_sen_types; ++i){
+        if(_sen_types[i].sen == sen)
+            return i;
+    }
+    return -1;
+}
@@ -3,11 +3,13 @@
 
 
 #include <ArduinoJson.h>
+#include "base_class.hpp"
 #include "const.hpp"
 #include "esp32_memory.hpp"
 #include "httpsclient.hpp"
 #include "mqttsclient.hpp"
 #include "neologger.hpp"
+#include "timerwheel.hpp"
 #include "wifimanager.hpp"
 
 class neoscheduler {
@@ -21,18 +23,48 @@ public:
     void setup();
 
     /* function to call in the .ino loop 
-    * User inputs how often the loop should repeat (in seconds)
+    * runs the timer wheel: sensors jobs, mqtt processing and reconnects
     */
     void loop();
 
-    /* add user's custom publish and on_message functions */
-    void add_sen_type();
+    /* add user's custom publish, poll and on_message functions
+    * poll and publish callbacks get registered with their periods
+    */
+    bool add_sen_type(base_class *);
+
+    /* jitter and overrun stats of the sensor types jobs */
+    const tw_stats_t *poll_stats(const base_class *) const;
+    const tw_stats_t *publish_stats(const base_class *) const;
+    inline const timerwheel &wheel() const {
+        return _wheel;
+    }
+    /* print stats to serial */
+    void serialize();
 private:
+    static uint32_t _clock();
+    static void _poll_cb(void *);
+    static void _publish_cb(void *);
+    static void _mqtt_loop_cb(void *);
+    static void _reconnect_cb(void *);
+    int _find(const base_class *) const;
+
     wifimanager _wm;
     httpsclient _https;
     mqttsclient _mqtts;
     esp32_memory _mem;
     StaticJsonDocument<(JSON_OBJECT_SIZE (128))> _jso;
     uint8_t _mac_addr[6];
+
+    timerwheel _wheel;
+    struct sen_type{
+        base_class *sen;
+        tw_handle_t poll;
+        tw_handle_t publish;
+    } _sen_types [MAX_SENSORS];
+    int _numb_sen_types;
+    bool _arm(sen_type &);
+    tw_handle_t _mqtt_loop;
+    tw_handle_t _reconnect;
+    uint32_t _backoff_ms;
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,206 @@
+#include <string.h>
+#include "timerwheel.hpp"
+
+#if (TW_SLOTS & (TW_SLOTS - 1)) != 0
+#error "TW_SLOTS must be a power of 2"
+#endif
+#if TW_MAX_TIMERS >= TW_INVALID
+#error "TW_MAX_TIMERS too large for tw_handle_t"
+#endif
+
+#define TW_MASK (TW_SLOTS - 1)
+
+timerwheel::timerwheel(tw_clock_t clock) : _clock(clock) {
+    begin(0);
+}
+
+void timerwheel::begin(uint32_t now_ms){
+    memset(_timers, 0, sizeof(_timers));
+    memset(_buckets, TW_INVALID, sizeof(_buckets));
+    for(uint8_t i = 0; i < TW_MAX_TIMERS; ++i)
+        _timers[i].next = (i + 1 < TW_MAX_TIMERS) ? i + 1 : TW_INVALID;
+    _free = 0;
+    _cur_tick = 0;
+    _last_ms = now_ms;
+    _count = 0;
+    reset_stats();
+}
+
+void timerwheel::reset_stats(){
+    memset(&_total, 0, sizeof(_total));
+    for(uint8_t i = 0; i < TW_MAX_TIMERS; ++i)
+        memset(&_timers[i].stats, 0, sizeof(tw_stats_t));
+}
+
+tw_handle_t timerwheel::every(uint32_t period_ms, tw_callback_t cb, void *arg, int32_t first_ms){
+    if(period_ms < TW_TICK_MS)
+        period_ms = TW_TICK_MS;
+    tw_handle_t h = _alloc(period_ms, cb, arg);
+    if(h == TW_INVALID)
+        return h;
+    _timers[h].due_ms = _last_ms + (first_ms < 0 ? period_ms : (uint32_t)first_ms);
+    _link(h);
+    return h;
+}
+
+tw_handle_t timerwheel::after(uint32_t delay_ms, tw_callback_t cb, void *arg){
+    tw_handle_t h = _alloc(0, cb, arg);
+    if(h == TW_INVALID)
+        return h;
+    _timers[h].due_ms = _last_ms + delay_ms;
+    _link(h);
+    return h;
+}
+
+bool timerwheel::reschedule(tw_handle_t h, uint32_t delay_ms){
+    if(!active(h))
+        return false;
+    _unlink(h);
+    _timers[h].due_ms = _last_ms + delay_ms;
+    _link(h);
+    return true;
+}
+
+bool timerwheel::cancel(tw_handle_t &h){
+    if(!active(h))
+        return false;
+    _unlink(h);
+    _release(h);
+    h = TW_INVALID;
+    return true;
+}
+
+bool timerwheel::active(tw_handle_t h) const {
+    return h < TW_MAX_TIMERS && _timers[h].used;
+}
+
+const tw_stats_t *timerwheel::stats(tw_handle_t h) const {
+    return active(h) ? &_timers[h].stats : NULL;
+}
+
+void timerwheel::advance(uint32_t now_ms){
+    uint32_t ticks = (now_ms - _last_ms) / TW_TICK_MS;
+
+    /* a timer hashed to a bucket is due at the first visit of this bucket
+     * following its expiry, hence visiting each bucket once is enough
+     * whatever the number of elapsed ticks */
+    if(ticks > TW_SLOTS){
+        _cur_tick += ticks - TW_SLOTS;
+        _last_ms += (ticks - TW_SLOTS) * TW_TICK_MS;
+        ticks = TW_SLOTS;
+    }
+    /* _last_ms follows _cur_tick so that timers (re)armed from a callback
+     * get hashed relative to the tick being processed */
+    while(ticks--){
+        ++_cur_tick;
+        _last_ms += TW_TICK_MS;
+        _process_bucket(_cur_tick & TW_MASK, now_ms);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+tw_handle_t timerwheel::_alloc(uint32_t period_ms, tw_callback_t cb, void *arg){
+    if(cb == NULL || _free == TW_INVALID)
+        return TW_INVALID;
+    uint8_t id = _free;
+    _free = _timers[id].next;
+    memset(&_timers[id], 0, sizeof(timer));
+    _timers[id].used = true;
+    _timers[id].cb = cb;
+    _timers[id].arg = arg;
+    _timers[id].period_ms = period_ms;
+    ++_count;
+    return id;
+}
+
+/* timer must be unlinked from its bucket */
+void timerwheel::_release(uint8_t id){
+    _timers[id].used = false;
+    _timers[id].next = _free;
+    _free = id;
+    --_count;
+}
+
+void timerwheel::_link(uint8_t id){
+    timer &t = _timers[id];
+    int32_t delta = (int32_t)(t.due_ms - _last_ms);
+    uint32_t ticks = (delta <= 0) ? 1 : ((uint32_t)delta + TW_TICK_MS - 1) / TW_TICK_MS;
+    t.expires = _cur_tick + ticks;
+
+    uint8_t slot = t.expires & TW_MASK;
+    t.prev = TW_INVALID;
+    t.next = _buckets[slot];
+    if(t.next != TW_INVALID)
+        _timers[t.next].prev = id;
+    _buckets[slot] = id;
+}
+
+void timerwheel::_unlink(uint8_t id){
+    timer &t = _timers[id];
+    if(t.prev != TW_INVALID)
+        _timers[t.prev].next = t.next;
+    else
+        _buckets[t.expires & TW_MASK] = t.next;
+    if(t.next != TW_INVALID)
+        _timers[t.next].prev = t.prev;
+    t.prev = t.next = TW_INVALID;
+}
+
+void timerwheel::_process_bucket(uint8_t slot, uint32_t now_ms){
+    /* callbacks may add or cancel any timer, including the ones of this
+     * bucket: restart from the head after each call */
+    bool fired = true;
+    while(fired){
+        fired = false;
+        for(uint8_t id = _buckets[slot]; id != TW_INVALID; id = _timers[id].next){
+            if((int32_t)(_timers[id].expires - _cur_tick) > 0)
+                continue;
+            _unlink(id);
+            _fire(id, now_ms);
+            fired = true;
+            break;
+        }
+    }
+}
+
+void timerwheel::_fire(uint8_t id, uint32_t now_ms){
+    timer &t = _timers[id];
+    uint32_t jitter = (int32_t)(now_ms - t.due_ms) > 0 ? now_ms - t.due_ms : 0;
+    uint32_t missed = 0;
+
+    if(t.period_ms){
+        /* drift-free: next call is aligned on the initial schedule,
+         * periods entirely elapsed are accounted as overruns */
+        missed = jitter / t.period_ms;
+        t.due_ms += (missed + 1) * t.period_ms;
+        _link(id);
+    }else{
+        _release(id);
+    }
+
+    tw_callback_t cb = t.cb;
+    void *arg = t.arg;
+    uint32_t period_ms = t.period_ms;
+    uint32_t start = _clock ? _clock() : now_ms;
+    cb(arg);
+    uint32_t duration = _clock ? _clock() - start : 0;
+
+    /* one-shot timers have been released before the callback and a periodic
+     * one may have been cancelled from it: these only contribute to the totals */
+    bool own = period_ms && t.used && t.cb == cb && t.arg == arg;
+    tw_stats_t *s[2] = { &_total, own ? &t.stats : NULL };
+    bool overrun = missed || (period_ms && duration > period_ms);
+    for(uint8_t i = 0; i < 2; ++i){
+        if(!s[i])
+            continue;
+        ++s[i]->runs;
+        s[i]->sum_jitter_ms += jitter;
+        if(jitter > s[i]->max_jitter_ms)
+            s[i]->max_jitter_ms = jitter;
+        if(duration > s[i]->max_duration_ms)
+            s[i]->max_duration_ms = duration;
+        if(overrun)
+            s[i]->overruns += missed ? missed : 1;
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+/*
+ * Hashed timer wheel used by the neOScheduler
+ * Timers live in a static pool (no heap) whose free entries are chained in
+ * a free list, each bucket holds a doubly linked list of timers whose expiry
+ * tick hashes to it: insert and cancel are O(1), advancing the wheel only
+ * visits the buckets of the elapsed ticks.
+ * Wheel size, resolution and pool size come from const.hpp.
+ *
+ * The wheel does not read any clock on its own: advance() gets the current
+ * time and the optional clock function is only used to measure how long a
+ * callback lasted. This way it runs the same against millis() or against a
+ * virtual clock (host tests).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "const.hpp"
+
+#define TW_INVALID 0xFF         // invalid timer handle
+
+typedef uint8_t tw_handle_t;
+typedef void (*tw_callback_t)(void *);
+typedef uint32_t (*tw_clock_t)(void);
+
+/* per timer statistics
+ * jitter is the delay between the due time and the effective call,
+ * an overrun is either a missed period or a callback lasting more than its period
+ */
+struct tw_stats_t {
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t max_jitter_ms;
+    uint32_t sum_jitter_ms;
+    uint32_t max_duration_ms;
+
+    inline uint32_t avg_jitter_ms() const {
+        return runs ? sum_jitter_ms / runs : 0;
+    }
+};
+
+class timerwheel {
+public:
+    /* clock is only used to measure callbacks duration (may be NULL) */
+    timerwheel(tw_clock_t clock = NULL);
+
+    /* (re)start the wheel at the specified time, drops all timers */
+    void begin(uint32_t now_ms);
+
+    /* periodic timer, first call after first_ms (default: one period) */
+    tw_handle_t every(uint32_t period_ms, tw_callback_t cb, void *arg = NULL, int32_t first_ms = -1);
+    /* one-shot timer */
+    tw_handle_t after(uint32_t delay_ms, tw_callback_t cb, void *arg = NULL);
+    /* move an active timer to now + delay_ms (periodic timers keep their period) */
+    bool reschedule(tw_handle_t h, uint32_t delay_ms);
+    /* remove a timer, handle gets invalidated */
+    bool cancel(tw_handle_t &h);
+    bool active(tw_handle_t h) const;
+
+    /* run all callbacks due up to now_ms */
+    void advance(uint32_t now_ms);
+
+    /* statistics */
+    const tw_stats_t *stats(tw_handle_t h) const;
+    inline const tw_stats_t &total() const {
+        return _total;
+    }
+    inline uint8_t count() const {
+        return _count;
+    }
+    void reset_stats();
+
+private:
+    struct timer {
+        tw_callback_t cb;
+        void *arg;
+        uint32_t due_ms;        // time the callback ought to get called
+        uint32_t period_ms;     // 0 for one-shot timers
+        uint32_t expires;       // absolute tick
+        uint8_t prev;
+        uint8_t next;           // next in bucket, or in free list if unused
+        bool used;
+        tw_stats_t stats;
+    };
+
+    tw_handle_t _alloc(uint32_t period_ms, tw_callback_t cb, void *arg);
+    void _release(uint8_t id);
+    void _link(uint8_t id);
+    void _unlink(uint8_t id);
+    void _fire(uint8_t id, uint32_t now_ms);
+    void _process_bucket(uint8_t slot, uint32_t now_ms);
+
+    tw_clock_t _clock;
+    timer _timers[TW_MAX_TIMERS];
+    uint8_t _buckets[TW_SLOTS];
+    uint8_t _free;              // head of unused timers list
+    uint32_t _cur_tick;
+    uint32_t _last_ms;          // time matching _cur_tick
+    uint8_t _count;
+    tw_stats_t _total;
+};
+
+#endif
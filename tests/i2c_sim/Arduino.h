@@ -0,0 +1,164 @@
+/*
+ * Host (linux) Arduino shim for the I2C bus simulator
+ *
+ * Only what neocampus_i2c and the I2C drivers make use of: virtual time
+ * (millis, delay ...) is the simulated bus clock, gpios of the I2C pins
+ * are wired to the simulated bus (recovery), Serial is quiet unless
+ * I2C_SIM_VERBOSE is set in the environment.
+ */
+
+#ifndef _I2C_SIM_ARDUINO_H_
+#define _I2C_SIM_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+
+/*
+ * Types and constants
+ */
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH                0x1
+#define LOW                 0x0
+
+#define INPUT               0x00
+#define OUTPUT              0x01
+#define INPUT_PULLUP        0x02
+#define OUTPUT_OPEN_DRAIN   0x03
+
+#define DEC                 10
+#define HEX                 16
+#define OCT                 8
+#define BIN                 2
+
+#define PROGMEM
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+#define PSTR(s)             (s)
+#define F(s)                (s)
+#define FPSTR(p)            (p)
+#define pgm_read_byte(p)        (*(const uint8_t *)(p))
+#define pgm_read_byte_near(p)   (*(const uint8_t *)(p))
+#define pgm_read_word(p)        (*(const uint16_t *)(p))
+#define strncmp_P           strncmp
+#define strcmp_P            strcmp
+#define strlen_P            strlen
+#define strcpy_P            strcpy
+#define snprintf_P          snprintf
+
+
+/*
+ * Virtual time (i.e simulated bus clock)
+ */
+unsigned long millis( void );
+unsigned long micros( void );
+void delay( unsigned long ms );
+void delayMicroseconds( unsigned int us );
+static inline void yield( void ) { }
+
+
+/*
+ * Gpios: I2C pins are wired to the simulated bus
+ */
+void pinMode( uint8_t pin, uint8_t mode );
+int digitalRead( uint8_t pin );
+void digitalWrite( uint8_t pin, uint8_t val );
+
+// interrupts get raised by tests (e.g INT line of a model)
+#define RISING              0x01
+#define FALLING             0x02
+#define CHANGE              0x03
+#define NOT_AN_INTERRUPT    -1
+#define digitalPinToInterrupt(p)  ( (p) < 40 ? (int)(p) : NOT_AN_INTERRUPT )
+void attachInterruptArg( uint8_t pin, void (*isr)( void * ), void *arg, int mode );
+void detachInterrupt( uint8_t pin );
+
+
+/*
+ * String (subset)
+ */
+class String {
+  public:
+    String( void ) { }
+    String( const char *s ) : _s( s ? s : "" ) { }
+    String( const std::string &s ) : _s( s ) { }
+    String( char c ) : _s( 1, c ) { }
+    String( int v, unsigned char base=DEC ) { _fmt( (long)v, base ); }
+    String( unsigned int v, unsigned char base=DEC ) { _fmt( (unsigned long)v, base ); }
+    String( long v, unsigned char base=DEC ) { _fmt( v, base ); }
+    String( unsigned long v, unsigned char base=DEC ) { _fmt( v, base ); }
+    String( unsigned char v, unsigned char base=DEC ) { _fmt( (unsigned long)v, base ); }
+    String( float v, unsigned char decimals=2 ) { char b[32]; snprintf( b, sizeof(b), "%.*f", decimals, v ); _s = b; }
+
+    const char *c_str( void ) const { return _s.c_str(); }
+    unsigned int length( void ) const { return _s.length(); }
+    long toInt( void ) const { return atol( _s.c_str() ); }
+    float toFloat( void ) const { return (float)atof( _s.c_str() ); }
+
+    String &operator+=( const String &o ) { _s += o._s; return *this; }
+    String &operator+=( const char *o ) { _s += o; return *this; }
+    String &operator+=( char c ) { _s += c; return *this; }
+    friend String operator+( const String &a, const String &b ) { return String( a._s + b._s ); }
+    friend String operator+( const String &a, const char *b ) { return String( a._s + b ); }
+    bool operator==( const String &o ) const { return _s == o._s; }
+    bool operator==( const char *o ) const { return _s == o; }
+    bool operator!=( const String &o ) const { return _s != o._s; }
+    bool operator!=( const char *o ) const { return _s != o; }
+
+  private:
+    void _fmt( long v, unsigned char base ) {
+      if( v < 0 and base==DEC ) { _fmt( (unsigned long)(-v), base ); _s.insert( 0, 1, '-' ); }
+      else _fmt( (unsigned long)v, base );
+    }
+    void _fmt( unsigned long v, unsigned char base ) {
+      char b[72]; int i = sizeof(b) - 1; b[i] = 0;
+      if( base < 2 ) base = DEC;
+      do { b[--i] = "0123456789ABCDEF"[v % base]; v /= base; } while( v );
+      _s = &b[i];
+    }
+    std::string _s;
+};
+
+
+/*
+ * Serial: quiet unless I2C_SIM_VERBOSE environment variable is set
+ */
+class HardwareSerial {
+  public:
+    void begin( unsigned long ) { }
+    void flush( void ) { if( _verbose() ) fflush( stdout ); }
+    size_t print( const char *s ) { return _out( "%s", s ); }
+    size_t print( const String &s ) { return _out( "%s", s.c_str() ); }
+    size_t print( char c ) { return _out( "%c", c ); }
+    size_t print( double v, int decimals=2 ) { return _out( "%.*f", decimals, v ); }
+    size_t print( unsigned char v, int base=DEC ) { return print( (unsigned long)v, base ); }
+    size_t print( int v, int base=DEC ) { return print( (long)v, base ); }
+    size_t print( unsigned int v, int base=DEC ) { return print( (unsigned long)v, base ); }
+    size_t print( long v, int base=DEC ) { return print( String( v, (unsigned char)base ) ); }
+    size_t print( unsigned long v, int base=DEC ) { return print( String( v, (unsigned char)base ) ); }
+    size_t print( unsigned long long v, int base=DEC ) { return print( String( (unsigned long)v, (unsigned char)base ) ); }
+    template<typename T> size_t println( T v ) { size_t n = print( v ); return n + print( "\n" ); }
+    size_t printf( const char *fmt, ... ) __attribute__((format(printf, 2, 3))) {
+      if( !_verbose() ) return 0;
+      va_list ap; va_start( ap, fmt ); int n = vprintf( fmt, ap ); va_end( ap );
+      return n;
+    }
+  private:
+    static bool _verbose( void ) { static int v = -1; if( v < 0 ) v = ( getenv("I2C_SIM_VERBOSE") != nullptr ); return v; }
+    size_t _out( const char *fmt, ... ) {
+      if( !_verbose() ) return 0;
+      va_list ap; va_start( ap, fmt ); int n = vprintf( fmt, ap ); va_end( ap );
+      return n;
+    }
+};
+extern HardwareSerial Serial;
+
+#endif /* _I2C_SIM_ARDUINO_H_ */
@@ -0,0 +1,56 @@
+/*
+ * Host (linux) in-memory SPIFFS for the I2C bus simulator
+ * (i.e devices inventory of neocampus_i2c)
+ */
+
+#ifndef _I2C_SIM_FS_H_
+#define _I2C_SIM_FS_H_
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+
+namespace fs {
+
+class File {
+  public:
+    File( void ) { }
+    File( std::string *content, bool write ) : _content( content ), _write( write ) { if( write ) _content->clear(); }
+    explicit operator bool( void ) const { return _content != nullptr; }
+    int available( void ) const { return _content ? (int)( _content->size() - _pos ) : 0; }
+    int read( void ) { return ( _content and _pos < _content->size() ) ? (uint8_t)(*_content)[_pos++] : -1; }
+    size_t readBytes( char *buf, size_t len ) {
+      size_t n = 0;
+      while( n < len and available() ) buf[n++] = (char)read();
+      return n;
+    }
+    size_t write( uint8_t c ) { if( !_content or !_write ) return 0; _content->push_back( (char)c ); return 1; }
+    size_t write( const uint8_t *buf, size_t len ) { size_t n = 0; while( n < len and write( buf[n] ) ) n++; return n; }
+    void close( void ) { _content = nullptr; }
+  private:
+    std::string *_content = nullptr;
+    bool _write = false;
+    size_t _pos = 0;
+};
+
+class FS {
+  public:
+    bool begin( bool=false ) { return true; }
+    bool exists( const char *path ) { return _files.count( path ) != 0; }
+    bool remove( const char *path ) { return _files.erase( path ) != 0; }
+    File open( const char *path, const char *mode ) {
+      if( mode[0]=='r' and not exists( path ) ) return File();
+      return File( &_files[path], mode[0]=='w' );
+    }
+    void format( void ) { _files.clear(); }
+  private:
+    std::map<std::string, std::string> _files;
+};
+
+} // namespace fs
+
+using fs::File;
+extern fs::FS SPIFFS;
+
+#endif /* _I2C_SIM_FS_H_ */
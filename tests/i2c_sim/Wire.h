@@ -0,0 +1,54 @@
+/*
+ * Host (linux) Wire replacement backed by the simulated I2C bus
+ *
+ * Same return codes as the ESP8266/ESP32 cores:
+ *   endTransmission: 0 ok, 1 data too long, 2 NACK on address,
+ *                    3 NACK on data, 4 other error (bus busy), 5 timeout
+ *   requestFrom: number of bytes read (0 on NACK or timeout)
+ */
+
+#ifndef _I2C_SIM_WIRE_H_
+#define _I2C_SIM_WIRE_H_
+
+#include <Arduino.h>
+
+#define I2C_BUFFER_LENGTH       128
+#define BUFFER_LENGTH           I2C_BUFFER_LENGTH
+
+
+class TwoWire {
+  public:
+    bool begin( int sda, int scl, uint32_t frequency=0 );
+    bool begin( void ) { return begin( _sda, _scl ); }
+    bool end( void );
+    void setClock( uint32_t frequency );
+    uint32_t getClock( void ) const;
+    void setClockStretchLimit( uint32_t us );    // esp8266
+    void setTimeOut( uint16_t ms );              // esp32
+
+    void beginTransmission( uint8_t addr );
+    void beginTransmission( int addr ) { beginTransmission( (uint8_t)addr ); }
+    uint8_t endTransmission( bool sendStop=true );
+    size_t write( uint8_t val );
+    size_t write( const uint8_t *buf, size_t len );
+
+    uint8_t requestFrom( uint8_t addr, uint8_t len, bool sendStop=true );
+    uint8_t requestFrom( int addr, int len ) { return requestFrom( (uint8_t)addr, (uint8_t)len ); }
+    uint8_t requestFrom( int addr, int len, int sendStop ) { return requestFrom( (uint8_t)addr, (uint8_t)len, (bool)sendStop ); }
+    int available( void ) { return _rxLen - _rxIdx; }
+    int read( void ) { return ( _rxIdx < _rxLen ) ? _rxBuf[_rxIdx++] : -1; }
+    int peek( void ) { return ( _rxIdx < _rxLen ) ? _rxBuf[_rxIdx] : -1; }
+
+  private:
+    int _sda = -1, _scl = -1;
+    uint8_t _txAddr = 0;
+    uint8_t _txBuf[I2C_BUFFER_LENGTH];
+    size_t _txLen = 0;
+    bool _txOverflow = false;
+    uint8_t _rxBuf[I2C_BUFFER_LENGTH];
+    uint8_t _rxLen = 0, _rxIdx = 0;
+};
+
+extern TwoWire Wire;
+
+#endif /* _I2C_SIM_WIRE_H_ */
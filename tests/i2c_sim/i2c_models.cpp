@@ -0,0 +1,742 @@
+/*
+ * Host (linux) I2C bus simulator: behavioural devices models
+ *
+ * Timings are datasheets' maximum values.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "i2c_models.h"
+
+using i2c_sim::now;
+using i2c_sim::crc8;
+
+
+static uint16_t _clamp16( double v ) {
+  if( v < 0 ) return 0;
+  if( v > 65535 ) return 65535;
+  return (uint16_t)lround( v );
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * MCP9808
+ */
+static const uint32_t _mcp9808_tconv[4] = { 30000, 65000, 130000, 250000 };    // µs, 0.5 to 0.0625°C
+
+// 13 bits signed (sign bit 12) to 1/16°C
+static int _mcp9808_s13( uint16_t r ) {
+  int v = r & 0x0FFF;
+  return ( r & 0x1000 ) ? v - 4096 : v;
+}
+
+sim_MCP9808::sim_MCP9808( uint8_t addr ) : i2c_sim_device( addr, I2C_SIM_FAST_CLOCK ),
+    _temperature( 20.0f ), _ptr( 0 ), _config( 0 ), _upper( 0 ), _lower( 0 ), _crit( 0 ), _ambient( 0 ),
+    _resolution( 3 ), _convStart( now() ), _lastOutside( false ), _latched( false ), _conversions( 0 ) { }
+
+void sim_MCP9808::setTemperature( float t ) {
+  _update();
+  _temperature = t;
+}
+
+uint16_t sim_MCP9808::_encode( float t ) const {
+  int v = (int)floor( t * 16.0f );
+  v &= ~( ( 1 << ( 3 - _resolution ) ) - 1 );
+  return (uint16_t)v & 0x1FFF;
+}
+
+bool sim_MCP9808::_outside( void ) const {
+  int ta = _mcp9808_s13( _ambient );
+  return ( ta > _mcp9808_s13( _upper ) ) or ( ta < _mcp9808_s13( _lower ) );
+}
+
+bool sim_MCP9808::_critical( void ) const {
+  return _mcp9808_s13( _ambient ) >= _mcp9808_s13( _crit );
+}
+
+// conversions elapsed since last call (temperature was constant meanwhile)
+void sim_MCP9808::_update( void ) {
+  if( _config & 0x0100 ) { _convStart = now(); return; }
+  uint32_t _tconv = _mcp9808_tconv[_resolution];
+  if( now() - _convStart < _tconv ) return;
+  uint64_t n = ( now() - _convStart ) / _tconv;
+  _convStart += n * _tconv;
+  _conversions += n;
+  _ambient = _encode( _temperature );
+  bool _out = _outside();
+  if( ( _config & 0x0001 ) and _out != _lastOutside ) _latched = true;   // interrupt mode: window crossed
+  _lastOutside = _out;
+}
+
+bool sim_MCP9808::alert( void ) {
+  _update();
+  if( not ( _config & 0x0008 ) ) return false;
+  bool _crt = _critical();
+  if( _config & 0x0004 ) return _crt;                   // critical only
+  if( _config & 0x0001 ) return _latched or _crt;       // interrupt mode
+  return _outside() or _crt;                            // comparator mode
+}
+
+uint16_t sim_MCP9808::reg( uint8_t r ) {
+  _update();
+  switch( r ) {
+    case 0x01: return _config | ( alert() ? 0x0010 : 0 );
+    case 0x02: return _upper;
+    case 0x03: return _lower;
+    case 0x04: return _crit;
+    case 0x05: {
+      int ta = _mcp9808_s13( _ambient );
+      return _ambient | ( ta >= _mcp9808_s13( _crit ) ? 0x8000 : 0 )
+                      | ( ta > _mcp9808_s13( _upper ) ? 0x4000 : 0 )
+                      | ( ta < _mcp9808_s13( _lower ) ? 0x2000 : 0 );
+    }
+    case 0x06: return 0x0054;
+    case 0x07: return 0x0400;
+    case 0x08: return _resolution;
+  }
+  return 0;
+}
+
+uint8_t sim_MCP9808::write( const uint8_t *buf, uint8_t len ) {
+  if( len==0 ) return 0;
+  _ptr = buf[0] & 0x0F;
+  if( len >= 2 and _ptr == 0x08 ) { _update(); _resolution = buf[1] & 0x03; }
+  if( len >= 3 ) {
+    uint16_t v = ( buf[1] << 8 ) | buf[2];
+    switch( _ptr ) {
+      case 0x01:
+        _update();
+        if( v & 0x0020 ) _latched = false;              // interrupt clear
+        if( ( _config & 0x0100 ) and not ( v & 0x0100 ) ) _convStart = now();
+        _config = v & 0x07CF;
+        break;
+      case 0x02: _upper = v & 0x1FFC; break;
+      case 0x03: _lower = v & 0x1FFC; break;
+      case 0x04: _crit = v & 0x1FFC; break;
+    }
+  }
+  return len;
+}
+
+void sim_MCP9808::read( uint8_t *buf, uint8_t len ) {
+  uint16_t v = reg( _ptr );
+  for( uint8_t i=0; i < len; i++ ) {
+    if( _ptr == 0x08 ) buf[i] = (uint8_t)v;
+    else buf[i] = ( i==0 ) ? ( v >> 8 ) : ( i==1 ) ? ( v & 0xFF ) : 0;
+  }
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * SHT2x
+ * note: neOCampus driver reads user register through the 'write user
+ * register' command (0xE6) without data, model answers as for 0xE7
+ */
+static const uint32_t _sht2x_t_us[4]    = { 85000, 22000, 43000, 11000 };
+static const uint32_t _sht2x_rh_us[4]   = { 29000, 4000, 9000, 15000 };
+static const uint8_t _sht2x_t_bits[4]   = { 14, 12, 13, 11 };
+static const uint8_t _sht2x_rh_bits[4]  = { 12, 8, 10, 11 };
+
+sim_SHT2x::sim_SHT2x( uint8_t addr ) : i2c_sim_device( addr, I2C_SIM_FAST_CLOCK ),
+    _temperature( 20.0f ), _humidity( 50.0f ), _userReg( 0x02 ), _respLen( 0 ), _readyAt( 0 ),
+    _hold( false ), _conversions( 0 ) { }
+
+bool sim_SHT2x::ack( bool read ) {
+  if( not read ) return ( _respLen or now() >= _readyAt );      // soft reset in progress
+  if( _respLen==0 ) return false;
+  return _hold or now() >= _readyAt;                            // no hold master: NACK till done
+}
+
+uint32_t sim_SHT2x::stretch( bool read ) {
+  if( read and _hold and now() < _readyAt ) return (uint32_t)( _readyAt - now() );
+  return 0;
+}
+
+void sim_SHT2x::_measure( bool rh, bool hold ) {
+  uint8_t res = ( ( _userReg & 0x80 ) >> 6 ) | ( _userReg & 0x01 );
+  uint8_t bits = rh ? _sht2x_rh_bits[res] : _sht2x_t_bits[res];
+  uint16_t raw = rh ? _clamp16( ( _humidity + 6.0 ) * 65536.0 / 125.0 )
+                    : _clamp16( ( _temperature + 46.85 ) * 65536.0 / 175.72 );
+  raw &= ~( ( 1 << ( 16 - bits ) ) - 1 ) & 0xFFFC;
+  if( rh ) raw |= 0x0002;
+  _resp[0] = raw >> 8;
+  _resp[1] = raw & 0xFF;
+  _resp[2] = crc8( _resp, 2, 0x00 );
+  _respLen = 3;
+  _hold = hold;
+  _readyAt = now() + ( rh ? _sht2x_rh_us[res] : _sht2x_t_us[res] );
+  _conversions++;
+}
+
+uint8_t sim_SHT2x::write( const uint8_t *buf, uint8_t len ) {
+  if( len==0 ) return 0;
+  switch( buf[0] ) {
+    case 0xE3: _measure( false, true ); break;
+    case 0xF3: _measure( false, false ); break;
+    case 0xE5: _measure( true, true ); break;
+    case 0xF5: _measure( true, false ); break;
+    case 0xE6:
+      if( len >= 2 ) { _userReg = ( buf[1] & 0xC7 ) | ( _userReg & 0x38 ); _respLen = 0; break; }
+      // fall through (read user register)
+    case 0xE7:
+      _resp[0] = _userReg; _respLen = 1; _hold = false; _readyAt = now();
+      break;
+    case 0xFE:
+      _userReg = 0x02; _respLen = 0; _readyAt = now() + 15000;
+      break;
+    case 0xFA: {
+      if( len < 2 or buf[1] != 0x0F ) return 1;
+      static const uint8_t snb[4] = { 0x12, 0x34, 0x56, 0x78 };
+      for( uint8_t i=0; i < 4; i++ ) { _resp[2*i] = snb[i]; _resp[2*i+1] = crc8( &snb[i], 1, 0x00 ); }
+      _respLen = 8; _hold = false; _readyAt = now();
+      break;
+    }
+    case 0xFC: {
+      if( len < 2 or buf[1] != 0xC9 ) return 1;
+      static const uint8_t snc[2] = { 0xAB, 0xCD }, sna[2] = { 0x00, 0x80 };
+      _resp[0] = snc[0]; _resp[1] = snc[1]; _resp[2] = crc8( snc, 2, 0x00 );
+      _resp[3] = sna[0]; _resp[4] = sna[1]; _resp[5] = crc8( sna, 2, 0x00 );
+      _respLen = 6; _hold = false; _readyAt = now();
+      break;
+    }
+    default:
+      return 0;
+  }
+  return len;
+}
+
+void sim_SHT2x::read( uint8_t *buf, uint8_t len ) {
+  for( uint8_t i=0; i < len; i++ ) buf[i] = ( i < _respLen ) ? _resp[i] : 0xFF;
+  _respLen = 0;
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * SHT3x
+ */
+#define SHT3X_MEAS_HIGH_US    15500
+#define SHT3X_MEAS_MED_US     6500
+#define SHT3X_MEAS_LOW_US     4500
+
+sim_SHT3x::sim_SHT3x( uint8_t addr ) : i2c_sim_device( addr, I2C_SIM_FASTPLUS_CLOCK ),
+    _temperature( 20.0f ), _humidity( 50.0f ), _status( 0x8010 ), _heater( false ), _respLen( 0 ),
+    _readyAt( 0 ), _busyUntil( 0 ), _stretchMode( false ), _measTime( SHT3X_MEAS_HIGH_US ),
+    _period( 0 ), _nextResult( 0 ), _unread( false ), _conversions( 0 ) { }
+
+void sim_SHT3x::_update( void ) {
+  if( _period==0 or now() < _nextResult ) return;
+  uint64_t n = ( now() - _nextResult ) / _period + 1;
+  _nextResult += n * _period;
+  _conversions += n;
+  _unread = true;
+}
+
+bool sim_SHT3x::ack( bool read ) {
+  _update();
+  if( now() < _busyUntil ) return false;
+  if( not read ) return true;
+  if( _respLen==0 ) return false;
+  return _stretchMode or now() >= _readyAt;
+}
+
+uint32_t sim_SHT3x::stretch( bool read ) {
+  if( read and _stretchMode and now() < _readyAt ) return (uint32_t)( _readyAt - now() );
+  return 0;
+}
+
+void sim_SHT3x::_respond( uint16_t w0, int32_t w1 ) {
+  _resp[0] = w0 >> 8; _resp[1] = w0 & 0xFF; _resp[2] = crc8( _resp, 2 );
+  _respLen = 3;
+  if( w1 >= 0 ) {
+    _resp[3] = ( w1 >> 8 ) & 0xFF; _resp[4] = w1 & 0xFF; _resp[5] = crc8( &_resp[3], 2 );
+    _respLen = 6;
+  }
+  _readyAt = now();
+  _stretchMode = false;
+}
+
+void sim_SHT3x::_result( void ) {
+  _respond( _clamp16( ( _temperature + 45.0 ) * 65535.0 / 175.0 ), _clamp16( _humidity * 65535.0 / 100.0 ) );
+}
+
+uint8_t sim_SHT3x::write( const uint8_t *buf, uint8_t len ) {
+  _update();
+  if( len < 2 ) return len;
+  uint16_t cmd = ( buf[0] << 8 ) | buf[1];
+  uint32_t _meas = 0, _per = 0;
+
+  // periodic modes: rate (MSB) along with repeatability (LSB)
+  switch( cmd ) {
+    case 0x2032: _per = 2000000; _meas = SHT3X_MEAS_HIGH_US; break;
+    case 0x2024: _per = 2000000; _meas = SHT3X_MEAS_MED_US; break;
+    case 0x202F: _per = 2000000; _meas = SHT3X_MEAS_LOW_US; break;
+    case 0x2130: _per = 1000000; _meas = SHT3X_MEAS_HIGH_US; break;
+    case 0x2126: _per = 1000000; _meas = SHT3X_MEAS_MED_US; break;
+    case 0x212D: _per = 1000000; _meas = SHT3X_MEAS_LOW_US; break;
+    case 0x2236: _per = 500000; _meas = SHT3X_MEAS_HIGH_US; break;
+    case 0x2220: _per = 500000; _meas = SHT3X_MEAS_MED_US; break;
+    case 0x222B: _per = 500000; _meas = SHT3X_MEAS_LOW_US; break;
+    case 0x2334: _per = 250000; _meas = SHT3X_MEAS_HIGH_US; break;
+    case 0x2322: _per = 250000; _meas = SHT3X_MEAS_MED_US; break;
+    case 0x2329: _per = 250000; _meas = SHT3X_MEAS_LOW_US; break;
+    case 0x2737: _per = 100000; _meas = SHT3X_MEAS_HIGH_US; break;
+    case 0x2721: _per = 100000; _meas = SHT3X_MEAS_MED_US; break;
+    case 0x272A: _per = 100000; _meas = SHT3X_MEAS_LOW_US; break;
+    case 0x2B32: _per = 250000; _meas = SHT3X_MEAS_HIGH_US; break;    // ART
+  }
+  if( _per ) {
+    _period = _per;
+    _measTime = _meas;
+    _nextResult = now() + _meas;
+    _unread = false;
+    _respLen = 0;
+    _status &= ~0x0002;
+    return len;
+  }
+
+  // periodic mode: only a few commands get accepted
+  if( _period and cmd != 0xE000 and cmd != 0x3093 and cmd != 0x30A2 and
+      cmd != 0xF32D and cmd != 0x3041 and cmd != 0x306D and cmd != 0x3066 ) {
+    _status |= 0x0002;
+    return 1;
+  }
+
+  switch( cmd ) {
+    case 0x30A2:      // soft reset
+      _status = 0x8010; _heater = false; _period = 0; _respLen = 0;
+      _busyUntil = now() + 1500;
+      break;
+    case 0xF32D: _respond( _status ); break;
+    case 0x3041: _status &= ~( 0x8000 | 0x0800 | 0x0400 | 0x0010 ); break;
+    case 0x306D: _heater = true; _status |= 0x2000; break;
+    case 0x3066: _heater = false; _status &= ~0x2000; break;
+    case 0x2400: case 0x240B: case 0x2416:
+    case 0x2C06: case 0x2C0D: case 0x2C10:
+      _measTime = ( ( cmd & 0xFF ) == 0x00 or ( cmd & 0xFF ) == 0x06 ) ? SHT3X_MEAS_HIGH_US :
+                  ( ( cmd & 0xFF ) == 0x0B or ( cmd & 0xFF ) == 0x0D ) ? SHT3X_MEAS_MED_US : SHT3X_MEAS_LOW_US;
+      _result();
+      _stretchMode = ( ( cmd >> 8 ) == 0x2C );
+      _readyAt = now() + _measTime;
+      if( not _stretchMode ) _busyUntil = _readyAt;
+      _conversions++;
+      break;
+    case 0xE000:      // fetch data
+      if( not _period ) { _status |= 0x0002; return 1; }
+      if( _unread ) { _result(); _unread = false; }
+      else _respLen = 0;
+      break;
+    case 0x3093:      // break
+      _period = 0; _respLen = 0;
+      _busyUntil = now() + 1000;
+      break;
+    default:
+      _status |= 0x0002;
+      return 1;
+  }
+  _status &= ~0x0002;
+  return len;
+}
+
+void sim_SHT3x::read( uint8_t *buf, uint8_t len ) {
+  for( uint8_t i=0; i < len; i++ ) buf[i] = ( i < _respLen ) ? _resp[i] : 0xFF;
+  _respLen = 0;
+  _stretchMode = false;
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * SCD4x
+ */
+sim_SCD4x::sim_SCD4x( uint8_t addr ) : i2c_sim_device( addr, I2C_SIM_STD_CLOCK ),
+    _temperature( 20.0f ), _humidity( 50.0f ), _co2( 400 ), _tOffset( 1498 ), _altitude( 0 ), _pressure( 1013 ),
+    _respLen( 0 ), _busyUntil( 0 ), _period( 0 ), _nextResult( 0 ), _singleShot( 0 ), _ready( false ),
+    _sleeping( false ), _conversions( 0 ) { }
+
+void sim_SCD4x::_update( void ) {
+  if( _period and now() >= _nextResult ) {
+    uint64_t n = ( now() - _nextResult ) / _period + 1;
+    _nextResult += n * _period;
+    _conversions += n;
+    _ready = true;
+  }
+  if( _singleShot and now() >= _singleShot ) {
+    _singleShot = 0;
+    _conversions++;
+    _ready = true;
+  }
+}
+
+bool sim_SCD4x::ack( bool read ) {
+  _update();
+  if( _sleeping ) {
+    // wake_up does not get acknowledged
+    if( not read ) { _sleeping = false; _busyUntil = now() + 30000; }
+    return false;
+  }
+  if( now() < _busyUntil ) return false;
+  if( read ) return _respLen != 0;
+  return true;
+}
+
+void sim_SCD4x::_respond( const uint16_t *words, uint8_t nb ) {
+  for( uint8_t i=0; i < nb; i++ ) {
+    _resp[3*i] = words[i] >> 8;
+    _resp[3*i+1] = words[i] & 0xFF;
+    _resp[3*i+2] = crc8( &_resp[3*i], 2 );
+  }
+  _respLen = 3 * nb;
+}
+
+uint8_t sim_SCD4x::write( const uint8_t *buf, uint8_t len ) {
+  _update();
+  if( len < 2 ) return len;
+  uint16_t cmd = ( buf[0] << 8 ) | buf[1];
+  bool _hasArg = ( len >= 5 and crc8( &buf[2], 2 ) == buf[4] );
+  uint16_t _arg = _hasArg ? ( ( buf[2] << 8 ) | buf[3] ) : 0;
+  uint16_t _w[3];
+  _respLen = 0;
+
+  // periodic modes: only a few commands get accepted
+  if( _period and cmd != 0xEC05 and cmd != 0xE4B8 and cmd != 0x3F86 and cmd != 0xE000 ) return 1;
+
+  switch( cmd ) {
+    case 0x21B1: _period = 5000000; _nextResult = now() + _period; _ready = false; break;
+    case 0x21AC: _period = 30000000; _nextResult = now() + _period; _ready = false; break;
+    case 0x3F86: _period = 0; _busyUntil = now() + 500000; break;
+    case 0xEC05:
+      if( _ready ) {
+        _w[0] = _co2;
+        _w[1] = _clamp16( ( _temperature + 45.0 ) * 65535.0 / 175.0 );
+        _w[2] = _clamp16( _humidity * 65535.0 / 100.0 );
+        _respond( _w, 3 );
+        _ready = false;
+      }
+      _busyUntil = now() + 1000;
+      break;
+    case 0xE4B8: _w[0] = _ready ? 0x8006 : 0x8000; _respond( _w, 1 ); _busyUntil = now() + 1000; break;
+    case 0x241D: if( _hasArg ) _tOffset = _arg; _busyUntil = now() + 1000; break;
+    case 0x2318: _w[0] = _tOffset; _respond( _w, 1 ); _busyUntil = now() + 1000; break;
+    case 0x2427: if( _hasArg ) _altitude = _arg; _busyUntil = now() + 1000; break;
+    case 0x2322: _w[0] = _altitude; _respond( _w, 1 ); _busyUntil = now() + 1000; break;
+    case 0xE000:
+      if( _hasArg ) _pressure = _arg;
+      else { _w[0] = _pressure; _respond( _w, 1 ); }
+      _busyUntil = now() + 1000;
+      break;
+    case 0x3682: _w[0] = 0x1234; _w[1] = 0x5678; _w[2] = 0x9ABC; _respond( _w, 3 ); _busyUntil = now() + 1000; break;
+    case 0x3639: _w[0] = 0; _respond( _w, 1 ); _busyUntil = now() + 10000000; break;
+    case 0x3632: _busyUntil = now() + 1200000; break;
+    case 0x3646: _busyUntil = now() + 30000; break;
+    case 0x3615: _busyUntil = now() + 800000; break;
+    case 0x219D: _singleShot = now() + 5000000; _ready = false; _busyUntil = _singleShot; break;
+    case 0x2196: _singleShot = now() + 50000; _ready = false; _busyUntil = _singleShot; break;
+    case 0x36E0: _sleeping = true; break;
+    case 0x36F6: break;
+    default:
+      return 1;
+  }
+  return len;
+}
+
+void sim_SCD4x::read( uint8_t *buf, uint8_t len ) {
+  for( uint8_t i=0; i < len; i++ ) buf[i] = ( i < _respLen ) ? _resp[i] : 0xFF;
+  _respLen = 0;
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * TSL2561
+ * note: bytes without the COMMAND bit get acked but ignored
+ */
+sim_TSL2561::sim_TSL2561( uint8_t addr ) : i2c_sim_device( addr, I2C_SIM_FAST_CLOCK ),
+    _light0( 0 ), _light1( 0 ), _ptr( 0 ), _word( false ), _control( 0 ), _timing( 0x02 ), _intrReg( 0 ),
+    _thLow( 0 ), _thHigh( 0 ), _ch0( 0 ), _ch1( 0 ), _cycleStart( 0 ), _outCount( 0 ), _intr( false ),
+    _cycles( 0 ) { }
+
+uint32_t sim_TSL2561::_tint( void ) const {
+  switch( _timing & 0x03 ) {
+    case 0: return 13700;
+    case 1: return 101000;
+  }
+  return 402000;
+}
+
+uint16_t sim_TSL2561::_counts( uint32_t light ) const {
+  static const uint32_t _max[3] = { 5047, 37177, 65535 };
+  uint64_t v = (uint64_t)light * ( ( _timing & 0x10 ) ? 16 : 1 ) * _tint() / 402000;
+  uint32_t m = _max[ ( _timing & 0x03 ) < 3 ? ( _timing & 0x03 ) : 2 ];
+  return (uint16_t)( v > m ? m : v );
+}
+
+void sim_TSL2561::_update( void ) {
+  if( not powered() or now() - _cycleStart < _tint() ) return;
+  uint64_t n = ( now() - _cycleStart ) / _tint();
+  _cycleStart += n * _tint();
+  _cycles += n;
+  _ch0 = _counts( _light0 );
+  _ch1 = _counts( _light1 );
+  if( ( ( _intrReg >> 4 ) & 0x03 ) == 0x01 ) {
+    uint8_t _persist = _intrReg & 0x0F;
+    if( _ch0 < _thLow or _ch0 > _thHigh ) {
+      _outCount = ( _outCount + n > 255 ) ? 255 : _outCount + n;
+      if( _outCount >= _persist ) _intr = true;
+    }
+    else {
+      _outCount = 0;
+      if( _persist==0 ) _intr = true;
+    }
+  }
+}
+
+uint8_t sim_TSL2561::_reg( uint8_t r ) {
+  switch( r & 0x0F ) {
+    case 0x00: return _control;
+    case 0x01: return _timing;
+    case 0x02: return _thLow & 0xFF;
+    case 0x03: return _thLow >> 8;
+    case 0x04: return _thHigh & 0xFF;
+    case 0x05: return _thHigh >> 8;
+    case 0x06: return _intrReg;
+    case 0x0A: return 0x50;     // TSL2561T/FN/CL, rev 0
+    case 0x0C: return _ch0 & 0xFF;
+    case 0x0D: return _ch0 >> 8;
+    case 0x0E: return _ch1 & 0xFF;
+    case 0x0F: return _ch1 >> 8;
+  }
+  return 0;
+}
+
+uint8_t sim_TSL2561::write( const uint8_t *buf, uint8_t len ) {
+  if( len==0 ) return 0;
+  if( not ( buf[0] & 0x80 ) ) return len;
+  _update();
+  _ptr = buf[0] & 0x0F;
+  _word = ( buf[0] & 0x20 ) != 0;
+  if( buf[0] & 0x40 ) { _intr = false; _outCount = 0; }
+  for( uint8_t i=1; i < len; i++ ) {
+    uint8_t r = ( _ptr + i - 1 ) & 0x0F, v = buf[i];
+    switch( r ) {
+      case 0x00:
+        if( ( v & 0x03 ) == 0x03 and not powered() ) _cycleStart = now();
+        _control = v & 0x03;
+        break;
+      case 0x01: _timing = v & 0x1B; _cycleStart = now(); break;
+      case 0x02: _thLow = ( _thLow & 0xFF00 ) | v; break;
+      case 0x03: _thLow = ( _thLow & 0x00FF ) | ( v << 8 ); break;
+      case 0x04: _thHigh = ( _thHigh & 0xFF00 ) | v; break;
+      case 0x05: _thHigh = ( _thHigh & 0x00FF ) | ( v << 8 ); break;
+      case 0x06: _intrReg = v & 0x3F; _outCount = 0; break;
+    }
+  }
+  return len;
+}
+
+void sim_TSL2561::read( uint8_t *buf, uint8_t len ) {
+  _update();
+  for( uint8_t i=0; i < len; i++ ) buf[i] = _reg( _ptr + i );
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * MAX44009
+ */
+sim_MAX44009::sim_MAX44009( uint8_t addr ) : i2c_sim_device( addr, I2C_SIM_FAST_CLOCK ),
+    _lux( 0.0f ), _ptr( 0 ), _cycleStart( now() ), _outsideSince( 0 ), _outside( false ), _conversions( 0 ) {
+  static const uint8_t _por[8] = { 0x00, 0x00, 0x03, 0x00, 0x00, 0xFF, 0x00, 0xFF };
+  memcpy( _regs, _por, sizeof(_regs) );
+}
+
+void sim_MAX44009::_update( void ) {
+  uint32_t _cycle = ( _regs[2] & 0x80 ) ? 100000 : 800000;     // continuous mode bit
+  if( now() - _cycleStart < _cycle ) return;
+  uint64_t n = ( now() - _cycleStart ) / _cycle;
+  _cycleStart += n * _cycle;
+  _conversions += n;
+
+  // lux = 2^exponent x mantissa x 0.045
+  uint8_t e = 0;
+  double m = _lux / 0.045;
+  while( m > 255.0 and e < 14 ) { m /= 2.0; e++; }
+  uint8_t _m = ( m > 255.0 ) ? 255 : (uint8_t)m;
+  _regs[3] = ( e << 4 ) | ( _m >> 4 );
+  _regs[4] = _m & 0x0F;
+
+  // threshold window
+  float _upper = (float)( 1UL << ( _regs[5] >> 4 ) ) * ( ( ( _regs[5] & 0x0F ) << 4 ) | 0x0F ) * 0.045f;
+  float _lower = (float)( 1UL << ( _regs[6] >> 4 ) ) * ( ( _regs[6] & 0x0F ) << 4 ) * 0.045f;
+  float _val = lux( _regs[3], _regs[4] );
+  if( _val > _upper or _val < _lower ) {
+    if( not _outside ) { _outside = true; _outsideSince = _cycleStart - ( n - 1 ) * _cycle; }
+    if( _cycleStart - _outsideSince >= (uint64_t)_regs[7] * 100000 ) _regs[0] |= 0x01;
+  }
+  else _outside = false;
+}
+
+uint8_t sim_MAX44009::write( const uint8_t *buf, uint8_t len ) {
+  if( len==0 ) return 0;
+  _update();
+  _ptr = buf[0] & 0x07;
+  for( uint8_t i=1; i < len; i++ ) {
+    uint8_t r = ( _ptr + i - 1 ) & 0x07;
+    if( r==1 or r==2 or r>=5 ) _regs[r] = buf[i];
+  }
+  return len;
+}
+
+void sim_MAX44009::read( uint8_t *buf, uint8_t len ) {
+  _update();
+  for( uint8_t i=0; i < len; i++ ) {
+    uint8_t r = ( _ptr + i ) & 0x07;
+    buf[i] = _regs[r];
+    if( r==0 ) _regs[0] = 0;        // interrupt status clears on read
+  }
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * MCP47X6
+ */
+sim_MCP47X6::sim_MCP47X6( uint8_t addr, uint8_t resolution ) : i2c_sim_device( addr, I2C_SIM_FAST_CLOCK ),
+    _resolution( resolution ), _dac( 0 ), _eeDac( 0 ), _config( 0 ), _eeConfig( 0 ), _busyUntil( 0 ) { }
+
+bool sim_MCP47X6::ack( bool read ) { return now() >= _busyUntil; }
+
+uint16_t sim_MCP47X6::_fromLeft( uint8_t hi, uint8_t lo ) const {
+  return ( ( hi << 8 ) | lo ) >> ( 16 - _resolution );
+}
+
+uint8_t sim_MCP47X6::write( const uint8_t *buf, uint8_t len ) {
+  if( len==0 ) return 0;
+  switch( buf[0] >> 5 ) {
+    case 0x00: case 0x01:     // volatile DAC register (right justified)
+      _config = ( _config & ~0x06 ) | ( ( buf[0] >> 3 ) & 0x06 );
+      if( len >= 2 ) _dac = ( ( ( buf[0] & 0x0F ) << 8 ) | buf[1] ) & ( ( 1 << _resolution ) - 1 );
+      break;
+    case 0x02:                // volatile memory
+    case 0x03:                // all memory
+      _config = buf[0] & 0x1F;
+      if( len >= 3 ) _dac = _fromLeft( buf[1], buf[2] );
+      if( ( buf[0] >> 5 ) == 0x03 ) { _eeConfig = _config; _eeDac = _dac; _busyUntil = i2c_sim::now() + 25000; }
+      break;
+    case 0x04:                // volatile configuration
+      _config = buf[0] & 0x1F;
+      break;
+    default:
+      return 0;
+  }
+  return len;
+}
+
+void sim_MCP47X6::read( uint8_t *buf, uint8_t len ) {
+  uint16_t _v = _dac << ( 16 - _resolution ), _ev = _eeDac << ( 16 - _resolution );
+  uint8_t _r[6] = { (uint8_t)( 0xC0 | _config ), (uint8_t)( _v >> 8 ), (uint8_t)( _v & 0xFF ),
+                    (uint8_t)( 0xC0 | _eeConfig ), (uint8_t)( _ev >> 8 ), (uint8_t)( _ev & 0xFF ) };
+  for( uint8_t i=0; i < len; i++ ) buf[i] = _r[i % 6];
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * MCP47FEB
+ */
+static bool _mcp47feb_valid( uint8_t r ) {
+  return r==0x00 or r==0x01 or r==0x08 or r==0x09 or r==0x0A or
+         r==0x10 or r==0x11 or r==0x18 or r==0x19 or r==0x1A;
+}
+
+sim_MCP47FEB::sim_MCP47FEB( uint8_t addr, uint8_t resolution ) : i2c_sim_device( addr, I2C_SIM_FAST_CLOCK ),
+    _ptr( 0 ), _busyUntil( 0 ) {
+  memset( _regs, 0, sizeof(_regs) );
+  uint16_t _mid = ( 1 << ( resolution - 1 ) ) - 1;
+  _regs[0x00] = _regs[0x01] = _regs[0x10] = _regs[0x11] = _mid;
+  _regs[0x0A] = 0x0080;                 // POR
+  _regs[0x1A] = addr & 0x7F;
+}
+
+bool sim_MCP47FEB::ack( bool read ) { return now() >= _busyUntil; }
+
+uint8_t sim_MCP47FEB::write( const uint8_t *buf, uint8_t len ) {
+  uint8_t i = 0;
+  while( i < len ) {
+    uint8_t r = buf[i] >> 3, c = ( buf[i] >> 1 ) & 0x03;
+    if( not _mcp47feb_valid( r ) ) return i;
+    if( c == 0x03 ) { _ptr = r; i++; continue; }        // read command
+    if( c != 0x00 ) { i++; continue; }                  // config bits enable/disable
+    if( i + 2 >= len ) return len;                      // incomplete data word
+    uint16_t v = ( buf[i+1] << 8 ) | buf[i+2];
+    if( r == 0x0A ) _regs[r] = ( _regs[r] & ~0x0300 ) | ( v & 0x0300 );
+    else _regs[r] = v;
+    if( r >= 0x10 ) _busyUntil = now() + 25000;        // EEPROM write cycle
+    i += 3;
+  }
+  return len;
+}
+
+void sim_MCP47FEB::read( uint8_t *buf, uint8_t len ) {
+  for( uint8_t i=0; i < len; i++ ) buf[i] = ( i & 1 ) ? ( _regs[_ptr] & 0xFF ) : ( _regs[_ptr] >> 8 );
+}
+
+
+
+/* ------------------------------------------------------------------------------
+ * SH1106
+ */
+sim_SH1106::sim_SH1106( uint8_t addr ) : i2c_sim_device( addr, I2C_SIM_FAST_CLOCK ),
+    _page( 0 ), _col( 0 ), _pending( 0 ), _on( false ), _contrast( 0x80 ) {
+  memset( _ram, 0, sizeof(_ram) );
+  clearStats();
+}
+
+void sim_SH1106::clearStats( void ) {
+  _dataBytes = 0;
+  _commandBytes = 0;
+  memset( _pageWrites, 0, sizeof(_pageWrites) );
+}
+
+void sim_SH1106::_command( uint8_t c ) {
+  _commandBytes++;
+  if( _pending ) {
+    if( _pending == 0x81 ) _contrast = c;
+    _pending = 0;
+    return;
+  }
+  if( c <= 0x0F ) _col = ( _col & 0xF0 ) | c;
+  else if( c <= 0x1F ) _col = ( _col & 0x0F ) | ( ( c & 0x0F ) << 4 );
+  else if( c >= 0xB0 and c <= 0xB7 ) _page = c & 0x07;
+  else if( c == 0xAE ) _on = false;
+  else if( c == 0xAF ) _on = true;
+  else if( c == 0x81 or c == 0xA8 or c == 0xAD or c == 0xD3 or c == 0xD5 or
+           c == 0xD9 or c == 0xDA or c == 0xDB ) _pending = c;
+}
+
+uint8_t sim_SH1106::write( const uint8_t *buf, uint8_t len ) {
+  uint8_t i = 0;
+  while( i < len ) {
+    uint8_t _ctrl = buf[i++];
+    bool _single = ( _ctrl & 0x80 ) != 0, _data = ( _ctrl & 0x40 ) != 0;
+    while( i < len ) {
+      uint8_t b = buf[i++];
+      if( _data ) {
+        _ram[_page][_col % SIM_SH1106_COLUMNS] = b;
+        _col = ( _col + 1 ) % SIM_SH1106_COLUMNS;
+        _dataBytes++;
+        _pageWrites[_page]++;
+      }
+      else _command( b );
+      if( _single ) break;
+    }
+  }
+  return len;
+}
+
+void sim_SH1106::read( uint8_t *buf, uint8_t len ) {
+  for( uint8_t i=0; i < len; i++ ) buf[i] = _on ? 0x00 : 0x40;
+}
@@ -0,0 +1,290 @@
+/*
+ * Host (linux) I2C bus simulator: behavioural devices models
+ *
+ * Register level models of the chips neOSensor supports; they honour
+ * conversion times (data registers update at end of conversion, busy
+ * devices NACK), clock stretching and maximum bus clock.
+ * Environment values (temperature, light ...) get set through setters
+ * so that conversions already elapsed keep previous values.
+ */
+
+#ifndef _I2C_MODELS_H_
+#define _I2C_MODELS_H_
+
+#include "i2c_sim.h"
+
+
+/*
+ * MCP9808 temperature sensor: continuous conversions, alert output
+ */
+class sim_MCP9808 : public i2c_sim_device {
+  public:
+    sim_MCP9808( uint8_t addr=0x18 );
+    void setTemperature( float t );
+    bool alert( void );                 // ALERT output asserted
+    uint16_t reg( uint8_t r );          // register value (as read)
+    uint32_t conversions( void ) const { return _conversions; }
+
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    void _update( void );
+    uint16_t _encode( float t ) const;
+    bool _outside( void ) const;
+    bool _critical( void ) const;
+    float _temperature;
+    uint8_t _ptr;
+    uint16_t _config, _upper, _lower, _crit, _ambient;
+    uint8_t _resolution;
+    uint64_t _convStart;
+    bool _lastOutside, _latched;
+    uint32_t _conversions;
+};
+
+
+/*
+ * SHT2x humidity + temperature sensor: hold/no-hold master commands,
+ * user register, serial number, CRC (init 0x00)
+ */
+class sim_SHT2x : public i2c_sim_device {
+  public:
+    sim_SHT2x( uint8_t addr=0x40 );
+    void setTemperature( float t ) { _temperature = t; }
+    void setHumidity( float rh ) { _humidity = rh; }
+    uint8_t userReg( void ) const { return _userReg; }
+    uint32_t conversions( void ) const { return _conversions; }
+
+    bool ack( bool read );
+    uint32_t stretch( bool read );
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    void _measure( bool rh, bool hold );
+    float _temperature, _humidity;
+    uint8_t _userReg;
+    uint8_t _resp[8];
+    uint8_t _respLen;
+    uint64_t _readyAt;      // µs, response available
+    bool _hold;
+    uint32_t _conversions;
+};
+
+
+/*
+ * SHT3x humidity + temperature sensor: single shot (with or without
+ * clock stretching), periodic and ART modes, status register, CRC
+ */
+class sim_SHT3x : public i2c_sim_device {
+  public:
+    sim_SHT3x( uint8_t addr=0x44 );
+    void setTemperature( float t ) { _update(); _temperature = t; }
+    void setHumidity( float rh ) { _update(); _humidity = rh; }
+    uint16_t status( void ) const { return _status; }
+    bool periodic( void ) const { return _period != 0; }
+    uint32_t periodMs( void ) const { return _period / 1000; }
+    uint32_t conversions( void ) { _update(); return _conversions; }
+
+    bool ack( bool read );
+    uint32_t stretch( bool read );
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    void _update( void );
+    void _result( void );
+    void _respond( uint16_t w0, int32_t w1=-1 );
+    float _temperature, _humidity;
+    uint16_t _status;
+    bool _heater;
+    uint8_t _resp[6];
+    uint8_t _respLen;
+    uint64_t _readyAt;      // µs, response (or single shot measure) available
+    uint64_t _busyUntil;    // µs, NACK until (single shot without stretching, reset)
+    bool _stretchMode;
+    uint32_t _measTime;     // µs, current repeatability
+    uint32_t _period;       // µs, periodic mode (0 means single shot)
+    uint64_t _nextResult;   // µs, periodic mode next result
+    bool _unread;           // periodic mode result not fetched
+    uint32_t _conversions;
+};
+
+
+/*
+ * SCD4x CO2 + temperature + humidity sensor: periodic, low power periodic,
+ * single shot, data ready status, commands execution times, CRC
+ */
+class sim_SCD4x : public i2c_sim_device {
+  public:
+    sim_SCD4x( uint8_t addr=0x62 );
+    void setCO2( uint16_t ppm ) { _update(); _co2 = ppm; }
+    void setTemperature( float t ) { _update(); _temperature = t; }
+    void setHumidity( float rh ) { _update(); _humidity = rh; }
+    uint32_t periodMs( void ) const { return _period / 1000; }
+    bool idle( void ) const { return _period == 0; }
+    uint32_t conversions( void ) { _update(); return _conversions; }
+    float temperatureOffset( void ) const { return _tOffset * 175.0f / 65536.0f; }
+
+    bool ack( bool read );
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    void _update( void );
+    void _respond( const uint16_t *words, uint8_t nb );
+    float _temperature, _humidity;
+    uint16_t _co2;
+    uint16_t _tOffset, _altitude, _pressure;
+    uint8_t _resp[9];
+    uint8_t _respLen;
+    uint64_t _busyUntil;    // µs, command execution
+    uint32_t _period;       // µs, periodic mode (0 means idle)
+    uint64_t _nextResult;   // µs
+    uint64_t _singleShot;   // µs, single shot result time (0 means none)
+    bool _ready;
+    bool _sleeping;
+    uint32_t _conversions;
+};
+
+
+/*
+ * TSL2561 luminosity sensor: command register, integration cycles,
+ * gain, level interrupt with persistence
+ */
+class sim_TSL2561 : public i2c_sim_device {
+  public:
+    sim_TSL2561( uint8_t addr=0x39 );
+    // light as 1x gain / 402ms counts for both channels
+    void setLight( uint32_t broadband, uint32_t ir ) { _update(); _light0 = broadband; _light1 = ir; }
+    bool intr( void ) { _update(); return _intr; }
+    bool powered( void ) const { return ( _control & 0x03 ) == 0x03; }
+    uint8_t timing( void ) const { return _timing; }
+    uint32_t cycles( void ) { _update(); return _cycles; }
+
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    void _update( void );
+    uint32_t _tint( void ) const;       // µs
+    uint16_t _counts( uint32_t light ) const;
+    uint8_t _reg( uint8_t r );
+    uint32_t _light0, _light1;
+    uint8_t _ptr;
+    bool _word;
+    uint8_t _control, _timing, _intrReg;
+    uint16_t _thLow, _thHigh;
+    uint16_t _ch0, _ch1;
+    uint64_t _cycleStart;
+    uint8_t _outCount;
+    bool _intr;
+    uint32_t _cycles;
+};
+
+
+/*
+ * MAX44009 ambient light sensor: continuous 800ms conversions, lux
+ * exponent/mantissa registers, threshold window interrupt
+ */
+class sim_MAX44009 : public i2c_sim_device {
+  public:
+    sim_MAX44009( uint8_t addr=0x4A );
+    void setLux( float lux ) { _update(); _lux = lux; }
+    bool intr( void ) { _update(); return ( _regs[1] & 0x01 ) and ( _regs[0] & 0x01 ); }
+    uint8_t reg( uint8_t r ) { _update(); return _regs[r & 0x07]; }
+    static float lux( uint8_t hi, uint8_t lo ) { return (float)( 1UL << ( hi >> 4 ) ) * ( ( ( hi & 0x0F ) << 4 ) | ( lo & 0x0F ) ) * 0.045f; }
+    uint32_t conversions( void ) { _update(); return _conversions; }
+
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    void _update( void );
+    float _lux;
+    uint8_t _ptr;
+    uint8_t _regs[8];
+    uint64_t _cycleStart;
+    uint64_t _outsideSince;
+    bool _outside;
+    uint32_t _conversions;
+};
+
+
+/*
+ * MCP47X6 (MCP4706/4716/4726) single DAC: volatile DAC and config
+ * commands, EEPROM write, 6 bytes read back
+ */
+class sim_MCP47X6 : public i2c_sim_device {
+  public:
+    sim_MCP47X6( uint8_t addr=0x60, uint8_t resolution=8 );
+    uint16_t output( void ) const { return _dac; }
+    uint8_t config( void ) const { return _config; }
+
+    bool ack( bool read );
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    uint16_t _fromLeft( uint8_t hi, uint8_t lo ) const;
+    uint8_t _resolution;
+    uint16_t _dac, _eeDac;
+    uint8_t _config, _eeConfig;
+    uint64_t _busyUntil;
+};
+
+
+/*
+ * MCP47FEBxx dual DAC: 5 bits register addresses with write/read
+ * commands, volatile and non-volatile (EEPROM) registers
+ */
+class sim_MCP47FEB : public i2c_sim_device {
+  public:
+    sim_MCP47FEB( uint8_t addr=0x60, uint8_t resolution=8 );
+    uint16_t reg( uint8_t r ) const { return _regs[r & 0x1F]; }
+
+    bool ack( bool read );
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    uint16_t _regs[32];
+    uint8_t _ptr;
+    uint64_t _busyUntil;
+};
+
+
+/*
+ * SH1106 132x64 oled controller: control bytes, commands (with
+ * arguments), page addressing, GDDRAM
+ */
+#define SIM_SH1106_COLUMNS    132
+#define SIM_SH1106_PAGES      8
+class sim_SH1106 : public i2c_sim_device {
+  public:
+    sim_SH1106( uint8_t addr=0x3C );
+    bool displayOn( void ) const { return _on; }
+    uint8_t contrast( void ) const { return _contrast; }
+    uint8_t ram( uint8_t page, uint8_t col ) const { return _ram[page & 7][col % SIM_SH1106_COLUMNS]; }
+    bool pixel( uint8_t x, uint8_t y ) const { return ( ram( y / 8, x ) >> ( y % 8 ) ) & 0x01; }
+    // statistics
+    uint32_t dataBytes( void ) const { return _dataBytes; }
+    uint32_t commandBytes( void ) const { return _commandBytes; }
+    uint32_t pageWrites( uint8_t page ) const { return _pageWrites[page & 7]; }
+    void clearStats( void );
+
+    uint8_t write( const uint8_t *buf, uint8_t len );
+    void read( uint8_t *buf, uint8_t len );
+
+  private:
+    void _command( uint8_t c );
+    uint8_t _ram[SIM_SH1106_PAGES][SIM_SH1106_COLUMNS];
+    uint8_t _page, _col;
+    uint8_t _pending;           // command awaiting its argument
+    bool _on;
+    uint8_t _contrast;
+    uint32_t _dataBytes, _commandBytes;
+    uint32_t _pageWrites[SIM_SH1106_PAGES];
+};
+
+#endif /* _I2C_MODELS_H_ */
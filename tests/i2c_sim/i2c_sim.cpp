@@ -0,0 +1,321 @@
+/*
+ * Host (linux) I2C bus simulator
+ *
+ * Bus core along with Arduino's time/gpio shim, Wire, Serial and SPIFFS
+ * instances.
+ */
+
+#include <map>
+#include <string.h>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <FS.h>
+
+#include "i2c_sim.h"
+
+
+/*
+ * Global instances
+ */
+HardwareSerial Serial;
+TwoWire Wire;
+fs::FS SPIFFS;
+
+
+
+/* ------------------------------------------------------------------------------
+ * Bus
+ */
+namespace i2c_sim {
+
+static std::map<uint8_t, i2c_sim_device *> _devices;
+static uint64_t _now_ns         = 0;
+static uint32_t _clock          = I2C_SIM_STD_CLOCK;
+static uint32_t _stretchLimit   = I2C_SIM_STRETCH_LIMIT;
+
+static uint64_t _busTime_ns     = 0;
+static uint32_t _transfers      = 0;
+static uint32_t _bytes          = 0;
+static uint32_t _errors         = 0;
+
+static bool _tracing            = true;
+static std::vector<transfer_t> _trace;
+
+static std::map<uint8_t, uint8_t> _nacks;
+static std::map<uint8_t, uint8_t> _corrupts;
+static uint8_t _sdaHold         = 0;
+
+static int _sda                 = -1;
+static int _scl                 = -1;
+static std::map<uint8_t, uint8_t> _pinMode;
+static std::map<uint8_t, uint8_t> _pinOut;
+static uint32_t _sclPulses      = 0;
+
+typedef struct { void (*isr)( void * ); void *arg; int mode; } isr_t;
+static std::map<uint8_t, isr_t> _isrs;
+
+
+void reset( void ) {
+  _devices.clear();
+  _now_ns = 0;
+  _clock = I2C_SIM_STD_CLOCK;
+  _stretchLimit = I2C_SIM_STRETCH_LIMIT;
+  clearStats();
+  _tracing = true;
+  _trace.clear();
+  _nacks.clear();
+  _corrupts.clear();
+  _sdaHold = 0;
+  _pinMode.clear();
+  _pinOut.clear();
+  _sclPulses = 0;
+  _isrs.clear();
+}
+
+void attach( i2c_sim_device *dev ) { _devices[dev->addr()] = dev; }
+void detach( uint8_t addr ) { _devices.erase( addr ); }
+i2c_sim_device *device( uint8_t addr ) {
+  auto it = _devices.find( addr );
+  return ( it == _devices.end() ) ? nullptr : it->second;
+}
+
+uint64_t now( void ) { return _now_ns / 1000; }
+void advance( uint64_t us ) { _now_ns += us * 1000; }
+
+void setClock( uint32_t hz ) { if( hz ) _clock = hz; }
+uint32_t clock( void ) { return _clock; }
+void setStretchLimit( uint32_t us ) { _stretchLimit = us; }
+
+void clearStats( void ) { _busTime_ns = 0; _transfers = 0; _bytes = 0; _errors = 0; }
+uint64_t busTime( void ) { return _busTime_ns / 1000; }
+uint32_t transfers( void ) { return _transfers; }
+uint32_t bytes( void ) { return _bytes; }
+uint32_t errors( void ) { return _errors; }
+
+void setTrace( bool enable ) { _tracing = enable; }
+const std::vector<transfer_t> &trace( void ) { return _trace; }
+void clearTrace( void ) { _trace.clear(); }
+
+void dumpTrace( FILE *out ) {
+  static const char *_status[] = { "ok", "too_long", "nack_addr", "nack_data", "bus_busy", "timeout" };
+  for( const transfer_t &t : _trace ) {
+    fprintf( out, "%10.3fms %4uus %4ukHz 0x%02x %c %2u/%-2u %-9s", t.start / 1000.0, t.duration, t.clock / 1000,
+             t.addr, t.read ? 'R' : 'W', t.done, t.len, _status[t.status <= I2C_SIM_TIMEOUT ? t.status : I2C_SIM_BUS_BUSY] );
+    for( uint8_t i=0; i < t.done and i < I2C_SIM_TRACE_BYTES; i++ ) fprintf( out, " %02x", t.data[i] );
+    fprintf( out, "%s\n", t.stop ? "" : " [Sr]" );
+  }
+}
+
+void nackNext( uint8_t addr, uint8_t count ) { _nacks[addr] = count; }
+void corruptNext( uint8_t addr, uint8_t count ) { _corrupts[addr] = count; }
+void holdSDA( uint8_t pulses ) { _sdaHold = pulses; }
+bool sdaHeld( void ) { return _sdaHold != 0; }
+
+static bool _take( std::map<uint8_t, uint8_t> &m, uint8_t addr ) {
+  auto it = m.find( addr );
+  if( it == m.end() or it->second == 0 ) return false;
+  it->second--;
+  return true;
+}
+
+
+/*
+ * A transfer: address phase, optional stretching, data bytes
+ * bits = START + 9 x (address + data bytes) [+ STOP]
+ */
+static uint8_t _transfer( uint8_t addr, bool rd, uint8_t *buf, uint8_t len, bool stop, uint8_t *done ) {
+  const uint64_t _bit_ns = 1000000000ULL / _clock;
+  uint64_t _start = _now_ns;
+  uint32_t _stretch = 0;
+  uint32_t _bits = 1 + 9 + ( stop ? 1 : 0 );
+  uint8_t _status = I2C_SIM_OK;
+  *done = 0;
+
+  i2c_sim_device *_dev = device( addr );
+
+  if( _sdaHold ) {
+    _status = I2C_SIM_BUS_BUSY;
+    _bits = 0;
+  }
+  else if( _dev==nullptr or _clock > _dev->maxClock() or _take( _nacks, addr ) or not _dev->ack( rd ) ) {
+    _status = I2C_SIM_NACK_ADDR;
+  }
+  else {
+    _stretch = _dev->stretch( rd );
+    if( _stretch > _stretchLimit ) {
+      _stretch = _stretchLimit;
+      _status = I2C_SIM_TIMEOUT;
+    }
+    else if( rd ) {
+      // device's data gets sampled once stretching is over
+      _now_ns += ( 10ULL * _bit_ns ) + _stretch * 1000ULL;
+      _dev->read( buf, len );
+      if( len and _take( _corrupts, addr ) ) buf[0] ^= 0x01;
+      *done = len;
+      _now_ns -= ( 10ULL * _bit_ns ) + _stretch * 1000ULL;
+      _bits += 9 * len;
+    }
+    else {
+      *done = _dev->write( buf, len );
+      _bits += 9 * ( *done < len ? *done + 1 : len );
+      if( *done < len ) _status = I2C_SIM_NACK_DATA;
+    }
+  }
+
+  uint64_t _dur = _bits * _bit_ns + _stretch * 1000ULL;
+  _now_ns = _start + _dur;
+  _busTime_ns += _dur;
+  _transfers++;
+  _bytes += ( _bits ? 1 : 0 ) + *done;
+  if( _status != I2C_SIM_OK ) _errors++;
+
+  if( _tracing ) {
+    transfer_t _t;
+    memset( &_t, 0, sizeof(_t) );
+    _t.start = _start / 1000;
+    _t.duration = (uint32_t)( _dur / 1000 );
+    _t.clock = _clock;
+    _t.addr = addr;
+    _t.read = rd;
+    _t.stop = stop;
+    _t.len = len;
+    _t.done = *done;
+    _t.status = _status;
+    memcpy( _t.data, buf, ( *done < I2C_SIM_TRACE_BYTES ? *done : I2C_SIM_TRACE_BYTES ) );
+    _trace.push_back( _t );
+  }
+  return _status;
+}
+
+uint8_t write( uint8_t addr, const uint8_t *buf, uint8_t len, bool stop ) {
+  uint8_t _tmp[256];
+  uint8_t _done;
+  memcpy( _tmp, buf, len );
+  return _transfer( addr, false, _tmp, len, stop, &_done );
+}
+
+uint8_t read( uint8_t addr, uint8_t *buf, uint8_t len, bool stop ) {
+  uint8_t _done;
+  _transfer( addr, true, buf, len, stop, &_done );
+  return _done;
+}
+
+
+/*
+ * Gpios: SDA is low whenever master drives it or a slave holds it,
+ * SCL low-to-high transitions driven by master are clock pulses
+ */
+void setPins( int sda, int scl ) { _sda = sda; _scl = scl; }
+
+void gpioMode( uint8_t pin, uint8_t mode ) {
+  _pinMode[pin] = mode;
+  if( mode==INPUT or mode==INPUT_PULLUP ) _pinOut[pin] = HIGH;
+}
+
+int gpioRead( uint8_t pin ) {
+  uint8_t _out = _pinOut.count( pin ) ? _pinOut[pin] : HIGH;
+  if( (int)pin == _sda and _sdaHold ) return LOW;
+  return _out;
+}
+
+void gpioWrite( uint8_t pin, uint8_t val ) {
+  uint8_t _prev = _pinOut.count( pin ) ? _pinOut[pin] : HIGH;
+  _pinOut[pin] = val;
+  if( (int)pin == _scl and _prev==LOW and val==HIGH ) {
+    _sclPulses++;
+    _now_ns += 1000000000ULL / _clock;
+    if( _sdaHold ) _sdaHold--;
+  }
+}
+
+uint32_t sclPulses( void ) { return _sclPulses; }
+
+void attachISR( uint8_t pin, void (*isr)( void * ), void *arg, int mode ) { _isrs[pin] = { isr, arg, mode }; }
+void detachISR( uint8_t pin ) { _isrs.erase( pin ); }
+
+bool interrupt( uint8_t pin ) {
+  auto it = _isrs.find( pin );
+  if( it == _isrs.end() or not ( it->second.mode & FALLING ) ) return false;
+  it->second.isr( it->second.arg );
+  return true;
+}
+
+
+uint8_t crc8( const uint8_t *data, uint8_t len, uint8_t init ) {
+  uint8_t crc = init;
+  while( len-- ) {
+    crc ^= *data++;
+    for( uint8_t bit=8; bit; --bit ) crc = ( crc & 0x80 ) ? ( crc << 1 ) ^ 0x31 : ( crc << 1 );
+  }
+  return crc;
+}
+
+} // namespace i2c_sim
+
+
+
+/* ------------------------------------------------------------------------------
+ * Arduino shim
+ */
+unsigned long millis( void ) { return (unsigned long)( i2c_sim::now() / 1000 ); }
+unsigned long micros( void ) { return (unsigned long)i2c_sim::now(); }
+void delay( unsigned long ms ) { i2c_sim::advance( (uint64_t)ms * 1000 ); }
+void delayMicroseconds( unsigned int us ) { i2c_sim::advance( us ); }
+
+void pinMode( uint8_t pin, uint8_t mode ) { i2c_sim::gpioMode( pin, mode ); }
+int digitalRead( uint8_t pin ) { return i2c_sim::gpioRead( pin ); }
+void digitalWrite( uint8_t pin, uint8_t val ) { i2c_sim::gpioWrite( pin, val ); }
+void attachInterruptArg( uint8_t pin, void (*isr)( void * ), void *arg, int mode ) { i2c_sim::attachISR( pin, isr, arg, mode ); }
+void detachInterrupt( uint8_t pin ) { i2c_sim::detachISR( pin ); }
+
+
+
+/* ------------------------------------------------------------------------------
+ * Wire
+ */
+bool TwoWire::begin( int sda, int scl, uint32_t frequency ) {
+  _sda = sda;
+  _scl = scl;
+  i2c_sim::setPins( sda, scl );
+  if( sda >= 0 ) i2c_sim::gpioMode( sda, INPUT_PULLUP );
+  if( scl >= 0 ) i2c_sim::gpioMode( scl, INPUT_PULLUP );
+  if( frequency ) i2c_sim::setClock( frequency );
+  return true;
+}
+
+bool TwoWire::end( void ) { return true; }
+void TwoWire::setClock( uint32_t frequency ) { i2c_sim::setClock( frequency ); }
+uint32_t TwoWire::getClock( void ) const { return i2c_sim::clock(); }
+void TwoWire::setClockStretchLimit( uint32_t us ) { i2c_sim::setStretchLimit( us ); }
+void TwoWire::setTimeOut( uint16_t ms ) { i2c_sim::setStretchLimit( (uint32_t)ms * 1000 ); }
+
+void TwoWire::beginTransmission( uint8_t addr ) {
+  _txAddr = addr;
+  _txLen = 0;
+  _txOverflow = false;
+}
+
+size_t TwoWire::write( uint8_t val ) {
+  if( _txLen >= sizeof(_txBuf) ) { _txOverflow = true; return 0; }
+  _txBuf[_txLen++] = val;
+  return 1;
+}
+
+size_t TwoWire::write( const uint8_t *buf, size_t len ) {
+  size_t n = 0;
+  while( n < len and write( buf[n] ) ) n++;
+  return n;
+}
+
+uint8_t TwoWire::endTransmission( bool sendStop ) {
+  if( _txOverflow ) return I2C_SIM_TOO_LONG;
+  return i2c_sim::write( _txAddr, _txBuf, (uint8_t)_txLen, sendStop );
+}
+
+uint8_t TwoWire::requestFrom( uint8_t addr, uint8_t len, bool sendStop ) {
+  if( len > sizeof(_rxBuf) ) len = sizeof(_rxBuf);
+  _rxIdx = 0;
+  _rxLen = i2c_sim::read( addr, _rxBuf, len, sendStop );
+  return _rxLen;
+}
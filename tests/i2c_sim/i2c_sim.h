@@ -0,0 +1,140 @@
+/*
+ * Host (linux) I2C bus simulator
+ *
+ * The simulated bus features:
+ * - virtual time (µs): bus transfers and Arduino's delay() advance it,
+ *   transfer duration accounts for bit times at current clock along with
+ *   clock stretching,
+ * - devices models attached at their i2c address (see i2c_models.h),
+ * - a transactions trace,
+ * - faults injection: NACKs, corrupted bytes, a slave holding SDA low
+ *   (bus recovery).
+ */
+
+#ifndef _I2C_SIM_H_
+#define _I2C_SIM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+
+/*
+ * Definitions
+ */
+#define I2C_SIM_STD_CLOCK         100000  // Hz
+#define I2C_SIM_FAST_CLOCK        400000  // Hz
+#define I2C_SIM_FASTPLUS_CLOCK    1000000 // Hz
+#define I2C_SIM_STRETCH_LIMIT     230     // µs, esp8266 Wire default
+#define I2C_SIM_TRACE_BYTES       12      // bytes kept per traced transfer
+
+// transfer status (i.e Wire's endTransmission codes)
+#define I2C_SIM_OK                0
+#define I2C_SIM_TOO_LONG          1
+#define I2C_SIM_NACK_ADDR         2
+#define I2C_SIM_NACK_DATA         3
+#define I2C_SIM_BUS_BUSY          4
+#define I2C_SIM_TIMEOUT           5
+
+
+/*
+ * Device model: behaviour of a slave at its i2c address
+ */
+class i2c_sim_device {
+  public:
+    i2c_sim_device( uint8_t addr, uint32_t maxClock=I2C_SIM_FAST_CLOCK ) : _addr( addr ), _maxClock( maxClock ) { }
+    virtual ~i2c_sim_device( void ) { }
+
+    uint8_t addr( void ) const { return _addr; }
+    uint32_t maxClock( void ) const { return _maxClock; }
+
+    // address phase: false means NACK (e.g busy device)
+    virtual bool ack( bool read ) { return true; }
+    // clock stretching (µs) after address phase
+    virtual uint32_t stretch( bool read ) { return 0; }
+    // write phase (address acked): number of data bytes acked
+    virtual uint8_t write( const uint8_t *buf, uint8_t len ) { return len; }
+    // read phase (address acked)
+    virtual void read( uint8_t *buf, uint8_t len ) { for( uint8_t i=0; i < len; i++ ) buf[i] = 0xFF; }
+
+  protected:
+    uint8_t _addr;
+    uint32_t _maxClock;
+};
+
+
+/*
+ * Simulated bus
+ */
+namespace i2c_sim {
+
+  // traced transfer
+  typedef struct {
+    uint64_t start;             // µs
+    uint32_t duration;          // µs, stretching included
+    uint32_t clock;             // Hz
+    uint8_t addr;
+    bool read;
+    bool stop;                  // false means repeated start follows
+    uint8_t len;                // requested bytes
+    uint8_t done;               // bytes transferred (acked)
+    uint8_t status;             // I2C_SIM_xxx
+    uint8_t data[I2C_SIM_TRACE_BYTES];
+  } transfer_t;
+
+  // setup
+  void reset( void );                       // detach all devices, time, trace, stats and faults
+  void attach( i2c_sim_device *dev );
+  void detach( uint8_t addr );
+  i2c_sim_device *device( uint8_t addr );
+
+  // virtual time
+  uint64_t now( void );                     // µs
+  void advance( uint64_t us );
+
+  // bus clock and clock stretching limit
+  void setClock( uint32_t hz );
+  uint32_t clock( void );
+  void setStretchLimit( uint32_t us );
+
+  // statistics (since reset or clearStats)
+  void clearStats( void );
+  uint64_t busTime( void );                 // µs the bus has been busy
+  uint32_t transfers( void );
+  uint32_t bytes( void );                   // address bytes included
+  uint32_t errors( void );
+
+  // trace
+  void setTrace( bool enable );
+  const std::vector<transfer_t> &trace( void );
+  void clearTrace( void );
+  void dumpTrace( FILE *out );
+
+  // faults injection
+  void nackNext( uint8_t addr, uint8_t count=1 );     // next 'count' address phases get NACKed
+  void corruptNext( uint8_t addr, uint8_t count=1 );  // next 'count' reads get a bit flipped
+  void holdSDA( uint8_t pulses );                     // a slave holds SDA low for 'pulses' SCL clocks
+  bool sdaHeld( void );
+
+  // Wire side
+  uint8_t write( uint8_t addr, const uint8_t *buf, uint8_t len, bool stop );  // endTransmission code
+  uint8_t read( uint8_t addr, uint8_t *buf, uint8_t len, bool stop );         // bytes read
+
+  // gpios side (bus recovery)
+  void setPins( int sda, int scl );
+  void gpioMode( uint8_t pin, uint8_t mode );
+  int gpioRead( uint8_t pin );
+  void gpioWrite( uint8_t pin, uint8_t val );
+  uint32_t sclPulses( void );               // bit-banged SCL clocks (recovery)
+
+  // gpios side (interrupts)
+  void attachISR( uint8_t pin, void (*isr)( void * ), void *arg, int mode );
+  void detachISR( uint8_t pin );
+  bool interrupt( uint8_t pin );            // falling edge on pin, false if no ISR attached
+
+  // Sensirion CRC8 (poly 0x31) helper for models
+  uint8_t crc8( const uint8_t *data, uint8_t len, uint8_t init=0xFF );
+
+} // namespace i2c_sim
+
+#endif /* _I2C_SIM_H_ */
@@ -0,0 +1,694 @@
+/*
+ * neocampus_i2c transaction layer and i2c drivers on the host I2C bus simulator
+ *
+ * L=../../neosensor/libraries; D=$L/neocampus_drivers; g++ -std=gnu++11 -O2 -Wall -DNEOSENSOR_BOARD -DESP8266 -I../i2c_sim -I$L/ArduinoJson/src -I$L/neocampus -I$D -I$L/boards i2c_sim_test.cpp ../i2c_sim/i2c_sim.cpp ../i2c_sim/i2c_models.cpp $L/neocampus/neocampus_i2c.cpp $D/generic_driver.cpp $D/driver_dac.cpp $D/Adafruit_MCP9808.cpp $D/SHT2x.cpp $D/sensirion_i2c.cpp $D/SHT3x.cpp $D/SCD4x.cpp $D/TSL2561.cpp $D/MAX44009.cpp $D/MCP47X6.cpp $D/MCP47FEB.cpp -o i2c_sim_test && ./i2c_sim_test
+ *
+ * I2C_SIM_VERBOSE=1 ./i2c_sim_test  displays drivers' logs along with the transfers trace
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "i2c_sim.h"
+#include "i2c_models.h"
+#include "neocampus.h"
+#include "neocampus_i2c.h"
+
+#include "Adafruit_MCP9808.h"
+#include "SHT2x.h"
+#include "SHT3x.h"
+#include "SCD4x.h"
+#include "sensirion_i2c.h"
+#include "TSL2561.h"
+#include "MAX44009.h"
+#include "MCP47X6.h"
+#include "MCP47FEB.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ printf("FAILED %s:%d %s\n", __FILE__, __LINE__, #cond); ++failures; } }while(0)
+
+/* per-device stat from i2c_status() */
+static long stat(uint8_t adr, const char *key){
+    for(uint8_t i = 0; i < i2c_nbDevices(); i++){
+        StaticJsonDocument<256> doc;
+        i2c_status(i, doc.to<JsonObject>());
+        if(doc["i2c_addr"] == adr) return doc[key].as<long>();
+    }
+    return -1;
+}
+
+static void dump(const char *title){
+    if(getenv("I2C_SIM_VERBOSE") == nullptr) return;
+    printf("--- %s\n", title);
+    i2c_sim::dumpTrace(stdout);
+}
+
+/* TSL2561 T package reference lux, light as 1x gain / 402ms counts */
+static float tsl_lux(float ch0, float ch1){
+    float r = ch1 / ch0, lux;
+    if(r <= 0.5f) lux = 0.0304f * ch0 - 0.062f * ch0 * powf(r, 1.4f);
+    else if(r <= 0.61f) lux = 0.0224f * ch0 - 0.031f * ch1;
+    else if(r <= 0.80f) lux = 0.0128f * ch0 - 0.0153f * ch1;
+    else if(r <= 1.30f) lux = 0.00146f * ch0 - 0.00112f * ch1;
+    else lux = 0;
+    return 16 * lux;
+}
+
+/* status, retries and errors accounting */
+static void test_transfer(){
+    i2c_sim::reset();
+    sim_MCP9808 mcp(0x18);
+    i2c_sim::attach(&mcp);
+    CHECK(i2c_begin(SDA, SCL));
+
+    uint8_t reg = 0x06, buf[2] = {0, 0}, nb;
+    CHECK(i2c_transfer(0x18, &reg, 1, buf, 2, &nb) == i2cStatus_t::ok);
+    CHECK(nb == 2 && buf[0] == 0x00 && buf[1] == 0x54);
+    CHECK(read16(0x18, 0x07) == 0x0400);
+
+    // a NACK gets retried
+    i2c_sim::nackNext(0x18);
+    CHECK(i2c_transfer(0x18, &reg, 1, buf, 2, &nb) == i2cStatus_t::ok);
+    CHECK(stat(0x18, "nacks") == 1 && stat(0x18, "retries") == 1 && stat(0x18, "errors") == 0);
+
+    // ... till retries get exhausted
+    i2c_sim::nackNext(0x18, 10);
+    CHECK(i2c_transfer(0x18, &reg, 1, buf, 2, &nb) == i2cStatus_t::nack_addr);
+    CHECK(stat(0x18, "errors") == 1 && stat(0x18, "nacks") == 1 + 1 + I2C_RETRIES);
+    CHECK(read8(0x18, 0x08) == 0xFF);
+
+    // no device
+    CHECK(i2c_transfer(0x50, &reg, 1, nullptr, 0, nullptr, 0, false, 0) == i2cStatus_t::nack_addr);
+    CHECK(stat(0x50, "errors") == 1 && stat(0x50, "retries") == 0);
+    dump("transfer");
+}
+
+/* a slave holding SDA low */
+static void test_recovery(){
+    i2c_sim::reset();
+    sim_MCP9808 mcp(0x18);
+    i2c_sim::attach(&mcp);
+
+    i2c_sim::holdSDA(3);
+    CHECK(i2c_begin(SDA, SCL));
+    CHECK(not i2c_sim::sdaHeld() && i2c_sim::sclPulses() == 3 + 1);   // clocks + STOP
+    long recoveries = stat(0x18, "recoveries");
+
+    i2c_sim::holdSDA(5);
+    CHECK(read16(0x18, 0x06) == 0x0054);
+    CHECK(stat(0x18, "recoveries") == recoveries + 1);
+    CHECK(i2c_sim::sclPulses() == 4 + 5 + 1);
+
+    // more than 9 clock pulses: recovery fails
+    i2c_sim::holdSDA(20);
+    uint8_t reg = 0x06;
+    CHECK(i2c_transfer(0x18, &reg, 1) == i2cStatus_t::bus_stuck);
+    i2c_sim::holdSDA(0);
+    dump("recovery");
+}
+
+/* per-device clock */
+static void test_clock(){
+    i2c_sim::reset();
+    sim_MCP9808 mcp(0x18);
+    sim_SCD4x scd(0x62);
+    i2c_sim::attach(&mcp);
+    i2c_sim::attach(&scd);
+    CHECK(i2c_begin(SDA, SCL, I2C_FAST_CLOCK));
+
+    // SCD4x is a standard mode device
+    uint8_t cmd[2] = {0x36, 0x82}, buf[9], nb;
+    CHECK(i2c_transfer(0x62, cmd, 2, nullptr, 0, nullptr, 0, false, 0) == i2cStatus_t::nack_addr);
+    i2c_setClock(0x62, 100000);
+    CHECK(i2c_transfer(0x62, cmd, 2, buf, 9, &nb, 1) == i2cStatus_t::ok);
+    CHECK(nb == 9 && buf[0] == 0x12 && buf[2] == i2c_sim::crc8(buf, 2));
+    CHECK(i2c_sim::trace().back().clock == 100000);
+
+    // ... while others run at bus default clock
+    CHECK(read16(0x18, 0x06) == 0x0054);
+    CHECK(i2c_sim::trace().back().clock == I2C_FAST_CLOCK);
+
+    // a read at 100kHz vs 400kHz
+    i2c_sim::clearStats();
+    read16(0x62, 0x00);
+    uint64_t slow = i2c_sim::busTime();
+    i2c_sim::clearStats();
+    read16(0x18, 0x05);
+    CHECK(i2c_sim::busTime() * 3 < slow);
+    dump("clock");
+}
+
+/* known addresses enumeration */
+static void test_enumerate(){
+    i2c_sim::reset();
+    sim_MCP9808 mcp(0x18);
+    sim_SHT3x sht(0x44);
+    sim_TSL2561 tsl(0x39);
+    i2c_sim::attach(&mcp);
+    i2c_sim::attach(&sht);
+    i2c_sim::attach(&tsl);
+    i2c_begin(SDA, SCL);
+
+    uint8_t bitmap[I2C_BITMAP_SIZE] = {0};
+    i2c_bitmap_add(bitmap, Adafruit_MCP9808::i2c_addrs, sizeof(Adafruit_MCP9808::i2c_addrs));
+    i2c_bitmap_add(bitmap, SHT3x::i2c_addrs, sizeof(SHT3x::i2c_addrs));
+
+    uint8_t found[8];
+    i2c_sim::clearStats();
+    CHECK(i2c_enumerate(bitmap, found, sizeof(found)) == 2);
+    CHECK(found[0] == 0x18 && found[1] == 0x44);
+    uint64_t known = i2c_sim::busTime();
+    i2c_sim::clearStats();
+    CHECK(i2c_enumerate(bitmap, found, sizeof(found), true) == 3);
+    printf("enumeration: known addresses %luus, full sweep %luus (bus time)\n",
+           (unsigned long)known, (unsigned long)i2c_sim::busTime());
+}
+
+/* drivers on top of the models */
+static void test_drivers(){
+    i2c_sim::reset();
+    sim_MCP9808 mcp(0x18);
+    sim_SHT2x sht2(0x40);
+    sim_SHT3x sht3(0x44);
+    sim_TSL2561 tsl(0x39);
+    sim_MAX44009 max(0x4A);
+    sim_MCP47X6 dac(0x60);
+    sim_MCP47FEB feb(0x61, 10);
+    i2c_sim_device *devs[] = { &mcp, &sht2, &sht3, &tsl, &max, &dac, &feb };
+    for(i2c_sim_device *d : devs) i2c_sim::attach(d);
+    i2c_begin(SDA, SCL);
+    delay(1000);
+
+    mcp.setTemperature(23.5f);
+    sht2.setTemperature(21.25f); sht2.setHumidity(45.0f);
+    sht3.setTemperature(-5.5f); sht3.setHumidity(80.0f);
+    tsl.setLight(2000, 500);
+    max.setLux(300.0f);
+
+    Adafruit_MCP9808 t1;
+    SHT2x t2(sht2xMeasureType_t::temperature), h2(sht2xMeasureType_t::humidity);
+    SHT3x t3(sht3xMeasureType_t::temperature), h3(sht3xMeasureType_t::humidity);
+    TSL2561 l1;
+    MAX44009 l2;
+    MCP47X6 d1;
+    MCP47FEB d2;
+
+    CHECK(Adafruit_MCP9808::is_device(0x18) && t1.begin(0x18));
+    CHECK(SHT2x::is_device(0x40) && t2.begin(0x40) && h2.begin(0x40));
+    CHECK(SHT3x::is_device(0x44) && t3.begin(0x44) && h3.begin(0x44));
+    CHECK(TSL2561::is_device(0x39) && l1.begin(0x39));
+    CHECK(MAX44009::is_device(0x4A) && l2.begin(0x4A));
+    CHECK(d1.begin(0x60) && dac.output() == 63);
+    CHECK(d2.begin(0x61) && feb.reg(0x00) == 255);
+    CHECK(sht2.userReg() == 0x02 && not tsl.powered());
+    delay(1000);
+
+    float v = 0;
+    uint64_t wall = i2c_sim::now();
+    i2c_sim::clearStats();
+    i2c_sim::clearTrace();
+    CHECK(t1.acquire(&v) && fabs(v - 23.5f) < 0.07f);
+    CHECK(t2.acquire(&v) && fabs(v - 21.25f) < 0.05f);
+    CHECK(h2.acquire(&v) && fabs(v - 45.0f) < 0.1f);
+    CHECK(t3.acquire(&v) && fabs(v + 5.5f) < 0.05f);
+    CHECK(h3.acquire(&v) && fabs(v - 80.0f) < 0.1f);
+    CHECK(not l1.acquire(&v));      // integration starts
+    CHECK(l2.acquire(&v) && fabs(v - 300.0f) < 300.0f / 32);
+    wall = i2c_sim::now() - wall;
+    printf("acquisition cycle: %u transfers, %u bytes, bus %luus, wall %lums\n", i2c_sim::transfers(),
+           i2c_sim::bytes(), (unsigned long)i2c_sim::busTime(), (unsigned long)(wall / 1000));
+    CHECK(i2c_sim::errors() == 0);
+    delay(450);
+    CHECK(l1.acquire(&v) && fabs(v - tsl_lux(2000, 500)) < tsl_lux(2000, 500) / 32);
+    CHECK(not tsl.powered());
+    dump("drivers");
+
+    // raw lux registers
+    uint8_t buf[2];
+    CHECK(readList(0x4A, 0x03, buf, 2) == 2);
+    CHECK(fabs(sim_MAX44009::lux(buf[0], buf[1]) - 300.0f) < 300.0f / 128);
+
+    // MAX44009 lux formula (datasheet): 2^exp x 8 bits mantissa x 0.045
+    CHECK(MAX44009::toLux(0x00, 0x01, &v) && fabs(v - 0.045f) < 1e-4f);
+    CHECK(MAX44009::toLux(0x17, 0x0F, &v) && fabs(v - 11.43f) < 1e-3f);
+    CHECK(MAX44009::toLux(0xEF, 0x0F, &v) && fabs(v - 188006.4f) < 1.0f);
+    CHECK(not MAX44009::toLux(0xF0, 0x00, &v));
+
+    // corrupted answer: CRC check fails, driver measures anew
+    delay(6000);
+    uint32_t conversions = sht3.conversions();
+    i2c_sim::corruptNext(0x44);
+    CHECK(t3.acquire(&v) && fabs(v + 5.5f) < 0.05f);
+    CHECK(sht3.conversions() == conversions + 2);
+    delay(6000);
+    i2c_sim::corruptNext(0x44, 3 * 3);
+    CHECK(not t3.acquire(&v));
+
+    // DACs
+    d1.setPercentOutput(50);
+    CHECK(dac.output() == 128);
+    d2.setPercentOutput(25);
+    CHECK(feb.reg(0x00) == 256);
+}
+
+/* SHT3x periodic mode: fetch latest measure, no conversion wait */
+static void test_sht3x_periodic(){
+    i2c_sim::reset();
+    sim_SHT3x sht3(0x44);
+    i2c_sim::attach(&sht3);
+    i2c_begin(SDA, SCL);
+    sht3.setTemperature(24.0f); sht3.setHumidity(40.0f);
+
+    SHT3x t3(sht3xMeasureType_t::temperature), h3(sht3xMeasureType_t::humidity);
+    CHECK(t3.begin(0x44) && h3.begin(0x44));
+    CHECK(t3.setMode(sht3xMode_t::mps_1) && sht3.periodic() && sht3.periodMs() == 1000);
+
+    float v = 0;
+    CHECK(not t3.acquire(&v));              // no measure yet
+    delay(1100);
+    uint64_t wall = i2c_sim::now();
+    i2c_sim::clearStats();
+    CHECK(t3.acquire(&v) && fabs(v - 24.0f) < 0.05f);
+    CHECK(h3.acquire(&v) && fabs(v - 40.0f) < 0.1f);
+    wall = i2c_sim::now() - wall;
+    printf("sht3x periodic: %u transfers, bus %luus, wall %luus\n", i2c_sim::transfers(),
+           (unsigned long)i2c_sim::busTime(), (unsigned long)wall);
+    CHECK(i2c_sim::transfers() == 2 && wall < 1000);
+
+    // fetched every period, cached values in between
+    sht3.setTemperature(25.0f);
+    delay(500);
+    CHECK(t3.acquire(&v) && fabs(v - 24.0f) < 0.05f);
+    delay(600);
+    CHECK(t3.acquire(&v) && fabs(v - 25.0f) < 0.05f);
+
+    // device reset: periodic mode gets restarted
+    uint8_t reset[2] = {0x30, 0xA2};
+    i2c_sim::write(0x44, reset, 2, true);
+    delay(SHT3X_SENSOR_CACHE_MS);
+    CHECK(not t3.acquire(&v) && sht3.periodic());
+    delay(1100);
+    CHECK(t3.acquire(&v) && fabs(v - 25.0f) < 0.05f);
+
+    // ART then back to single shot
+    CHECK(h3.setMode(sht3xMode_t::art) && sht3.periodMs() == 250);
+    CHECK(t3.setMode(sht3xMode_t::single_shot) && not sht3.periodic());
+    CHECK(t3.acquire(&v) && fabs(v - 25.0f) < 0.05f);
+    CHECK((sht3.status() & 0x0002) == 0);
+    dump("sht3x periodic");
+}
+
+/* two SHT3x chips (0x44 & 0x45): each one with its own mode and values */
+static void test_sht3x_two_devices(){
+    i2c_sim::reset();
+    sim_SHT3x a(0x44), b(0x45);
+    i2c_sim::attach(&a);
+    i2c_sim::attach(&b);
+    i2c_begin(SDA, SCL);
+    a.setTemperature(20.0f); b.setTemperature(30.0f);
+
+    SHT3x ta(sht3xMeasureType_t::temperature), tb(sht3xMeasureType_t::temperature);
+    CHECK(ta.begin(0x44) && ta.setMode(sht3xMode_t::mps_1) && a.periodic());
+    CHECK(tb.begin(0x45) && not b.periodic() && a.periodic());
+    CHECK(tb.setMode(sht3xMode_t::mps_2) && b.periodMs() == 500 && a.periodMs() == 1000);
+
+    float v = 0;
+    delay(1100);
+    CHECK(ta.acquire(&v) && fabs(v - 20.0f) < 0.05f);
+    CHECK(tb.acquire(&v) && fabs(v - 30.0f) < 0.05f);
+
+    CHECK(ta.setMode(sht3xMode_t::single_shot) && tb.setMode(sht3xMode_t::single_shot));
+    CHECK(not a.periodic() && not b.periodic());
+    dump("sht3x two devices");
+}
+
+/* SCD4x low power periodic measurement: one device shared by CO2, T and RH */
+static void test_scd4x(){
+    i2c_sim::reset();
+    sim_SCD4x scd(0x62);
+    i2c_sim::attach(&scd);
+    i2c_begin(SDA, SCL);
+    scd.setCO2(900); scd.setTemperature(22.0f); scd.setHumidity(45.0f);
+
+    SCD4x co2(scd4xMeasureType_t::co2), t(scd4xMeasureType_t::temperature), rh(scd4xMeasureType_t::humidity);
+    CHECK(co2.begin(0x62) && scd.periodMs() == 30000);
+    i2c_sim::clearStats();
+    CHECK(t.begin(0x62) && rh.begin(0x62));
+    CHECK(i2c_sim::transfers() == 0);       // device already identified and started
+
+    // never waits for a measure
+    float v = 0;
+    uint64_t wall = i2c_sim::now();
+    CHECK(not co2.acquire(&v) && not t.acquire(&v));
+    CHECK(i2c_sim::now() - wall < 10000);
+
+    delay(30000);
+    wall = i2c_sim::now();
+    i2c_sim::clearStats();
+    CHECK(co2.acquire(&v) && v == 900.0f);
+    CHECK(t.acquire(&v) && fabs(v - 22.0f) < 0.05f);
+    CHECK(rh.acquire(&v) && fabs(v - 45.0f) < 0.1f);
+    wall = i2c_sim::now() - wall;
+    printf("scd4x low power: %u transfers, bus %luus, wall %luus\n", i2c_sim::transfers(),
+           (unsigned long)i2c_sim::busTime(), (unsigned long)wall);
+    CHECK(i2c_sim::transfers() == 4);       // data ready status + measurement
+
+    // no bus traffic within a period
+    scd.setCO2(1000);
+    delay(10000);
+    i2c_sim::clearStats();
+    CHECK(co2.acquire(&v) && v == 900.0f && i2c_sim::transfers() == 0);
+    delay(20000);
+    CHECK(co2.acquire(&v) && v == 1000.0f);
+
+    // periodic mode, then device stopped behind our back gets restarted
+    CHECK(rh.setMode(scd4xMode_t::periodic) && scd.periodMs() == 5000);
+    uint8_t stop[2] = {0x3F, 0x86};
+    i2c_sim::write(0x62, stop, 2, true);
+    CHECK(scd.idle());
+    delay(SCD4X_STALE_PERIODS * 5000);
+    CHECK(not t.acquire(&v));              // stale: restarted
+    CHECK(not scd.idle() && scd.periodMs() == 5000);
+    delay(5000);
+    CHECK(t.acquire(&v) && fabs(v - 22.0f) < 0.05f);
+    dump("scd4x");
+}
+
+/* luminosity sensors event mode: reads only upon INT line (falling edge) */
+static void test_lux_events(){
+    i2c_sim::reset();
+    sim_TSL2561 tsl(0x39);
+    sim_MAX44009 max(0x4A), max2(0x4B);
+    i2c_sim::attach(&tsl);
+    i2c_sim::attach(&max);
+    i2c_sim::attach(&max2);
+    i2c_begin(SDA, SCL);
+    tsl.setLight(2000, 500);
+    max.setLux(300.0f);
+    max2.setLux(300.0f);
+    delay(1000);
+
+    TSL2561 l1;
+    MAX44009 l2, l3;
+    CHECK(l1.begin(0x39) && l2.begin(0x4A) && l3.begin(0x4B));
+    CHECK(l1.setEventMode(4) && l2.setEventMode(5));
+    CHECK(not l3.setEventMode(INVALID_GPIO));   // INT not wired: polling
+    CHECK(tsl.powered());
+
+    // main loop: INT lines are active low, ISRs fire on falling edges
+    bool int1 = false, int2 = false;
+    uint32_t reads = 0, polled = 0;
+    auto loop = [&](uint32_t ms){
+        for(uint32_t t = 0; t < ms; t += 100){
+            delay(100);
+            if(tsl.intr() && not int1) i2c_sim::interrupt(4);
+            if(max.intr() && not int2) i2c_sim::interrupt(5);
+            int1 = tsl.intr(); int2 = max.intr();
+            uint32_t n = i2c_sim::transfers();
+            l1.process(); l2.process();
+            reads += i2c_sim::transfers() - n;
+            n = i2c_sim::transfers();
+            l3.process();
+            polled += i2c_sim::transfers() - n;
+        }
+    };
+
+    // first reads arm windows, then nothing while light is stable
+    loop(10000);
+    CHECK(l1.getTrigger() && l2.getTrigger() && l3.getTrigger());
+    CHECK(fabs(l2.getValue() - 300.0f) < 300.0f / 32);
+    float v1 = l1.getValue();
+    l1.setDataSent(); l2.setDataSent(); l3.setDataSent();
+    reads = polled = 0;
+    loop(60000);
+    printf("lux events: stable 60s, %u transfers (event) vs %u transfers (polling)\n", reads, polled);
+    CHECK(reads == 0 && polled > 40);
+    CHECK(not l1.getTrigger() && not l2.getTrigger());
+
+    // small changes stay inside window
+    tsl.setLight(2050, 510);
+    max.setLux(310.0f);
+    loop(10000);
+    CHECK(reads == 0);
+
+    // light doubled: INT lines fire after persistence, new values get sent
+    tsl.setLight(4000, 1000);
+    max.setLux(600.0f);
+    loop(5000);
+    CHECK(reads > 0);
+    CHECK(l1.getTrigger() && l1.getValue() > 1.8f * v1);
+    CHECK(l2.getTrigger() && fabs(l2.getValue() - 600.0f) < 600.0f / 32);
+
+    // INT lines wired-OR on one gpio: its single ISR flags all drivers
+    CHECK(l3.setEventMode(5));
+    l2.setDataSent();
+    for(uint32_t t = 0; t < 3000; t += 100){ delay(100); l2.process(); l3.process(); }
+    l3.setDataSent();
+    max.setLux(1200.0f);
+    delay(3000);
+    CHECK(max.intr());
+    i2c_sim::interrupt(5);
+    for(uint32_t t = 0; t < 2000; t += 100){ delay(100); l2.process(); l3.process(); }
+    CHECK(l2.getTrigger() && fabs(l2.getValue() - 1200.0f) < 1200.0f / 32);
+    CHECK(not l3.getTrigger());         // read as well, but within its window
+    dump("lux events");
+}
+
+/* Sensirion transport: CRC, words framing, commands deadlines, status codes */
+static void test_sensirion(){
+    i2c_sim::reset();
+    sim_SHT2x sht2(0x40);
+    sim_SHT3x sht3(0x44);
+    sim_SCD4x scd(0x62);
+    i2c_sim::attach(&sht2);
+    i2c_sim::attach(&sht3);
+    i2c_sim::attach(&scd);
+    i2c_begin(SDA, SCL);
+    sht2.setTemperature(21.0f); sht2.setHumidity(40.0f);
+    sht3.setTemperature(22.0f); sht3.setHumidity(50.0f);
+    delay(1000);
+
+    // datasheets' examples
+    uint8_t w[2] = {0xBE, 0xEF};
+    CHECK(sensirion_crc8(w, 2) == 0x92);
+    uint8_t w2[2] = {0x68, 0x3A};
+    CHECK(sensirion_crc8(w2, 2, SHT2X_CRC8_INIT) == 0x7C);
+
+    // status codes
+    uint16_t words[SENSIRION_WORDS_MAX + 1];
+    CHECK(sensirion_read_cmd(0x44, 0xF32D, words, 1) == sensirionStatus_t::ok && (words[0] & 0xFC1F) == 0x8010);
+    i2c_sim::corruptNext(0x44);
+    CHECK(sensirion_read_cmd(0x44, 0xF32D, words, 1) == sensirionStatus_t::crc_error);
+    CHECK(sensirion_read_cmd(0x45, 0xF32D, words, 1) == sensirionStatus_t::i2c_error);
+    CHECK(sensirion_read_cmd(0x44, 0xF32D, words, SENSIRION_WORDS_MAX + 1) == sensirionStatus_t::invalid);
+
+    // deadlines: command execution time, non blocking check
+    uint64_t t = i2c_sim::now();
+    CHECK(sensirion_command(0x44, 0x30A2, 50) == sensirionStatus_t::ok);     // soft reset
+    CHECK(not sensirion_ready(0x44) && i2c_sim::now() - t < 2000);
+    CHECK(sensirion_read_cmd(0x44, 0xF32D, words, 1) == sensirionStatus_t::ok);
+    CHECK(i2c_sim::now() - t >= 50000 && sensirion_ready(0x44));
+
+    // batched words: SCD4x serial number
+    CHECK(sensirion_read_cmd(0x62, 0x3682, words, 3) == sensirionStatus_t::ok && (words[0] | words[1] | words[2]));
+
+    // drivers on top of it: identification then one measure each
+    // (SCD4x devices are static, see test_scd4x)
+    i2c_sim::clearStats();
+    t = i2c_sim::now();
+    SHT2x t2(sht2xMeasureType_t::temperature);
+    SHT3x t3(sht3xMeasureType_t::temperature);
+    CHECK(t2.begin(0x40) && t3.begin(0x44));
+    float v = 0;
+    CHECK(t2.acquire(&v) && fabs(v - 21.0f) < 0.05f);
+    CHECK(t3.acquire(&v) && fabs(v - 22.0f) < 0.05f);
+    t = i2c_sim::now() - t;
+    printf("sensirion: begin + measures %u transfers, %u bytes, bus %luus, wall %lums\n", i2c_sim::transfers(),
+           i2c_sim::bytes(), (unsigned long)i2c_sim::busTime(), (unsigned long)(t / 1000));
+    CHECK(i2c_sim::errors() == 0);
+    dump("sensirion");
+}
+
+/* TSL2561 auto-range: gain and integration time follow light, never waits */
+static void test_tsl2561_range(){
+    i2c_sim::reset();
+    sim_TSL2561 tsl(0x39);
+    i2c_sim::attach(&tsl);
+    i2c_begin(SDA, SCL);
+    tsl.setLight(2000, 500);
+
+    TSL2561 l1;
+    CHECK(l1.begin(0x39));
+
+    // acquire as main loop does (every 100ms), returns first valid value
+    uint64_t longest = 0;
+    auto acquire = [&](float *v, uint32_t *ms){
+        uint64_t start = i2c_sim::now();
+        for(*ms = 0; *ms < 5000; *ms += 100){
+            uint64_t t = i2c_sim::now();
+            bool ok = l1.acquire(v);
+            if(i2c_sim::now() - t > longest) longest = i2c_sim::now() - t;
+            if(ok){ *ms = (i2c_sim::now() - start) / 1000; return true; }
+            delay(100);
+        }
+        return false;
+    };
+
+    // default 402ms / 16x
+    float v = 0; uint32_t ms;
+    CHECK(acquire(&v, &ms) && fabs(v - tsl_lux(2000, 500)) < tsl_lux(2000, 500) / 32);
+    CHECK(tsl.timing() == 0x12 && ms < 600);
+
+    // sunlight: saturated steps get skipped down to 101ms / 1x
+    tsl.setLight(100000, 25000);
+    CHECK(acquire(&v, &ms) && fabs(v - tsl_lux(100000, 25000)) < tsl_lux(100000, 25000) / 32);
+    CHECK(tsl.timing() == 0x01);
+    printf("tsl2561 auto-range: sunlight %.0f lux after %ums\n", v, ms);
+
+    // full sunlight: 13ms / 1x
+    tsl.setLight(145000, 36000);
+    CHECK(acquire(&v, &ms) && tsl.timing() == 0x00);
+    CHECK(fabs(v - tsl_lux(145000, 36000)) < tsl_lux(145000, 36000) / 32);
+
+    // small decrease: hysteresis keeps settings
+    tsl.setLight(130000, 32500);
+    CHECK(acquire(&v, &ms) && tsl.timing() == 0x00);
+    CHECK(fabs(v - tsl_lux(130000, 32500)) < tsl_lux(130000, 32500) / 32);
+
+    // overcast: 402ms / 1x
+    tsl.setLight(5000, 1250);
+    CHECK(acquire(&v, &ms) && tsl.timing() == 0x02);
+    CHECK(fabs(v - tsl_lux(5000, 1250)) < tsl_lux(5000, 1250) / 32);
+
+    // darkness: up to 402ms / 16x
+    tsl.setLight(20, 5);
+    CHECK(acquire(&v, &ms) && tsl.timing() == 0x12);
+    CHECK(fabs(v - tsl_lux(20, 5)) < 1.0f);
+    printf("tsl2561 auto-range: darkness %.1f lux after %ums, longest acquire %luus\n", v, ms, (unsigned long)longest);
+
+    // no acquire ever waits for integration
+    CHECK(longest < 2000);
+    CHECK(not tsl.powered());
+
+    // fixed settings
+    l1.enableAutoRange(false);
+    l1.setGain(TSL2561_GAIN_1X);
+    l1.setTiming(TSL2561_INTEGRATIONTIME_13MS);
+    CHECK(acquire(&v, &ms) && tsl.timing() == 0x00 && v < 2);
+    CHECK(i2c_sim::errors() == 0);
+    dump("tsl2561 range");
+}
+
+/* MCP9808 alert mode: reads upon ALERT line, or Ta flags poll without it */
+static void test_mcp9808_alert(){
+    i2c_sim::reset();
+    sim_MCP9808 mcp(0x18), mcp2(0x19);
+    i2c_sim::attach(&mcp);
+    i2c_sim::attach(&mcp2);
+    i2c_begin(SDA, SCL);
+    mcp.setTemperature(21.0f);
+    mcp2.setTemperature(21.0f);
+
+    Adafruit_MCP9808 t1, t2;
+    CHECK(t1.begin(0x18) && t2.begin(0x19));
+    t1.setResolution(MCP9808_RESOLUTION_0125DEG); t1.powerOFF();
+    t2.setResolution(MCP9808_RESOLUTION_0125DEG); t2.powerOFF();
+    CHECK(t1.setAlertMode(6));
+    CHECK(not t2.setAlertMode(INVALID_GPIO));   // no ALERT line: Ta flags poll
+
+    bool alert = false;
+    uint32_t reads = 0, polled = 0;
+    auto loop = [&](uint32_t ms){
+        for(uint32_t t = 0; t < ms; t += 250){
+            delay(250);
+            if(mcp.alert() && not alert) i2c_sim::interrupt(6);
+            alert = mcp.alert();
+            uint32_t n = i2c_sim::transfers();
+            t1.process(0, 3);
+            reads += i2c_sim::transfers() - n;
+            n = i2c_sim::transfers();
+            t2.process(0, 3);
+            polled += i2c_sim::transfers() - n;
+        }
+    };
+
+    loop(2000);
+    CHECK(t1.getTrigger() && fabs(t1.getValue() - 21.0f) < 0.07f);
+    CHECK(t2.getTrigger() && fabs(t2.getValue() - 21.0f) < 0.07f);
+    CHECK(not alert && (mcp.reg(0x01) & 0x0100) == 0);
+    t1.setDataSent(); t2.setDataSent();
+
+    // stable temperature: no traffic with ALERT line, a single Ta read per poll otherwise
+    reads = polled = 0;
+    mcp.setTemperature(21.1f);
+    mcp2.setTemperature(21.1f);
+    loop(60000);
+    printf("mcp9808 alert: stable 60s, %u transfers (ALERT line) vs %u transfers (Ta flags poll)\n", reads, polled);
+    CHECK(reads == 0 && polled <= 2 * 49);
+    CHECK(not t1.getTrigger() && not t2.getTrigger());
+
+    // fast swing gets reported at once (no stability counter)
+    mcp.setTemperature(23.0f);
+    mcp2.setTemperature(23.0f);
+    loop(500);
+    CHECK(t1.getTrigger() && fabs(t1.getValue() - 23.0f) < 0.07f);
+    loop(1000);
+    CHECK(t2.getTrigger() && fabs(t2.getValue() - 23.0f) < 0.07f);
+    dump("mcp9808 alert");
+}
+
+/* raw exchanges: SCD4x commands, SH1106 without driver */
+static void test_raw(){
+    i2c_sim::reset();
+    sim_SCD4x scd(0x62);
+    sim_SH1106 oled(0x3C);
+    i2c_sim::attach(&scd);
+    i2c_sim::attach(&oled);
+    i2c_begin(SDA, SCL);
+    i2c_setClock(0x62, 100000);
+    i2c_setClock(0x3C, I2C_FAST_CLOCK);
+
+    // SCD4x low power periodic measurement
+    scd.setCO2(850);
+    uint8_t start[2] = {0x21, 0xAC}, ready[2] = {0xE4, 0xB8}, meas[2] = {0xEC, 0x05}, buf[9], nb;
+    CHECK(i2c_transfer(0x62, start, 2) == i2cStatus_t::ok && scd.periodMs() == 30000);
+    CHECK(i2c_transfer(0x62, ready, 2, buf, 3, &nb, 1) == i2cStatus_t::ok && (buf[1] & 0x07) == 0);
+    CHECK(i2c_transfer(0x62, meas, 2, buf, 9, &nb, 1, false, 0) == i2cStatus_t::nack_addr);
+    delay(30000);
+    CHECK(i2c_transfer(0x62, ready, 2, buf, 3, &nb, 1) == i2cStatus_t::ok && (buf[1] & 0x07) != 0);
+    CHECK(i2c_transfer(0x62, meas, 2, buf, 9, &nb, 1) == i2cStatus_t::ok && nb == 9);
+    CHECK((buf[0] << 8 | buf[1]) == 850 && buf[2] == i2c_sim::crc8(buf, 2) && buf[8] == i2c_sim::crc8(&buf[6], 2));
+
+    // SH1106: a command stream then a page of data
+    uint8_t cmds[] = {0x00, 0xAE, 0x81, 0x40, 0xB2, 0x02, 0x10, 0xAF};
+    CHECK(i2c_transfer(0x3C, cmds, sizeof(cmds)) == i2cStatus_t::ok);
+    CHECK(oled.displayOn() && oled.contrast() == 0x40 && oled.commandBytes() == 7);
+    uint8_t data[1 + 128];
+    data[0] = 0x40;
+    for(int i = 1; i < (int)sizeof(data); i++) data[i] = (uint8_t)i;
+    CHECK(i2c_transfer(0x3C, data, 64 + 1) == i2cStatus_t::ok);
+    CHECK(oled.pageWrites(2) == 64 && oled.ram(2, 2) == 1 && oled.ram(2, 65) == 64 && oled.pixel(2, 16));
+}
+
+int main(){
+    test_transfer();
+    test_recovery();
+    test_clock();
+    test_enumerate();
+    test_drivers();
+    test_sensirion();
+    test_sht3x_periodic();
+    test_sht3x_two_devices();
+    test_scd4x();
+    test_tsl2561_range();
+    test_lux_events();
+    test_mcp9808_alert();
+    test_raw();
+    printf("%s (%d failures)\n", failures ? "KO" : "OK", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * lcc_sensor piecewise-linear conversion tables host test
+ *
+ * g++ -std=c++11 -O2 -Wall -I../../neosensor/libraries/neocampus_drivers lcc_ppm_test.cpp ../../neosensor/libraries/neocampus_drivers/lcc_ppm.cpp -o lcc_ppm_test && ./lcc_ppm_test
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "lcc_ppm.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ printf("FAILED %s:%d %s\n", __FILE__, __LINE__, #cond); ++failures; } }while(0)
+
+/* former lcc_sensor::calculatePPM */
+static float legacy_ohm(uint32_t rgain, uint32_t mv){
+    return (float)rgain*(5000-mv)/mv;
+}
+
+/* default tables against the float formula over the whole ADC range */
+static void test_resistance(){
+    const uint32_t rgains[] = { 10000, 100000, 1000000, 10000000 };
+    for(uint32_t rgain : rgains){
+        lcc_ppm_table t;
+        CHECK(t.setResistance(rgain));
+        CHECK(t.size() > 2 && t.size() <= LCC_PPM_MAX_POINTS);
+        double worst = 0;
+        for(uint32_t mv = LCC_PPM_DEFL_MV_MIN; mv <= LCC_PPM_DEFL_MV_MAX; mv++){
+            double ref = legacy_ohm(rgain, mv);
+            double err = fabs(t.value(mv) - ref) / ref;
+            if(err > worst) worst = err;
+        }
+        printf("Rgain=%8u points=%u frac=%d max rel. error=%.4f%%\n", rgain, t.size(), t.frac(), worst*100);
+        CHECK(worst < 0.005);
+
+        // saturation outside of the table
+        CHECK(t.value(0) == t.value(LCC_PPM_DEFL_MV_MIN));
+        CHECK(t.value(4095) == t.value(LCC_PPM_DEFL_MV_MAX));
+        // monotonic (decreasing resistance)
+        for(uint32_t mv = 1; mv < 4000; mv++)
+            CHECK(t.lookup(mv+1) <= t.lookup(mv));
+    }
+}
+
+/* calibration points are exact, interpolation in between */
+static void test_calibration(){
+    const uint16_t mv[] = { 100, 500, 1200, 2500 };
+    const float ppm[] = { 0.0f, 0.5f, 2.0f, 10.0f };
+    lcc_ppm_table t;
+    CHECK(t.set(mv, ppm, 4));
+    CHECK(t.frac() == LCC_PPM_MAX_FRAC);
+    for(int i = 0; i < 4; i++)
+        CHECK(fabs(t.value(mv[i]) - ppm[i]) < 1e-4);
+    CHECK(fabs(t.value(300) - 0.25f) < 1e-4);
+    CHECK(fabs(t.value(1850) - 6.0f) < 1e-4);
+    CHECK(t.value(50) == 0.0f);
+    CHECK(fabs(t.value(3000) - 10.0f) < 1e-4);
+
+    // single point table is a constant
+    CHECK(t.set(mv, ppm + 3, 1));
+    CHECK(fabs(t.value(10) - 10.0f) < 1e-4 && fabs(t.value(4000) - 10.0f) < 1e-4);
+}
+
+static void test_invalid(){
+    lcc_ppm_table t;
+    CHECK(t.value(1000) == -1.0f);
+    const uint16_t unsorted[] = { 100, 100, 200 };
+    const uint16_t sorted[] = { 100, 150, 200 };
+    const float ok[] = { 1, 2, 3 };
+    const float negative[] = { 1, -2, 3 };
+    CHECK(!t.set(unsorted, ok, 3));
+    CHECK(!t.set(sorted, negative, 3));
+    CHECK(!t.set(sorted, ok, 0));
+    CHECK(!t.set(sorted, ok, LCC_PPM_MAX_POINTS + 1));
+    CHECK(t.size() == 0 && t.value(150) == -1.0f);
+
+    // huge values get negative fractional bits
+    const float huge[] = { 1e12f, 1e11f, 1e10f };
+    CHECK(t.set(sorted, huge, 3));
+    CHECK(t.frac() < 0);
+    CHECK(fabs(t.value(100) - 1e12f) / 1e12f < 1e-3);
+}
+
+/* table lookup vs float formula throughput */
+static void bench(){
+    lcc_ppm_table t;
+    t.setResistance(1000000);
+    volatile float sink = 0;
+    const int loops = 200;
+    clock_t c0 = clock();
+    for(int l = 0; l < loops; l++)
+        for(uint32_t mv = 1; mv < 4096; mv++) sink += t.value(mv);
+    clock_t c1 = clock();
+    for(int l = 0; l < loops; l++)
+        for(uint32_t mv = 1; mv < 4096; mv++) sink += legacy_ohm(1000000, mv);
+    clock_t c2 = clock();
+    printf("table: %.1f ns/conversion, float formula: %.1f ns/conversion\n",
+           1e9 * (c1 - c0) / CLOCKS_PER_SEC / (loops * 4095.0),
+           1e9 * (c2 - c1) / CLOCKS_PER_SEC / (loops * 4095.0));
+}
+
+int main(){
+    test_resistance();
+    test_calibration();
+    test_invalid();
+    bench();
+    printf("%s (%d failures)\n", failures ? "KO" : "OK", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,327 @@
+/*
+ * pm_serial frames parsers host test + fuzz / throughput harness
+ *
+ * g++ -std=c++11 -O2 -Wall -I../../neosensor/libraries/neocampus_drivers pm_parsers_test.cpp ../../neosensor/libraries/neocampus_drivers/pm_parsers.cpp -o pm_parsers_test && ./pm_parsers_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "pm_parsers.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ printf("FAILED %s:%d %s\n", __FILE__, __LINE__, #cond); ++failures; } }while(0)
+
+typedef std::vector<uint8_t> bytes;
+
+/* frames captured from sensors */
+static const uint8_t pms5003_frame[] = {    // PM2_5=8 PM10=10
+    0x42, 0x4D, 0x00, 0x1C, 0x00, 0x05, 0x00, 0x08, 0x00, 0x0A, 0x00, 0x05, 0x00, 0x08, 0x00, 0x0A,
+    0x03, 0x1E, 0x00, 0xE1, 0x00, 0x2A, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x97, 0x00, 0x02, 0xA2 };
+static const uint8_t sds011_frame[] = {     // PM2_5=12 PM10=23
+    0xAA, 0xC0, 0x7B, 0x00, 0xEA, 0x00, 0x12, 0x34, 0xAB, 0xAB };
+static const uint8_t ikea_frame[] = {       // PM2_5=28 PM10=42
+    0x16, 0x11, 0x0B, 0x00, 0x00, 0x00, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0x00,
+    0x00, 0x00, 0x00, 0x88 };
+static const uint8_t mhz19_frame[] = {      // CO2=608
+    0xFF, 0x86, 0x02, 0x60, 0x47, 0x00, 0x00, 0x00, 0xD1 };
+
+/* SPS30: datasheet answers + a measured values frame featuring stuffed bytes
+ * PM1=3.75 PM2_5=4.5 PM4=5.25 PM10=15.875 NC0_5=25.5 NC1=30.25 NC2_5=9.0625 NC4=30.5 NC10=30.75 size=0.5 */
+static const uint8_t sps30_start_ack[] = { 0x7E, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x7E };
+static const uint8_t sps30_read_empty[] = { 0x7E, 0x00, 0x03, 0x00, 0x00, 0xFC, 0x7E };
+static const uint8_t sps30_frame[] = {
+    0x7E, 0x00, 0x03, 0x00, 0x28, 0x40, 0x70, 0x00, 0x00, 0x40, 0x90, 0x00, 0x00, 0x40, 0xA8, 0x00,
+    0x00, 0x41, 0x7D, 0x5E, 0x00, 0x00, 0x41, 0xCC, 0x00, 0x00, 0x41, 0xF2, 0x00, 0x00, 0x41, 0x7D,
+    0x31, 0x00, 0x00, 0x41, 0xF4, 0x00, 0x00, 0x41, 0xF6, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x70,
+    0x7E };
+
+/* frames builders (random values for the fuzz harness) */
+static bytes build_pmsx003(uint16_t pm25, uint16_t pm10, bool short_frame){
+    uint16_t words[13] = { 1, 2, 3, 4, pm25, pm10, 100, 50, 10, 1, 0, 0, 0x9700 };
+    uint8_t nwords = short_frame ? 9 : 13;
+    bytes f = { 0x42, 0x4D, 0x00, (uint8_t)(2 * nwords + 2) };
+    for(uint8_t i = 0; i < nwords; ++i){
+        f.push_back(words[i] >> 8);
+        f.push_back(words[i] & 0xFF);
+    }
+    uint16_t cs = 0;
+    for(uint8_t b : f) cs += b;
+    f.push_back(cs >> 8);
+    f.push_back(cs & 0xFF);
+    return f;
+}
+
+static bytes build_sds011(uint16_t pm25, uint16_t pm10){
+    uint16_t r25 = pm25 * 10, r10 = pm10 * 10;
+    bytes d = { (uint8_t)r25, (uint8_t)(r25 >> 8), (uint8_t)r10, (uint8_t)(r10 >> 8), 0x12, 0x34 };
+    uint8_t cs = 0;
+    for(uint8_t b : d) cs += b;
+    bytes f = { 0xAA, 0xC0 };
+    f.insert(f.end(), d.begin(), d.end());
+    f.push_back(cs);
+    f.push_back(0xAB);
+    return f;
+}
+
+static bytes build_ikea(uint16_t pm25, uint16_t pm10){
+    bytes f = { 0x16, 0x11, 0x0B };
+    for(uint8_t i = 0; i < 16; ++i)
+        f.push_back(0);
+    f[3 + 2] = pm25 >> 8; f[3 + 3] = pm25 & 0xFF;
+    f[3 + 10] = pm10 >> 8; f[3 + 11] = pm10 & 0xFF;
+    uint8_t cs = 0;
+    for(uint8_t b : f) cs += b;
+    f.push_back((uint8_t)(0 - cs));
+    return f;
+}
+
+static bytes build_mhz1x(uint16_t co2){
+    bytes f = { 0xFF, 0x86, (uint8_t)(co2 >> 8), (uint8_t)(co2 & 0xFF), 0x47, 0x00, 0x00, 0x00 };
+    uint8_t cs = 0;
+    for(size_t i = 1; i < f.size(); ++i)
+        cs += f[i];
+    f.push_back((uint8_t)(~cs + 1));
+    return f;
+}
+
+static bytes build_sps30(float pm1){
+    float vals[10] = { pm1, 4.5f, 5.25f, 15.875f, 25.5f, 30.25f, 9.0625f, 30.5f, 30.75f, 0.5f };
+    bytes body = { 0x00, 0x03, 0x00, 40 };
+    for(float v : vals){
+        uint32_t raw;
+        memcpy(&raw, &v, sizeof(raw));
+        for(int sh = 24; sh >= 0; sh -= 8)
+            body.push_back((raw >> sh) & 0xFF);
+    }
+    uint8_t cs = 0;
+    for(uint8_t b : body) cs += b;
+    body.push_back((uint8_t)~cs);
+    bytes f = { 0x7E };
+    for(uint8_t b : body){
+        if(b == 0x7E || b == 0x7D || b == 0x11 || b == 0x13){
+            f.push_back(0x7D);
+            b ^= 0x20;
+        }
+        f.push_back(b);
+    }
+    f.push_back(0x7E);
+    return f;
+}
+
+/* feed a whole buffer one byte at a time, count frames */
+static int feed_bytes(pm_parser &p, const uint8_t *buf, size_t len){
+    int n = 0;
+    for(size_t i = 0; i < len; ++i)
+        n += p.feed(buf[i]) ? 1 : 0;
+    return n;
+}
+
+static pm_parser *new_parser(int k){
+    switch(k){
+        case 0: return new pmsx003_parser();
+        case 1: return new sds011_parser();
+        case 2: return new ikea_parser();
+        case 3: return new mhz1x_parser();
+        default: return new sps30_parser();
+    }
+}
+
+static void test_captured_frames(){
+    pmsx003_parser pms;
+    CHECK(feed_bytes(pms, pms5003_frame, sizeof(pms5003_frame)) == 1);
+    CHECK(pms.value(0) == 8 && pms.value(1) == 10 && pms.nbValues() == 2);
+
+    sds011_parser sds;
+    CHECK(feed_bytes(sds, sds011_frame, sizeof(sds011_frame)) == 1);
+    CHECK(sds.value(0) == 12 && sds.value(1) == 23);
+
+    ikea_parser ikea;
+    CHECK(feed_bytes(ikea, ikea_frame, sizeof(ikea_frame)) == 1);
+    CHECK(ikea.value(0) == 28 && ikea.value(1) == 42);
+
+    mhz1x_parser mhz;
+    CHECK(feed_bytes(mhz, mhz19_frame, sizeof(mhz19_frame)) == 1);
+    CHECK(mhz.value(0) == 608 && mhz.nbValues() == 1);
+
+    sps30_parser sps;
+    CHECK(feed_bytes(sps, sps30_start_ack, sizeof(sps30_start_ack)) == 0);
+    CHECK(sps.command() == SPS30_CMD_START && sps.status() == 0 && sps.stats()->frames == 1);
+    CHECK(feed_bytes(sps, sps30_read_empty, sizeof(sps30_read_empty)) == 0);
+    CHECK(sps.command() == SPS30_CMD_READ && sps.stats()->frames == 2);
+    CHECK(feed_bytes(sps, sps30_frame, sizeof(sps30_frame)) == 1);
+    CHECK(sps.value(0) == 3.75f && sps.value(1) == 4.5f && sps.value(3) == 15.875f);
+    CHECK(sps.value(6) == 9.0625f && sps.value(9) == 0.5f && sps.nbValues() == 10);
+    CHECK(sps.stats()->errors == 0);
+
+    /* device error state: valid frame, command failure */
+    const uint8_t sps30_nack[] = { 0x7E, 0x00, 0x10, 0x43, 0x00, 0xAC, 0x7E };
+    CHECK(feed_bytes(sps, sps30_nack, sizeof(sps30_nack)) == 0);
+    CHECK(sps.command() == SPS30_CMD_SLEEP && sps.status() == 0x43 && sps.stats()->errors == 1);
+}
+
+static void test_sps30_encoder(){
+    /* datasheet MOSI frames */
+    uint8_t buf[SPS30_FRAME_MAXLEN];
+    const uint8_t start_data[] = { 0x01, 0x03 };
+    const uint8_t start[] = { 0x7E, 0x00, 0x00, 0x02, 0x01, 0x03, 0xF9, 0x7E };
+    const uint8_t stop[]  = { 0x7E, 0x00, 0x01, 0x00, 0xFE, 0x7E };
+    const uint8_t read[]  = { 0x7E, 0x00, 0x03, 0x00, 0xFC, 0x7E };
+    const uint8_t sleep[] = { 0x7E, 0x00, 0x10, 0x00, 0xEF, 0x7E };
+    const uint8_t wake[]  = { 0x7E, 0x00, 0x7D, 0x31, 0x00, 0xEE, 0x7E };   // 0x11 gets stuffed
+    const uint8_t clean[] = { 0x7E, 0x00, 0x56, 0x00, 0xA9, 0x7E };
+    size_t n;
+    n = sps30_parser::encode(buf, sizeof(buf), SPS30_CMD_START, start_data, sizeof(start_data));
+    CHECK(n == sizeof(start) && memcmp(buf, start, n) == 0);
+    n = sps30_parser::encode(buf, sizeof(buf), SPS30_CMD_STOP);
+    CHECK(n == sizeof(stop) && memcmp(buf, stop, n) == 0);
+    n = sps30_parser::encode(buf, sizeof(buf), SPS30_CMD_READ);
+    CHECK(n == sizeof(read) && memcmp(buf, read, n) == 0);
+    n = sps30_parser::encode(buf, sizeof(buf), SPS30_CMD_SLEEP);
+    CHECK(n == sizeof(sleep) && memcmp(buf, sleep, n) == 0);
+    n = sps30_parser::encode(buf, sizeof(buf), SPS30_CMD_WAKEUP);
+    CHECK(n == sizeof(wake) && memcmp(buf, wake, n) == 0);
+    n = sps30_parser::encode(buf, sizeof(buf), SPS30_CMD_CLEANING);
+    CHECK(n == sizeof(clean) && memcmp(buf, clean, n) == 0);
+    CHECK(sps30_parser::encode(buf, 4, SPS30_CMD_READ) == 0);
+}
+
+static void test_split_frames(){
+    /* every possible split point of a frame across two feed() calls */
+    for(size_t cut = 0; cut < sizeof(pms5003_frame); ++cut){
+        pmsx003_parser pms;
+        size_t used = 0;
+        CHECK(!pms.feed(pms5003_frame, cut, &used) && used == cut);
+        CHECK(pms.feed(pms5003_frame + cut, sizeof(pms5003_frame) - cut, &used));
+        CHECK(used == sizeof(pms5003_frame) - cut && pms.value(0) == 8);
+    }
+    /* short PMSA003 frames */
+    pmsx003_parser pms;
+    bytes f = build_pmsx003(35, 60, true);
+    CHECK(feed_bytes(pms, f.data(), f.size()) == 1 && pms.value(0) == 35 && pms.value(1) == 60);
+
+    /* SPS30 split anywhere, including between escape byte and stuffed one */
+    for(size_t cut = 0; cut < sizeof(sps30_frame); ++cut){
+        sps30_parser sps;
+        CHECK(!sps.feed(sps30_frame, cut));
+        CHECK(sps.feed(sps30_frame + cut, sizeof(sps30_frame) - cut) && sps.value(3) == 15.875f);
+    }
+}
+
+static void test_corrupted_frames(){
+    /* any single byte flip is rejected and the next frame still gets decoded */
+    const uint8_t *frames[] = { pms5003_frame, sds011_frame, ikea_frame, mhz19_frame, sps30_frame };
+    size_t sizes[] = { sizeof(pms5003_frame), sizeof(sds011_frame), sizeof(ikea_frame), sizeof(mhz19_frame), sizeof(sps30_frame) };
+    for(int k = 0; k < 5; ++k){
+        for(size_t i = 0; i < sizes[k]; ++i){
+            pm_parser *p = new_parser(k);
+            bytes bad(frames[k], frames[k] + sizes[k]);
+            bad[i] ^= 0x01;
+            CHECK(feed_bytes(*p, bad.data(), bad.size()) == 0);
+            CHECK(feed_bytes(*p, frames[k], sizes[k]) == 1);
+            delete p;
+        }
+    }
+    /* repeated sync bytes before a frame */
+    pmsx003_parser pms;
+    const uint8_t pre[] = { 0x42, 0x42, 0x42 };
+    CHECK(feed_bytes(pms, pre, sizeof(pre)) == 0);
+    CHECK(feed_bytes(pms, pms5003_frame, sizeof(pms5003_frame)) == 1);
+}
+
+/* fuzz harness: noise between frames, random chunks
+ * sync_free: noise never contains the first sync byte (no frame shall get lost) */
+static uint32_t rnd_state = 12345;
+static uint32_t rnd(){
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static void fuzz(const char *name, pm_parser &p, int type, uint8_t sync1, bool sync_free, int nframes){
+    bytes stream;
+    std::vector<uint16_t> expected;
+    for(int i = 0; i < nframes; ++i){
+        int noise = rnd() % 24;
+        for(int j = 0; j < noise; ++j){
+            uint8_t b = rnd() & 0xFF;
+            if(sync_free && b == sync1)
+                b ^= 0x01;
+            stream.push_back(b);
+        }
+        uint16_t v = rnd() % 1000;
+        bytes f = (type == 0) ? build_pmsx003(v, v + 1, rnd() & 1) :
+                  (type == 1) ? build_sds011(v, v + 1) :
+                  (type == 2) ? build_ikea(v, v + 1) :
+                  (type == 3) ? build_mhz1x(v) : build_sps30(v);
+        stream.insert(stream.end(), f.begin(), f.end());
+        expected.push_back(v);
+    }
+
+    int decoded = 0, wrong = 0;
+    size_t pos = 0;
+    while(pos < stream.size()){
+        size_t chunk = 1 + rnd() % 40;
+        if(chunk > stream.size() - pos)
+            chunk = stream.size() - pos;
+        size_t used = 0;
+        while(chunk){
+            bool frame = p.feed(stream.data() + pos, chunk, &used);
+            pos += used;
+            chunk -= used;
+            if(!frame)
+                continue;
+            // frames are only skipped, never reordered
+            while(decoded < (int)expected.size() && expected[decoded] != p.value(0))
+                ++decoded, ++wrong;
+            ++decoded;
+        }
+    }
+    int lost = wrong;
+    printf("  %-8s %s noise: %d frames, %d lost, %u errors, %u discarded bytes\n", name,
+           sync_free ? "sync-free" : "random   ", nframes, lost,
+           (unsigned)p.stats()->errors, (unsigned)p.stats()->discarded);
+    if(sync_free)
+        CHECK(lost == 0 && decoded == nframes);
+    else
+        CHECK(lost * 100 <= nframes * 2);   // frame start hidden in noise: <2% lost
+}
+
+static void test_fuzz(){
+    const uint8_t sync[] = { 0x42, 0xAA, 0x16, 0xFF, 0x7E };
+    const char *names[] = { "PMSx003", "SDS011", "IKEA", "MH-Z1x", "SPS30" };
+    for(int k = 0; k < 5; ++k){
+        for(int sf = 1; sf >= 0; --sf){
+            pm_parser *p = new_parser(k);
+            fuzz(names[k], *p, k, sync[k], sf, 20000);
+            delete p;
+        }
+    }
+}
+
+static void test_throughput(){
+    bytes stream;
+    while(stream.size() < (8u << 20))
+        stream.insert(stream.end(), pms5003_frame, pms5003_frame + sizeof(pms5003_frame));
+    pmsx003_parser pms;
+    clock_t start = clock();
+    int n = 0;
+    for(int loop = 0; loop < 4; ++loop)
+        n += feed_bytes(pms, stream.data(), stream.size());
+    double s = (double)(clock() - start) / CLOCKS_PER_SEC;
+    CHECK(n == (int)(4 * stream.size() / sizeof(pms5003_frame)));
+    printf("  throughput: %.1f MB/s (%d frames)\n", s > 0 ? 4 * stream.size() / s / 1e6 : 0.0, n);
+}
+
+int main(){
+    test_captured_frames();
+    test_sps30_encoder();
+    test_split_frames();
+    test_corrupted_frames();
+    test_fuzz();
+    test_throughput();
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * neOScheduler timer wheel host test against a virtual clock
+ *
+ * g++ -std=c++11 -Wall -I../../src/neosensor/src timerwheel_test.cpp ../../src/neosensor/src/timerwheel.cpp -o timerwheel_test && ./timerwheel_test
+ */
+
+#include <stdio.h>
+#include "timerwheel.hpp"
+
+static uint32_t vclock = 0;
+static int failures = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ printf("FAILED %s:%d %s\n", __FILE__, __LINE__, #cond); ++failures; } }while(0)
+
+static uint32_t virtual_clock(){
+    return vclock;
+}
+
+/* run the wheel up to t, one call every step ms (i.e the main loop) */
+static void run_until(timerwheel &tw, uint32_t t, uint32_t step = 1){
+    while((int32_t)(t - vclock) > 0){
+        vclock += step;
+        tw.advance(vclock);
+    }
+}
+
+static int counter[4];
+static uint32_t fired_at[16];
+static void count_cb(void *arg){
+    int *c = (int *)arg;
+    if(c == &counter[0] && counter[0] < 16)
+        fired_at[counter[0]] = vclock;
+    ++(*c);
+}
+
+static uint32_t busy_ms;
+static void busy_cb(void *arg){
+    ++counter[0];
+    vclock += busy_ms;
+}
+
+static timerwheel *self_tw;
+static tw_handle_t self_h;
+static void self_cancel_cb(void *arg){
+    ++counter[0];
+    if(counter[0] == 3)
+        self_tw->cancel(self_h);
+}
+
+static void rearm_cb(void *arg){
+    ++counter[0];
+    if(counter[0] < 5)
+        self_tw->after(25, &rearm_cb);
+}
+
+static void test_periodic(){
+    timerwheel tw(&virtual_clock);
+    vclock = 1000;
+    tw.begin(vclock);
+    counter[0] = 0;
+    tw_handle_t h = tw.every(100, &count_cb, &counter[0]);
+    CHECK(h != TW_INVALID);
+    run_until(tw, 1000 + 1000);
+    CHECK(counter[0] == 10);
+    for(int i = 0; i < 10; ++i)
+        CHECK(fired_at[i] == 1000 + (uint32_t)(i + 1) * 100);
+    const tw_stats_t *s = tw.stats(h);
+    CHECK(s && s->runs == 10 && s->overruns == 0 && s->max_jitter_ms == 0);
+}
+
+static void test_one_shot_and_cancel(){
+    timerwheel tw(&virtual_clock);
+    vclock = 0;
+    tw.begin(vclock);
+    counter[1] = counter[2] = 0;
+    tw_handle_t a = tw.after(250, &count_cb, &counter[1]);
+    tw_handle_t b = tw.after(250, &count_cb, &counter[2]);
+    CHECK(tw.count() == 2);
+    CHECK(tw.cancel(b) && b == TW_INVALID);
+    run_until(tw, 249);
+    CHECK(counter[1] == 0);
+    run_until(tw, 260);
+    CHECK(counter[1] == 1 && counter[2] == 0);
+    CHECK(!tw.active(a) && tw.count() == 0);
+    run_until(tw, 2000);
+    CHECK(counter[1] == 1);
+}
+
+static void test_jitter_and_missed_periods(){
+    timerwheel tw(&virtual_clock);
+    vclock = 0;
+    tw.begin(vclock);
+    counter[0] = 0;
+    tw_handle_t h = tw.every(100, &count_cb, &counter[0]);
+    // main loop stalled for 350ms: one late call, 2 periods missed
+    vclock = 350;
+    tw.advance(vclock);
+    CHECK(counter[0] == 1);
+    const tw_stats_t *s = tw.stats(h);
+    CHECK(s->max_jitter_ms == 250 && s->overruns == 2);
+    // schedule stays aligned on multiples of the period
+    run_until(tw, 400);
+    CHECK(counter[0] == 2 && fired_at[1] == 400);
+}
+
+static void test_callback_overrun(){
+    timerwheel tw(&virtual_clock);
+    vclock = 0;
+    tw.begin(vclock);
+    counter[0] = 0;
+    busy_ms = 150;
+    tw_handle_t h = tw.every(100, &busy_cb);
+    run_until(tw, 100);
+    const tw_stats_t *s = tw.stats(h);
+    CHECK(counter[0] == 1 && s->overruns == 1 && s->max_duration_ms == 150);
+}
+
+static void test_callbacks_modify_wheel(){
+    timerwheel tw(&virtual_clock);
+    self_tw = &tw;
+    vclock = 0;
+    tw.begin(vclock);
+    counter[0] = 0;
+    self_h = tw.every(10, &self_cancel_cb);
+    run_until(tw, 1000);
+    CHECK(counter[0] == 3 && tw.count() == 0);
+
+    counter[0] = 0;
+    tw.after(25, &rearm_cb);
+    run_until(tw, 2000, 7);
+    CHECK(counter[0] == 5 && tw.count() == 0);
+}
+
+static void test_long_delays_and_wrap(){
+    timerwheel tw(&virtual_clock);
+    // start right before millis() wrap around
+    vclock = 0xFFFFFF00;
+    tw.begin(vclock);
+    counter[0] = counter[1] = 0;
+    // several wheel turns (64 slots * 10ms)
+    tw.after(5000, &count_cb, &counter[1]);
+    tw_handle_t h = tw.every(1000, &count_cb, &counter[0]);
+    run_until(tw, 0xFFFFFF00 + 4990, 3);
+    CHECK(counter[1] == 0 && counter[0] == 4);
+    run_until(tw, 0xFFFFFF00 + 5010, 3);
+    CHECK(counter[1] == 1 && counter[0] == 5);
+    CHECK(tw.stats(h)->overruns == 0);
+    // a single advance over many wheel turns
+    vclock += 60000;
+    tw.advance(vclock);
+    CHECK(counter[0] == 6 && tw.stats(h)->overruns == 59);
+}
+
+static void test_pool_exhaustion(){
+    timerwheel tw(&virtual_clock);
+    tw.begin(0);
+    int n = 0;
+    while(tw.after(100, &count_cb, &counter[3]) != TW_INVALID)
+        ++n;
+    CHECK(n == TW_MAX_TIMERS);
+    CHECK(tw.every(100, NULL) == TW_INVALID);
+}
+
+static void test_throughput(){
+    timerwheel tw(&virtual_clock);
+    vclock = 0;
+    tw.begin(vclock);
+    counter[3] = 0;
+    for(int i = 0; i < TW_MAX_TIMERS; ++i)
+        tw.every(10 * (i + 1), &count_cb, &counter[3]);
+    run_until(tw, 3600UL * 1000UL, 10);
+    int expected = 0;
+    for(int i = 0; i < TW_MAX_TIMERS; ++i)
+        expected += 3600 * 1000 / (10 * (i + 1));
+    CHECK(counter[3] == expected);
+    CHECK(tw.total().overruns == 0 && tw.total().max_jitter_ms == 0);
+}
+
+int main(){
+    test_periodic();
+    test_one_shot_and_cancel();
+    test_jitter_and_missed_periods();
+    test_callback_overrun();
+    test_callbacks_modify_wheel();
+    test_long_delays_and_wrap();
+    test_pool_exhaustion();
+    test_throughput();
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}